@@ -197,6 +197,7 @@ static void
 set_widget_sensitivity_for_uri_type( FileAccessWindow* faw, const gchar* uri_type )
 {
     if ( strcmp( uri_type, "file" ) == 0 || strcmp( uri_type, "xml" ) == 0
+            || strcmp( uri_type, "gncbin" ) == 0
             || strcmp( uri_type, "sqlite3" ) == 0 )
     {
         set_widget_sensitivity( faw, /* is_file_based_uri */ TRUE );
@@ -260,6 +261,7 @@ gnc_ui_file_access (GtkWindow *parent, int type)
     gboolean need_access_method_postgres = FALSE;
     gboolean need_access_method_sqlite3 = FALSE;
     gboolean need_access_method_xml = FALSE;
+    gboolean need_access_method_gncbin = FALSE;
     gint access_method_index = -1;
     gint active_access_method_index = -1;
     const gchar* default_db;
@@ -370,8 +372,8 @@ gnc_ui_file_access (GtkWindow *parent, int type)
         const gchar* access_method = node->data;
 
         /* For the different access methods, "mysql" and "postgres" are added if available.  Access
-        methods "xml" and "sqlite3" are compressed to "file" if opening a file, but when saving a file,
-        both access methods are added. */
+        methods "xml", "gncbin" and "sqlite3" are compressed to "file" if opening a file, but when
+        saving a file, all of them are added. */
         if ( strcmp( access_method, "mysql" ) == 0 )
         {
             need_access_method_mysql = TRUE;
@@ -402,6 +404,17 @@ gnc_ui_file_access (GtkWindow *parent, int type)
                 need_access_method_sqlite3 = TRUE;
             }
         }
+        else if ( strcmp( access_method, "gncbin" ) == 0 )
+        {
+            if ( type == FILE_ACCESS_OPEN )
+            {
+                need_access_method_file = TRUE;
+            }
+            else
+            {
+                need_access_method_gncbin = TRUE;
+            }
+        }
     }
     g_list_free(list);
 
@@ -428,6 +441,11 @@ gnc_ui_file_access (GtkWindow *parent, int type)
         gtk_combo_box_text_append_text( faw->cb_uri_type, "sqlite3" );
         active_access_method_index = ++access_method_index;
     }
+    if ( need_access_method_gncbin )
+    {
+        gtk_combo_box_text_append_text( faw->cb_uri_type, "gncbin" );
+        ++access_method_index;
+    }
     if ( need_access_method_xml )
     {
         gtk_combo_box_text_append_text( faw->cb_uri_type, "xml" );
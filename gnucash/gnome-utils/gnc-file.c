@@ -1289,8 +1289,8 @@ gnc_file_do_export(GtkWindow *parent, const char * filename)
 
 static gboolean been_here_before = FALSE;
 
-void
-gnc_file_save (GtkWindow *parent)
+static void
+gnc_file_do_save (GtkWindow *parent, gboolean incremental)
 {
     QofBackendError io_err;
     const char * newfile;
@@ -1325,7 +1325,10 @@ gnc_file_save (GtkWindow *parent)
     save_in_progress++;
     gnc_set_busy_cursor (NULL, TRUE);
     gnc_window_show_progress(_("Writing file..."), 0.0);
-    qof_session_save (session, gnc_window_show_progress);
+    if (incremental)
+        qof_session_save_incremental (session, gnc_window_show_progress);
+    else
+        qof_session_save (session, gnc_window_show_progress);
     gnc_window_show_progress(NULL, -1.0);
     gnc_unset_busy_cursor (NULL);
     save_in_progress--;
@@ -1351,6 +1354,18 @@ gnc_file_save (GtkWindow *parent)
     LEAVE (" ");
 }
 
+void
+gnc_file_save (GtkWindow *parent)
+{
+    gnc_file_do_save (parent, FALSE);
+}
+
+void
+gnc_file_autosave (GtkWindow *parent)
+{
+    gnc_file_do_save (parent, TRUE);
+}
+
 /* Note: this dialog will only be used when dbi is not enabled
  *       paths used in it always refer to files and are
  *       never db uris. See gnc_file_do_save_as for that.
@@ -257,11 +257,20 @@ static const gchar *readwrite_only_active_actions[] =
  */
 static const gchar *dirty_only_active_actions[] =
 {
-    "FileSaveAction",
     "FileRevertAction",
     NULL
 };
 
+/** These actions are made not sensitive when the current book is not
+ * dirty and there is no journal of incremental saves either, that a full
+ * save would fold into the file.
+ */
+static const gchar *unsaved_only_active_actions[] =
+{
+    "FileSaveAction",
+    NULL
+};
+
 /** The instance private data structure for an basic commands
  *  plugin. */
 typedef struct GncPluginBasicCommandsPrivate
@@ -324,6 +333,7 @@ static void update_inactive_actions(GncPluginPage *plugin_page)
     // We are readonly - so we have to switch particular actions to inactive.
     gboolean is_readwrite = !qof_book_is_readonly(gnc_get_current_book());
     gboolean is_dirty = qof_book_session_not_saved (gnc_get_current_book ());
+    gboolean is_journaled = qof_book_session_journaled (gnc_get_current_book ());
 
     // We continue only if the current page is a plugin page
     if (!plugin_page || !GNC_IS_PLUGIN_PAGE(plugin_page))
@@ -339,6 +349,8 @@ static void update_inactive_actions(GncPluginPage *plugin_page)
                                "sensitive", is_readwrite);
     gnc_plugin_update_actions (action_group, dirty_only_active_actions,
                                "sensitive", is_dirty);
+    gnc_plugin_update_actions (action_group, unsaved_only_active_actions,
+                               "sensitive", is_dirty || is_journaled);
 }
 
 static void
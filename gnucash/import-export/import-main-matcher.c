@@ -196,6 +196,8 @@ on_matcher_ok_clicked (GtkButton *button, GNCImportMainMatcher *info)
     /* Don't run any queries and/or split sorts while processing the matcher
     results. */
     gnc_suspend_gui_refresh();
+    /* Each imported split would otherwise send its account a modify event. */
+    qof_event_begin_batch();
 
     do
     {
@@ -214,6 +216,7 @@ on_matcher_ok_clicked (GtkButton *button, GNCImportMainMatcher *info)
     }
     while (gtk_tree_model_iter_next (model, &iter));
 
+    qof_event_end_batch();
     gnc_gen_trans_list_delete (info);
 
     /* Allow GUI refresh again. */
@@ -20,6 +20,7 @@
 #include <config.h>
 
 #include <stdio.h>
+#include <string.h>
 
 #include "gnc-component-manager.h"
 #include "qof.h"
@@ -67,6 +68,18 @@ static GList *components = NULL;
 static ComponentEventInfo changes = { NULL, NULL, FALSE };
 static ComponentEventInfo changes_backup = { NULL, NULL, FALSE };
 
+/* component_id --> ComponentInfo */
+static GHashTable *components_by_id = NULL;
+
+/* An inverted index of the components' watches, from an entity's GncGUID
+ * and from an entity type to the set of ids of the components watching
+ * it, so that a refresh only visits the components the changes concern
+ * instead of comparing every component's watches with them. */
+static GHashTable *entity_watchers = NULL;
+static GHashTable *type_watchers = NULL;
+
+static GNCComponentManagerStats stats;
+
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_GUI;
@@ -252,6 +265,92 @@ add_event_type (ComponentEventInfo *cei, QofIdTypeConst entity_type,
         *mask = event_mask;
 }
 
+static gpointer
+copy_guid_key (gconstpointer guid)
+{
+    GncGUID *key = guid_malloc ();
+
+    *key = *(const GncGUID*) guid;
+    return key;
+}
+
+static gpointer
+copy_type_key (gconstpointer entity_type)
+{
+    return g_strdup (entity_type);
+}
+
+/* Add component_id to the watchers of key in index, using copy_key to
+ * make the index its own copy of a new key. */
+static void
+index_watch (GHashTable *index, gconstpointer key,
+             gpointer (*copy_key) (gconstpointer), gint component_id)
+{
+    GHashTable *ids;
+
+    ids = g_hash_table_lookup (index, key);
+    if (!ids)
+    {
+        ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+        g_hash_table_insert (index, copy_key (key), ids);
+    }
+    g_hash_table_add (ids, GINT_TO_POINTER (component_id));
+}
+
+static void
+index_watch_entity (gint component_id, const GncGUID *entity)
+{
+    if (!entity_watchers)
+        entity_watchers = g_hash_table_new_full (guid_hash_to_guint,
+                                                 guid_g_hash_table_equal,
+                                                 (GDestroyNotify) guid_free,
+                                                 (GDestroyNotify) g_hash_table_destroy);
+
+    index_watch (entity_watchers, entity, copy_guid_key, component_id);
+}
+
+static void
+index_watch_type (gint component_id, QofIdTypeConst entity_type)
+{
+    if (!type_watchers)
+        type_watchers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                               (GDestroyNotify) g_hash_table_destroy);
+
+    index_watch (type_watchers, entity_type, copy_type_key, component_id);
+}
+
+static void
+unindex_watch (GHashTable *index, gconstpointer key, gint component_id)
+{
+    GHashTable *ids;
+
+    if (!index)
+        return;
+
+    ids = g_hash_table_lookup (index, key);
+    if (!ids)
+        return;
+
+    g_hash_table_remove (ids, GINT_TO_POINTER (component_id));
+    if (g_hash_table_size (ids) == 0)
+        g_hash_table_remove (index, key);
+}
+
+static void
+unindex_watches (ComponentInfo *ci)
+{
+    GHashTableIter iter;
+    gpointer key;
+
+    g_hash_table_iter_init (&iter, ci->watch_info.entity_events);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        unindex_watch (entity_watchers, key, ci->component_id);
+
+    g_hash_table_iter_init (&iter, ci->watch_info.event_masks);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        unindex_watch (type_watchers, key, ci->component_id);
+}
+
 static void
 gnc_cm_event_handler (QofInstance *entity,
                       QofEventId event_type,
@@ -300,7 +399,9 @@ gnc_component_manager_init (void)
     changes_backup.event_masks = g_hash_table_new (g_str_hash, g_str_equal);
     changes_backup.entity_events = guid_hash_table_new ();
 
-    handler_id = qof_event_register_handler (gnc_cm_event_handler, NULL);
+    /* The changes are kept as masks anyway, so take batched events
+     * as one call per entity. */
+    handler_id = qof_event_register_batch_handler (gnc_cm_event_handler, NULL);
 }
 
 void
@@ -324,23 +425,28 @@ gnc_component_manager_shutdown (void)
     destroy_event_hash (changes_backup.entity_events);
     changes_backup.entity_events = NULL;
 
+    if (entity_watchers)
+        g_hash_table_destroy (entity_watchers);
+    entity_watchers = NULL;
+
+    if (type_watchers)
+        g_hash_table_destroy (type_watchers);
+    type_watchers = NULL;
+
+    if (components_by_id)
+        g_hash_table_destroy (components_by_id);
+    components_by_id = NULL;
+
     qof_event_unregister_handler (handler_id);
 }
 
 static ComponentInfo *
 find_component (gint component_id)
 {
-    GList *node;
-
-    for (node = components; node; node = node->next)
-    {
-        ComponentInfo *ci = node->data;
-
-        if (ci->component_id == component_id)
-            return ci;
-    }
+    if (!components_by_id)
+        return NULL;
 
-    return NULL;
+    return g_hash_table_lookup (components_by_id, GINT_TO_POINTER (component_id));
 }
 
 static GList *
@@ -410,6 +516,9 @@ gnc_register_gui_component_internal (const char * component_class)
     ci->session = NULL;
 
     components = g_list_prepend (components, ci);
+    if (!components_by_id)
+        components_by_id = g_hash_table_new (g_direct_hash, g_direct_equal);
+    g_hash_table_insert (components_by_id, GINT_TO_POINTER (component_id), ci);
 
     /* update id for next registration */
     next_component_id = component_id + 1;
@@ -466,6 +575,10 @@ gnc_gui_component_watch_entity (gint component_id,
     }
 
     add_event (&ci->watch_info, entity, event_mask, FALSE);
+    if (event_mask)
+        index_watch_entity (component_id, entity);
+    else
+        unindex_watch (entity_watchers, entity, component_id);
 }
 
 void
@@ -483,6 +596,10 @@ gnc_gui_component_watch_entity_type (gint component_id,
     }
 
     add_event_type (&ci->watch_info, entity_type, event_mask, FALSE);
+    if (event_mask)
+        index_watch_type (component_id, entity_type);
+    else
+        unindex_watch (type_watchers, entity_type, component_id);
 }
 
 const EventInfo *
@@ -506,6 +623,7 @@ gnc_gui_component_clear_watches (gint component_id)
         return;
     }
 
+    unindex_watches (ci);
     clear_event_info (&ci->watch_info);
 }
 
@@ -530,6 +648,7 @@ gnc_unregister_gui_component (gint component_id)
     gnc_gui_component_clear_watches (component_id);
 
     components = g_list_remove (components, ci);
+    g_hash_table_remove (components_by_id, GINT_TO_POINTER (component_id));
 
     destroy_mask_hash (ci->watch_info.event_masks);
     ci->watch_info.event_masks = NULL;
@@ -662,16 +781,73 @@ changes_match (ComponentEventInfo *cei, ComponentEventInfo *changes)
     return big_cei->match;
 }
 
+static void
+add_watchers (GHashTable *index, gconstpointer key, GHashTable *candidates)
+{
+    GHashTable *ids;
+    GHashTableIter iter;
+    gpointer id;
+
+    if (!index)
+        return;
+
+    ids = g_hash_table_lookup (index, key);
+    if (!ids)
+        return;
+
+    g_hash_table_iter_init (&iter, ids);
+    while (g_hash_table_iter_next (&iter, &id, NULL))
+        g_hash_table_add (candidates, id);
+}
+
+static gint
+compare_component_ids (gconstpointer a, gconstpointer b)
+{
+    gint id_a = GPOINTER_TO_INT (a);
+    gint id_b = GPOINTER_TO_INT (b);
+
+    return id_a > id_b ? -1 : id_a < id_b;
+}
+
+/* Return the ids of the components watching something in changes,
+ * newest first like a full refresh, so that a GncPluginPageRegister
+ * is still refreshed before its register-single. */
+static GList *
+find_component_ids_by_changes (ComponentEventInfo *changes)
+{
+    GHashTable *candidates = g_hash_table_new (g_direct_hash, g_direct_equal);
+    GHashTableIter iter;
+    gpointer key, value;
+    GList *list;
+
+    g_hash_table_iter_init (&iter, changes->event_masks);
+    while (g_hash_table_iter_next (&iter, &key, &value))
+        if (*(QofEventId*) value)
+            add_watchers (type_watchers, key, candidates);
+
+    g_hash_table_iter_init (&iter, changes->entity_events);
+    while (g_hash_table_iter_next (&iter, &key, NULL))
+        add_watchers (entity_watchers, key, candidates);
+
+    list = g_hash_table_get_keys (candidates);
+    g_hash_table_destroy (candidates);
+
+    return g_list_sort (list, compare_component_ids);
+}
+
 static void
 gnc_gui_refresh_internal (gboolean force)
 {
     GList *list;
     GList *node;
+    gint64 start;
 
     if (!got_events && !force)
         return;
 
     gnc_suspend_gui_refresh ();
+    start = g_get_monotonic_time ();
+    stats.refreshes++;
 
     {
         GHashTable *table;
@@ -689,9 +865,14 @@ gnc_gui_refresh_internal (gboolean force)
     fprintf (stderr, "%srefresh!\n", force ? "forced " : "");
 #endif
 
-    list = find_component_ids_by_class (NULL);
-    // reverse the list so class GncPluginPageRegister is before register-single
-    list = g_list_reverse (list);
+    if (force)
+    {
+        list = find_component_ids_by_class (NULL);
+        // reverse the list so class GncPluginPageRegister is before register-single
+        list = g_list_reverse (list);
+    }
+    else
+        list = find_component_ids_by_changes (&changes_backup);
 
     for (node = list; node; node = node->next)
     {
@@ -708,6 +889,7 @@ gnc_gui_refresh_internal (gboolean force)
             continue;
         }
 
+        stats.components_checked++;
         if (force)
         {
             if (ci->refresh_handler)
@@ -715,6 +897,7 @@ gnc_gui_refresh_internal (gboolean force)
 #if CM_DEBUG
                 fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
 #endif
+                stats.components_matched++;
                 ci->refresh_handler (NULL, ci->user_data);
             }
         }
@@ -722,6 +905,7 @@ gnc_gui_refresh_internal (gboolean force)
         {
             if (ci->refresh_handler)
             {
+                stats.components_matched++;
 #if CM_DEBUG
                 fprintf (stderr, "calling %s:%d C handler\n", ci->component_class, ci->component_id);
 #endif
@@ -741,9 +925,26 @@ gnc_gui_refresh_internal (gboolean force)
 
     g_list_free (list);
 
+    stats.last_refresh_usec = g_get_monotonic_time () - start;
+    stats.total_refresh_usec += stats.last_refresh_usec;
+
     gnc_resume_gui_refresh ();
 }
 
+void
+gnc_component_manager_get_stats (GNCComponentManagerStats *out)
+{
+    g_return_if_fail (out);
+
+    *out = stats;
+}
+
+void
+gnc_component_manager_reset_stats (void)
+{
+    memset (&stats, 0, sizeof (stats));
+}
+
 void
 gnc_gui_refresh_all (void)
 {
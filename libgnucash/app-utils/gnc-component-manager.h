@@ -253,6 +253,26 @@ void gnc_gui_refresh_all (void);
  */
 gboolean gnc_gui_refresh_suspended (void);
 
+/* Counters kept by the component manager, for profiling refreshes. */
+typedef struct
+{
+    guint refreshes;           /* refreshes run, forced or not      */
+    guint components_checked;  /* components compared with changes  */
+    guint components_matched;  /* refresh handlers called           */
+    gint64 last_refresh_usec;  /* time taken by the last refresh    */
+    gint64 total_refresh_usec; /* time taken by all of them         */
+} GNCComponentManagerStats;
+
+/* gnc_component_manager_get_stats
+ *   Copy the refresh counters into stats.
+ */
+void gnc_component_manager_get_stats (GNCComponentManagerStats *stats);
+
+/* gnc_component_manager_reset_stats
+ *   Zero the refresh counters.
+ */
+void gnc_component_manager_reset_stats (void);
+
 /* gnc_close_gui_component
  *   Invoke the close handler for the indicated component.
  *
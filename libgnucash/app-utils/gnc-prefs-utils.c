@@ -32,6 +32,11 @@ static QofLogModule log_module = G_LOG_DOMAIN;
 
 /* Keys used for core preferences */
 #define GNC_PREF_FILE_COMPRESSION    "file-compression"
+#define GNC_PREF_FILE_COMPRESSION_LEVEL "file-compression-level"
+#define GNC_PREF_FILE_COMPRESSION_ZSTD  "file-compression-zstd"
+#define GNC_PREF_FILE_SAVE_INCREMENTAL  "file-save-incremental"
+#define GNC_PREF_FILE_JOURNAL_MAX_SIZE  "file-journal-max-size"
+#define GNC_PREF_FILE_LOAD_THREADS      "file-load-threads"
 #define GNC_PREF_RETAIN_TYPE_NEVER   "retain-type-never"
 #define GNC_PREF_RETAIN_TYPE_DAYS    "retain-type-days"
 #define GNC_PREF_RETAIN_TYPE_FOREVER "retain-type-forever"
@@ -78,6 +83,56 @@ file_compression_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
     }
 }
 
+static void
+file_compression_level_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint level = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_LEVEL);
+        gnc_prefs_set_file_compression_level (level);
+    }
+}
+
+static void
+file_compression_zstd_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean zstd = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_ZSTD);
+        gnc_prefs_set_file_save_zstd (zstd);
+    }
+}
+
+static void
+file_save_incremental_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gboolean incremental = gnc_prefs_get_bool(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_SAVE_INCREMENTAL);
+        gnc_prefs_set_file_save_incremental (incremental);
+    }
+}
+
+static void
+file_journal_max_size_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint size = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_JOURNAL_MAX_SIZE);
+        gnc_prefs_set_file_journal_max_size (size);
+    }
+}
+
+static void
+file_load_threads_changed_cb(gpointer gsettings, gchar *key, gpointer user_data)
+{
+    if (gnc_prefs_is_set_up())
+    {
+        gint threads = (int)gnc_prefs_get_float(GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_LOAD_THREADS);
+        gnc_prefs_set_file_load_threads (threads);
+    }
+}
+
 
 void gnc_prefs_init (void)
 {
@@ -89,6 +144,11 @@ void gnc_prefs_init (void)
     file_retain_changed_cb (NULL, NULL, NULL);
     file_retain_type_changed_cb (NULL, NULL, NULL);
     file_compression_changed_cb (NULL, NULL, NULL);
+    file_compression_level_changed_cb (NULL, NULL, NULL);
+    file_compression_zstd_changed_cb (NULL, NULL, NULL);
+    file_save_incremental_changed_cb (NULL, NULL, NULL);
+    file_journal_max_size_changed_cb (NULL, NULL, NULL);
+    file_load_threads_changed_cb (NULL, NULL, NULL);
 
     /* Check for invalid retain_type (days)/retain_days (0) combo.
      * This can happen either because a user changed the preferences
@@ -122,5 +182,15 @@ void gnc_prefs_init (void)
                            file_retain_type_changed_cb, NULL);
     gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION,
                            file_compression_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_LEVEL,
+                           file_compression_level_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_COMPRESSION_ZSTD,
+                           file_compression_zstd_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_SAVE_INCREMENTAL,
+                           file_save_incremental_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_JOURNAL_MAX_SIZE,
+                           file_journal_max_size_changed_cb, NULL);
+    gnc_prefs_register_cb (GNC_PREFS_GROUP_GENERAL, GNC_PREF_FILE_LOAD_THREADS,
+                           file_load_threads_changed_cb, NULL);
 
 }
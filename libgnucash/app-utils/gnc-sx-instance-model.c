@@ -1356,6 +1356,9 @@ gnc_sx_instance_model_effect_change(GncSxInstanceModel *model,
         return;
     }
 
+    /* Creating the transactions touches the same accounts over and over;
+     * let listeners hear about each of them once, when we're done. */
+    qof_event_begin_batch();
     for (iter = model->sx_instance_list; iter != NULL; iter = iter->next)
     {
         GList *instance_iter;
@@ -1445,6 +1448,7 @@ gnc_sx_instance_model_effect_change(GncSxInstanceModel *model,
         gnc_sx_set_instance_count(instances->sx, instance_count);
         xaccSchedXactionSetRemOccur(instances->sx, remain_occur_count);
     }
+    qof_event_end_batch();
 }
 
 void
@@ -0,0 +1,234 @@
+/********************************************************************
+ * test-gnc-component-manager.c: GLib g_test test suite for         *
+ * gnc-component-manager.c.                                         *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, you can retrieve it from        *
+ * https://www.gnu.org/licenses/old-licenses/gpl-2.0.html            *
+ * or contact:                                                      *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#include <config.h>
+#include <glib.h>
+#include <unittest-support.h>
+#include <qof.h>
+#include <Account.h>
+
+#include "../gnc-component-manager.h"
+
+static const gchar *suitename = "/app-utils/gnc-component-manager";
+void test_suite_gnc_component_manager (void);
+
+#define TEST_CLASS "test-component"
+
+typedef struct
+{
+    QofBook *book;
+    Account *watched;
+    Account *other;
+    /* One component watching the account watched, one watching the
+     * destruction of any account and one watching nothing. */
+    gint entity_id;
+    gint type_id;
+    gint idle_id;
+    guint entity_refreshes;
+    guint type_refreshes;
+    guint idle_refreshes;
+} Fixture;
+
+static void
+count_refresh (GHashTable *changes, gpointer user_data)
+{
+    ++*(guint*) user_data;
+}
+
+static void
+setup (Fixture *fixture, gconstpointer pData)
+{
+    fixture->book = qof_book_new ();
+    fixture->watched = xaccMallocAccount (fixture->book);
+    fixture->other = xaccMallocAccount (fixture->book);
+    fixture->entity_refreshes = 0;
+    fixture->type_refreshes = 0;
+    fixture->idle_refreshes = 0;
+
+    fixture->entity_id =
+        gnc_register_gui_component (TEST_CLASS, count_refresh, NULL,
+                                    &fixture->entity_refreshes);
+    gnc_gui_component_watch_entity (fixture->entity_id,
+                                    qof_entity_get_guid (fixture->watched),
+                                    QOF_EVENT_MODIFY);
+
+    fixture->type_id =
+        gnc_register_gui_component (TEST_CLASS, count_refresh, NULL,
+                                    &fixture->type_refreshes);
+    gnc_gui_component_watch_entity_type (fixture->type_id, GNC_ID_ACCOUNT,
+                                         QOF_EVENT_DESTROY);
+
+    fixture->idle_id =
+        gnc_register_gui_component (TEST_CLASS, count_refresh, NULL,
+                                    &fixture->idle_refreshes);
+
+    gnc_component_manager_reset_stats ();
+}
+
+static void
+teardown (Fixture *fixture, gconstpointer pData)
+{
+    gnc_unregister_gui_component (fixture->entity_id);
+    gnc_unregister_gui_component (fixture->type_id);
+    gnc_unregister_gui_component (fixture->idle_id);
+    qof_book_destroy (fixture->book);
+}
+
+static void
+test_refresh_watched_entity (Fixture *fixture, gconstpointer pData)
+{
+    GNCComponentManagerStats stats;
+
+    qof_event_gen (QOF_INSTANCE (fixture->watched), QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 0);
+    g_assert_cmpuint (fixture->idle_refreshes, ==, 0);
+
+    /* Only the components watching the entity or its type are looked at. */
+    gnc_component_manager_get_stats (&stats);
+    g_assert_cmpuint (stats.refreshes, ==, 1);
+    g_assert_cmpuint (stats.components_checked, ==, 2);
+    g_assert_cmpuint (stats.components_matched, ==, 1);
+
+    qof_event_gen (QOF_INSTANCE (fixture->other), QOF_EVENT_MODIFY, NULL);
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 0);
+
+    gnc_component_manager_get_stats (&stats);
+    g_assert_cmpuint (stats.refreshes, ==, 2);
+    g_assert_cmpuint (stats.components_checked, ==, 3);
+    g_assert_cmpuint (stats.components_matched, ==, 1);
+}
+
+static void
+test_refresh_watched_type (Fixture *fixture, gconstpointer pData)
+{
+    GNCComponentManagerStats stats;
+
+    qof_event_gen (QOF_INSTANCE (fixture->other), QOF_EVENT_DESTROY, NULL);
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 0);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->idle_refreshes, ==, 0);
+
+    gnc_component_manager_get_stats (&stats);
+    g_assert_cmpuint (stats.refreshes, ==, 1);
+    g_assert_cmpuint (stats.components_checked, ==, 1);
+    g_assert_cmpuint (stats.components_matched, ==, 1);
+}
+
+static void
+test_refresh_suspended (Fixture *fixture, gconstpointer pData)
+{
+    GNCComponentManagerStats stats;
+
+    gnc_suspend_gui_refresh ();
+    qof_event_gen (QOF_INSTANCE (fixture->watched), QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (QOF_INSTANCE (fixture->other), QOF_EVENT_DESTROY, NULL);
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 0);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 0);
+    gnc_resume_gui_refresh ();
+
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->idle_refreshes, ==, 0);
+    gnc_component_manager_get_stats (&stats);
+    g_assert_cmpuint (stats.refreshes, ==, 1);
+    g_assert_cmpuint (stats.components_matched, ==, 2);
+}
+
+static void
+test_refresh_forced (Fixture *fixture, gconstpointer pData)
+{
+    GNCComponentManagerStats stats;
+
+    gnc_gui_refresh_all ();
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->idle_refreshes, ==, 1);
+
+    gnc_component_manager_get_stats (&stats);
+    g_assert_cmpuint (stats.refreshes, ==, 1);
+    g_assert_cmpuint (stats.components_checked, ==, 3);
+    g_assert_cmpuint (stats.components_matched, ==, 3);
+
+    gnc_component_manager_reset_stats ();
+    gnc_component_manager_get_stats (&stats);
+    g_assert_cmpuint (stats.refreshes, ==, 0);
+    g_assert_cmpuint (stats.components_checked, ==, 0);
+}
+
+static void
+test_clear_watches (Fixture *fixture, gconstpointer pData)
+{
+    GNCComponentManagerStats stats;
+
+    gnc_gui_component_clear_watches (fixture->entity_id);
+    gnc_unregister_gui_component (fixture->type_id);
+    fixture->type_id = gnc_register_gui_component (TEST_CLASS, count_refresh,
+                                                   NULL,
+                                                   &fixture->type_refreshes);
+
+    qof_event_gen (QOF_INSTANCE (fixture->watched), QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (QOF_INSTANCE (fixture->other), QOF_EVENT_DESTROY, NULL);
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 0);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 0);
+
+    /* Nothing watches anything any more, so nothing is looked at. */
+    gnc_component_manager_get_stats (&stats);
+    g_assert_cmpuint (stats.refreshes, ==, 2);
+    g_assert_cmpuint (stats.components_checked, ==, 0);
+}
+
+/* Shutting down drops the indexes; they are built afresh after. */
+static void
+test_shutdown (Fixture *fixture, gconstpointer pData)
+{
+    teardown (fixture, pData);
+    gnc_component_manager_shutdown ();
+    gnc_component_manager_init ();
+    setup (fixture, pData);
+
+    qof_event_gen (QOF_INSTANCE (fixture->watched), QOF_EVENT_MODIFY, NULL);
+    qof_event_gen (QOF_INSTANCE (fixture->other), QOF_EVENT_DESTROY, NULL);
+    g_assert_cmpuint (fixture->entity_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->type_refreshes, ==, 1);
+    g_assert_cmpuint (fixture->idle_refreshes, ==, 0);
+}
+
+void
+test_suite_gnc_component_manager (void)
+{
+    GNC_TEST_ADD (suitename, "refresh watched entity", Fixture, NULL, setup,
+                  test_refresh_watched_entity, teardown);
+    GNC_TEST_ADD (suitename, "refresh watched type", Fixture, NULL, setup,
+                  test_refresh_watched_type, teardown);
+    GNC_TEST_ADD (suitename, "refresh suspended", Fixture, NULL, setup,
+                  test_refresh_suspended, teardown);
+    GNC_TEST_ADD (suitename, "refresh forced", Fixture, NULL, setup,
+                  test_refresh_forced, teardown);
+    GNC_TEST_ADD (suitename, "clear watches", Fixture, NULL, setup,
+                  test_clear_watches, teardown);
+    GNC_TEST_ADD (suitename, "shutdown", Fixture, NULL, setup,
+                  test_shutdown, teardown);
+}
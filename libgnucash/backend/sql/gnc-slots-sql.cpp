@@ -760,6 +760,7 @@ gnc_sql_slots_load (GncSqlBackend* sql_be, QofInstance* inst)
     info.context = NONE;
 
     slots_load_info (&info);
+    qof_instance_slots_changed (inst);
 }
 
 static void
@@ -816,7 +817,7 @@ load_slot_for_list_item (GncSqlBackend* sql_be, GncSqlRow& row,
     slot_info.context = NONE;
 
     gnc_sql_load_object (sql_be, row, TABLE_NAME, &slot_info, col_table);
-
+    qof_instance_slots_changed (inst);
 
 }
 
@@ -842,6 +843,7 @@ load_slot_for_book_object (GncSqlBackend* sql_be, GncSqlRow& row,
     slot_info.path.clear();
 
     gnc_sql_load_object (sql_be, row, TABLE_NAME, &slot_info, col_table);
+    qof_instance_slots_changed (inst);
 }
 
 /**
@@ -80,9 +80,11 @@ extern "C"
 #include "gnc-backend-xml.h"
 #include <qof-backend.hpp>
 #include "gnc-xml-backend.hpp"
+#include "gnc-bin-backend.hpp"
 #include "gnc-xml-helper.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml.h"
+#include "io-gncbin.hpp"
 
 #include "gnc-address-xml-v2.h"
 #include "gnc-bill-term-xml-v2.h"
@@ -170,6 +172,47 @@ det_exit:
     return result;
 }
 
+struct QofBinBackendProvider : public QofBackendProvider
+{
+    QofBinBackendProvider (const char* name, const char* type) :
+        QofBackendProvider {name, type} {}
+    QofBinBackendProvider(QofBinBackendProvider&) = delete;
+    QofBinBackendProvider operator=(QofBinBackendProvider&) = delete;
+    QofBinBackendProvider(QofBinBackendProvider&&) = delete;
+    QofBinBackendProvider operator=(QofBinBackendProvider&&) = delete;
+    ~QofBinBackendProvider () = default;
+    QofBackend* create_backend(void) { return new GncBinBackend; }
+    bool type_check(const char* type);
+
+};
+
+/* Registered for "file" after the XML provider, which takes new and empty
+ * files, so there this one only gets to open existing snapshots. */
+bool
+QofBinBackendProvider::type_check (const char *uri)
+{
+    GStatBuf sbuf;
+    gboolean result;
+
+    if (!uri)
+        return FALSE;
+
+    auto filename = gnc_uri_get_path (uri);
+    if (g_stat (filename, &sbuf) != 0)
+    {
+        PINFO (" new file");
+        result = TRUE;
+    }
+    else
+    {
+        result = gnc_bin_file_type (filename) != GncBinFileType::NOT_OURS;
+        if (!result)
+            PINFO (" %s is not a gnc snapshot", filename);
+    }
+    g_free (filename);
+    return result;
+}
+
 /* ================================================================= */
 
 static void
@@ -207,6 +250,12 @@ gnc_module_init_backend_xml (void)
     prov = QofBackendProvider_ptr(new QofXmlBackendProvider{name, "file"});
     qof_backend_register_provider(std::move(prov));
 
+    const char* bin_name {"GnuCash Binary Snapshot Backend Version 1"};
+    prov = QofBackendProvider_ptr(new QofBinBackendProvider{bin_name, "gncbin"});
+    qof_backend_register_provider(std::move(prov));
+    prov = QofBackendProvider_ptr(new QofBinBackendProvider{bin_name, "file"});
+    qof_backend_register_provider(std::move(prov));
+
     /* And the business objects */
     business_core_xml_init ();
 }
@@ -0,0 +1,85 @@
+/********************************************************************
+ * gnc-bin-backend.cpp: Implement binary snapshot file backend.     *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+#include <errno.h>
+#include <glib.h>
+
+#include <gnc-engine.h> //for GNC_MOD_BACKEND
+}
+
+#include "gnc-bin-backend.hpp"
+#include "io-gncbin.hpp"
+
+static QofLogModule log_module = GNC_MOD_BACKEND;
+
+void
+GncBinBackend::load (QofBook* book, QofBackendLoadType loadType)
+{
+    if (loadType != LOAD_TYPE_INITIAL_LOAD) return;
+
+    auto error = ERR_BACKEND_NO_ERR;
+    m_book = book;
+
+    errno = 0;
+    switch (gnc_bin_file_type (m_fullpath.c_str()))
+    {
+    case GncBinFileType::SNAPSHOT:
+        if (!qof_session_load_from_bin_file (book, m_fullpath.c_str(),
+                                             get_percentage()))
+        {
+            PWARN ("Damaged snapshot %s", m_fullpath.c_str());
+            error = ERR_FILEIO_PARSE_ERROR;
+        }
+        break;
+    case GncBinFileType::TOO_NEW:
+        PWARN ("Version of snapshot %s is newer than what we can read",
+               m_fullpath.c_str());
+        error = ERR_BACKEND_TOO_NEW;
+        break;
+    default:
+        if (errno == EACCES)
+        {
+            PWARN ("No read permission to file");
+            error = ERR_FILEIO_FILE_EACCES;
+        }
+        else
+        {
+            PWARN ("File not a snapshot");
+            error = ERR_FILEIO_UNKNOWN_FILE_TYPE;
+        }
+        break;
+    }
+
+    if (error != ERR_BACKEND_NO_ERR)
+        set_error(error);
+
+    /* We just got done loading, it can't possibly be dirty !! */
+    qof_book_mark_session_saved (book);
+}
+
+bool
+GncBinBackend::write_book_file (const char* filename)
+{
+    return gnc_book_write_to_bin_file (m_book, filename, get_percentage());
+}
@@ -0,0 +1,46 @@
+/********************************************************************
+ * gnc-bin-backend.hpp: Declare binary snapshot file backend.       *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+#ifndef __GNC_BIN_BACKEND_HPP__
+#define __GNC_BIN_BACKEND_HPP__
+
+#include "gnc-xml-backend.hpp"
+
+/* Keeps the book in a binary snapshot (io-gncbin.hpp) instead of XML. The
+ * locking, backups and log files are the XML backend's. */
+class GncBinBackend : public GncXmlBackend
+{
+public:
+    GncBinBackend() = default;
+    GncBinBackend(const GncBinBackend&) = delete;
+    GncBinBackend operator=(const GncBinBackend&) = delete;
+    GncBinBackend(const GncBinBackend&&) = delete;
+    GncBinBackend operator=(const GncBinBackend&&) = delete;
+    ~GncBinBackend() = default;
+    void load(QofBook* book, QofBackendLoadType loadType) override;
+    /* Snapshots have no journal; every save writes the whole book. */
+    void commit(QofInstance* inst) override {}
+    void sync_incremental(QofBook* book) override { sync(book); }
+
+protected:
+    bool write_book_file(const char* filename) override;
+};
+#endif // __GNC_BIN_BACKEND_HPP__
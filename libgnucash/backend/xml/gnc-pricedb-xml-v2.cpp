@@ -27,6 +27,7 @@ extern "C"
 #include <string.h>
 #include "gnc-pricedb.h"
 #include "gnc-pricedb-p.h"
+#include "gnc-prefs.h"
 }
 
 #include "gnc-xml.h"
@@ -37,6 +38,10 @@ extern "C"
 #include "sixtp-dom-generators.h"
 #include "io-gncxml-gen.h"
 #include "io-gncxml-v2.h"
+#include "sixtp-stream-parser.hpp"
+#include "io-gncxml-pipeline.hpp"
+
+#include <memory>
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = GNC_MOD_IO;
@@ -142,6 +147,40 @@ price_parse_xml_sub_node (GNCPrice* p, xmlNodePtr sub_node, QofBook* book)
     return TRUE;
 }
 
+GNCPrice*
+dom_tree_to_price (xmlNodePtr node, QofBook* book)
+{
+    xmlNodePtr child;
+    GNCPrice* p;
+
+    if (!node || !node->xmlChildrenNode) return NULL;
+
+    p = gnc_price_create (book);
+    if (!p) return NULL;
+
+    for (child = node->xmlChildrenNode; child; child = child->next)
+    {
+        switch (child->type)
+        {
+        case XML_COMMENT_NODE:
+        case XML_TEXT_NODE:
+            break;
+        case XML_ELEMENT_NODE:
+            if (!price_parse_xml_sub_node (p, child, book))
+            {
+                gnc_price_unref (p);
+                return NULL;
+            }
+            break;
+        default:
+            PERR ("Unknown node type (%d) while parsing gnc-price xml.", child->type);
+            gnc_price_unref (p);
+            return NULL;
+        }
+    }
+    return p;
+}
+
 static gboolean
 price_parse_xml_end_handler (gpointer data_for_children,
                              GSList* data_from_children,
@@ -151,9 +190,7 @@ price_parse_xml_end_handler (gpointer data_for_children,
                              gpointer* result,
                              const gchar* tag)
 {
-    gboolean ok = TRUE;
     xmlNodePtr price_xml = (xmlNodePtr) data_for_children;
-    xmlNodePtr child;
     GNCPrice* p = NULL;
     gxpf_data* gdata = static_cast<decltype (gdata)> (global_data);
     QofBook* book = static_cast<decltype (book)> (gdata->bookdata);
@@ -164,75 +201,220 @@ price_parse_xml_end_handler (gpointer data_for_children,
     *result = NULL;
 
     if (!price_xml) return FALSE;
-    if (price_xml->next)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (price_xml->prev)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
-    if (!price_xml->xmlChildrenNode)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
+    if (!price_xml->next && !price_xml->prev)
+        p = dom_tree_to_price (price_xml, book);
 
-    p = gnc_price_create (book);
-    if (!p)
-    {
-        ok = FALSE;
-        goto cleanup_and_exit;
-    }
+    *result = p;
+    xmlFreeNode (price_xml);
+    return p != NULL;
+}
+
+static void
+cleanup_gnc_price (sixtp_child_result* result)
+{
+    if (result->data) gnc_price_unref ((GNCPrice*) result->data);
+}
+
+/* The stream parser reads a price into a GncXmlPriceRecord, which then
+   does what price_parse_xml_end_handler does. */
+
+enum price_field
+{
+    PRICE_ID, PRICE_COMMODITY, PRICE_CURRENCY, PRICE_TIME, PRICE_SOURCE,
+    PRICE_TYPE, PRICE_VALUE, PRICE_NFIELDS
+};
+
+static const GncXmlField price_fields[PRICE_NFIELDS] =
+{
+    { "price:id", false },
+    { "price:commodity", false },
+    { "price:currency", false },
+    { "price:time", false },
+    { "price:source", false },
+    { "price:type", false },
+    { "price:value", false },
+};
+
+class GncXmlPriceRecord : public GncXmlRecord
+{
+public:
+    bool make (gxpf_data* gdata, const gchar* tag, gpointer* result) override;
+
+    bool ok = true;
+    unsigned set = 0;
+    GncXmlGuid id;
+    GncXmlCommodityRefReader commodity;
+    GncXmlCommodityRefReader currency;
+    time64 time = 0;
+    std::string source;
+    std::string type;
+    gnc_numeric value;
+};
+
+bool
+GncXmlPriceRecord::make (gxpf_data* gdata, const gchar* tag, gpointer* result)
+{
+    auto book = static_cast<QofBook*> (gdata->bookdata);
+    gnc_commodity* c;
+
+    *result = NULL;
+    if (!ok)
+        return false;
 
-    for (child = price_xml->xmlChildrenNode; child; child = child->next)
+    auto price = gnc_price_create (book);
+    gnc_price_begin_edit (price);
+    for (std::size_t field = 0; field < PRICE_NFIELDS; ++field)
     {
-        switch (child->type)
+        if (!(set & (1u << field)))
+            continue;
+        switch (field)
         {
-        case XML_COMMENT_NODE:
-        case XML_TEXT_NODE:
+        case PRICE_ID:
+            gnc_price_set_guid (price, id.get ());
             break;
-        case XML_ELEMENT_NODE:
-            if (!price_parse_xml_sub_node (p, child, book))
+        case PRICE_COMMODITY:
+        case PRICE_CURRENCY:
+            c = (field == PRICE_COMMODITY ? commodity : currency).value (book);
+            if (!c)
             {
-                ok = FALSE;
-                goto cleanup_and_exit;
+                /* Left open, as price_parse_xml_sub_node does. */
+                gnc_price_unref (price);
+                return false;
             }
+            if (field == PRICE_COMMODITY)
+                gnc_price_set_commodity (price, c);
+            else
+                gnc_price_set_currency (price, c);
             break;
-        default:
-            PERR ("Unknown node type (%d) while parsing gnc-price xml.", child->type);
-            child = NULL;
-            ok = FALSE;
-            goto cleanup_and_exit;
+        case PRICE_TIME:
+            gnc_price_set_time64 (price, time);
+            break;
+        case PRICE_SOURCE:
+            gnc_price_set_source_string (price, source.c_str ());
+            break;
+        case PRICE_TYPE:
+            gnc_price_set_typestr (price, type.c_str ());
+            break;
+        case PRICE_VALUE:
+            gnc_price_set_value (price, value);
             break;
         }
     }
+    gnc_price_commit_edit (price);
 
-cleanup_and_exit:
-    if (ok)
-    {
-        *result = p;
-    }
-    else
+    *result = price;
+    return true;
+}
+
+class GncXmlPriceParser : public GncXmlRecordParser
+{
+public:
+    explicit GncXmlPriceParser (gxpf_data* gdata)
+        : GncXmlRecordParser {gdata}, m_record {new GncXmlPriceRecord} {}
+    GncXmlRecord* take_record () override;
+
+protected:
+    void start_element (std::size_t depth, const gchar* tag,
+                        gchar** attrs) override;
+    void end_element (std::size_t depth, const gchar* tag,
+                      const GncXmlElement& element) override;
+
+private:
+    bool read_field (const gchar* tag, const GncXmlElement& element);
+
+    std::unique_ptr<GncXmlPriceRecord> m_record;
+    std::size_t m_field = PRICE_NFIELDS;
+    GncXmlTimeReader m_time;
+};
+
+void
+GncXmlPriceParser::start_element (std::size_t depth, const gchar* tag,
+                                  gchar** attrs)
+{
+    if (depth != 1)
+        return;
+    m_field = gnc_xml_field_lookup (price_fields, PRICE_NFIELDS, tag);
+    if (m_field == PRICE_COMMODITY)
+        m_record->commodity.reset ();
+    else if (m_field == PRICE_CURRENCY)
+        m_record->currency.reset ();
+    m_time.reset ();
+}
+
+void
+GncXmlPriceParser::end_element (std::size_t depth, const gchar* tag,
+                                const GncXmlElement& element)
+{
+    /* Like price_parse_xml_end_handler, give up at the first bad field. */
+    if (!m_record->ok)
+        return;
+    if (depth == 1)
+        m_record->ok = read_field (tag, element);
+    else if (depth == 2 && m_field == PRICE_COMMODITY)
+        m_record->commodity.end_element (tag, element);
+    else if (depth == 2 && m_field == PRICE_CURRENCY)
+        m_record->currency.end_element (tag, element);
+    else if (depth == 2 && m_field == PRICE_TIME)
+        m_time.end_element (tag, element);
+}
+
+bool
+GncXmlPriceParser::read_field (const gchar* tag, const GncXmlElement& element)
+{
+    auto& record = *m_record;
+    const gchar* text = element.text ();
+
+    switch (m_field)
     {
-        *result = NULL;
-        gnc_price_unref (p);
+    case PRICE_ID:
+        if (!record.id.read (element)) return false;
+        break;
+    case PRICE_COMMODITY:
+    case PRICE_CURRENCY:
+        /* Looked up by make (). */
+        break;
+    case PRICE_TIME:
+        record.time = m_time.value ();
+        if (!dom_tree_valid_time64 (record.time, BAD_CAST tag)) record.time = 0;
+        break;
+    case PRICE_SOURCE:
+        if (!text) return false;
+        record.source = text;
+        break;
+    case PRICE_TYPE:
+        if (!text) return false;
+        record.type = text;
+        break;
+    case PRICE_VALUE:
+        if (!element.to_numeric (&record.value)) return false;
+        break;
+    default:
+        return true;
     }
-    xmlFreeNode (price_xml);
-    return ok;
+    record.set |= 1u << m_field;
+    return true;
 }
 
-static void
-cleanup_gnc_price (sixtp_child_result* result)
+GncXmlRecord*
+GncXmlPriceParser::take_record ()
 {
-    if (result->data) gnc_price_unref ((GNCPrice*) result->data);
+    if (!top ().has_children ())
+        m_record->ok = false;
+    return m_record.release ();
+}
+
+static GncXmlRecordParser*
+gnc_price_record_parser_new (void)
+{
+    return new GncXmlPriceParser (nullptr);
 }
 
 static sixtp*
 gnc_price_parser_new (void)
 {
+    if (gnc_prefs_get_file_load_stream_parsers ())
+        return sixtp_stream_parser_new<GncXmlPriceParser> (cleanup_gnc_price,
+                                                           cleanup_gnc_price);
     return sixtp_dom_parser_new (price_parse_xml_end_handler,
                                  cleanup_gnc_price,
                                  cleanup_gnc_price);
@@ -351,10 +533,9 @@ pricedb_v2_end_handler (
 }
 
 static sixtp*
-gnc_pricedb_parser_new (void)
+gnc_pricedb_parser_new (sixtp* price_parser)
 {
     sixtp* top_level;
-    sixtp* price_parser;
 
     top_level =
         sixtp_set_any (sixtp_new (), TRUE,
@@ -366,9 +547,11 @@ gnc_pricedb_parser_new (void)
                        SIXTP_CLEANUP_RESULT_ID, pricedb_cleanup_result_handler,
                        SIXTP_NO_MORE_HANDLERS);
 
-    if (!top_level) return NULL;
-
-    price_parser = gnc_price_parser_new ();
+    if (!top_level)
+    {
+        if (price_parser) sixtp_destroy (price_parser);
+        return NULL;
+    }
 
     if (!price_parser)
     {
@@ -383,10 +566,26 @@ gnc_pricedb_parser_new (void)
 
 sixtp*
 gnc_pricedb_sixtp_parser_create (void)
+{
+    return gnc_pricedb_sixtp_parser_create_pipelined (NULL);
+}
+
+sixtp*
+gnc_pricedb_sixtp_parser_create_pipelined (GncXmlPipeline* pipeline)
 {
     sixtp* ret;
-    ret = gnc_pricedb_parser_new ();
-    sixtp_set_end (ret, pricedb_v2_end_handler);
+    sixtp* price_parser;
+
+    if (pipeline)
+        price_parser = pipeline->add_type ("price", "gnc:pricedb",
+                                           gnc_price_record_parser_new,
+                                           cleanup_gnc_price,
+                                           cleanup_gnc_price);
+    else
+        price_parser = gnc_price_parser_new ();
+    ret = gnc_pricedb_parser_new (price_parser);
+    if (ret)
+        sixtp_set_end (ret, pricedb_v2_end_handler);
     return ret;
 }
 
@@ -462,6 +661,12 @@ gnc_price_to_dom_tree (const xmlChar* tag, GNCPrice* price)
     return price_xml;
 }
 
+xmlNodePtr
+gnc_price_dom_tree_create (GNCPrice* price)
+{
+    return gnc_price_to_dom_tree (BAD_CAST "price", price);
+}
+
 static gboolean
 xml_add_gnc_price_adapter (GNCPrice* p, gpointer data)
 {
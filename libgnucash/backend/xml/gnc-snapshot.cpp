@@ -0,0 +1,211 @@
+/********************************************************************
+ * gnc-snapshot.cpp -- convert and time binary snapshots            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+/* gnc-snapshot convert [--to=xml|gncbin] IN OUT
+ *     Write the book in IN to OUT, as a binary snapshot if IN is an XML
+ *     file and as XML if it is a snapshot, unless --to says otherwise.
+ * gnc-snapshot bench [--runs=N] FILE...
+ *     Load each FILE N times and print the fastest load with the size of
+ *     the book.
+ */
+extern "C"
+{
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#include "cashobjects.h"
+#include "gnc-engine.h"
+#include "TransLog.h"
+}
+
+#include <string>
+
+#include "gnc-backend-xml.h"
+#include "io-gncbin.hpp"
+
+static void
+usage (void)
+{
+    fprintf (stderr,
+             "Usage: gnc-snapshot convert [--to=xml|gncbin] IN OUT\n"
+             "       gnc-snapshot bench [--runs=N] FILE...\n");
+}
+
+/* The URI of path for the given access method, path made absolute since
+ * the backend resolves relative ones against the data directory. */
+static std::string
+file_uri (const char* scheme, const char* path)
+{
+    std::string uri {scheme};
+    uri += "://";
+    if (g_path_is_absolute (path))
+        return uri + path;
+
+    auto cwd = g_get_current_dir ();
+    auto abs_path = g_build_filename (cwd, path, (gchar*)NULL);
+    uri += abs_path;
+    g_free (abs_path);
+    g_free (cwd);
+    return uri;
+}
+
+static bool
+check_session (QofSession* session, const char* filename)
+{
+    auto error = qof_session_get_error (session);
+    if (error == ERR_BACKEND_NO_ERR)
+        return true;
+    fprintf (stderr, "%s: error %d %s\n", filename, error,
+             qof_session_get_error_message (session));
+    return false;
+}
+
+/* Open filename read only, leaving the lock of whoever has it alone. */
+static QofSession*
+open_book (const char* filename)
+{
+    auto session = qof_session_new ();
+    qof_session_begin (session, file_uri ("file", filename).c_str (), TRUE,
+                       FALSE, FALSE);
+    if (check_session (session, filename))
+    {
+        qof_session_load (session, NULL);
+        if (check_session (session, filename))
+            return session;
+    }
+    qof_session_destroy (session);
+    return NULL;
+}
+
+static int
+convert (int argc, char** argv)
+{
+    const char* to = NULL;
+    int i = 0;
+
+    if (argc > 0 && g_str_has_prefix (argv[0], "--to="))
+        to = argv[i++] + strlen ("--to=");
+    if (argc - i != 2
+        || (to && g_strcmp0 (to, "xml") != 0 && g_strcmp0 (to, "gncbin") != 0))
+    {
+        usage ();
+        return EXIT_FAILURE;
+    }
+
+    auto in = argv[i], out = argv[i + 1];
+    if (!to)
+        to = gnc_bin_file_type (in) == GncBinFileType::NOT_OURS ? "gncbin" : "xml";
+
+    auto in_session = open_book (in);
+    if (!in_session)
+        return EXIT_FAILURE;
+
+    auto out_session = qof_session_new ();
+    qof_session_begin (out_session, file_uri (to, out).c_str (), FALSE, TRUE,
+                       FALSE);
+    auto success = check_session (out_session, out);
+    if (success)
+    {
+        qof_session_swap_data (in_session, out_session);
+        qof_session_save (out_session, NULL);
+        success = check_session (out_session, out);
+        qof_session_swap_data (in_session, out_session);
+    }
+
+    qof_session_destroy (out_session);
+    qof_session_destroy (in_session);
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int
+bench (int argc, char** argv)
+{
+    int runs = 3;
+    int i = 0;
+
+    if (argc > 0 && g_str_has_prefix (argv[0], "--runs="))
+        runs = atoi (argv[i++] + strlen ("--runs="));
+    if (i == argc || runs < 1)
+    {
+        usage ();
+        return EXIT_FAILURE;
+    }
+
+    for (; i < argc; ++i)
+    {
+        gint64 best = G_MAXINT64;
+        guint accounts = 0, transactions = 0, splits = 0;
+
+        for (int run = 0; run < runs; ++run)
+        {
+            auto start = g_get_monotonic_time ();
+            auto session = open_book (argv[i]);
+            auto elapsed = g_get_monotonic_time () - start;
+            if (!session)
+                return EXIT_FAILURE;
+
+            best = MIN (best, elapsed);
+            auto book = qof_session_get_book (session);
+            accounts = qof_collection_count (
+                qof_book_get_collection (book, GNC_ID_ACCOUNT));
+            transactions = qof_collection_count (
+                qof_book_get_collection (book, GNC_ID_TRANS));
+            splits = qof_collection_count (
+                qof_book_get_collection (book, GNC_ID_SPLIT));
+            qof_session_destroy (session);
+        }
+        printf ("%s: %.3f s, %u accounts, %u transactions, %u splits\n",
+                argv[i], best / 1e6, accounts, transactions, splits);
+    }
+    return EXIT_SUCCESS;
+}
+
+int
+main (int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        usage ();
+        return EXIT_FAILURE;
+    }
+
+    qof_init ();
+    cashobjects_register ();
+    gnc_module_init_backend_xml ();
+    xaccLogDisable ();
+
+    int result;
+    if (g_strcmp0 (argv[1], "convert") == 0)
+        result = convert (argc - 2, argv + 2);
+    else if (g_strcmp0 (argv[1], "bench") == 0)
+        result = bench (argc - 2, argv + 2);
+    else
+    {
+        usage ();
+        result = EXIT_FAILURE;
+    }
+
+    qof_close ();
+    return result;
+}
@@ -32,6 +32,7 @@ extern "C"
 #include "TransactionP.h"
 #include "gnc-lot.h"
 #include "gnc-lot-p.h"
+#include "gnc-prefs.h"
 }
 #include "gnc-xml-helper.h"
 
@@ -47,6 +48,12 @@ extern "C"
 #include "io-gncxml-gen.h"
 
 #include "sixtp-dom-parsers.h"
+#include "sixtp-stream-parser.hpp"
+#include "io-gncxml-pipeline.hpp"
+
+#include <memory>
+
+static QofLogModule log_module = GNC_MOD_IO;
 
 const gchar* transaction_version_string = "2.0.0";
 
@@ -295,26 +302,45 @@ spl_quantity_handler (xmlNodePtr node, gpointer data)
 
 gboolean gnc_transaction_xml_v2_testing = FALSE;
 
-static gboolean
-spl_account_handler (xmlNodePtr node, gpointer data)
+static void
+split_set_account (Split* split, const GncGUID* id, QofBook* book)
 {
-    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
-    GncGUID* id = dom_tree_to_guid (node);
-    Account* account;
-
-    g_return_val_if_fail (id, FALSE);
-
-    account = xaccAccountLookup (id, pdata->book);
+    Account* account = xaccAccountLookup (id, book);
     if (!account && gnc_transaction_xml_v2_testing &&
         !guid_equal (id, guid_null ()))
     {
-        account = xaccMallocAccount (pdata->book);
+        account = xaccMallocAccount (book);
         xaccAccountSetGUID (account, id);
         xaccAccountSetCommoditySCU (account,
-                                    xaccSplitGetAmount (pdata->split).denom);
+                                    xaccSplitGetAmount (split).denom);
     }
 
-    xaccAccountInsertSplit (account, pdata->split);
+    xaccAccountInsertSplit (account, split);
+}
+
+static void
+split_set_lot (Split* split, const GncGUID* id, QofBook* book)
+{
+    GNCLot* lot = gnc_lot_lookup (id, book);
+    if (!lot && gnc_transaction_xml_v2_testing &&
+        !guid_equal (id, guid_null ()))
+    {
+        lot = gnc_lot_new (book);
+        gnc_lot_set_guid (lot, *id);
+    }
+
+    gnc_lot_add_split (lot, split);
+}
+
+static gboolean
+spl_account_handler (xmlNodePtr node, gpointer data)
+{
+    struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
+    GncGUID* id = dom_tree_to_guid (node);
+
+    g_return_val_if_fail (id, FALSE);
+
+    split_set_account (pdata->split, id, pdata->book);
 
     guid_free (id);
 
@@ -326,19 +352,10 @@ spl_lot_handler (xmlNodePtr node, gpointer data)
 {
     struct split_pdata* pdata = static_cast<decltype (pdata)> (data);
     GncGUID* id = dom_tree_to_guid (node);
-    GNCLot* lot;
 
     g_return_val_if_fail (id, FALSE);
 
-    lot = gnc_lot_lookup (id, pdata->book);
-    if (!lot && gnc_transaction_xml_v2_testing &&
-        !guid_equal (id, guid_null ()))
-    {
-        lot = gnc_lot_new (pdata->book);
-        gnc_lot_set_guid (lot, *id);
-    }
-
-    gnc_lot_add_split (lot, pdata->split);
+    split_set_lot (pdata->split, id, pdata->book);
 
     guid_free (id);
 
@@ -641,8 +658,420 @@ dom_tree_to_transaction (xmlNodePtr node, QofBook* book)
     return trn;
 }
 
+/***********************************************************************/
+/* The stream parser reads a transaction into a GncXmlTransactionRecord,
+   which then does what dom_tree_to_transaction and dom_tree_to_split
+   do. */
+
+enum trn_field
+{
+    TRN_ID, TRN_CURRENCY, TRN_NUM, TRN_DATE_POSTED, TRN_DATE_ENTERED,
+    TRN_DESCRIPTION, TRN_SLOTS, TRN_SPLITS, TRN_NFIELDS
+};
+
+static const GncXmlField trn_fields[TRN_NFIELDS] =
+{
+    { "trn:id", true },
+    { "trn:currency", false },
+    { "trn:num", false },
+    { "trn:date-posted", true },
+    { "trn:date-entered", true },
+    { "trn:description", false },
+    { "trn:slots", false },
+    { "trn:splits", true },
+};
+
+enum spl_field
+{
+    SPL_ID, SPL_MEMO, SPL_ACTION, SPL_RECONCILED_STATE, SPL_RECONCILE_DATE,
+    SPL_VALUE, SPL_QUANTITY, SPL_ACCOUNT, SPL_LOT, SPL_SLOTS, SPL_NFIELDS
+};
+
+static const GncXmlField spl_fields[SPL_NFIELDS] =
+{
+    { "split:id", true },
+    { "split:memo", false },
+    { "split:action", false },
+    { "split:reconciled-state", true },
+    { "split:reconcile-date", false },
+    { "split:value", true },
+    { "split:quantity", true },
+    { "split:account", true },
+    { "split:lot", false },
+    { "split:slots", false },
+};
+
+/* The set masks say which fields make() passes on: a field can be there
+   without a value to set, like a trn:num with no text. */
+struct GncXmlSplitRecord
+{
+    unsigned gotten = 0;
+    unsigned set = 0;
+    GncXmlGuid id;
+    std::string memo;
+    std::string action;
+    char reconciled = NREC;
+    time64 reconcile_date = 0;
+    gnc_numeric value;
+    gnc_numeric quantity;
+    GncXmlGuid account;
+    GncXmlGuid lot;
+    GncXmlSlotsRecord slots;
+};
+
+class GncXmlTransactionRecord : public GncXmlRecord
+{
+public:
+    bool make (gxpf_data* gdata, const gchar* tag, gpointer* result) override;
+
+    bool ok = true;
+    unsigned set = 0;
+    GncXmlGuid id;
+    GncXmlCommodityRefReader currency;
+    std::string num;
+    time64 date_posted = 0;
+    time64 date_entered = 0;
+    std::string description;
+    GncXmlSlotsRecord slots;
+    /* Up to the first bad one, as trn_splits_handler stops there. */
+    std::vector<GncXmlSplitRecord> splits;
+
+private:
+    Split* make_split (GncXmlSplitRecord& record, QofBook* book);
+};
+
+static inline bool
+field_set (unsigned set, std::size_t field)
+{
+    return set & (1u << field);
+}
+
+/* The fields are set in the order gnc_transaction_dom_tree_create
+   writes them, which is the order the DOM parser sets them in for any
+   file we wrote. */
+Split*
+GncXmlTransactionRecord::make_split (GncXmlSplitRecord& record, QofBook* book)
+{
+    auto split = xaccMallocSplit (book);
+
+    if (field_set (record.set, SPL_ID))
+        xaccSplitSetGUID (split, record.id.get ());
+    if (field_set (record.set, SPL_MEMO))
+        xaccSplitSetMemo (split, record.memo.c_str ());
+    if (field_set (record.set, SPL_ACTION))
+        xaccSplitSetAction (split, record.action.c_str ());
+    if (field_set (record.set, SPL_RECONCILED_STATE))
+        xaccSplitSetReconcile (split, record.reconciled);
+    if (field_set (record.set, SPL_RECONCILE_DATE))
+        xaccSplitSetDateReconciledSecs (split, record.reconcile_date);
+    if (field_set (record.set, SPL_VALUE))
+        xaccSplitSetValue (split, record.value);
+    if (field_set (record.set, SPL_QUANTITY))
+        xaccSplitSetAmount (split, record.quantity);
+    if (field_set (record.set, SPL_ACCOUNT))
+        split_set_account (split, record.account.get (), book);
+    if (field_set (record.set, SPL_LOT))
+        split_set_lot (split, record.lot.get (), book);
+    record.slots.add_to (qof_instance_get_slots (QOF_INSTANCE (split)));
+    qof_instance_slots_changed (QOF_INSTANCE (split));
+    return split;
+}
+
+bool
+GncXmlTransactionRecord::make (gxpf_data* gdata, const gchar* tag,
+                               gpointer* result)
+{
+    auto book = static_cast<QofBook*> (gdata->bookdata);
+
+    if (!ok)
+        return false;
+
+    auto trn = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trn);
+    if (field_set (set, TRN_ID))
+        xaccTransSetGUID (trn, id.get ());
+    if (field_set (set, TRN_CURRENCY))
+        xaccTransSetCurrency (trn, currency.value (book));
+    if (field_set (set, TRN_NUM))
+        xaccTransSetNum (trn, num.c_str ());
+    if (field_set (set, TRN_DATE_POSTED))
+        xaccTransSetDatePostedSecs (trn, date_posted);
+    if (field_set (set, TRN_DATE_ENTERED))
+        xaccTransSetDateEnteredSecs (trn, date_entered);
+    if (field_set (set, TRN_DESCRIPTION))
+        xaccTransSetDescription (trn, description.c_str ());
+    slots.add_to (qof_instance_get_slots (QOF_INSTANCE (trn)));
+    qof_instance_slots_changed (QOF_INSTANCE (trn));
+    for (auto& split : splits)
+        xaccTransAppendSplit (trn, make_split (split, book));
+    xaccTransCommitEdit (trn);
+
+    gdata->cb (tag, gdata->parsedata, trn);
+    return true;
+}
+
+class GncXmlTransactionParser : public GncXmlRecordParser
+{
+public:
+    explicit GncXmlTransactionParser (gxpf_data* gdata)
+        : GncXmlRecordParser {gdata}, m_record {new GncXmlTransactionRecord} {}
+    GncXmlRecord* take_record () override;
+
+protected:
+    void start_element (std::size_t depth, const gchar* tag,
+                        gchar** attrs) override;
+    void end_element (std::size_t depth, const gchar* tag,
+                      const GncXmlElement& element) override;
+
+private:
+    void end_trn_field (const gchar* tag, const GncXmlElement& element);
+    void end_spl_field (const gchar* tag, const GncXmlElement& element);
+    void end_split ();
+    GncXmlSplitRecord& split () { return m_record->splits.back (); }
+
+    std::unique_ptr<GncXmlTransactionRecord> m_record;
+    std::size_t m_field = TRN_NFIELDS;
+    std::size_t m_spl_field = SPL_NFIELDS;
+    unsigned m_gotten = 0;
+    bool m_in_split = false;
+    bool m_split_ok = true;
+    /* trn_splits_handler stops at the first bad split. */
+    bool m_splits_ok = true;
+    GncXmlTimeReader m_time;
+    GncXmlSlotsRecord* m_slots = nullptr;
+};
+
+void
+GncXmlTransactionParser::start_element (std::size_t depth, const gchar* tag,
+                                        gchar** attrs)
+{
+    if (depth == 1)
+    {
+        m_field = gnc_xml_field_lookup (trn_fields, TRN_NFIELDS, tag);
+        m_time.reset ();
+        if (m_field == TRN_CURRENCY)
+            m_record->currency.reset ();
+        else if (m_field == TRN_SLOTS)
+            m_slots = &m_record->slots;
+    }
+    else if (m_field == TRN_SLOTS)
+        m_slots->start_element (tag, attrs);
+    else if (m_field != TRN_SPLITS)
+        return;
+    else if (depth == 2)
+    {
+        if (m_splits_ok && g_strcmp0 (tag, "trn:split") == 0)
+        {
+            m_record->splits.emplace_back ();
+            m_in_split = true;
+            m_split_ok = true;
+        }
+        else
+            m_splits_ok = false;
+    }
+    else if (!m_in_split)
+        return;
+    else if (depth == 3)
+    {
+        m_spl_field = gnc_xml_field_lookup (spl_fields, SPL_NFIELDS, tag);
+        m_time.reset ();
+        if (m_spl_field == SPL_SLOTS)
+            m_slots = &split ().slots;
+    }
+    else if (m_spl_field == SPL_SLOTS)
+        m_slots->start_element (tag, attrs);
+}
+
+void
+GncXmlTransactionParser::end_element (std::size_t depth, const gchar* tag,
+                                      const GncXmlElement& element)
+{
+    if (depth == 1)
+    {
+        end_trn_field (tag, element);
+        return;
+    }
+
+    switch (m_field)
+    {
+    case TRN_CURRENCY:
+        if (depth == 2)
+            m_record->currency.end_element (tag, element);
+        break;
+    case TRN_DATE_POSTED:
+    case TRN_DATE_ENTERED:
+        if (depth == 2)
+            m_time.end_element (tag, element);
+        break;
+    case TRN_SLOTS:
+        m_slots->end_element (tag, element);
+        break;
+    case TRN_SPLITS:
+        if (!m_in_split)
+            break;
+        if (depth == 2)
+            end_split ();
+        else if (depth == 3)
+            end_spl_field (tag, element);
+        else if (m_spl_field == SPL_SLOTS)
+            m_slots->end_element (tag, element);
+        else if (depth == 4 && m_spl_field == SPL_RECONCILE_DATE)
+            m_time.end_element (tag, element);
+        break;
+    default:
+        break;
+    }
+}
+
+void
+GncXmlTransactionParser::end_trn_field (const gchar* tag,
+                                        const GncXmlElement& element)
+{
+    auto& record = *m_record;
+    const gchar* text = element.text ();
+    bool set = true;
+    time64 time;
+
+    switch (m_field)
+    {
+    case TRN_ID:
+        set = record.id.read (element);
+        break;
+    case TRN_CURRENCY:
+        break;
+    case TRN_NUM:
+        set = text != nullptr;
+        if (set)
+            record.num = text;
+        break;
+    case TRN_DATE_POSTED:
+    case TRN_DATE_ENTERED:
+        time = m_time.value ();
+        if (!dom_tree_valid_time64 (time, BAD_CAST tag)) time = 0;
+        if (m_field == TRN_DATE_POSTED)
+            record.date_posted = time;
+        else
+            record.date_entered = time;
+        break;
+    case TRN_DESCRIPTION:
+        set = text != nullptr;
+        if (set)
+            record.description = text;
+        break;
+    case TRN_SLOTS:
+    case TRN_SPLITS:
+        /* Already read as their contents ended. */
+        set = false;
+        break;
+    default:
+        PERR ("Unhandled tag: %s", tag);
+        record.ok = false;
+        return;
+    }
+    m_gotten |= 1u << m_field;
+    if (set)
+        record.set |= 1u << m_field;
+}
+
+void
+GncXmlTransactionParser::end_spl_field (const gchar* tag,
+                                        const GncXmlElement& element)
+{
+    auto& record = split ();
+    const gchar* text = element.text ();
+    bool set = true;
+    time64 time;
+
+    switch (m_spl_field)
+    {
+    case SPL_ID:
+        set = record.id.read (element);
+        break;
+    case SPL_MEMO:
+        set = text != nullptr;
+        if (set)
+            record.memo = text;
+        break;
+    case SPL_ACTION:
+        set = text != nullptr;
+        if (set)
+            record.action = text;
+        break;
+    case SPL_RECONCILED_STATE:
+        set = text != nullptr;
+        if (set)
+            record.reconciled = text[0];
+        break;
+    case SPL_RECONCILE_DATE:
+        time = m_time.value ();
+        if (!dom_tree_valid_time64 (time, BAD_CAST tag)) time = 0;
+        record.reconcile_date = time;
+        break;
+    case SPL_VALUE:
+        set = element.to_numeric (&record.value);
+        break;
+    case SPL_QUANTITY:
+        set = element.to_numeric (&record.quantity);
+        break;
+    case SPL_ACCOUNT:
+        set = record.account.read (element);
+        break;
+    case SPL_LOT:
+        set = record.lot.read (element);
+        break;
+    case SPL_SLOTS:
+        set = false;
+        break;
+    default:
+        PERR ("Unhandled tag: %s", tag);
+        m_split_ok = false;
+        return;
+    }
+    record.gotten |= 1u << m_spl_field;
+    if (set)
+        record.set |= 1u << m_spl_field;
+}
+
+void
+GncXmlTransactionParser::end_split ()
+{
+    if (!m_split_ok ||
+        !gnc_xml_fields_all_gotten (spl_fields, SPL_NFIELDS, split ().gotten))
+    {
+        m_record->splits.pop_back ();
+        m_splits_ok = false;
+    }
+    m_in_split = false;
+}
+
+GncXmlRecord*
+GncXmlTransactionParser::take_record ()
+{
+    if (!gnc_xml_fields_all_gotten (trn_fields, TRN_NFIELDS, m_gotten))
+        m_record->ok = false;
+    return m_record.release ();
+}
+
+static GncXmlRecordParser*
+gnc_transaction_record_parser_new (void)
+{
+    return new GncXmlTransactionParser (nullptr);
+}
+
 sixtp*
 gnc_transaction_sixtp_parser_create (void)
 {
+    if (gnc_prefs_get_file_load_stream_parsers ())
+        return sixtp_stream_parser_new<GncXmlTransactionParser> (NULL, NULL);
     return sixtp_dom_parser_new (gnc_transaction_end_handler, NULL, NULL);
 }
+
+sixtp*
+gnc_transaction_sixtp_parser_create_pipelined (GncXmlPipeline* pipeline,
+                                               const gchar* parent)
+{
+    if (!pipeline)
+        return gnc_transaction_sixtp_parser_create ();
+    return pipeline->add_type ("gnc:transaction", parent,
+                               gnc_transaction_record_parser_new, NULL, NULL);
+}
@@ -176,6 +176,12 @@ GncXmlBackend::session_end()
         return;
     }
 
+    /* Fold the journal of the last auto-saves into the data file, unless
+     * changes since were thrown away and the book is to be dropped. */
+    if (m_book && m_journal && qof_book_session_journaled (m_book)
+        && !qof_book_session_not_saved (m_book))
+        sync (m_book);
+
     if (!m_linkfile.empty())
         g_unlink (m_linkfile.c_str());
 
@@ -202,6 +208,7 @@ GncXmlBackend::session_end()
     m_fullpath.clear();
     m_lockfile.clear();
     m_linkfile.clear();
+    m_journal.reset();
 }
 
 static QofBookFileType
@@ -243,6 +250,8 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
 
     error = ERR_BACKEND_NO_ERR;
     m_book = book;
+    m_loading = true;
+    bool journal_bad = false;
 
     int rc;
     switch (determine_file_type (m_fullpath))
@@ -254,6 +263,18 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
         {
             PWARN ("Syntax error in Xml File %s", m_fullpath.c_str());
             error = ERR_FILEIO_PARSE_ERROR;
+            break;
+        }
+        /* Auto-saves since the file was last written are in its journal. */
+        m_journal.reset (new GncXmlJournal (m_fullpath));
+        if (!m_journal->replay (book))
+        {
+            /* Nothing of a damaged or stale journal was applied, so the
+             * book is the data file alone; keep the journal for whoever
+             * wants to dig the changes out of it, and have the next save
+             * write everything. */
+            m_journal->set_aside ();
+            journal_bad = true;
         }
         break;
 
@@ -296,13 +317,27 @@ GncXmlBackend::load(QofBook* book, QofBackendLoadType loadType)
         break;
     }
 
+    m_loading = false;
     if (error != ERR_BACKEND_NO_ERR)
     {
         set_error(error);
     }
 
-    /* We just got done loading, it can't possibly be dirty !! */
-    qof_book_mark_session_saved (book);
+    /* We just got done loading, it can't possibly be dirty !! Unless it has
+     * changes the data file hasn't, from a journal or lost with one. */
+    if (journal_bad)
+        qof_book_mark_session_dirty (book);
+    else if (m_journal && m_journal->size () > 0)
+        qof_book_mark_session_journaled (book);
+    else
+        qof_book_mark_session_saved (book);
+}
+
+void
+GncXmlBackend::commit (QofInstance* inst)
+{
+    if (m_journal && !m_loading)
+        m_journal->note (inst);
 }
 
 void
@@ -324,10 +359,44 @@ GncXmlBackend::sync(QofBook* book)
         return;
     }
 
-    write_to_file (true);
+    if (write_to_file (true))
+    {
+        if (!m_journal)
+            m_journal.reset (new GncXmlJournal (m_fullpath));
+        m_journal->reset ();
+    }
     remove_old_files();
 }
 
+void
+GncXmlBackend::sync_incremental (QofBook* book)
+{
+    if (m_book == nullptr) m_book = book;
+    if (book != m_book) return;
+
+    /* A big journal takes long to replay; fold it into the data file. The
+     * book can also be dirty without any commit the journal could note. */
+    auto max_size = static_cast<gint64>(gnc_prefs_get_file_journal_max_size ())
+        * 1024 * 1024;
+    if (!gnc_prefs_get_file_save_incremental () || !m_journal
+        || !m_journal->can_append () || !m_journal->has_changes ()
+        || m_journal->size () > max_size || qof_book_is_readonly (m_book))
+    {
+        sync (book);
+        return;
+    }
+
+    if (!m_journal->append (m_book))
+    {
+        PWARN ("Could not append to the journal of %s, writing it in full",
+               m_fullpath.c_str());
+        sync (book);
+        return;
+    }
+    /* The journal still has to go into the data file, so Save stays on. */
+    qof_book_mark_session_journaled (m_book);
+}
+
 bool
 GncXmlBackend::save_may_clobber_data()
 {
@@ -352,6 +421,18 @@ GncXmlBackend::export_coa(QofBook* book)
     fclose(out);
 }
 
+bool
+GncXmlBackend::write_book_file (const char* filename)
+{
+    auto compression = GncXmlCompression::NONE;
+    if (gnc_prefs_get_file_save_compressed ())
+        compression = gnc_prefs_get_file_save_zstd () ? GncXmlCompression::ZSTD
+                                                      : GncXmlCompression::GZIP;
+
+    return gnc_book_write_to_xml_file_v2 (m_book, filename, compression,
+                                          gnc_prefs_get_file_compression_level ());
+}
+
 bool
 GncXmlBackend::write_to_file (bool make_backup)
 {
@@ -400,8 +481,7 @@ GncXmlBackend::write_to_file (bool make_backup)
         }
     }
 
-    if (gnc_book_write_to_xml_file_v2 (m_book, tmp_name,
-                                       gnc_prefs_get_file_save_compressed ()))
+    if (write_book_file (tmp_name))
     {
         /* Record the file's permissions before g_unlinking it */
         GStatBuf statbuf;
@@ -23,9 +23,12 @@ extern "C"
 #include <qof.h>
 }
 
+#include <memory>
 #include <string>
 #include <qof-backend.hpp>
 
+#include "io-gncxml-journal.hpp"
+
 class GncXmlBackend : public QofBackend
 {
 public:
@@ -39,13 +42,21 @@ public:
                        bool ignore_lock, bool create, bool force) override;
     void session_end() override;
     void load(QofBook* book, QofBackendLoadType loadType) override;
-    /* The XML backend isn't able to do anything with individual instances. */
+    /* The XML backend only notes which instances changed, for the journal. */
+    void commit(QofInstance* inst) override;
     void export_coa(QofBook*) override;
     void sync(QofBook* book) override;
+    void sync_incremental(QofBook* book) override;
     void safe_sync(QofBook* book) override { sync(book); } // XML sync is inherently safe.
     const char * get_filename() { return m_fullpath.c_str(); }
     QofBook* get_book() { return m_book; }
 
+protected:
+    /* Write the whole book to filename, in the backend's format. */
+    virtual bool write_book_file(const char* filename);
+
+    QofBook* m_book = nullptr;  /* The primary, main open book */
+
 private:
     bool save_may_clobber_data();
     bool get_file_lock();
@@ -61,6 +72,8 @@ private:
     std::string m_linkfile;
     int m_lockfd;
 
-    QofBook* m_book = nullptr;  /* The primary, main open book */
+    bool m_loading = false;
+    /* Changes since the data file was last written in full, once it was. */
+    std::unique_ptr<GncXmlJournal> m_journal;
 };
 #endif // __GNC_XML_BACKEND_HPP__
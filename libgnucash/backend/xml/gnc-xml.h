@@ -36,6 +36,8 @@ extern "C"
 #include "gnc-xml-helper.h"
 #include "sixtp.h"
 
+class GncXmlPipeline;
+
 xmlNodePtr gnc_account_dom_tree_create (Account* act, gboolean exporting,
                                         gboolean allow_incompat);
 sixtp* gnc_account_sixtp_parser_create (void);
@@ -54,7 +56,11 @@ xmlNodePtr gnc_lot_dom_tree_create (GNCLot*);
 sixtp* gnc_lot_sixtp_parser_create (void);
 
 xmlNodePtr gnc_pricedb_dom_tree_create (GNCPriceDB* db);
+xmlNodePtr gnc_price_dom_tree_create (GNCPrice* price);
 sixtp* gnc_pricedb_sixtp_parser_create (void);
+/** Like gnc_pricedb_sixtp_parser_create, but the prices are read on
+ *  pipeline's worker threads. A NULL pipeline reads them here. */
+sixtp* gnc_pricedb_sixtp_parser_create_pipelined (GncXmlPipeline* pipeline);
 
 xmlNodePtr gnc_schedXaction_dom_tree_create (SchedXaction* sx);
 sixtp* gnc_schedXaction_sixtp_parser_create (void);
@@ -64,6 +70,11 @@ sixtp* gnc_budget_sixtp_parser_create (void);
 
 xmlNodePtr gnc_transaction_dom_tree_create (Transaction* txn);
 sixtp* gnc_transaction_sixtp_parser_create (void);
+/** Like gnc_transaction_sixtp_parser_create for the transactions directly
+ *  inside a parent element, which are read on pipeline's worker threads.
+ *  A NULL pipeline reads them here. */
+sixtp* gnc_transaction_sixtp_parser_create_pipelined (GncXmlPipeline* pipeline,
+                                                      const gchar* parent);
 
 sixtp* gnc_template_transaction_sixtp_parser_create (void);
 
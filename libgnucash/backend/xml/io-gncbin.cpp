@@ -0,0 +1,1196 @@
+/********************************************************************
+ * io-gncbin.cpp -- binary snapshots of a book                      *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <errno.h>
+#include <string.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "gnc-engine.h"
+#include "AccountP.h"
+#include "Scrub.h"
+#include "SplitP.h"
+#include "Transaction.h"
+#include "TransactionP.h"
+#include "TransLog.h"
+#include "gnc-lot.h"
+#include "gnc-lot-p.h"
+#include "gnc-pricedb.h"
+#include "gnc-pricedb-p.h"
+#include "qofinstance-p.h"
+}
+
+#include <kvp-frame.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "io-gncbin.hpp"
+#include "io-gncxml-v2.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+#define GNC_BIN_VERSION 1
+#define GNC_BIN_BYTE_ORDER 0x01020304
+/* A string or a row that isn't there. */
+#define GNC_BIN_NONE G_MAXUINT32
+/* The slots of an instance that has none. */
+#define GNC_BIN_NO_SLOTS G_MAXUINT64
+/* KVP nested deeper than this is taken for a damaged file. */
+#define GNC_BIN_MAX_KVP_DEPTH 64
+/* How many transactions to write or load between progress reports. */
+#define GNC_BIN_PROGRESS_ROWS 10000
+
+static const char gnc_bin_magic[8] = { '\211', 'G', 'N', 'C', 'B', 'I', 'N', '\n' };
+
+struct GncBinHeader
+{
+    char magic[8];
+    guint32 version;
+    guint32 byte_order;
+    guint32 n_sections;
+    guint32 reserved;
+    guint64 file_size;
+};
+
+/* The directory has one of these for each section. A section is count
+   values of width bytes each, starting at offset, which is a multiple of
+   8 so that the columns can be read in place. */
+struct GncBinSection
+{
+    guint32 id;
+    guint32 width;
+    guint64 offset;
+    guint64 count;
+};
+
+/* The sections of a snapshot. New ones go at the end; a reader skips those
+   it doesn't know. */
+enum GncBinSectionId : guint32
+{
+    BIN_STRINGS, BIN_SLOTS,
+    BIN_BOOK_ID, BIN_BOOK_SLOTS,
+    BIN_CMDTY_NAMESPACE, BIN_CMDTY_MNEMONIC, BIN_CMDTY_FULLNAME,
+    BIN_CMDTY_CUSIP, BIN_CMDTY_FRACTION, BIN_CMDTY_QUOTE_FLAG,
+    BIN_CMDTY_QUOTE_SOURCE, BIN_CMDTY_QUOTE_TZ, BIN_CMDTY_SLOTS,
+    BIN_PRICE_ID, BIN_PRICE_COMMODITY, BIN_PRICE_CURRENCY, BIN_PRICE_TIME,
+    BIN_PRICE_SOURCE, BIN_PRICE_TYPE, BIN_PRICE_VALUE,
+    BIN_ACT_ID, BIN_ACT_NAME, BIN_ACT_TYPE, BIN_ACT_PARENT, BIN_ACT_COMMODITY,
+    BIN_ACT_SCU, BIN_ACT_NON_STD_SCU, BIN_ACT_CODE, BIN_ACT_DESCRIPTION,
+    BIN_ACT_SLOTS,
+    BIN_LOT_ID, BIN_LOT_ACCOUNT, BIN_LOT_SLOTS,
+    BIN_TRN_ID, BIN_TRN_CURRENCY, BIN_TRN_NUM, BIN_TRN_DATE_POSTED,
+    BIN_TRN_DATE_ENTERED, BIN_TRN_DESCRIPTION, BIN_TRN_SLOTS,
+    /* Where each transaction's splits start in the split table, and after
+       the last transaction the number of splits. */
+    BIN_TRN_SPLITS,
+    BIN_SPL_ID, BIN_SPL_ACCOUNT, BIN_SPL_LOT, BIN_SPL_MEMO, BIN_SPL_ACTION,
+    BIN_SPL_RECONCILED, BIN_SPL_RECONCILE_DATE, BIN_SPL_VALUE,
+    BIN_SPL_QUANTITY, BIN_SPL_SLOTS,
+    /* The rest of the book, as XML. */
+    BIN_XML,
+    BIN_NSECTIONS
+};
+
+static guint64
+bin_align (guint64 offset)
+{
+    return (offset + 7) & ~static_cast<guint64> (7);
+}
+
+GncBinFileType
+gnc_bin_file_type (const gchar* filename)
+{
+    GncBinHeader header;
+    auto file = g_fopen (filename, "rb");
+    if (!file)
+        return GncBinFileType::NOT_OURS;
+    auto bytes = fread (&header, 1, sizeof (header), file);
+    fclose (file);
+
+    if (bytes != sizeof (header)
+        || memcmp (header.magic, gnc_bin_magic, sizeof (gnc_bin_magic)) != 0)
+        return GncBinFileType::NOT_OURS;
+    if (header.byte_order != GNC_BIN_BYTE_ORDER)
+    {
+        PWARN ("%s is a snapshot from a machine of another byte order",
+               filename);
+        return GncBinFileType::NOT_OURS;
+    }
+    if (header.version > GNC_BIN_VERSION)
+        return GncBinFileType::TOO_NEW;
+    return GncBinFileType::SNAPSHOT;
+}
+
+/***********************************************************************/
+
+/* Builds the sections of a snapshot in memory and writes them out. */
+class GncBinWriter
+{
+public:
+    GncBinWriter (QofBook* book, QofBePercentageFunc percentage)
+        : m_book {book}, m_percentage {percentage}, m_sections (BIN_NSECTIONS) {}
+    bool write (const gchar* filename);
+
+private:
+    struct Section
+    {
+        guint32 width = 0;
+        guint64 count = 0;
+        std::string data;
+    };
+
+    template <typename T> void put (GncBinSectionId id, const T& value)
+    {
+        auto& section = m_sections[id];
+        section.width = sizeof (T);
+        section.count++;
+        section.data.append (reinterpret_cast<const char*> (&value), sizeof (T));
+    }
+    template <typename T> static void append (std::string& blob, const T& value)
+    {
+        blob.append (reinterpret_cast<const char*> (&value), sizeof (T));
+    }
+    template <typename T> static guint32
+    row (const std::unordered_map<const T*, guint32>& rows, const T* object)
+    {
+        auto iter = rows.find (object);
+        return iter == rows.end () ? GNC_BIN_NONE : iter->second;
+    }
+    guint32 rows (GncBinSectionId id) const { return m_sections[id].count; }
+
+    guint32 string (const char* str);
+    guint64 slots (const QofInstance* inst);
+    void add_kvp_frame (std::string& blob, const KvpFrame* frame);
+    void add_kvp_value (std::string& blob, const KvpValue* value);
+    void add_book ();
+    void add_commodities ();
+    void add_prices ();
+    void add_account (const Account* account);
+    void add_accounts ();
+    void add_transaction (const Transaction* trans);
+    void add_transactions ();
+    std::vector<GncBinSection> directory () const;
+    bool write_sections (FILE* out,
+                         const std::vector<GncBinSection>& directory);
+
+    QofBook* m_book;
+    QofBePercentageFunc m_percentage;
+    std::vector<Section> m_sections;
+    std::unordered_map<std::string, guint32> m_strings;
+    std::unordered_map<const gnc_commodity*, guint32> m_commodities;
+    std::unordered_map<const Account*, guint32> m_accounts;
+    std::unordered_map<const GNCLot*, guint32> m_lots;
+    guint64 m_n_transactions = 0;
+};
+
+guint32
+GncBinWriter::string (const char* str)
+{
+    if (!str)
+        return GNC_BIN_NONE;
+
+    auto& pool = m_sections[BIN_STRINGS];
+    auto result = m_strings.emplace (str, pool.data.size ());
+    if (result.second)
+    {
+        pool.data.append (str, strlen (str) + 1);
+        pool.width = 1;
+        pool.count = pool.data.size ();
+    }
+    return result.first->second;
+}
+
+guint64
+GncBinWriter::slots (const QofInstance* inst)
+{
+    auto frame = qof_instance_get_slots (inst);
+    if (!frame || frame->empty ())
+        return GNC_BIN_NO_SLOTS;
+
+    auto& pool = m_sections[BIN_SLOTS];
+    guint64 offset = pool.data.size ();
+    add_kvp_frame (pool.data, frame);
+    pool.width = 1;
+    pool.count = pool.data.size ();
+    return offset;
+}
+
+/* A frame is its number of slots followed by each slot's key and value. */
+void
+GncBinWriter::add_kvp_frame (std::string& blob, const KvpFrame* frame)
+{
+    auto count_at = blob.size ();
+    guint32 count = 0;
+
+    append (blob, count);
+    if (!frame)
+        return;
+    frame->for_each_slot_temp ([&] (const char* key, KvpValue* value)
+    {
+        append (blob, string (key));
+        add_kvp_value (blob, value);
+        ++count;
+    });
+    memcpy (&blob[count_at], &count, sizeof (count));
+}
+
+/* A value is its type as a byte followed by what it holds. */
+void
+GncBinWriter::add_kvp_value (std::string& blob, const KvpValue* value)
+{
+    auto type = value->get_type ();
+    append (blob, static_cast<guint8> (type));
+
+    switch (type)
+    {
+    case KvpValue::Type::INT64:
+        append (blob, value->get<int64_t> ());
+        break;
+    case KvpValue::Type::DOUBLE:
+        append (blob, value->get<double> ());
+        break;
+    case KvpValue::Type::NUMERIC:
+        append (blob, value->get<gnc_numeric> ());
+        break;
+    case KvpValue::Type::STRING:
+        append (blob, string (value->get<const char*> ()));
+        break;
+    case KvpValue::Type::GUID:
+    {
+        auto guid = value->get<GncGUID*> ();
+        append (blob, guid ? *guid : *guid_null ());
+        break;
+    }
+    case KvpValue::Type::TIME64:
+        append (blob, value->get<Time64> ().t);
+        break;
+    case KvpValue::Type::GDATE:
+    {
+        auto date = value->get<GDate> ();
+        guint32 julian = g_date_valid (&date) ? g_date_get_julian (&date) : 0;
+        append (blob, julian);
+        break;
+    }
+    case KvpValue::Type::GLIST:
+    {
+        auto list = value->get<GList*> ();
+        append (blob, static_cast<guint32> (g_list_length (list)));
+        for (auto node = list; node; node = node->next)
+            add_kvp_value (blob, static_cast<KvpValue*> (node->data));
+        break;
+    }
+    case KvpValue::Type::FRAME:
+        add_kvp_frame (blob, value->get<KvpFrame*> ());
+        break;
+    default:
+        /* Nothing to write, and the reader drops it. */
+        break;
+    }
+}
+
+void
+GncBinWriter::add_book ()
+{
+    put (BIN_BOOK_ID, *qof_book_get_guid (m_book));
+    put (BIN_BOOK_SLOTS, slots (QOF_INSTANCE (m_book)));
+}
+
+void
+GncBinWriter::add_commodities ()
+{
+    auto table = gnc_commodity_table_get_table (m_book);
+    auto namespaces = gnc_commodity_table_get_namespaces (table);
+
+    for (auto ns = namespaces; ns; ns = ns->next)
+    {
+        auto commodities = gnc_commodity_table_get_commodities (
+            table, static_cast<const char*> (ns->data));
+
+        for (auto node = commodities; node; node = node->next)
+        {
+            auto commodity = static_cast<gnc_commodity*> (node->data);
+            auto quote_flag = gnc_commodity_get_quote_flag (commodity);
+            auto source = quote_flag ? gnc_commodity_get_quote_source (commodity)
+                                     : NULL;
+
+            m_commodities[commodity] = rows (BIN_CMDTY_NAMESPACE);
+            put (BIN_CMDTY_NAMESPACE,
+                 string (gnc_commodity_get_namespace (commodity)));
+            put (BIN_CMDTY_MNEMONIC,
+                 string (gnc_commodity_get_mnemonic (commodity)));
+            put (BIN_CMDTY_FULLNAME,
+                 string (gnc_commodity_get_fullname (commodity)));
+            put (BIN_CMDTY_CUSIP, string (gnc_commodity_get_cusip (commodity)));
+            put (BIN_CMDTY_FRACTION,
+                 static_cast<gint32> (gnc_commodity_get_fraction (commodity)));
+            put (BIN_CMDTY_QUOTE_FLAG, static_cast<guint8> (quote_flag));
+            put (BIN_CMDTY_QUOTE_SOURCE,
+                 string (source ? gnc_quote_source_get_internal_name (source)
+                                : NULL));
+            put (BIN_CMDTY_QUOTE_TZ,
+                 string (quote_flag ? gnc_commodity_get_quote_tz (commodity)
+                                    : NULL));
+            put (BIN_CMDTY_SLOTS, slots (QOF_INSTANCE (commodity)));
+        }
+        g_list_free (commodities);
+    }
+    g_list_free (namespaces);
+}
+
+void
+GncBinWriter::add_prices ()
+{
+    auto db = gnc_pricedb_get_db (m_book);
+    gnc_pricedb_foreach_price (db, [] (GNCPrice* price, gpointer data) -> gboolean
+    {
+        auto writer = static_cast<GncBinWriter*> (data);
+        auto commodity = writer->row (writer->m_commodities,
+            static_cast<const gnc_commodity*> (gnc_price_get_commodity (price)));
+        auto currency = writer->row (writer->m_commodities,
+            static_cast<const gnc_commodity*> (gnc_price_get_currency (price)));
+
+        /* The XML file can't have these either. */
+        if (commodity == GNC_BIN_NONE || currency == GNC_BIN_NONE)
+            return TRUE;
+
+        writer->put (BIN_PRICE_ID, *gnc_price_get_guid (price));
+        writer->put (BIN_PRICE_COMMODITY, commodity);
+        writer->put (BIN_PRICE_CURRENCY, currency);
+        writer->put (BIN_PRICE_TIME, gnc_price_get_time64 (price));
+        writer->put (BIN_PRICE_SOURCE,
+                     writer->string (gnc_price_get_source_string (price)));
+        writer->put (BIN_PRICE_TYPE,
+                     writer->string (gnc_price_get_typestr (price)));
+        writer->put (BIN_PRICE_VALUE, gnc_price_get_value (price));
+        return TRUE;
+    }, this, TRUE);
+}
+
+void
+GncBinWriter::add_account (const Account* account)
+{
+    auto account_row = rows (BIN_ACT_ID);
+
+    m_accounts[account] = account_row;
+    put (BIN_ACT_ID, *xaccAccountGetGUID (account));
+    put (BIN_ACT_NAME, string (xaccAccountGetName (account)));
+    put (BIN_ACT_TYPE, static_cast<gint32> (xaccAccountGetType (account)));
+    put (BIN_ACT_PARENT,
+         row (m_accounts, static_cast<const Account*> (gnc_account_get_parent (account))));
+    put (BIN_ACT_COMMODITY,
+         row (m_commodities,
+              static_cast<const gnc_commodity*> (xaccAccountGetCommodity (account))));
+    put (BIN_ACT_SCU, static_cast<gint32> (xaccAccountGetCommoditySCUi (account)));
+    put (BIN_ACT_NON_STD_SCU,
+         static_cast<guint8> (xaccAccountGetNonStdSCU (account)));
+    put (BIN_ACT_CODE, string (xaccAccountGetCode (account)));
+    put (BIN_ACT_DESCRIPTION, string (xaccAccountGetDescription (account)));
+    put (BIN_ACT_SLOTS, slots (QOF_INSTANCE (account)));
+
+    auto lots = g_list_sort (xaccAccountGetLotList (account),
+                             qof_instance_guid_compare);
+    for (auto node = lots; node; node = node->next)
+    {
+        auto lot = static_cast<GNCLot*> (node->data);
+        m_lots[lot] = rows (BIN_LOT_ID);
+        put (BIN_LOT_ID, *gnc_lot_get_guid (lot));
+        put (BIN_LOT_ACCOUNT, account_row);
+        put (BIN_LOT_SLOTS, slots (QOF_INSTANCE (lot)));
+    }
+    g_list_free (lots);
+}
+
+/* Parents come before their children, so that a reader can put each
+   account in its place as it makes it. */
+void
+GncBinWriter::add_accounts ()
+{
+    auto root = gnc_book_get_root_account (m_book);
+    auto descendants = gnc_account_get_descendants (root);
+
+    add_account (root);
+    for (auto node = descendants; node; node = node->next)
+        add_account (static_cast<Account*> (node->data));
+    g_list_free (descendants);
+}
+
+void
+GncBinWriter::add_transaction (const Transaction* trans)
+{
+    put (BIN_TRN_ID, *xaccTransGetGUID (trans));
+    put (BIN_TRN_CURRENCY,
+         row (m_commodities,
+              static_cast<const gnc_commodity*> (xaccTransGetCurrency (trans))));
+    put (BIN_TRN_NUM, string (xaccTransGetNum (trans)));
+    put (BIN_TRN_DATE_POSTED, xaccTransRetDatePosted (trans));
+    put (BIN_TRN_DATE_ENTERED, xaccTransRetDateEntered (trans));
+    put (BIN_TRN_DESCRIPTION, string (xaccTransGetDescription (trans)));
+    put (BIN_TRN_SLOTS, slots (QOF_INSTANCE (trans)));
+
+    for (auto node = xaccTransGetSplitList (trans); node; node = node->next)
+    {
+        auto split = static_cast<Split*> (node->data);
+        put (BIN_SPL_ID, *xaccSplitGetGUID (split));
+        put (BIN_SPL_ACCOUNT,
+             row (m_accounts, static_cast<const Account*> (xaccSplitGetAccount (split))));
+        put (BIN_SPL_LOT,
+             row (m_lots, static_cast<const GNCLot*> (xaccSplitGetLot (split))));
+        put (BIN_SPL_MEMO, string (xaccSplitGetMemo (split)));
+        put (BIN_SPL_ACTION, string (xaccSplitGetAction (split)));
+        put (BIN_SPL_RECONCILED, xaccSplitGetReconcile (split));
+        put (BIN_SPL_RECONCILE_DATE, xaccSplitGetDateReconciled (split));
+        put (BIN_SPL_VALUE, xaccSplitGetValue (split));
+        put (BIN_SPL_QUANTITY, xaccSplitGetAmount (split));
+        put (BIN_SPL_SLOTS, slots (QOF_INSTANCE (split)));
+    }
+    put (BIN_TRN_SPLITS, rows (BIN_SPL_ID));
+
+    if (m_percentage && rows (BIN_TRN_ID) % GNC_BIN_PROGRESS_ROWS == 0)
+        m_percentage (NULL, 100.0 * rows (BIN_TRN_ID) / m_n_transactions);
+}
+
+void
+GncBinWriter::add_transactions ()
+{
+    m_n_transactions = MAX (gnc_book_count_transactions (m_book), 1);
+    put (BIN_TRN_SPLITS, static_cast<guint32> (0));
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (m_book),
+                                       [] (Transaction* trans, void* data) -> gint
+    {
+        static_cast<GncBinWriter*> (data)->add_transaction (trans);
+        return 0;
+    }, this);
+}
+
+/* Lay the sections out one after the other, each on an 8 byte boundary,
+   after the header and the directory. */
+std::vector<GncBinSection>
+GncBinWriter::directory () const
+{
+    std::vector<GncBinSection> directory (BIN_NSECTIONS);
+    guint64 offset = bin_align (sizeof (GncBinHeader)
+                                + BIN_NSECTIONS * sizeof (GncBinSection));
+    for (guint32 id = 0; id < BIN_NSECTIONS; ++id)
+    {
+        const auto& section = m_sections[id];
+        directory[id] = { id, section.width, offset, section.count };
+        offset = bin_align (offset + section.data.size ());
+    }
+    return directory;
+}
+
+static bool
+write_header (FILE* out, const std::vector<GncBinSection>& directory,
+              guint64 file_size)
+{
+    GncBinHeader header;
+
+    memcpy (header.magic, gnc_bin_magic, sizeof (header.magic));
+    header.version = GNC_BIN_VERSION;
+    header.byte_order = GNC_BIN_BYTE_ORDER;
+    header.n_sections = directory.size ();
+    header.reserved = 0;
+    header.file_size = file_size;
+    return fwrite (&header, sizeof (header), 1, out) == 1
+           && fwrite (directory.data (), sizeof (GncBinSection),
+                      directory.size (), out) == directory.size ();
+}
+
+/* Write every section but the XML, which is left for the caller to write
+   at the end. */
+bool
+GncBinWriter::write_sections (FILE* out,
+                              const std::vector<GncBinSection>& directory)
+{
+    static const char padding[8] = { 0 };
+    guint64 position = sizeof (GncBinHeader)
+                       + directory.size () * sizeof (GncBinSection);
+
+    for (guint32 id = 0; id < BIN_XML; ++id)
+    {
+        const auto& data = m_sections[id].data;
+        auto pad = directory[id].offset - position;
+        if ((pad && fwrite (padding, 1, pad, out) != pad)
+            || (!data.empty ()
+                && fwrite (data.data (), 1, data.size (), out) != data.size ()))
+            return false;
+        position = directory[id].offset + data.size ();
+    }
+    auto pad = directory[BIN_XML].offset - position;
+    return !pad || fwrite (padding, 1, pad, out) == pad;
+}
+
+bool
+GncBinWriter::write (const gchar* filename)
+{
+    add_book ();
+    add_commodities ();
+    add_prices ();
+    add_accounts ();
+    add_transactions ();
+
+    auto out = g_fopen (filename, "wb");
+    if (!out)
+    {
+        PWARN ("Could not open %s: %s", filename, g_strerror (errno));
+        return false;
+    }
+
+    /* The header is written again once the XML is, with its size and the
+       file's. */
+    auto sections = directory ();
+    auto success = write_header (out, sections, 0)
+                   && write_sections (out, sections)
+                   && gnc_book_write_extras_to_xml_filehandle_v2 (m_book, out);
+    if (success)
+    {
+        auto file_size = ftell (out);
+        auto& xml = sections[BIN_XML];
+        success = file_size >= 0
+                  && static_cast<guint64> (file_size) >= xml.offset;
+        if (success)
+        {
+            xml.width = 1;
+            xml.count = file_size - xml.offset;
+            success = fseek (out, 0, SEEK_SET) == 0
+                      && write_header (out, sections, file_size);
+        }
+    }
+    if (fclose (out) != 0)
+        success = false;
+
+    if (!success)
+        PWARN ("Could not write the snapshot %s", filename);
+    return success;
+}
+
+gboolean
+gnc_book_write_to_bin_file (QofBook* book, const gchar* filename,
+                            QofBePercentageFunc percentage)
+{
+    GncBinWriter writer {book, percentage};
+    return writer.write (filename);
+}
+
+/***********************************************************************/
+
+/* Reads KVP from the slots pool, minding its end. */
+struct GncBinCursor
+{
+    const char* pos;
+    const char* end;
+    bool ok;
+
+    template <typename T> T get ()
+    {
+        T value {};
+        if (end - pos < static_cast<ptrdiff_t> (sizeof (T)))
+        {
+            ok = false;
+            return value;
+        }
+        memcpy (&value, pos, sizeof (T));
+        pos += sizeof (T);
+        return value;
+    }
+};
+
+/* Makes the engine objects of a mapped snapshot. Any reference in it that
+   doesn't check out makes the whole load fail. */
+class GncBinReader
+{
+    struct SplitColumns
+    {
+        const GncGUID* ids;
+        const guint32* accounts;
+        const guint32* lots;
+        const guint32* memos;
+        const guint32* actions;
+        const char* reconciled;
+        const time64* reconcile_dates;
+        const gnc_numeric* values;
+        const gnc_numeric* quantities;
+        const guint64* slots;
+    };
+
+public:
+    GncBinReader (QofBook* book, QofBePercentageFunc percentage)
+        : m_book {book}, m_percentage {percentage}, m_sections (BIN_NSECTIONS) {}
+    GncBinReader (const GncBinReader&) = delete;
+    GncBinReader& operator= (const GncBinReader&) = delete;
+    ~GncBinReader ();
+    bool open (const gchar* filename);
+    bool load ();
+
+private:
+    template <typename T> const T* column (GncBinSectionId id, guint64 count);
+    template <typename T> T* row (const std::vector<T*>& rows, guint32 row);
+    guint64 rows (GncBinSectionId id) const { return m_sections[id].count; }
+    const char* string (guint32 offset);
+    void slots (guint64 offset, QofInstance* inst);
+    void read_kvp_frame (GncBinCursor& cursor, KvpFrame* frame, int depth);
+    KvpValue* read_kvp_value (GncBinCursor& cursor, int depth);
+    void fail (const char* what);
+    void load_book ();
+    void load_commodities ();
+    void load_prices ();
+    void load_accounts ();
+    void load_lots ();
+    void load_transactions ();
+    Split* make_split (const SplitColumns& columns, guint32 row);
+    void load_xml ();
+
+    QofBook* m_book;
+    QofBePercentageFunc m_percentage;
+    GMappedFile* m_file = nullptr;
+    const char* m_data = nullptr;
+    gsize m_size = 0;
+    std::vector<GncBinSection> m_sections;
+    std::vector<gnc_commodity*> m_commodities;
+    std::vector<Account*> m_accounts;
+    std::vector<GNCLot*> m_lots;
+    bool m_ok = true;
+};
+
+GncBinReader::~GncBinReader ()
+{
+    if (m_file)
+        g_mapped_file_unref (m_file);
+}
+
+bool
+GncBinReader::open (const gchar* filename)
+{
+    GError* error = NULL;
+    GncBinHeader header;
+
+    m_file = g_mapped_file_new (filename, FALSE, &error);
+    if (!m_file)
+    {
+        PWARN ("Could not map %s: %s", filename, error->message);
+        g_error_free (error);
+        return false;
+    }
+    m_data = g_mapped_file_get_contents (m_file);
+    m_size = g_mapped_file_get_length (m_file);
+
+    if (m_size < sizeof (header))
+        return false;
+    memcpy (&header, m_data, sizeof (header));
+    if (memcmp (header.magic, gnc_bin_magic, sizeof (gnc_bin_magic)) != 0
+        || header.version != GNC_BIN_VERSION
+        || header.byte_order != GNC_BIN_BYTE_ORDER
+        || header.file_size != m_size
+        || header.n_sections > (m_size - sizeof (header)) / sizeof (GncBinSection))
+    {
+        PWARN ("%s is not a complete snapshot", filename);
+        return false;
+    }
+
+    auto directory = m_data + sizeof (header);
+    for (guint32 i = 0; i < header.n_sections; ++i)
+    {
+        GncBinSection section;
+        memcpy (&section, directory + i * sizeof (section), sizeof (section));
+        if (section.id >= BIN_NSECTIONS)
+            continue;
+        if (section.offset % 8 != 0 || section.offset > m_size
+            || (section.count
+                && (section.width == 0
+                    || section.count > (m_size - section.offset) / section.width)))
+        {
+            PWARN ("Section %u of %s is damaged", section.id, filename);
+            return false;
+        }
+        m_sections[section.id] = section;
+    }
+
+    const auto& strings = m_sections[BIN_STRINGS];
+    if (strings.count && m_data[strings.offset + strings.count - 1] != '\0')
+    {
+        PWARN ("The strings of %s are damaged", filename);
+        return false;
+    }
+    return true;
+}
+
+void
+GncBinReader::fail (const char* what)
+{
+    if (m_ok)
+        PWARN ("Bad %s in the snapshot", what);
+    m_ok = false;
+}
+
+/* The count values of column id, or NULL if there are none. */
+template <typename T> const T*
+GncBinReader::column (GncBinSectionId id, guint64 count)
+{
+    const auto& section = m_sections[id];
+    if (count == 0)
+        return nullptr;
+    if (section.width != sizeof (T) || section.count != count)
+    {
+        fail ("column");
+        return nullptr;
+    }
+    return reinterpret_cast<const T*> (m_data + section.offset);
+}
+
+template <typename T> T*
+GncBinReader::row (const std::vector<T*>& rows, guint32 row)
+{
+    if (row == GNC_BIN_NONE)
+        return nullptr;
+    if (row >= rows.size ())
+    {
+        fail ("row");
+        return nullptr;
+    }
+    return rows[row];
+}
+
+const char*
+GncBinReader::string (guint32 offset)
+{
+    if (offset == GNC_BIN_NONE)
+        return nullptr;
+    if (offset >= m_sections[BIN_STRINGS].count)
+    {
+        fail ("string");
+        return nullptr;
+    }
+    return m_data + m_sections[BIN_STRINGS].offset + offset;
+}
+
+void
+GncBinReader::slots (guint64 offset, QofInstance* inst)
+{
+    const auto& pool = m_sections[BIN_SLOTS];
+
+    if (offset == GNC_BIN_NO_SLOTS)
+        return;
+    if (offset >= pool.count)
+    {
+        fail ("slots");
+        return;
+    }
+
+    GncBinCursor cursor {m_data + pool.offset + offset,
+                         m_data + pool.offset + pool.count, true};
+    read_kvp_frame (cursor, qof_instance_get_slots (inst), 0);
+    qof_instance_slots_changed (inst);
+    if (!cursor.ok)
+        fail ("slots");
+}
+
+void
+GncBinReader::read_kvp_frame (GncBinCursor& cursor, KvpFrame* frame, int depth)
+{
+    auto count = cursor.get<guint32> ();
+    for (guint32 i = 0; i < count && cursor.ok; ++i)
+    {
+        auto key = string (cursor.get<guint32> ());
+        auto value = read_kvp_value (cursor, depth);
+        if (key && value)
+            //We're deleting the old KvpValue returned by set().
+            delete frame->set ({key}, value);
+        else
+            delete value;
+    }
+}
+
+KvpValue*
+GncBinReader::read_kvp_value (GncBinCursor& cursor, int depth)
+{
+    if (depth > GNC_BIN_MAX_KVP_DEPTH)
+    {
+        cursor.ok = false;
+        return nullptr;
+    }
+
+    switch (static_cast<KvpValue::Type> (cursor.get<guint8> ()))
+    {
+    case KvpValue::Type::INT64:
+        return new KvpValue {cursor.get<int64_t> ()};
+    case KvpValue::Type::DOUBLE:
+        return new KvpValue {cursor.get<double> ()};
+    case KvpValue::Type::NUMERIC:
+        return new KvpValue {cursor.get<gnc_numeric> ()};
+    case KvpValue::Type::STRING:
+    {
+        auto str = string (cursor.get<guint32> ());
+        if (!str)
+            return nullptr;
+        const gchar* copy = g_strdup (str);
+        return new KvpValue {copy};
+    }
+    case KvpValue::Type::GUID:
+    {
+        auto guid = guid_malloc ();
+        *guid = cursor.get<GncGUID> ();
+        return new KvpValue {guid};
+    }
+    case KvpValue::Type::TIME64:
+        return new KvpValue {Time64 {cursor.get<time64> ()}};
+    case KvpValue::Type::GDATE:
+    {
+        GDate date;
+        auto julian = cursor.get<guint32> ();
+        g_date_clear (&date, 1);
+        if (g_date_valid_julian (julian))
+            g_date_set_julian (&date, julian);
+        return new KvpValue {date};
+    }
+    case KvpValue::Type::GLIST:
+    {
+        GList* list = NULL;
+        auto count = cursor.get<guint32> ();
+        for (guint32 i = 0; i < count && cursor.ok; ++i)
+        {
+            auto value = read_kvp_value (cursor, depth + 1);
+            if (value)
+                list = g_list_prepend (list, value);
+        }
+        return new KvpValue {g_list_reverse (list)};
+    }
+    case KvpValue::Type::FRAME:
+    {
+        auto frame = new KvpFrame;
+        read_kvp_frame (cursor, frame, depth + 1);
+        return new KvpValue {frame};
+    }
+    default:
+        return nullptr;
+    }
+}
+
+void
+GncBinReader::load_book ()
+{
+    auto ids = column<GncGUID> (BIN_BOOK_ID, 1);
+    auto book_slots = column<guint64> (BIN_BOOK_SLOTS, 1);
+    if (!m_ok)
+        return;
+
+    qof_instance_set_guid (QOF_INSTANCE (m_book), ids);
+    slots (book_slots[0], QOF_INSTANCE (m_book));
+}
+
+/* The commodities are made and inserted into the commodity table the way
+   the XML parser does, so a currency's row ends up as the table's own. */
+void
+GncBinReader::load_commodities ()
+{
+    auto n = rows (BIN_CMDTY_NAMESPACE);
+    auto namespaces = column<guint32> (BIN_CMDTY_NAMESPACE, n);
+    auto mnemonics = column<guint32> (BIN_CMDTY_MNEMONIC, n);
+    auto fullnames = column<guint32> (BIN_CMDTY_FULLNAME, n);
+    auto cusips = column<guint32> (BIN_CMDTY_CUSIP, n);
+    auto fractions = column<gint32> (BIN_CMDTY_FRACTION, n);
+    auto quote_flags = column<guint8> (BIN_CMDTY_QUOTE_FLAG, n);
+    auto quote_sources = column<guint32> (BIN_CMDTY_QUOTE_SOURCE, n);
+    auto quote_tzs = column<guint32> (BIN_CMDTY_QUOTE_TZ, n);
+    auto commodity_slots = column<guint64> (BIN_CMDTY_SLOTS, n);
+    auto table = gnc_commodity_table_get_table (m_book);
+
+    for (guint64 i = 0; i < n && m_ok; ++i)
+    {
+        auto commodity = gnc_commodity_new (m_book, string (fullnames[i]),
+                                            string (namespaces[i]),
+                                            string (mnemonics[i]),
+                                            string (cusips[i]), fractions[i]);
+        if (quote_flags[i])
+        {
+            gnc_commodity_set_quote_flag (commodity, TRUE);
+            if (auto name = string (quote_sources[i]))
+            {
+                auto source = gnc_quote_source_lookup_by_internal (name);
+                if (!source)
+                    source = gnc_quote_source_add_new (name, FALSE);
+                gnc_commodity_set_quote_source (commodity, source);
+            }
+            if (auto tz = string (quote_tzs[i]))
+                gnc_commodity_set_quote_tz (commodity, tz);
+        }
+        slots (commodity_slots[i], QOF_INSTANCE (commodity));
+        m_commodities.push_back (gnc_commodity_table_insert (table, commodity));
+    }
+}
+
+void
+GncBinReader::load_prices ()
+{
+    auto n = rows (BIN_PRICE_ID);
+    auto ids = column<GncGUID> (BIN_PRICE_ID, n);
+    auto commodities = column<guint32> (BIN_PRICE_COMMODITY, n);
+    auto currencies = column<guint32> (BIN_PRICE_CURRENCY, n);
+    auto times = column<time64> (BIN_PRICE_TIME, n);
+    auto sources = column<guint32> (BIN_PRICE_SOURCE, n);
+    auto types = column<guint32> (BIN_PRICE_TYPE, n);
+    auto values = column<gnc_numeric> (BIN_PRICE_VALUE, n);
+    auto db = gnc_pricedb_get_db (m_book);
+
+    gnc_pricedb_set_bulk_update (db, TRUE);
+    for (guint64 i = 0; i < n && m_ok; ++i)
+    {
+        auto price = gnc_price_create (m_book);
+        gnc_price_begin_edit (price);
+        gnc_price_set_guid (price, &ids[i]);
+        gnc_price_set_commodity (price, row (m_commodities, commodities[i]));
+        gnc_price_set_currency (price, row (m_commodities, currencies[i]));
+        gnc_price_set_time64 (price, times[i]);
+        if (auto source = string (sources[i]))
+            gnc_price_set_source_string (price, source);
+        if (auto type = string (types[i]))
+            gnc_price_set_typestr (price, type);
+        gnc_price_set_value (price, values[i]);
+        gnc_price_commit_edit (price);
+        gnc_pricedb_add_price (db, price);
+        gnc_price_unref (price);
+    }
+    gnc_pricedb_set_bulk_update (db, FALSE);
+}
+
+/* Like the XML parser, this leaves the accounts in edit until all the
+   transactions are in, to rebalance each account once. */
+void
+GncBinReader::load_accounts ()
+{
+    auto n = rows (BIN_ACT_ID);
+    auto ids = column<GncGUID> (BIN_ACT_ID, n);
+    auto names = column<guint32> (BIN_ACT_NAME, n);
+    auto types = column<gint32> (BIN_ACT_TYPE, n);
+    auto parents = column<guint32> (BIN_ACT_PARENT, n);
+    auto commodities = column<guint32> (BIN_ACT_COMMODITY, n);
+    auto scus = column<gint32> (BIN_ACT_SCU, n);
+    auto non_std_scus = column<guint8> (BIN_ACT_NON_STD_SCU, n);
+    auto codes = column<guint32> (BIN_ACT_CODE, n);
+    auto descriptions = column<guint32> (BIN_ACT_DESCRIPTION, n);
+    auto account_slots = column<guint64> (BIN_ACT_SLOTS, n);
+
+    for (guint64 i = 0; i < n && m_ok; ++i)
+    {
+        auto account = xaccMallocAccount (m_book);
+        xaccAccountBeginEdit (account);
+        xaccAccountSetGUID (account, &ids[i]);
+        if (auto name = string (names[i]))
+            xaccAccountSetName (account, name);
+        xaccAccountSetType (account, static_cast<GNCAccountType> (types[i]));
+        if (auto commodity = row (m_commodities, commodities[i]))
+        {
+            xaccAccountSetCommodity (account, commodity);
+            xaccAccountSetCommoditySCU (account, scus[i]);
+            if (non_std_scus[i])
+                xaccAccountSetNonStdSCU (account, TRUE);
+        }
+        if (auto code = string (codes[i]))
+            xaccAccountSetCode (account, code);
+        if (auto description = string (descriptions[i]))
+            xaccAccountSetDescription (account, description);
+        slots (account_slots[i], QOF_INSTANCE (account));
+
+        /* Only an account written before this one can be its parent. */
+        auto parent = parents[i] < i ? m_accounts[parents[i]] : nullptr;
+        if (parent)
+            gnc_account_append_child (parent, account);
+        else if (parents[i] != GNC_BIN_NONE)
+            fail ("parent account");
+        else if (types[i] == ACCT_TYPE_ROOT)
+            gnc_book_set_root_account (m_book, account);
+        else
+            gnc_account_append_child (gnc_book_get_root_account (m_book),
+                                      account);
+        m_accounts.push_back (account);
+    }
+}
+
+void
+GncBinReader::load_lots ()
+{
+    auto n = rows (BIN_LOT_ID);
+    auto ids = column<GncGUID> (BIN_LOT_ID, n);
+    auto accounts = column<guint32> (BIN_LOT_ACCOUNT, n);
+    auto lot_slots = column<guint64> (BIN_LOT_SLOTS, n);
+
+    for (guint64 i = 0; i < n && m_ok; ++i)
+    {
+        auto lot = gnc_lot_new (m_book);
+        gnc_lot_set_guid (lot, ids[i]);
+        slots (lot_slots[i], QOF_INSTANCE (lot));
+        if (auto account = row (m_accounts, accounts[i]))
+            xaccAccountInsertLot (account, lot);
+        m_lots.push_back (lot);
+    }
+}
+
+void
+GncBinReader::load_transactions ()
+{
+    auto n = rows (BIN_TRN_ID);
+    auto n_splits = rows (BIN_SPL_ID);
+    auto ids = column<GncGUID> (BIN_TRN_ID, n);
+    auto currencies = column<guint32> (BIN_TRN_CURRENCY, n);
+    auto nums = column<guint32> (BIN_TRN_NUM, n);
+    auto dates_posted = column<time64> (BIN_TRN_DATE_POSTED, n);
+    auto dates_entered = column<time64> (BIN_TRN_DATE_ENTERED, n);
+    auto descriptions = column<guint32> (BIN_TRN_DESCRIPTION, n);
+    auto trans_slots = column<guint64> (BIN_TRN_SLOTS, n);
+    auto splits = column<guint32> (BIN_TRN_SPLITS, n + 1);
+    SplitColumns split_columns {
+        column<GncGUID> (BIN_SPL_ID, n_splits),
+        column<guint32> (BIN_SPL_ACCOUNT, n_splits),
+        column<guint32> (BIN_SPL_LOT, n_splits),
+        column<guint32> (BIN_SPL_MEMO, n_splits),
+        column<guint32> (BIN_SPL_ACTION, n_splits),
+        column<char> (BIN_SPL_RECONCILED, n_splits),
+        column<time64> (BIN_SPL_RECONCILE_DATE, n_splits),
+        column<gnc_numeric> (BIN_SPL_VALUE, n_splits),
+        column<gnc_numeric> (BIN_SPL_QUANTITY, n_splits),
+        column<guint64> (BIN_SPL_SLOTS, n_splits)
+    };
+
+    if (!m_ok)
+        return;
+    if (splits[0] != 0 || splits[n] != n_splits)
+    {
+        fail ("split table");
+        return;
+    }
+
+    for (guint64 i = 0; i < n && m_ok; ++i)
+    {
+        if (splits[i + 1] < splits[i] || splits[i + 1] > n_splits)
+        {
+            fail ("transaction splits");
+            break;
+        }
+
+        auto trans = xaccMallocTransaction (m_book);
+        xaccTransBeginEdit (trans);
+        xaccTransSetGUID (trans, &ids[i]);
+        if (auto currency = row (m_commodities, currencies[i]))
+            xaccTransSetCurrency (trans, currency);
+        if (auto num = string (nums[i]))
+            xaccTransSetNum (trans, num);
+        xaccTransSetDatePostedSecs (trans, dates_posted[i]);
+        xaccTransSetDateEnteredSecs (trans, dates_entered[i]);
+        if (auto description = string (descriptions[i]))
+            xaccTransSetDescription (trans, description);
+        slots (trans_slots[i], QOF_INSTANCE (trans));
+        for (auto split = splits[i]; split < splits[i + 1]; ++split)
+            xaccTransAppendSplit (trans, make_split (split_columns, split));
+        xaccTransCommitEdit (trans);
+
+        if (m_percentage && (i + 1) % GNC_BIN_PROGRESS_ROWS == 0)
+            m_percentage (NULL, 100.0 * (i + 1) / n);
+    }
+}
+
+/* The split is made whole before it goes into its transaction, as
+   dom_tree_to_split does, so that its value and amount come out the
+   same. */
+Split*
+GncBinReader::make_split (const SplitColumns& columns, guint32 split_row)
+{
+    auto split = xaccMallocSplit (m_book);
+
+    xaccSplitSetGUID (split, &columns.ids[split_row]);
+    if (auto memo = string (columns.memos[split_row]))
+        xaccSplitSetMemo (split, memo);
+    if (auto action = string (columns.actions[split_row]))
+        xaccSplitSetAction (split, action);
+    xaccSplitSetReconcile (split, columns.reconciled[split_row]);
+    xaccSplitSetDateReconciledSecs (split, columns.reconcile_dates[split_row]);
+    xaccSplitSetValue (split, columns.values[split_row]);
+    xaccSplitSetAmount (split, columns.quantities[split_row]);
+    if (auto account = row (m_accounts, columns.accounts[split_row]))
+        xaccAccountInsertSplit (account, split);
+    if (auto lot = row (m_lots, columns.lots[split_row]))
+        gnc_lot_add_split (lot, split);
+    slots (columns.slots[split_row], QOF_INSTANCE (split));
+    return split;
+}
+
+void
+GncBinReader::load_xml ()
+{
+    const auto& section = m_sections[BIN_XML];
+    if (section.count
+        && !gnc_book_load_extras_from_xml_buffer_v2 (m_book,
+                                                     m_data + section.offset,
+                                                     section.count))
+        fail ("XML");
+}
+
+bool
+GncBinReader::load ()
+{
+    load_book ();
+    if (m_ok)
+        load_commodities ();
+    if (m_ok)
+        load_prices ();
+    if (m_ok)
+        load_accounts ();
+    if (m_ok)
+        load_lots ();
+    if (m_ok)
+        load_transactions ();
+    if (m_ok)
+        load_xml ();
+    return m_ok;
+}
+
+gboolean
+qof_session_load_from_bin_file (QofBook* book, const gchar* filename,
+                                QofBePercentageFunc percentage)
+{
+    GncBinReader reader {book, percentage};
+    if (!reader.open (filename))
+        return FALSE;
+
+    /* stop logging while we load */
+    xaccLogDisable ();
+    xaccDisableDataScrubbing ();
+    auto success = reader.load ();
+    xaccEnableDataScrubbing ();
+
+    /* fix price quote sources */
+    auto root = gnc_book_get_root_account (book);
+    xaccAccountTreeScrubQuoteSources (root, gnc_commodity_table_get_table (book));
+
+    /* commit all groups, this completes the BeginEdit started when the
+     * accounts were made. */
+    gnc_account_foreach_descendant (root, (AccountCb) xaccAccountCommitEdit,
+                                    NULL);
+    xaccAccountCommitEdit (root);
+
+    /* start logging again */
+    xaccLogEnable ();
+
+    qof_book_mark_session_saved (book);
+    return success;
+}
@@ -0,0 +1,70 @@
+/********************************************************************
+ * io-gncbin.hpp -- binary snapshots of a book                      *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+/* A binary snapshot holds a book as tables of fixed-width columns, one
+   table each for the commodities, prices, accounts, lots, transactions and
+   splits, so that opening it is a matter of mapping the file and making
+   the engine objects straight from the columns; nothing is parsed.
+
+   The file starts with a header and a directory of sections. Each column
+   is a section of fixed-width values; objects refer to each other by their
+   row in the other object's table. Strings are offsets into one pool that
+   holds every distinct string once, and slots are offsets into a pool of
+   KVP frames in a compact binary encoding. What is left of the book --
+   template and scheduled transactions, budgets and the business objects --
+   is in the last section as the same XML a data file would have.
+
+   The numbers in a snapshot are in the byte order of the machine that
+   wrote it, and another machine won't read it; it is meant as a fast local
+   copy, with the XML file as the portable one.
+*/
+
+#ifndef IO_GNCBIN_HPP
+#define IO_GNCBIN_HPP
+
+extern "C"
+{
+#include <qof.h>
+}
+
+enum class GncBinFileType
+{
+    NOT_OURS,
+    SNAPSHOT,
+    /* A snapshot of a later format version than this one reads. */
+    TOO_NEW,
+};
+
+/** What the file named filename is, from its header. */
+GncBinFileType gnc_bin_file_type (const gchar* filename);
+
+/** Write book to a snapshot named filename.
+ *  @param percentage Called now and then with the progress, may be NULL. */
+gboolean gnc_book_write_to_bin_file (QofBook* book, const gchar* filename,
+                                     QofBePercentageFunc percentage);
+
+/** Load the snapshot named filename into book, which has to be empty.
+ *  @param percentage Called now and then with the progress, may be NULL. */
+gboolean qof_session_load_from_bin_file (QofBook* book, const gchar* filename,
+                                         QofBePercentageFunc percentage);
+
+#endif /* IO_GNCBIN_HPP */
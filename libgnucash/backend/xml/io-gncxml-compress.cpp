@@ -0,0 +1,586 @@
+/********************************************************************
+ * io-gncxml-compress.cpp -- gzip and zstd streams for data files   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <glib/gstdio.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+# include <io.h>
+#endif
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+# include <zstd.h>
+#endif
+}
+
+#include <algorithm>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "io-gncxml-compress.hpp"
+
+#ifndef O_BINARY
+# define O_BINARY 0
+#endif
+
+/* The size of the blocks the gzip writer deflates in parallel, the same
+   as pigz's, and of the history each block starts from. */
+#define GZ_BLOCK_SIZE (128 * 1024)
+#define GZ_DICT_SIZE (32 * 1024)
+/* How many blocks per thread may wait to be written. */
+#define GZ_BLOCKS_PER_THREAD 2
+/* The buffer sizes for reading gzip files and for the pipe. */
+#define GZ_READ_BUFFER (256 * 1024)
+#define PIPE_BUFLEN (64 * 1024)
+
+#define ZSTD_MAGIC "\x28\xb5\x2f\xfd"
+
+static gssize
+read_fully (int fd, gchar* buf, gsize size)
+{
+    gsize got = 0;
+    while (got < size)
+    {
+        auto bytes = read (fd, buf + got, size - got);
+        if (bytes < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
+                       g_strerror (errno) ? g_strerror (errno) : "", errno);
+            return -1;
+        }
+        if (bytes == 0)
+            break;
+        got += bytes;
+    }
+    return got;
+}
+
+static gboolean
+write_fully (int fd, const void* data, gsize size, const gchar* filename)
+{
+    auto buf = static_cast<const gchar*> (data);
+    while (size > 0)
+    {
+        auto bytes = write (fd, buf, size);
+        if (bytes < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            g_warning ("Could not write to '%s'. The error is '%s' (errno %d)",
+                       filename, g_strerror (errno) ? g_strerror (errno) : "",
+                       errno);
+            return FALSE;
+        }
+        buf += bytes;
+        size -= bytes;
+    }
+    return TRUE;
+}
+
+GncXmlCompression
+gnc_xml_file_compression (const gchar* filename)
+{
+    unsigned char buf[4];
+    int fd = g_open (filename, O_RDONLY | O_BINARY, 0);
+
+    if (fd == -1)
+        return GncXmlCompression::NONE;
+
+    auto bytes = read (fd, buf, sizeof (buf));
+    close (fd);
+
+    if (bytes >= 2 && buf[0] == 037 && buf[1] == 0213)
+        return GncXmlCompression::GZIP;
+    if (bytes == sizeof (buf) && memcmp (buf, ZSTD_MAGIC, sizeof (buf)) == 0)
+        return GncXmlCompression::ZSTD;
+    return GncXmlCompression::NONE;
+}
+
+gboolean
+gnc_xml_compression_supported (GncXmlCompression type)
+{
+#ifndef HAVE_ZSTD
+    if (type == GncXmlCompression::ZSTD)
+        return FALSE;
+#endif
+    return TRUE;
+}
+
+/* gzip */
+
+struct GzBlock
+{
+    std::vector<gchar> in;
+    std::vector<gchar> dict;
+    std::vector<Bytef> out;
+    uLong crc;
+    gboolean last;
+    gboolean done;
+    gboolean ok;
+};
+
+struct GzWriter
+{
+    gint level;
+    GMutex mutex;
+    GCond cond;
+};
+
+/* Deflate one block to raw deflate data that continues the blocks before
+   it: it may refer back into their last 32 KiB and it ends on a byte
+   boundary with a sync flush, except for the last one, which finishes the
+   stream. */
+static void
+gz_deflate_block (GzBlock* block, GzWriter* writer)
+{
+    z_stream strm;
+    memset (&strm, 0, sizeof (strm));
+
+    block->crc = crc32 (crc32 (0L, Z_NULL, 0),
+                        reinterpret_cast<const Bytef*> (block->in.data ()),
+                        block->in.size ());
+    block->ok = deflateInit2 (&strm, writer->level, Z_DEFLATED, -MAX_WBITS,
+                              8, Z_DEFAULT_STRATEGY) == Z_OK;
+    if (block->ok && !block->dict.empty ())
+        block->ok = deflateSetDictionary (
+            &strm, reinterpret_cast<const Bytef*> (block->dict.data ()),
+            block->dict.size ()) == Z_OK;
+    if (block->ok)
+    {
+        /* Room for the sync flush marker on top of the bound. */
+        block->out.resize (deflateBound (&strm, block->in.size ()) + 16);
+        strm.next_in = reinterpret_cast<Bytef*> (block->in.data ());
+        strm.avail_in = block->in.size ();
+        strm.next_out = block->out.data ();
+        strm.avail_out = block->out.size ();
+        auto rc = deflate (&strm, block->last ? Z_FINISH : Z_SYNC_FLUSH);
+        block->ok = (block->last ? rc == Z_STREAM_END : rc == Z_OK)
+                    && strm.avail_in == 0;
+        block->out.resize (block->out.size () - strm.avail_out);
+    }
+    deflateEnd (&strm);
+
+    g_mutex_lock (&writer->mutex);
+    block->done = TRUE;
+    g_cond_broadcast (&writer->cond);
+    g_mutex_unlock (&writer->mutex);
+}
+
+static void
+gz_pool_func (gpointer data, gpointer user_data)
+{
+    gz_deflate_block (static_cast<GzBlock*> (data),
+                      static_cast<GzWriter*> (user_data));
+}
+
+static void
+put_le32 (unsigned char* buf, guint32 value)
+{
+    for (int i = 0; i < 4; ++i)
+        buf[i] = (value >> (8 * i)) & 0xff;
+}
+
+static gboolean
+gz_compress (int in_fd, int out_fd, gint level, guint threads,
+             const gchar* filename)
+{
+    GzWriter writer;
+    writer.level = level;
+    g_mutex_init (&writer.mutex);
+    g_cond_init (&writer.cond);
+
+    GThreadPool* pool = NULL;
+    if (threads > 1)
+        pool = g_thread_pool_new (gz_pool_func, &writer, threads, TRUE, NULL);
+
+    std::deque<std::unique_ptr<GzBlock>> queue;
+    uLong crc = crc32 (0L, Z_NULL, 0);
+    guint32 total = 0;
+
+    /* Hand the block at the front to the file once it is deflated. */
+    auto write_front = [&] () -> gboolean
+    {
+        auto block = queue.front ().get ();
+        g_mutex_lock (&writer.mutex);
+        while (!block->done)
+            g_cond_wait (&writer.cond, &writer.mutex);
+        g_mutex_unlock (&writer.mutex);
+
+        if (!block->ok)
+        {
+            g_warning ("Could not compress the data for '%s'", filename);
+            return FALSE;
+        }
+        if (!write_fully (out_fd, block->out.data (), block->out.size (),
+                          filename))
+            return FALSE;
+        crc = crc32_combine (crc, block->crc, block->in.size ());
+        total += block->in.size ();
+        queue.pop_front ();
+        return TRUE;
+    };
+
+    /* A plain gzip header: no name, no time stamp. */
+    unsigned char header[10] = { 037, 0213, Z_DEFLATED, 0, 0, 0, 0, 0, 0, 3 };
+    header[8] = level == 9 ? 2 : level == 1 ? 4 : 0;
+    gboolean success = write_fully (out_fd, header, sizeof (header), filename);
+
+    /* Read one block ahead to know which one is the last. */
+    std::unique_ptr<GzBlock> next (new GzBlock ());
+    next->in.resize (GZ_BLOCK_SIZE);
+    auto bytes = success ? read_fully (in_fd, next->in.data (), GZ_BLOCK_SIZE)
+                         : -1;
+    std::vector<gchar> history;
+    while (bytes >= 0)
+    {
+        std::unique_ptr<GzBlock> block (std::move (next));
+        block->in.resize (bytes);
+        block->dict = history;
+        block->done = FALSE;
+
+        if (!block->in.empty ())
+        {
+            next.reset (new GzBlock ());
+            next->in.resize (GZ_BLOCK_SIZE);
+            bytes = read_fully (in_fd, next->in.data (), GZ_BLOCK_SIZE);
+            if (bytes < 0)
+            {
+                success = FALSE;
+                break;
+            }
+        }
+        block->last = block->in.empty () || bytes == 0;
+
+        auto tail = std::min<gsize> (block->in.size (), GZ_DICT_SIZE);
+        if (tail == GZ_DICT_SIZE)
+            history.assign (block->in.end () - tail, block->in.end ());
+        else
+            history.insert (history.end (), block->in.begin (),
+                            block->in.end ());
+        if (history.size () > GZ_DICT_SIZE)
+            history.erase (history.begin (),
+                           history.end () - GZ_DICT_SIZE);
+
+        auto last = block->last;
+        queue.push_back (std::move (block));
+        if (pool)
+            g_thread_pool_push (pool, queue.back ().get (), NULL);
+        else
+            gz_deflate_block (queue.back ().get (), &writer);
+
+        while (success && queue.size () > threads * GZ_BLOCKS_PER_THREAD)
+            success = write_front ();
+        if (!success || last)
+            break;
+    }
+    if (bytes < 0)
+        success = FALSE;
+
+    while (success && !queue.empty ())
+        success = write_front ();
+
+    if (pool)
+        g_thread_pool_free (pool, FALSE, TRUE);
+    g_mutex_clear (&writer.mutex);
+    g_cond_clear (&writer.cond);
+
+    if (success)
+    {
+        unsigned char trailer[8];
+        put_le32 (trailer, crc);
+        put_le32 (trailer + 4, total);
+        success = write_fully (out_fd, trailer, sizeof (trailer), filename);
+    }
+    return success;
+}
+
+static gzFile
+gz_open_fd (int fd)
+{
+    /* gzclose closes the descriptor it was given, which isn't ours. */
+    int dup_fd = dup (fd);
+    if (dup_fd < 0)
+        return NULL;
+
+    gzFile file = gzdopen (dup_fd, "rb");
+    if (file == NULL)
+    {
+        close (dup_fd);
+        return NULL;
+    }
+    gzbuffer (file, GZ_READ_BUFFER);
+    return file;
+}
+
+static gboolean
+gz_decompress (int in_fd, int out_fd, const gchar* filename)
+{
+    gzFile file = gz_open_fd (in_fd);
+    if (file == NULL)
+    {
+        g_warning ("Could not open the compressed file '%s'", filename);
+        return FALSE;
+    }
+
+    std::vector<gchar> buffer (PIPE_BUFLEN);
+    gboolean success = TRUE;
+    while (success)
+    {
+        auto gzval = gzread (file, buffer.data (), buffer.size ());
+        if (gzval > 0)
+            success = write_fully (out_fd, buffer.data (), gzval, "pipe");
+        else if (gzval == 0)
+            break;
+        else
+        {
+            gint errnum;
+            const gchar* error = gzerror (file, &errnum);
+            g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
+                       filename, error, errnum);
+            success = FALSE;
+        }
+    }
+
+    auto gzval = gzclose (file);
+    if (gzval != Z_OK)
+    {
+        g_warning ("Could not close the compressed file '%s' (errnum %d)",
+                   filename, gzval);
+        success = FALSE;
+    }
+    return success;
+}
+
+/* zstd */
+
+#ifdef HAVE_ZSTD
+static gboolean
+zstd_compress (int in_fd, int out_fd, gint level, guint threads,
+               const gchar* filename)
+{
+    auto cctx = ZSTD_createCCtx ();
+    if (!cctx)
+        return FALSE;
+
+    ZSTD_CCtx_setParameter (cctx, ZSTD_c_compressionLevel, level);
+    ZSTD_CCtx_setParameter (cctx, ZSTD_c_checksumFlag, 1);
+    /* Fails harmlessly if libzstd was built without threads. */
+    if (threads > 1)
+        ZSTD_CCtx_setParameter (cctx, ZSTD_c_nbWorkers, threads);
+
+    std::vector<gchar> in_buf (ZSTD_CStreamInSize ());
+    std::vector<gchar> out_buf (ZSTD_CStreamOutSize ());
+    gboolean success = TRUE;
+    gboolean finished = FALSE;
+    while (success && !finished)
+    {
+        auto bytes = read_fully (in_fd, in_buf.data (), in_buf.size ());
+        if (bytes < 0)
+        {
+            success = FALSE;
+            break;
+        }
+        finished = static_cast<gsize> (bytes) < in_buf.size ();
+        auto mode = finished ? ZSTD_e_end : ZSTD_e_continue;
+
+        ZSTD_inBuffer input = { in_buf.data (), static_cast<gsize> (bytes), 0 };
+        gsize remaining;
+        do
+        {
+            ZSTD_outBuffer output = { out_buf.data (), out_buf.size (), 0 };
+            remaining = ZSTD_compressStream2 (cctx, &output, &input, mode);
+            if (ZSTD_isError (remaining))
+            {
+                g_warning ("Could not write the compressed file '%s'. The error is: '%s'",
+                           filename, ZSTD_getErrorName (remaining));
+                success = FALSE;
+                break;
+            }
+            success = write_fully (out_fd, out_buf.data (), output.pos,
+                                   filename);
+        }
+        while (success && (finished ? remaining != 0
+                                    : input.pos < input.size));
+    }
+
+    ZSTD_freeCCtx (cctx);
+    return success;
+}
+
+/* Decompress in_fd until its end or until limit bytes came out, handing
+   the output to sink. */
+template <typename Sink> static gboolean
+zstd_decompress_to (int in_fd, gsize limit, Sink sink, const gchar* filename)
+{
+    auto dctx = ZSTD_createDCtx ();
+    if (!dctx)
+        return FALSE;
+
+    std::vector<gchar> in_buf (ZSTD_DStreamInSize ());
+    std::vector<gchar> out_buf (ZSTD_DStreamOutSize ());
+    gboolean success = TRUE;
+    gsize produced = 0;
+    gsize pending = 0;
+    while (success && produced < limit)
+    {
+        auto bytes = read_fully (in_fd, in_buf.data (), in_buf.size ());
+        if (bytes <= 0)
+        {
+            if (bytes < 0 || pending != 0)
+            {
+                g_warning ("The compressed file '%s' is truncated", filename);
+                success = FALSE;
+            }
+            break;
+        }
+
+        ZSTD_inBuffer input = { in_buf.data (), static_cast<gsize> (bytes), 0 };
+        /* A full output buffer may leave more output in the context. */
+        gboolean full = FALSE;
+        while (success && (input.pos < input.size || full) && produced < limit)
+        {
+            ZSTD_outBuffer output =
+                { out_buf.data (), MIN (out_buf.size (), limit - produced), 0 };
+            pending = ZSTD_decompressStream (dctx, &output, &input);
+            full = output.pos == output.size;
+            if (ZSTD_isError (pending))
+            {
+                g_warning ("Could not read from compressed file '%s'. The error is: '%s'",
+                           filename, ZSTD_getErrorName (pending));
+                success = FALSE;
+                break;
+            }
+            success = sink (out_buf.data (), output.pos);
+            produced += output.pos;
+        }
+    }
+
+    ZSTD_freeDCtx (dctx);
+    return success;
+}
+#endif
+
+gboolean
+gnc_xml_compress_fd (int in_fd, int out_fd, GncXmlCompression type,
+                     gint level, guint threads, const gchar* filename)
+{
+    level = CLAMP (level, 1, 9);
+    if (threads == 0)
+        threads = g_get_num_processors ();
+
+    switch (type)
+    {
+    case GncXmlCompression::GZIP:
+        return gz_compress (in_fd, out_fd, level, threads, filename);
+    case GncXmlCompression::ZSTD:
+#ifdef HAVE_ZSTD
+        return zstd_compress (in_fd, out_fd, level, threads, filename);
+#else
+        g_warning ("Cannot write '%s': GnuCash was built without zstd",
+                   filename);
+        return FALSE;
+#endif
+    case GncXmlCompression::NONE:
+        break;
+    }
+
+    std::vector<gchar> buffer (PIPE_BUFLEN);
+    gssize bytes;
+    while ((bytes = read_fully (in_fd, buffer.data (), buffer.size ())) > 0)
+        if (!write_fully (out_fd, buffer.data (), bytes, filename))
+            return FALSE;
+    return bytes == 0;
+}
+
+gboolean
+gnc_xml_decompress_fd (int in_fd, int out_fd, GncXmlCompression type,
+                       const gchar* filename)
+{
+    switch (type)
+    {
+    case GncXmlCompression::GZIP:
+        return gz_decompress (in_fd, out_fd, filename);
+    case GncXmlCompression::ZSTD:
+#ifdef HAVE_ZSTD
+        return zstd_decompress_to (in_fd, G_MAXSIZE,
+                                   [out_fd] (const gchar* data, gsize size)
+                                   {
+                                       return write_fully (out_fd, data, size,
+                                                           "pipe");
+                                   }, filename);
+#else
+        g_warning ("Cannot read '%s': GnuCash was built without zstd",
+                   filename);
+        return FALSE;
+#endif
+    case GncXmlCompression::NONE:
+        break;
+    }
+    return gnc_xml_compress_fd (in_fd, out_fd, type, 0, 1, filename);
+}
+
+gssize
+gnc_xml_decompress_head (int in_fd, GncXmlCompression type, gchar* buf,
+                         gsize size)
+{
+    switch (type)
+    {
+    case GncXmlCompression::GZIP:
+    {
+        gzFile file = gz_open_fd (in_fd);
+        if (file == NULL)
+            return -1;
+        auto bytes = gzread (file, buf, size);
+        gzclose (file);
+        return bytes;
+    }
+    case GncXmlCompression::ZSTD:
+    {
+#ifdef HAVE_ZSTD
+        gsize got = 0;
+        auto sink = [buf, &got] (const gchar* data, gsize bytes)
+        {
+            memcpy (buf + got, data, bytes);
+            got += bytes;
+            return TRUE;
+        };
+        if (!zstd_decompress_to (in_fd, size, sink, "data file") && got == 0)
+            return -1;
+        return got;
+#else
+        return -1;
+#endif
+    }
+    case GncXmlCompression::NONE:
+        break;
+    }
+    return read_fully (in_fd, buf, size);
+}
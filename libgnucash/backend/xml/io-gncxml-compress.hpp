@@ -0,0 +1,77 @@
+/********************************************************************
+ * io-gncxml-compress.hpp -- gzip and zstd streams for data files   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+/* The helpers here move a whole data file between a file descriptor and a
+   pipe. They run on the (de)compression thread of io-gncxml-v2.cpp.
+
+   gzip files are written pigz style: the input is cut into blocks that a
+   pool of threads deflates independently, each primed with the last 32 KiB
+   of the block before it, and the results are joined into one ordinary
+   gzip member that any gunzip or older GnuCash reads.
+
+   zstd files need GnuCash to be built with libzstd (HAVE_ZSTD).
+*/
+
+#ifndef IO_GNCXML_COMPRESS_HPP
+#define IO_GNCXML_COMPRESS_HPP
+
+extern "C"
+{
+#include <glib.h>
+}
+
+enum class GncXmlCompression
+{
+    NONE,
+    GZIP,
+    ZSTD,
+};
+
+/** The compression of the file named filename, from its magic bytes.
+ *  NONE if it isn't compressed or can't be read. */
+GncXmlCompression gnc_xml_file_compression (const gchar* filename);
+
+/** Whether this build can read and write files compressed as type. */
+gboolean gnc_xml_compression_supported (GncXmlCompression type);
+
+/** Read in_fd to its end and write it to out_fd, compressed as type.
+ *
+ *  @param level 1 (fastest) to 9 (smallest).
+ *  @param threads The number of threads compressing, 0 for one per
+ *  processor.
+ *  @param filename The name of out_fd's file, for messages.
+ */
+gboolean gnc_xml_compress_fd (int in_fd, int out_fd, GncXmlCompression type,
+                              gint level, guint threads,
+                              const gchar* filename);
+
+/** Read the file in in_fd, compressed as type, and write it uncompressed to
+ *  out_fd. */
+gboolean gnc_xml_decompress_fd (int in_fd, int out_fd, GncXmlCompression type,
+                                const gchar* filename);
+
+/** Decompress at most size bytes from the start of the file in in_fd.
+ *  @return The number of bytes put in buf, -1 on errors. */
+gssize gnc_xml_decompress_head (int in_fd, GncXmlCompression type,
+                                gchar* buf, gsize size);
+
+#endif /* IO_GNCXML_COMPRESS_HPP */
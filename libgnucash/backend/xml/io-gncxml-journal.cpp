@@ -0,0 +1,518 @@
+/********************************************************************
+ * io-gncxml-journal.cpp -- journal of auto-saved changes           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include <config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "gnc-engine.h"
+#include "gnc-pricedb-p.h"
+#include "Transaction.h"
+#include "TransactionP.h"
+}
+
+#include "gnc-xml.h"
+#include "sixtp.h"
+#include "sixtp-parsers.h"
+#include "sixtp-dom-parsers.h"
+#include "io-gncxml-journal.hpp"
+
+#include <vector>
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+#define JOURNAL_SUFFIX ".journal"
+#define JOURNAL_TAG "gnc-journal"
+#define BASE_TAG "journal:base"
+#define SAVE_TAG "journal:save"
+#define DELETE_TAG "journal:delete"
+#define TRANSACTION_TAG "gnc:transaction"
+#define PRICE_TAG "price"
+
+GncXmlJournal::GncXmlJournal (const std::string& datafile) :
+    m_datafile{datafile}, m_filename{datafile + JOURNAL_SUFFIX}
+{
+}
+
+/* Template transactions belong to their scheduled transaction, which isn't
+   journaled. */
+static bool
+is_template_transaction (Transaction* trans)
+{
+    auto split = xaccTransGetSplit (trans, 0);
+    auto account = split ? xaccSplitGetAccount (split) : nullptr;
+    if (!account)
+        return false;
+    auto book = qof_instance_get_book (QOF_INSTANCE (trans));
+    return gnc_account_get_root (account) == gnc_book_get_template_root (book);
+}
+
+void
+GncXmlJournal::note (QofInstance* inst)
+{
+    if (!qof_instance_get_dirty_flag (inst) && !qof_instance_get_destroying (inst))
+        return;
+
+    Transaction* trans = nullptr;
+    if (g_strcmp0 (inst->e_type, GNC_ID_TRANS) == 0)
+        trans = GNC_TRANS (inst);
+    else if (g_strcmp0 (inst->e_type, GNC_ID_SPLIT) == 0)
+        trans = xaccSplitGetParent (GNC_SPLIT (inst));
+    else if (g_strcmp0 (inst->e_type, GNC_ID_PRICE) == 0)
+        m_prices.insert (*qof_instance_get_guid (inst));
+    /* Committing the price DB only adds or removes a price, and that price
+       is committed too. */
+    else if (g_strcmp0 (inst->e_type, GNC_ID_PRICEDB) != 0)
+        m_untracked = true;
+
+    if (trans && is_template_transaction (trans))
+        m_untracked = true;
+    else if (trans)
+        m_transactions.insert (*qof_instance_get_guid (QOF_INSTANCE (trans)));
+}
+
+gint64
+GncXmlJournal::size () const
+{
+    GStatBuf statbuf;
+    if (g_stat (m_filename.c_str (), &statbuf) != 0)
+        return 0;
+    return statbuf.st_size;
+}
+
+static bool
+stat_base (const std::string& datafile, gint64* size, gint64* mtime)
+{
+    GStatBuf statbuf;
+    if (g_stat (datafile.c_str (), &statbuf) != 0)
+        return false;
+    *size = statbuf.st_size;
+    *mtime = statbuf.st_mtime;
+    return true;
+}
+
+bool
+GncXmlJournal::base_unchanged () const
+{
+    gint64 size, mtime;
+    return stat_base (m_datafile, &size, &mtime)
+           && size == m_base_size && mtime == m_base_mtime;
+}
+
+static xmlNodePtr
+delete_dom_tree_create (const char* type, const GncGUID* guid)
+{
+    gchar guidstr[GUID_ENCODING_LENGTH + 1];
+    auto node = xmlNewNode (NULL, BAD_CAST DELETE_TAG);
+    guid_to_string_buff (guid, guidstr);
+    xmlSetProp (node, BAD_CAST "type", BAD_CAST type);
+    xmlSetProp (node, BAD_CAST "guid", BAD_CAST guidstr);
+    return node;
+}
+
+static bool
+write_node (FILE* out, xmlNodePtr node)
+{
+    if (!node)
+        return false;
+    xmlElemDump (out, NULL, node);
+    xmlFreeNode (node);
+    return !ferror (out) && fprintf (out, "\n") >= 0;
+}
+
+bool
+GncXmlJournal::append (QofBook* book)
+{
+    if (!can_append ())
+        return false;
+    if (m_transactions.empty () && m_prices.empty ())
+        return true;
+
+    /* A journal that doesn't belong to the data file any more can't be
+       added to. */
+    bool new_journal = size () == 0;
+    if (!new_journal && !base_unchanged ())
+        return false;
+    if (new_journal && !stat_base (m_datafile, &m_base_size, &m_base_mtime))
+        return false;
+
+    auto out = g_fopen (m_filename.c_str (), new_journal ? "wb" : "ab");
+    if (!out)
+    {
+        PWARN ("Could not open %s: %s", m_filename.c_str (),
+               g_strerror (errno));
+        return false;
+    }
+
+    bool ok = true;
+    if (new_journal)
+        ok = fprintf (out, "<" BASE_TAG " size=\"%" G_GINT64_FORMAT "\""
+                      " mtime=\"%" G_GINT64_FORMAT "\"/>\n",
+                      m_base_size, m_base_mtime) >= 0;
+    ok = ok && fprintf (out, "<" SAVE_TAG ">\n") >= 0;
+
+    for (auto guid = m_transactions.begin ();
+         ok && guid != m_transactions.end (); ++guid)
+    {
+        auto trans = xaccTransLookup (&*guid, book);
+        if (trans && !qof_instance_get_destroying (QOF_INSTANCE (trans)))
+            ok = write_node (out, gnc_transaction_dom_tree_create (trans));
+        else
+            ok = write_node (out, delete_dom_tree_create (GNC_ID_TRANS, &*guid));
+    }
+
+    for (auto guid = m_prices.begin (); ok && guid != m_prices.end (); ++guid)
+    {
+        /* A price that isn't in the price DB is as good as deleted. */
+        auto price = gnc_price_lookup (&*guid, book);
+        if (price && price->db
+            && !qof_instance_get_destroying (QOF_INSTANCE (price)))
+            ok = write_node (out, gnc_price_dom_tree_create (price));
+        else
+            ok = write_node (out, delete_dom_tree_create (GNC_ID_PRICE, &*guid));
+    }
+
+    ok = ok && fprintf (out, "</" SAVE_TAG ">\n") >= 0;
+    ok = fclose (out) == 0 && ok;
+    if (!ok)
+    {
+        /* What made it into the file ends in a torn save; leave the journal
+           to the next full save. */
+        PWARN ("Could not write to %s", m_filename.c_str ());
+        m_broken = true;
+        return false;
+    }
+
+    m_transactions.clear ();
+    m_prices.clear ();
+    return true;
+}
+
+static gboolean
+journal_dom_tree_end_handler (gpointer data_for_children,
+                              GSList* data_from_children, GSList* sibling_data,
+                              gpointer parent_data, gpointer global_data,
+                              gpointer* result, const gchar* tag)
+{
+    /* Only the root element, and not the second call with a NULL tag. */
+    if (parent_data || !tag)
+        return TRUE;
+
+    *static_cast<xmlNodePtr*> (global_data) =
+        static_cast<xmlNodePtr> (data_for_children);
+    return TRUE;
+}
+
+/* The GncGUID and type of a journal record. */
+static bool
+record_guid (xmlNodePtr node, const char** type, GncGUID* guid)
+{
+    const char* id_tag = nullptr;
+    if (g_strcmp0 ((char*)node->name, TRANSACTION_TAG) == 0)
+    {
+        *type = GNC_ID_TRANS;
+        id_tag = "trn:id";
+    }
+    else if (g_strcmp0 ((char*)node->name, PRICE_TAG) == 0)
+    {
+        *type = GNC_ID_PRICE;
+        id_tag = "price:id";
+    }
+    else if (g_strcmp0 ((char*)node->name, DELETE_TAG) == 0)
+    {
+        auto typestr = (char*)xmlGetProp (node, BAD_CAST "type");
+        auto guidstr = (char*)xmlGetProp (node, BAD_CAST "guid");
+        bool ok = guidstr && string_to_guid (guidstr, guid);
+        if (g_strcmp0 (typestr, GNC_ID_TRANS) == 0)
+            *type = GNC_ID_TRANS;
+        else if (g_strcmp0 (typestr, GNC_ID_PRICE) == 0)
+            *type = GNC_ID_PRICE;
+        else
+            ok = false;
+        xmlFree (typestr);
+        xmlFree (guidstr);
+        return ok;
+    }
+    else
+        return false;
+
+    for (auto child = node->xmlChildrenNode; child; child = child->next)
+    {
+        if (g_strcmp0 ((char*)child->name, id_tag) != 0)
+            continue;
+        auto id = dom_tree_to_guid (child);
+        if (!id)
+            return false;
+        *guid = *id;
+        guid_free (id);
+        return true;
+    }
+    return false;
+}
+
+/* Put the commodity that the child tag of node refers to in book into
+   scratch as well, for a record read into scratch to find. */
+static void
+twin_commodity (xmlNodePtr node, const char* tag, QofBook* book,
+                QofBook* scratch)
+{
+    for (auto child = node->xmlChildrenNode; child; child = child->next)
+    {
+        if (g_strcmp0 ((char*)child->name, tag) != 0)
+            continue;
+        auto commodity = dom_tree_to_commodity_ref (child, book);
+        if (commodity)
+            gnc_commodity_obtain_twin (commodity, scratch);
+        return;
+    }
+}
+
+/* Whether the record in node replays onto book: read it into scratch, a
+   book of its own that is thrown away whole, so that trying it leaves
+   everything in book alone. */
+static bool
+record_replays (xmlNodePtr node, QofBook* book, QofBook* scratch)
+{
+    if (g_strcmp0 ((char*)node->name, TRANSACTION_TAG) == 0)
+    {
+        twin_commodity (node, "trn:currency", book, scratch);
+        return dom_tree_to_transaction (node, scratch) != nullptr;
+    }
+    if (g_strcmp0 ((char*)node->name, PRICE_TAG) == 0)
+    {
+        twin_commodity (node, "price:commodity", book, scratch);
+        twin_commodity (node, "price:currency", book, scratch);
+        auto price = dom_tree_to_price (node, scratch);
+        if (price)
+            gnc_price_unref (price);
+        return price != nullptr;
+    }
+    return true;
+}
+
+static bool
+check_save (xmlNodePtr save, QofBook* book, QofBook* scratch)
+{
+    for (auto node = save->xmlChildrenNode; node; node = node->next)
+    {
+        const char* type;
+        GncGUID guid;
+
+        if (node->type != XML_ELEMENT_NODE)
+            continue;
+        if (!record_guid (node, &type, &guid)
+            || !record_replays (node, book, scratch))
+        {
+            PERR ("Bad record %s in the journal", (char*)node->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+replay_save (xmlNodePtr save, QofBook* book)
+{
+    auto db = gnc_pricedb_get_db (book);
+
+    /* Remove what the save replaces first, so that a transaction whose
+       splits moved to another one is never in the book twice. */
+    for (auto node = save->xmlChildrenNode; node; node = node->next)
+    {
+        const char* type;
+        GncGUID guid;
+
+        if (node->type != XML_ELEMENT_NODE)
+            continue;
+        if (!record_guid (node, &type, &guid))
+        {
+            PERR ("Bad record %s in the journal", (char*)node->name);
+            return false;
+        }
+
+        if (g_strcmp0 (type, GNC_ID_TRANS) == 0)
+        {
+            /* The record is the transaction as it was saved, voided or
+               not, with its gains transactions recorded on their own. */
+            xaccTransDestroyReplayed (xaccTransLookup (&guid, book));
+        }
+        else
+        {
+            auto price = gnc_price_lookup (&guid, book);
+            if (price)
+                gnc_pricedb_remove_price (db, price);
+        }
+    }
+
+    for (auto node = save->xmlChildrenNode; node; node = node->next)
+    {
+        if (g_strcmp0 ((char*)node->name, TRANSACTION_TAG) == 0)
+        {
+            if (!dom_tree_to_transaction (node, book))
+                return false;
+        }
+        else if (g_strcmp0 ((char*)node->name, PRICE_TAG) == 0)
+        {
+            auto price = dom_tree_to_price (node, book);
+            if (!price)
+                return false;
+            gnc_pricedb_add_price (db, price);
+            gnc_price_unref (price);
+        }
+    }
+    return true;
+}
+
+bool
+GncXmlJournal::replay (QofBook* book)
+{
+    gchar* contents = nullptr;
+    gsize length = 0;
+
+    if (!g_file_get_contents (m_filename.c_str (), &contents, &length, NULL))
+        return true;
+
+    std::string text{contents, length};
+    g_free (contents);
+
+    /* A save cut short by a crash ends the journal; leave it out, and have
+       the next save rewrite the data file. */
+    static const std::string save_end{"</" SAVE_TAG ">"};
+    auto end = text.rfind (save_end);
+    end = end == std::string::npos ? 0 : end + save_end.size ();
+    if (text.find_first_not_of (" \t\r\n", end) != std::string::npos)
+    {
+        PWARN ("%s ends in an incomplete save", m_filename.c_str ());
+        m_broken = true;
+        text.erase (end);
+    }
+
+    text = "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n<" JOURNAL_TAG ">\n"
+           + text + "</" JOURNAL_TAG ">\n";
+
+    xmlNodePtr tree = nullptr;
+    gpointer parse_result = nullptr;
+    auto parser = sixtp_dom_parser_new (journal_dom_tree_end_handler,
+                                        NULL, NULL);
+    auto parsed = sixtp_parse_buffer (parser, &text[0], text.size (), NULL,
+                                      &tree, &parse_result);
+    sixtp_destroy (parser);
+    if (!parsed || !tree)
+    {
+        PERR ("Could not parse %s", m_filename.c_str ());
+        if (tree)
+            xmlFreeNode (tree);
+        m_broken = true;
+        return false;
+    }
+
+    bool ok = true;
+    bool based = false;
+    bool empty = true;
+    std::vector<xmlNodePtr> saves;
+    for (auto node = tree->xmlChildrenNode; node; node = node->next)
+    {
+        if (node->type != XML_ELEMENT_NODE)
+            continue;
+        empty = false;
+        if (g_strcmp0 ((char*)node->name, BASE_TAG) == 0)
+        {
+            auto size = (char*)xmlGetProp (node, BAD_CAST "size");
+            auto mtime = (char*)xmlGetProp (node, BAD_CAST "mtime");
+            m_base_size = size ? g_ascii_strtoll (size, NULL, 10) : -1;
+            m_base_mtime = mtime ? g_ascii_strtoll (mtime, NULL, 10) : -1;
+            xmlFree (size);
+            xmlFree (mtime);
+            based = base_unchanged ();
+            if (!based)
+                break;
+        }
+        else if (!based)
+            break;
+        else if (g_strcmp0 ((char*)node->name, SAVE_TAG) == 0)
+            saves.push_back (node);
+    }
+
+    /* Apply all of the journal or, if a record in it won't replay, none. */
+    if (based)
+    {
+        auto scratch = qof_book_new ();
+        for (auto save = saves.begin (); ok && save != saves.end (); ++save)
+            ok = check_save (*save, book, scratch);
+        qof_book_destroy (scratch);
+        for (auto save = saves.begin (); ok && save != saves.end (); ++save)
+            ok = replay_save (*save, book);
+    }
+    xmlFreeNode (tree);
+
+    if (empty)
+    {
+        reset ();
+        return true;
+    }
+    /* The data file was replaced or written by something else since, but
+       the journal may still hold the only copy of some changes. */
+    if (!based)
+    {
+        PWARN ("%s doesn't belong to %s as it is now, not applying it",
+               m_filename.c_str (), m_datafile.c_str ());
+        return false;
+    }
+    if (!ok)
+    {
+        PERR ("Could not apply %s", m_filename.c_str ());
+        m_broken = true;
+    }
+    return ok;
+}
+
+void
+GncXmlJournal::set_aside ()
+{
+    auto bad = m_filename + ".bad";
+    PWARN ("Moving the journal %s that couldn't be applied aside to %s",
+           m_filename.c_str (), bad.c_str ());
+    g_unlink (bad.c_str ());
+    if (g_rename (m_filename.c_str (), bad.c_str ()) != 0)
+        PWARN ("Could not rename %s, removing it: %s", m_filename.c_str (),
+               g_strerror (errno));
+    reset ();
+}
+
+void
+GncXmlJournal::reset ()
+{
+    m_transactions.clear ();
+    m_prices.clear ();
+    m_untracked = false;
+    m_broken = false;
+    m_base_size = m_base_mtime = -1;
+
+    if (g_unlink (m_filename.c_str ()) != 0 && errno != ENOENT)
+        PWARN ("Could not remove %s: %s", m_filename.c_str (),
+               g_strerror (errno));
+}
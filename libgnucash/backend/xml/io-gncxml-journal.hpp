@@ -0,0 +1,112 @@
+/********************************************************************
+ * io-gncxml-journal.hpp -- journal of auto-saved changes           *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+/* An auto-save of a large book needn't rewrite the whole data file. The
+   journal lives next to the data file, as <datafile>.journal, and each
+   auto-save appends one <journal:save> block to it holding the
+   transactions and prices committed since the previous save, in the same
+   XML as the data file, and a <journal:delete> for each one deleted.
+   Opening the data file replays the journal onto the book, and the next
+   full save of the data file removes it. A journal that can't be replayed
+   in full isn't replayed at all; it is moved aside, to
+   <datafile>.journal.bad, and the book is left to be saved in full.
+
+   The journal starts with the size and modification time of the data file
+   it belongs to, so a journal left behind by a data file that was since
+   replaced isn't applied either, but moved aside in the same way. Any
+   other change (accounts, commodities, scheduled
+   transactions, business objects, book options, ...) can't be journaled,
+   and the next save rewrites the whole file.
+*/
+
+#ifndef IO_GNCXML_JOURNAL_HPP
+#define IO_GNCXML_JOURNAL_HPP
+
+extern "C"
+{
+#include <qof.h>
+}
+
+#include <set>
+#include <string>
+
+class GncXmlJournal
+{
+public:
+    /** A journal for the data file named datafile. */
+    GncXmlJournal (const std::string& datafile);
+    GncXmlJournal (const GncXmlJournal&) = delete;
+    GncXmlJournal& operator= (const GncXmlJournal&) = delete;
+
+    /** Take note of inst, just committed, for the next append(). */
+    void note (QofInstance* inst);
+    /** Whether the changes noted can be appended to the journal. If not, the
+     *  whole data file has to be written. */
+    bool can_append () const { return !m_untracked && !m_broken; }
+    /** Whether any change was noted since the last append() or reset(). */
+    bool has_changes () const
+    {
+        return m_untracked || !m_transactions.empty () || !m_prices.empty ();
+    }
+    /** The size of the journal file in bytes, 0 if there is none. */
+    gint64 size () const;
+    /** Append the changes noted since the last append() or reset().
+     *  @return false if the journal couldn't be written; the data file has to
+     *  be written then. */
+    bool append (QofBook* book);
+    /** Apply the journal to book, just loaded from the data file.
+     *  @return false if the journal is there but damaged or belongs to
+     *  another version of the data file; none of it is applied then. */
+    bool replay (QofBook* book);
+    /** Move a journal that couldn't be applied out of the way, to
+     *  <datafile>.journal.bad, and start afresh. */
+    void set_aside ();
+    /** Forget the changes noted and remove the journal file; the data file
+     *  has just been written in full. */
+    void reset ();
+
+private:
+    struct GuidLess
+    {
+        bool operator() (const GncGUID& a, const GncGUID& b) const
+        {
+            return guid_compare (&a, &b) < 0;
+        }
+    };
+    using GuidSet = std::set<GncGUID, GuidLess>;
+
+    bool base_unchanged () const;
+
+    std::string m_datafile;
+    std::string m_filename;
+    GuidSet m_transactions;
+    GuidSet m_prices;
+    /* Something that isn't journaled changed. */
+    bool m_untracked = false;
+    /* The journal file has a torn or failed save at its end. */
+    bool m_broken = false;
+    /* The data file's size and modification time recorded in the journal. */
+    gint64 m_base_size = -1;
+    gint64 m_base_mtime = -1;
+};
+
+#endif /* IO_GNCXML_JOURNAL_HPP */
@@ -0,0 +1,744 @@
+/********************************************************************
+ * io-gncxml-pipeline.cpp -- load the bulk of a v2 file on worker   *
+ *                           threads                                *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <string.h>
+#include <stdlib.h>
+}
+
+#include <deque>
+#include <string>
+
+#include "io-gncxml-pipeline.hpp"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/* How much of the file the splitter reads at a time, and how big it
+   lets a batch of objects or a piece of the skeleton grow before handing
+   it on. */
+#define PIPELINE_READ_SIZE 65536
+#define PIPELINE_BATCH_SIZE 65536
+#define PIPELINE_PIECE_SIZE 65536
+/* How many batches per worker thread, and how many skeleton pieces, may
+   be waiting at a time. */
+#define PIPELINE_BATCHES_PER_THREAD 4
+#define PIPELINE_MAX_PIECES 16
+
+/* The attribute with an object's number in its placeholder. */
+#define PIPELINE_INDEX_ATTR "n"
+
+struct GncXmlPipelineType
+{
+    std::string tag;
+    std::string parent;
+    GncXmlRecordParserNew new_parser;
+};
+
+/* Some consecutive objects, and once a worker has read them, their
+   records. The text is an XML document with the objects as the children
+   of its root element. */
+struct GncXmlPipelineBatch
+{
+    gsize first = 0;
+    std::string text;
+    std::vector<const GncXmlPipelineType*> types;
+    std::vector<std::unique_ptr<GncXmlRecord>> records;
+    bool read = false;
+    bool ok = false;
+};
+
+typedef std::vector<std::unique_ptr<GncXmlPipelineType>> GncXmlPipelineTypes;
+
+/* The state of one GncXmlPipeline::parse. The splitter thread, the
+   worker pool and the main thread meet in here. */
+class GncXmlPipelineRun
+{
+public:
+    GncXmlPipelineRun (const GncXmlPipelineTypes& types, guint threads,
+                       FILE* file);
+    ~GncXmlPipelineRun ();
+
+    /* The main thread's side. */
+    bool next_piece (std::string& piece);
+    GncXmlRecord* next_record (const gchar* tag, gsize index);
+    bool well_formed () const noexcept { return m_well_formed; }
+    void set_well_formed (bool well_formed) { m_well_formed = well_formed; }
+
+    /* The splitter's side. */
+    bool dispatch (GncXmlPipelineBatch* batch);
+    bool queue_piece (std::string&& piece);
+    void input_done ();
+
+    /* A worker's. */
+    void read_batch (GncXmlPipelineBatch* batch);
+
+    const GncXmlPipelineTypes& types () const noexcept { return m_types; }
+    FILE* file () const noexcept { return m_file; }
+
+private:
+    const GncXmlPipelineTypes& m_types;
+    FILE* m_file;
+    GMutex m_lock;
+    GCond m_changed;
+    std::deque<std::unique_ptr<GncXmlPipelineBatch>> m_batches;
+    std::deque<std::string> m_pieces;
+    std::size_t m_max_batches;
+    bool m_waiting_for_piece = false;
+    bool m_input_done = false;
+    bool m_stop = false;
+    bool m_well_formed = false;
+    GThreadPool* m_pool;
+    GThread* m_splitter;
+};
+
+/***********************************************************************/
+/* The splitter. It only looks at the file as far as it must to find the
+   objects: markup is told from text, and start tags from end tags, but
+   nothing is checked. The main thread's and the workers' parsers see
+   all of the file between them and complain about whatever is wrong
+   with it. */
+
+class GncXmlPipelineSplitter
+{
+public:
+    explicit GncXmlPipelineSplitter (GncXmlPipelineRun& run) : m_run (run) {}
+    void split ();
+
+private:
+    bool fill ();
+    std::size_t markup_end (std::size_t pos) const;
+    void copy (std::size_t pos, std::size_t end);
+    void markup (std::size_t pos, std::size_t end);
+    const GncXmlPipelineType* object_type (const std::string& name) const;
+    void start_object (const GncXmlPipelineType* type, const std::string& name,
+                       std::size_t pos, std::size_t end, bool empty);
+    void end_object ();
+    void flush ();
+
+    GncXmlPipelineRun& m_run;
+    std::string m_in;
+    std::size_t m_pos = 0;
+    bool m_eof = false;
+    bool m_stopped = false;
+    bool m_seen_element = false;
+    std::string m_decl;
+    std::string m_skeleton;
+    std::vector<std::string> m_open;
+    std::unique_ptr<GncXmlPipelineBatch> m_batch;
+    /* The depth inside the current object, 0 between objects. */
+    std::size_t m_depth = 0;
+    gsize m_objects = 0;
+};
+
+bool
+GncXmlPipelineSplitter::fill ()
+{
+    char buffer[PIPELINE_READ_SIZE];
+    std::size_t bytes;
+
+    if (m_eof)
+        return false;
+    m_in.erase (0, m_pos);
+    m_pos = 0;
+    bytes = fread (buffer, 1, sizeof (buffer), m_run.file ());
+    if (bytes == 0)
+    {
+        if (ferror (m_run.file ()))
+            PWARN ("Error reading XML file");
+        m_eof = true;
+        return false;
+    }
+    m_in.append (buffer, bytes);
+    return true;
+}
+
+/* Where the markup starting at pos ends, or npos if it isn't all in. */
+std::size_t
+GncXmlPipelineSplitter::markup_end (std::size_t pos) const
+{
+    auto starts_with = [&] (const char* prefix)
+    {
+        return m_in.compare (pos, strlen (prefix), prefix) == 0;
+    };
+    std::size_t end;
+    char quote = 0;
+    int brackets = 0;
+
+    /* Enough to tell the kinds of markup apart. */
+    if (!m_eof && m_in.size () - pos < sizeof ("<![CDATA[") - 1)
+        return std::string::npos;
+
+    if (starts_with ("<!--"))
+        end = m_in.find ("-->", pos + 4);
+    else if (starts_with ("<![CDATA["))
+        end = m_in.find ("]]>", pos + 9);
+    else if (starts_with ("<?"))
+        return (end = m_in.find ("?>", pos + 2)) == std::string::npos ?
+               end : end + 2;
+    else
+    {
+        /* A tag or a <!DOCTYPE ...>, with maybe an internal subset. */
+        for (end = pos + 1; end < m_in.size (); ++end)
+        {
+            auto c = m_in[end];
+            if (quote)
+            {
+                if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '"' || c == '\'')
+                quote = c;
+            else if (c == '[')
+                ++brackets;
+            else if (c == ']')
+                --brackets;
+            else if (c == '>' && brackets <= 0)
+                return end + 1;
+        }
+        return std::string::npos;
+    }
+    return end == std::string::npos ? end : end + 3;
+}
+
+void
+GncXmlPipelineSplitter::copy (std::size_t pos, std::size_t end)
+{
+    if (m_depth)
+        m_batch->text.append (m_in, pos, end - pos);
+    else
+        m_skeleton.append (m_in, pos, end - pos);
+}
+
+const GncXmlPipelineType*
+GncXmlPipelineSplitter::object_type (const std::string& name) const
+{
+    if (m_open.empty ())
+        return nullptr;
+    for (const auto& type : m_run.types ())
+        if (type->tag == name && type->parent == m_open.back ())
+            return type.get ();
+    return nullptr;
+}
+
+void
+GncXmlPipelineSplitter::markup (std::size_t pos, std::size_t end)
+{
+    bool closing, empty;
+    std::size_t name_end;
+
+    if (m_in[pos + 1] == '?' || m_in[pos + 1] == '!')
+    {
+        if (!m_seen_element && m_decl.empty () &&
+            m_in.compare (pos, 6, "<?xml ") == 0)
+            m_decl.assign (m_in, pos, end - pos);
+        copy (pos, end);
+        return;
+    }
+
+    m_seen_element = true;
+    closing = m_in[pos + 1] == '/';
+    empty = !closing && m_in[end - 2] == '/';
+    name_end = m_in.find_first_of (" \t\r\n/>", pos + 1 + closing);
+    std::string name {m_in, pos + 1 + closing, name_end - pos - 1 - closing};
+
+    if (m_depth)
+    {
+        copy (pos, end);
+        if (closing && --m_depth == 0)
+            end_object ();
+        else if (!closing && !empty)
+            ++m_depth;
+        return;
+    }
+
+    if (closing)
+    {
+        if (!m_open.empty ())
+            m_open.pop_back ();
+    }
+    else if (auto type = object_type (name))
+    {
+        start_object (type, name, pos, end, empty);
+        return;
+    }
+    else if (!empty)
+        m_open.push_back (name);
+    copy (pos, end);
+    if (m_skeleton.size () >= PIPELINE_PIECE_SIZE)
+        flush ();
+}
+
+void
+GncXmlPipelineSplitter::start_object (const GncXmlPipelineType* type,
+                                      const std::string& name,
+                                      std::size_t pos, std::size_t end,
+                                      bool empty)
+{
+    if (!m_batch)
+    {
+        m_batch.reset (new GncXmlPipelineBatch);
+        m_batch->first = m_objects;
+        m_batch->text = m_decl + "<batch>";
+    }
+    m_skeleton += "<" + name + " " PIPELINE_INDEX_ATTR "=\"" +
+                  std::to_string (m_objects++) + "\"/>";
+    m_batch->types.push_back (type);
+    m_depth = 1;
+    copy (pos, end);
+    if (empty)
+    {
+        m_depth = 0;
+        end_object ();
+    }
+}
+
+void
+GncXmlPipelineSplitter::end_object ()
+{
+    if (m_batch->text.size () >= PIPELINE_BATCH_SIZE ||
+        m_skeleton.size () >= PIPELINE_PIECE_SIZE)
+        flush ();
+}
+
+/* Hand on the current batch and the skeleton so far. The batch goes
+   first, so that the main thread never waits for a batch that is still
+   with the splitter. */
+void
+GncXmlPipelineSplitter::flush ()
+{
+    if (m_stopped)
+        return;
+    if (m_batch)
+    {
+        m_batch->text += "</batch>";
+        m_batch->records.resize (m_batch->types.size ());
+        m_stopped = !m_run.dispatch (m_batch.release ());
+    }
+    if (!m_stopped && !m_skeleton.empty ())
+    {
+        m_stopped = !m_run.queue_piece (std::move (m_skeleton));
+        m_skeleton.clear ();
+    }
+}
+
+void
+GncXmlPipelineSplitter::split ()
+{
+    while (!m_stopped)
+    {
+        auto pos = m_in.find ('<', m_pos);
+        if (pos == std::string::npos)
+        {
+            copy (m_pos, m_in.size ());
+            m_pos = m_in.size ();
+            if (!fill ())
+                break;
+            continue;
+        }
+        copy (m_pos, pos);
+        m_pos = pos;
+
+        auto end = markup_end (pos);
+        if (end == std::string::npos)
+        {
+            if (fill ())
+                continue;
+            end = markup_end (m_pos);
+            if (end == std::string::npos)
+            {
+                /* Cut off; leave that to the parsers. */
+                copy (m_pos, m_in.size ());
+                break;
+            }
+        }
+        markup (m_pos, end);
+        m_pos = end;
+    }
+    flush ();
+}
+
+static gpointer
+pipeline_split (gpointer data)
+{
+    auto run = static_cast<GncXmlPipelineRun*> (data);
+
+    GncXmlPipelineSplitter {*run}.split ();
+    run->input_done ();
+    return NULL;
+}
+
+/***********************************************************************/
+/* The workers. */
+
+struct GncXmlBatchReader
+{
+    GncXmlPipelineBatch* batch;
+    std::unique_ptr<GncXmlRecordParser> parser;
+    std::size_t depth = 0;
+    std::size_t object = 0;
+    bool ok = true;
+};
+
+static void
+batch_start_element (void* data, const xmlChar* name, const xmlChar** attrs)
+{
+    auto reader = static_cast<GncXmlBatchReader*> (data);
+    auto tag = reinterpret_cast<const gchar*> (name);
+    auto batch = reader->batch;
+
+    /* Depth 1 is the <batch> around the objects. */
+    if (++reader->depth < 2 || !reader->ok)
+        return;
+    if (reader->depth == 2)
+    {
+        if (reader->object >= batch->types.size () ||
+            batch->types[reader->object]->tag != tag)
+        {
+            reader->ok = false;
+            return;
+        }
+        reader->parser.reset (batch->types[reader->object]->new_parser ());
+    }
+    reader->parser->start (tag, (gchar**) attrs);
+}
+
+static void
+batch_characters (void* data, const xmlChar* text, int length)
+{
+    auto reader = static_cast<GncXmlBatchReader*> (data);
+
+    if (reader->depth >= 2 && reader->ok)
+        reader->parser->characters (reinterpret_cast<const gchar*> (text),
+                                    length);
+}
+
+static void
+batch_end_element (void* data, const xmlChar* name)
+{
+    auto reader = static_cast<GncXmlBatchReader*> (data);
+
+    if (reader->depth >= 2 && reader->ok)
+    {
+        reader->parser->end (reinterpret_cast<const gchar*> (name));
+        if (reader->depth == 2)
+        {
+            reader->batch->records[reader->object++].reset (
+                reader->parser->take_record ());
+            reader->parser.reset ();
+        }
+    }
+    --reader->depth;
+}
+
+void
+GncXmlPipelineRun::read_batch (GncXmlPipelineBatch* batch)
+{
+    xmlSAXHandler handler;
+    xmlParserCtxtPtr ctxt;
+    GncXmlBatchReader reader;
+    int ret;
+    bool ok;
+
+    memset (&handler, 0, sizeof (handler));
+    handler.startElement = batch_start_element;
+    handler.endElement = batch_end_element;
+    handler.characters = batch_characters;
+    handler.getEntity = sixtp_sax_get_entity_handler;
+
+    reader.batch = batch;
+    ctxt = xmlCreatePushParserCtxt (&handler, &reader, NULL, 0, NULL);
+    ret = xmlParseChunk (ctxt, batch->text.data (), batch->text.size (), 1);
+    ok = ret == 0 && ctxt->wellFormed && reader.ok &&
+         reader.object == batch->types.size ();
+    xmlFreeParserCtxt (ctxt);
+    std::string ().swap (batch->text);
+
+    /* The main thread may drop the batch as soon as it is read. */
+    g_mutex_lock (&m_lock);
+    batch->ok = ok;
+    batch->read = true;
+    g_cond_broadcast (&m_changed);
+    g_mutex_unlock (&m_lock);
+}
+
+static void
+pipeline_read_batch (gpointer data, gpointer user_data)
+{
+    auto run = static_cast<GncXmlPipelineRun*> (user_data);
+    run->read_batch (static_cast<GncXmlPipelineBatch*> (data));
+}
+
+/***********************************************************************/
+
+GncXmlPipelineRun::GncXmlPipelineRun (const GncXmlPipelineTypes& types,
+                                      guint threads, FILE* file)
+    : m_types (types), m_file (file),
+      m_max_batches (threads * PIPELINE_BATCHES_PER_THREAD)
+{
+    g_mutex_init (&m_lock);
+    g_cond_init (&m_changed);
+    m_pool = g_thread_pool_new (pipeline_read_batch, this, threads, TRUE,
+                                NULL);
+    m_splitter = g_thread_new ("xml_splitter", pipeline_split, this);
+}
+
+GncXmlPipelineRun::~GncXmlPipelineRun ()
+{
+    g_mutex_lock (&m_lock);
+    m_stop = true;
+    g_cond_broadcast (&m_changed);
+    g_mutex_unlock (&m_lock);
+
+    g_thread_join (m_splitter);
+    g_thread_pool_free (m_pool, TRUE, TRUE);
+    m_batches.clear ();
+    g_cond_clear (&m_changed);
+    g_mutex_clear (&m_lock);
+}
+
+bool
+GncXmlPipelineRun::dispatch (GncXmlPipelineBatch* batch)
+{
+    bool ok;
+
+    g_mutex_lock (&m_lock);
+    /* Go over the limit rather than keep the main thread waiting for a
+       piece of the skeleton. */
+    while (m_batches.size () >= m_max_batches && !m_waiting_for_piece &&
+           !m_stop)
+        g_cond_wait (&m_changed, &m_lock);
+    ok = !m_stop;
+    if (ok)
+    {
+        m_batches.emplace_back (batch);
+        g_thread_pool_push (m_pool, batch, NULL);
+    }
+    g_mutex_unlock (&m_lock);
+
+    if (!ok)
+        delete batch;
+    return ok;
+}
+
+bool
+GncXmlPipelineRun::queue_piece (std::string&& piece)
+{
+    bool ok;
+
+    g_mutex_lock (&m_lock);
+    while (m_pieces.size () >= PIPELINE_MAX_PIECES && !m_stop)
+        g_cond_wait (&m_changed, &m_lock);
+    ok = !m_stop;
+    if (ok)
+    {
+        m_pieces.push_back (std::move (piece));
+        g_cond_broadcast (&m_changed);
+    }
+    g_mutex_unlock (&m_lock);
+    return ok;
+}
+
+void
+GncXmlPipelineRun::input_done ()
+{
+    g_mutex_lock (&m_lock);
+    m_input_done = true;
+    g_cond_broadcast (&m_changed);
+    g_mutex_unlock (&m_lock);
+}
+
+bool
+GncXmlPipelineRun::next_piece (std::string& piece)
+{
+    bool ok;
+
+    g_mutex_lock (&m_lock);
+    m_waiting_for_piece = true;
+    g_cond_broadcast (&m_changed);
+    while (m_pieces.empty () && !m_input_done)
+        g_cond_wait (&m_changed, &m_lock);
+    m_waiting_for_piece = false;
+    ok = !m_pieces.empty ();
+    if (ok)
+    {
+        piece = std::move (m_pieces.front ());
+        m_pieces.pop_front ();
+        g_cond_broadcast (&m_changed);
+    }
+    g_mutex_unlock (&m_lock);
+    return ok;
+}
+
+/* The record for the placeholder numbered index. A batch is dropped as
+   soon as its last record is handed out, or a later one is asked for. */
+GncXmlRecord*
+GncXmlPipelineRun::next_record (const gchar* tag, gsize index)
+{
+    GncXmlRecord* record = nullptr;
+
+    g_mutex_lock (&m_lock);
+    for (;;)
+    {
+        while (m_batches.empty () && !m_input_done)
+            g_cond_wait (&m_changed, &m_lock);
+        if (m_batches.empty ())
+            break;
+
+        auto& batch = *m_batches.front ();
+        while (!batch.read)
+            g_cond_wait (&m_changed, &m_lock);
+        auto last = batch.first + batch.types.size ();
+        if (index < batch.first)
+            break;
+        if (index < last)
+        {
+            auto i = index - batch.first;
+            if (batch.ok && batch.types[i]->tag == tag)
+                record = batch.records[i].release ();
+            if (index + 1 < last)
+                break;
+        }
+        m_batches.pop_front ();
+        g_cond_broadcast (&m_changed);
+        if (index < last)
+            break;
+    }
+    g_mutex_unlock (&m_lock);
+
+    if (!record)
+        PERR ("No %s record for object %" G_GSIZE_FORMAT, tag, index);
+    return record;
+}
+
+/***********************************************************************/
+/* The placeholders' parser. */
+
+struct GncXmlPipelineData : gxpf_data
+{
+    GncXmlPipelineRun* run;
+};
+
+static gboolean
+pipeline_start_handler (GSList* sibling_data, gpointer parent_data,
+                        gpointer global_data, gpointer* data_for_children,
+                        gpointer* result, const gchar* tag, gchar** attrs)
+{
+    /* Store the number plus one, as NULL means none. */
+    *data_for_children = NULL;
+    for (auto attr = attrs; attr && attr[0] && attr[1]; attr += 2)
+        if (g_strcmp0 (attr[0], PIPELINE_INDEX_ATTR) == 0)
+            *data_for_children =
+                GSIZE_TO_POINTER (g_ascii_strtoull (attr[1], NULL, 10) + 1);
+    return *data_for_children != NULL;
+}
+
+static gboolean
+pipeline_end_handler (gpointer data_for_children,
+                      GSList* data_from_children, GSList* sibling_data,
+                      gpointer parent_data, gpointer global_data,
+                      gpointer* result, const gchar* tag)
+{
+    auto gdata = static_cast<GncXmlPipelineData*> (global_data);
+    auto index = GPOINTER_TO_SIZE (data_for_children) - 1;
+    std::unique_ptr<GncXmlRecord> record {gdata->run->next_record (tag, index)};
+
+    *result = NULL;
+    if (!record)
+        return FALSE;
+    return record->make (gdata, tag, result);
+}
+
+static void
+pipeline_push_handler (xmlParserCtxtPtr ctxt, gpointer user_data)
+{
+    auto run = static_cast<GncXmlPipelineRun*> (user_data);
+    std::string piece;
+    int ret = 0;
+
+    while (ret == 0 && run->next_piece (piece))
+        ret = xmlParseChunk (ctxt, piece.data (), piece.size (), 0);
+    if (ret == 0)
+        ret = xmlParseChunk (ctxt, NULL, 0, 1);
+    run->set_well_formed (ret == 0 && ctxt->wellFormed);
+}
+
+/***********************************************************************/
+
+GncXmlPipeline::GncXmlPipeline (guint threads) : m_threads (MAX (threads, 1))
+{
+}
+
+GncXmlPipeline::~GncXmlPipeline () = default;
+
+sixtp*
+GncXmlPipeline::add_type (const gchar* tag, const gchar* parent,
+                          GncXmlRecordParserNew new_parser,
+                          sixtp_result_handler cleanup_result_by_default_func,
+                          sixtp_result_handler cleanup_result_on_fail_func)
+{
+    sixtp* placeholder;
+
+    g_return_val_if_fail (tag && parent && new_parser, NULL);
+
+    placeholder = sixtp_set_any (sixtp_new (), FALSE,
+                                 SIXTP_START_HANDLER_ID, pipeline_start_handler,
+                                 SIXTP_END_HANDLER_ID, pipeline_end_handler,
+                                 SIXTP_NO_MORE_HANDLERS);
+    if (!placeholder)
+        return NULL;
+    if (cleanup_result_by_default_func)
+        sixtp_set_cleanup_result (placeholder, cleanup_result_by_default_func);
+    if (cleanup_result_on_fail_func)
+        sixtp_set_result_fail (placeholder, cleanup_result_on_fail_func);
+
+    for (const auto& type : m_types)
+        if (type->tag == tag && type->parent == parent)
+            return placeholder;
+    m_types.emplace_back (new GncXmlPipelineType {tag, parent, new_parser});
+    return placeholder;
+}
+
+gboolean
+GncXmlPipeline::parse (sixtp* top_parser, FILE* file, gxpf_callback callback,
+                       gpointer parsedata, gpointer bookdata)
+{
+    gpointer parse_result = NULL;
+    GncXmlPipelineData gpdata;
+    gboolean ok;
+
+    g_return_val_if_fail (top_parser && file, FALSE);
+
+    /* libxml2 must be set up before its first use on another thread. */
+    xmlInitParser ();
+
+    GncXmlPipelineRun run {m_types, m_threads, file};
+    gpdata.cb = callback;
+    gpdata.parsedata = parsedata;
+    gpdata.bookdata = bookdata;
+    gpdata.run = &run;
+
+    ok = sixtp_parse_push (top_parser, pipeline_push_handler, &run,
+                           NULL, &gpdata, &parse_result);
+    return ok && run.well_formed ();
+}
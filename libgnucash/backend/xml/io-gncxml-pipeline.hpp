@@ -0,0 +1,94 @@
+/********************************************************************
+ * io-gncxml-pipeline.hpp -- load the bulk of a v2 file on worker   *
+ *                           threads                                *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+/* A GncXmlPipeline loads a file in three stages:
+
+   1. A splitter thread reads the (already decompressed) file and cuts
+      the elements of the registered object types out of it, in batches
+      of complete elements. What is left, the skeleton of the file, gets
+      a placeholder element in place of each object.
+
+   2. A pool of worker threads parses the batches with the objects'
+      GncXmlRecordParsers into GncXmlRecords.
+
+   3. The main thread parses the skeleton with the usual sixtp parser
+      tree. The placeholders' parsers, made by add_type, hand out the
+      records in file order and make the engine objects from them, so
+      the book is only ever touched from the main thread and sees the
+      objects in the same order as with gnc_xml_parse_fd.
+
+   Only elements whose parent has the registered tag are cut out, so
+   the same tag can still be parsed differently elsewhere in the file.
+*/
+
+#ifndef IO_GNCXML_PIPELINE_HPP
+#define IO_GNCXML_PIPELINE_HPP
+
+extern "C"
+{
+#include <glib.h>
+#include <stdio.h>
+}
+
+#include <memory>
+#include <vector>
+
+#include "sixtp.h"
+#include "io-gncxml-gen.h"
+#include "sixtp-stream-parser.hpp"
+
+struct GncXmlPipelineType;
+
+class GncXmlPipeline
+{
+public:
+    /** @param threads The number of worker threads parsing records. */
+    explicit GncXmlPipeline (guint threads);
+    ~GncXmlPipeline ();
+    GncXmlPipeline (const GncXmlPipeline&) = delete;
+    GncXmlPipeline& operator= (const GncXmlPipeline&) = delete;
+
+    /** Have the elements named tag inside an element named parent read by
+     *  new_parser's parsers on the worker threads.
+     *
+     *  @return The parser to add under parent in the sixtp tree given to
+     *  parse (). Its result is whatever the record's make () returns,
+     *  cleaned up with the two handlers like any other sixtp result.
+     */
+    sixtp* add_type (const gchar* tag, const gchar* parent,
+                     GncXmlRecordParserNew new_parser,
+                     sixtp_result_handler cleanup_result_by_default_func,
+                     sixtp_result_handler cleanup_result_on_fail_func);
+
+    /** Like gnc_xml_parse_fd, but with the registered types parsed on the
+     *  worker threads. top_parser must use the parsers from add_type.
+     */
+    gboolean parse (sixtp* top_parser, FILE* file, gxpf_callback callback,
+                    gpointer parsedata, gpointer bookdata);
+
+private:
+    guint m_threads;
+    std::vector<std::unique_ptr<GncXmlPipelineType>> m_types;
+};
+
+#endif /* IO_GNCXML_PIPELINE_HPP */
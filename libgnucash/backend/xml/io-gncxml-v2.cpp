@@ -43,7 +43,6 @@ extern "C"
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
-#include <zlib.h>
 #include <errno.h>
 
 #include "gnc-engine.h"
@@ -54,6 +53,7 @@ extern "C"
 #include "Transaction.h"
 #include "TransactionP.h"
 #include "TransLog.h"
+#include "gnc-prefs.h"
 #if PLATFORM(WINDOWS)
 #ifdef __STRICT_ANSI_UNSET__
 #undef __STRICT_ANSI_UNSET__
@@ -64,6 +64,9 @@ extern "C"
 # define g_fopen fopen
 # define g_open _open
 #endif
+#ifndef O_BINARY
+# define O_BINARY 0
+#endif
 }
 
 #include "gnc-xml-backend.hpp"
@@ -74,6 +77,8 @@ extern "C"
 #include "sixtp-dom-parsers.h"
 #include "io-gncxml-v2.h"
 #include "io-gncxml-gen.h"
+#include "io-gncxml-pipeline.hpp"
+#include "io-gncxml-compress.hpp"
 
 /* Do not treat -Wstrict-aliasing warnings as errors because of problems of the
  * G_LOCK* macros as declared by glib.  See
@@ -93,8 +98,9 @@ typedef struct
 {
     gint fd;
     gchar* filename;
-    gchar* perms;
     gboolean compress;
+    GncXmlCompression compression;
+    gint level;
 } gz_thread_params_t;
 
 /* Callback structure */
@@ -116,6 +122,10 @@ gnc_xml_register_backend(GncXmlDataType_t& xmlbe)
     backend_registry.push_back(xmlbe);
 }
 
+/* Files smaller than this load faster without the pipeline's threads. */
+#define GNC_XML_PIPELINE_MIN_FILE_SIZE (256 * 1024)
+#define GNC_XML_PIPELINE_MAX_THREADS 8
+
 #define GNC_V2_STRING "gnc-v2"
 /* non-static because they are used in sixtp.c */
 const gchar* gnc_v2_xml_version_string = GNC_V2_STRING;
@@ -124,9 +134,8 @@ gnc_v2_book_version_string;        /* see gnc-book-xml-v2 */
 
 /* Forward declarations */
 static FILE* try_gz_open (const char* filename, const char* perms,
-                          gboolean use_gzip,
+                          GncXmlCompression compression, gint level,
                           gboolean compress);
-static gboolean is_gzipped_file (const gchar* name);
 static gboolean wait_for_gzip (FILE* file);
 
 static void
@@ -691,6 +700,27 @@ gnc_sixtp_gdv2_new (
     return gd;
 }
 
+/* How many worker threads to load filename with, or 0 to not use a
+   GncXmlPipeline at all. */
+static guint
+load_threads (const char* filename)
+{
+    GStatBuf sb;
+    guint processors;
+    guint threads = gnc_prefs_get_file_load_threads ();
+
+    if (!gnc_prefs_get_file_load_stream_parsers () || threads == 1)
+        return 0;
+    if (threads > 1)
+        return threads;
+
+    processors = g_get_num_processors ();
+    if (processors < 2 || g_stat (filename, &sb) != 0 ||
+        sb.st_size < GNC_XML_PIPELINE_MIN_FILE_SIZE)
+        return 0;
+    return MIN (processors - 1, GNC_XML_PIPELINE_MAX_THREADS);
+}
+
 static gboolean
 qof_session_load_from_xml_file_v2_full (
     GncXmlBackend* xml_be, QofBook* book,
@@ -705,10 +735,21 @@ qof_session_load_from_xml_file_v2_full (
     struct file_backend be_data;
     gboolean retval;
     char* v2type = NULL;
+    GncXmlPipeline* pipeline = NULL;
+    guint threads;
 
     gd = gnc_sixtp_gdv2_new (book, FALSE, file_rw_feedback,
                              xml_be->get_percentage());
 
+    /* Transactions and prices are parsed on worker threads unless the
+       caller pushes the data itself. */
+    threads = push_handler ? 0 : load_threads (xml_be->get_filename ());
+    if (threads)
+    {
+        PINFO ("Loading with %u worker threads", threads);
+        pipeline = new GncXmlPipeline (threads);
+    }
+
     top_parser = sixtp_new ();
     main_parser = sixtp_new ();
     book_parser = sixtp_new ();
@@ -735,10 +776,12 @@ qof_session_load_from_xml_file_v2_full (
             /* the following are present here only to support
              * the older, pre-book format.  Basically, the top-level
              * book is implicit. */
-            PRICEDB_TAG, gnc_pricedb_sixtp_parser_create (),
+            PRICEDB_TAG, gnc_pricedb_sixtp_parser_create_pipelined (pipeline),
             COMMODITY_TAG, gnc_commodity_sixtp_parser_create (),
             ACCOUNT_TAG, gnc_account_sixtp_parser_create (),
-            TRANSACTION_TAG, gnc_transaction_sixtp_parser_create (),
+            TRANSACTION_TAG,
+            gnc_transaction_sixtp_parser_create_pipelined (pipeline,
+                                                           GNC_V2_STRING),
             SCHEDXACTION_TAG, gnc_schedXaction_sixtp_parser_create (),
             TEMPLATE_TRANSACTION_TAG, gnc_template_transaction_sixtp_parser_create (),
             NULL, NULL))
@@ -751,11 +794,12 @@ qof_session_load_from_xml_file_v2_full (
             BOOK_ID_TAG, gnc_book_id_sixtp_parser_create (),
             BOOK_SLOTS_TAG, gnc_book_slots_sixtp_parser_create (),
             COUNT_DATA_TAG, gnc_counter_sixtp_parser_create (),
-            PRICEDB_TAG, gnc_pricedb_sixtp_parser_create (),
+            PRICEDB_TAG, gnc_pricedb_sixtp_parser_create_pipelined (pipeline),
             COMMODITY_TAG, gnc_commodity_sixtp_parser_create (),
             ACCOUNT_TAG, gnc_account_sixtp_parser_create (),
             BUDGET_TAG, gnc_budget_sixtp_parser_create (),
-            TRANSACTION_TAG, gnc_transaction_sixtp_parser_create (),
+            TRANSACTION_TAG,
+            gnc_transaction_sixtp_parser_create_pipelined (pipeline, BOOK_TAG),
             SCHEDXACTION_TAG, gnc_schedXaction_sixtp_parser_create (),
             TEMPLATE_TRANSACTION_TAG, gnc_template_transaction_sixtp_parser_create (),
             NULL, NULL))
@@ -796,8 +840,8 @@ qof_session_load_from_xml_file_v2_full (
          */
          const char* filename = xml_be->get_filename();
         FILE* file;
-        gboolean is_compressed = is_gzipped_file (filename);
-        file = try_gz_open (filename, "r", is_compressed, FALSE);
+        auto compression = gnc_xml_file_compression (filename);
+        file = try_gz_open (filename, "r", compression, 0, FALSE);
         if (file == NULL)
         {
             PWARN ("Unable to open file %s", filename);
@@ -805,10 +849,14 @@ qof_session_load_from_xml_file_v2_full (
         }
         else
         {
-            retval = gnc_xml_parse_fd (top_parser, file,
-                                       generic_callback, gd, book);
+            if (pipeline)
+                retval = pipeline->parse (top_parser, file,
+                                          generic_callback, gd, book);
+            else
+                retval = gnc_xml_parse_fd (top_parser, file,
+                                           generic_callback, gd, book);
             fclose (file);
-            if (is_compressed)
+            if (compression != GncXmlCompression::NONE)
                 wait_for_gzip (file);
         }
     }
@@ -824,6 +872,7 @@ qof_session_load_from_xml_file_v2_full (
 
     /* destroy the parser */
     sixtp_destroy (top_parser);
+    delete pipeline;
     g_free (gd);
 
     xaccEnableDataScrubbing ();
@@ -863,6 +912,7 @@ qof_session_load_from_xml_file_v2_full (
     return TRUE;
 
 bail:
+    delete pipeline;
     g_free (gd);
     return FALSE;
 }
@@ -874,6 +924,74 @@ qof_session_load_from_xml_file_v2 (GncXmlBackend* xml_be, QofBook* book,
     return qof_session_load_from_xml_file_v2_full (xml_be, book, NULL, NULL, type);
 }
 
+gboolean
+gnc_book_load_extras_from_xml_buffer_v2 (QofBook* book, const char* buffer,
+                                         gsize size)
+{
+    sixtp_gdv2* gd;
+    sixtp* top_parser;
+    sixtp* main_parser;
+    sixtp* book_parser;
+    struct file_backend be_data;
+    gxpf_data gpdata;
+    gpointer parse_result = NULL;
+    gboolean retval;
+
+    top_parser = sixtp_new ();
+    main_parser = sixtp_new ();
+    book_parser = sixtp_new ();
+
+    if (!sixtp_add_some_sub_parsers (
+            top_parser, TRUE,
+            GNC_V2_STRING, main_parser,
+            NULL, NULL)
+        || !sixtp_add_some_sub_parsers (
+            main_parser, TRUE,
+            BOOK_TAG, book_parser,
+            NULL, NULL)
+        || !sixtp_add_some_sub_parsers (
+            book_parser, TRUE,
+            BUDGET_TAG, gnc_budget_sixtp_parser_create (),
+            SCHEDXACTION_TAG, gnc_schedXaction_sixtp_parser_create (),
+            TEMPLATE_TRANSACTION_TAG, gnc_template_transaction_sixtp_parser_create (),
+            NULL, NULL))
+        return FALSE;
+
+    be_data.ok = TRUE;
+    be_data.parser = book_parser;
+    for (auto data : backend_registry)
+        add_parser(data, &be_data);
+    if (be_data.ok == FALSE)
+    {
+        sixtp_destroy (top_parser);
+        return FALSE;
+    }
+
+    gd = gnc_sixtp_gdv2_new (book, FALSE, NULL, NULL);
+    gpdata.cb = generic_callback;
+    gpdata.parsedata = gd;
+    gpdata.bookdata = book;
+
+    retval = sixtp_parse_buffer (top_parser, const_cast<char*> (buffer), size,
+                                 NULL, &gpdata, &parse_result);
+    sixtp_destroy (top_parser);
+    g_free (gd);
+    if (!retval)
+        return FALSE;
+
+    /* Call individual scrub functions */
+    memset (&be_data, 0, sizeof (be_data));
+    be_data.book = book;
+    for (auto data : backend_registry)
+        scrub(data, &be_data);
+
+    /* The template accounts are left in edit like the others. */
+    gnc_account_foreach_descendant (gnc_book_get_template_root (book),
+                                    (AccountCb) xaccAccountCommitEdit,
+                                    NULL);
+    return TRUE;
+}
+
 /***********************************************************************/
 
 static gboolean
@@ -1340,6 +1458,44 @@ gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* out)
     return success;
 }
 
+gboolean
+gnc_book_write_extras_to_xml_filehandle_v2 (QofBook* book, FILE* out)
+{
+    struct file_backend be_data;
+    sixtp_gdv2* gd;
+    gboolean success = TRUE;
+
+    if (!out) return FALSE;
+
+    if (!write_v2_header (out))
+        return FALSE;
+
+    gd = gnc_sixtp_gdv2_new (book, FALSE, NULL, NULL);
+    be_data.out = out;
+    be_data.book = book;
+    be_data.gd = gd;
+
+    if (fprintf (out, "<%s version=\"%s\">\n", BOOK_TAG,
+                 gnc_v2_book_version_string) < 0
+        || !write_template_transaction_data (out, book, gd)
+        || !write_schedXactions (out, book, gd))
+        success = FALSE;
+
+    if (success)
+    {
+        qof_collection_foreach (qof_book_get_collection (book, GNC_ID_BUDGET),
+                                write_budget, &be_data);
+        for (auto data : backend_registry)
+            write_data (data, &be_data);
+        if (ferror (out)
+            || fprintf (out, "</%s>\n</" GNC_V2_STRING ">\n\n", BOOK_TAG) < 0)
+            success = FALSE;
+    }
+
+    g_free (gd);
+    return success;
+}
+
 /*
  * This function is called by the "export" code.
  */
@@ -1379,140 +1535,77 @@ gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* qof_be, QofBook* book,
     return success;
 }
 
-#define BUFLEN 4096
+/* The stdio buffer of the data file or of the pipe to the compression
+   thread, so that writing the file isn't a string of small writes. */
+#define FILE_BUFLEN (64 * 1024)
 
 /* Compress or decompress function that is to be run in a separate thread.
  * Returns 1 on success or 0 otherwise, stuffed into a pointer type. */
 static gpointer
 gz_thread_func (gz_thread_params_t* params)
 {
-    gchar buffer[BUFLEN];
-    gssize bytes;
-    gint gzval;
-    gzFile file;
     gint success = 1;
+    int file_fd;
 
-#ifdef G_OS_WIN32
-    {
-        gchar* conv_name = g_win32_locale_filename_from_utf8 (params->filename);
-        gchar* perms;
-
-        if (!conv_name)
-        {
-            g_warning ("Could not convert '%s' to system codepage",
-                       params->filename);
-            success = 0;
-            goto cleanup_gz_thread_func;
-        }
-
-        if (strchr (params->perms, 'b'))
-            perms = g_strdup (params->perms);
-        else
-            perms = g_strdup_printf ("%cb%s", *params->perms, params->perms + 1);
-
-        file = gzopen (conv_name, perms);
-        g_free (perms);
-        g_free (conv_name);
-    }
-#else /* !G_OS_WIN32 */
-    file = gzopen (params->filename, params->perms);
-#endif /* G_OS_WIN32 */
+    if (params->compress)
+        file_fd = g_open (params->filename,
+                          O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    else
+        file_fd = g_open (params->filename, O_RDONLY | O_BINARY, 0);
 
-    if (file == NULL)
+    if (file_fd == -1)
     {
-        g_warning ("Child threads gzopen failed");
+        g_warning ("Child thread could not open '%s'. The error is '%s' (errno %d)",
+                   params->filename,
+                   g_strerror (errno) ? g_strerror (errno) : "", errno);
         success = 0;
-        goto cleanup_gz_thread_func;
-    }
-
-    if (params->compress)
-    {
-        while (success)
-        {
-            bytes = read (params->fd, buffer, BUFLEN);
-            if (bytes > 0)
-            {
-                if (gzwrite (file, buffer, bytes) <= 0)
-                {
-                    gint errnum;
-                    const gchar* error = gzerror (file, &errnum);
-                    g_warning ("Could not write the compressed file '%s'. The error is: '%s' (%d)",
-                               params->filename, error, errnum);
-                    success = 0;
-                }
-            }
-            else if (bytes == 0)
-            {
-                break;
-            }
-            else
-            {
-                g_warning ("Could not read from pipe. The error is '%s' (errno %d)",
-                           g_strerror (errno) ? g_strerror (errno) : "", errno);
-                success = 0;
-            }
-        }
     }
     else
     {
-        while (success)
+        /* Compress with as many threads as there are processors. */
+        if (params->compress)
+            success = gnc_xml_compress_fd (params->fd, file_fd,
+                                           params->compression, params->level,
+                                           0, params->filename);
+        else
+            success = gnc_xml_decompress_fd (file_fd, params->fd,
+                                             params->compression,
+                                             params->filename);
+
+        if (close (file_fd) != 0)
         {
-            gzval = gzread (file, buffer, BUFLEN);
-            if (gzval > 0)
-            {
-                if (
-#if COMPILER(MSVC)
-                    _write
-#else
-                    write
-#endif
-                    (params->fd, buffer, gzval) < 0)
-                {
-                    g_warning ("Could not write to pipe. The error is '%s' (%d)",
-                               g_strerror (errno) ? g_strerror (errno) : "", errno);
-                    success = 0;
-                }
-            }
-            else if (gzval == 0)
-            {
-                break;
-            }
-            else
-            {
-                gint errnum;
-                const gchar* error = gzerror (file, &errnum);
-                g_warning ("Could not read from compressed file '%s'. The error is: '%s' (%d)",
-                           params->filename, error, errnum);
-                success = 0;
-            }
+            g_warning ("Could not close the compressed file '%s'. The error is '%s' (errno %d)",
+                       params->filename,
+                       g_strerror (errno) ? g_strerror (errno) : "", errno);
+            success = 0;
         }
     }
 
-    if ((gzval = gzclose (file)) != Z_OK)
-    {
-        g_warning ("Could not close the compressed file '%s' (errnum %d)",
-                   params->filename, gzval);
-        success = 0;
-    }
-
-cleanup_gz_thread_func:
     close (params->fd);
     g_free (params->filename);
-    g_free (params->perms);
     g_free (params);
 
     return GINT_TO_POINTER (success);
 }
 
 static FILE*
-try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
-             gboolean compress)
+buffered (FILE* file)
+{
+    if (file)
+        setvbuf (file, NULL, _IOFBF, FILE_BUFLEN);
+    return file;
+}
+
+static FILE*
+try_gz_open (const char* filename, const char* perms,
+             GncXmlCompression compression, gint level, gboolean compress)
 {
-    if (strstr (filename, ".gz.") != NULL) /* its got a temp extension */
-        use_gzip = TRUE;
+    if (compression == GncXmlCompression::NONE
+        && strstr (filename, ".gz.") != NULL) /* its got a temp extension */
+        compression = GncXmlCompression::GZIP;
 
-    if (!use_gzip)
-        return g_fopen (filename, perms);
+    if (compression == GncXmlCompression::NONE)
+        return buffered (g_fopen (filename, perms));
 
     {
         int filedes[2];
@@ -1521,21 +1614,22 @@ try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
         FILE* file;
 
 #ifdef G_OS_WIN32
-        if (_pipe (filedes, 4096, _O_BINARY) < 0)
+        if (_pipe (filedes, FILE_BUFLEN, _O_BINARY) < 0)
         {
 #else
         if (pipe (filedes) < 0)
         {
 #endif
             g_warning ("Pipe call failed. Opening uncompressed file.");
-            return g_fopen (filename, perms);
+            return buffered (g_fopen (filename, perms));
         }
 
         params = g_new (gz_thread_params_t, 1);
         params->fd = filedes[compress ? 0 : 1];
         params->filename = g_strdup (filename);
-        params->perms = g_strdup (perms);
         params->compress = compress;
+        params->compression = compression;
+        params->level = level;
 
         thread = g_thread_new ("xml_thread", (GThreadFunc) gz_thread_func,
                                params);
@@ -1543,18 +1637,17 @@ try_gz_open (const char* filename, const char* perms, gboolean use_gzip,
         {
             g_warning ("Could not create thread for (de)compression.");
             g_free (params->filename);
-            g_free (params->perms);
             g_free (params);
             close (filedes[0]);
             close (filedes[1]);
 
-            return g_fopen (filename, perms);
+            return buffered (g_fopen (filename, perms));
         }
 
         if (compress)
-            file = fdopen (filedes[1], "w");
+            file = buffered (fdopen (filedes[1], "w"));
         else
-            file = fdopen (filedes[0], "r");
+            file = buffered (fdopen (filedes[0], "r"));
 
         G_LOCK (threads);
         if (!threads)
@@ -1592,12 +1685,20 @@ gboolean
 gnc_book_write_to_xml_file_v2 (
     QofBook* book,
     const char* filename,
-    gboolean compress)
+    GncXmlCompression compression,
+    gint level)
 {
     FILE* out;
     gboolean success = TRUE;
 
-    out = try_gz_open (filename, "w", compress, TRUE);
+    if (!gnc_xml_compression_supported (compression))
+    {
+        PWARN ("This build cannot write zstd files, using gzip for %s",
+               filename);
+        compression = GncXmlCompression::GZIP;
+    }
+
+    out = try_gz_open (filename, "w", compression, level, TRUE);
 
     /* Try to write as much as possible */
     if (!out
@@ -1609,7 +1710,7 @@ gnc_book_write_to_xml_file_v2 (
         success = FALSE;
 
     /* Optionally wait for parallel compression threads */
-    if (out && compress)
+    if (out && compression != GncXmlCompression::NONE)
         if (!wait_for_gzip (out))
             success = FALSE;
 
@@ -1650,71 +1751,33 @@ gnc_book_write_accounts_to_xml_file_v2 (QofBackend* qof_be, QofBook* book,
 }
 
 /***********************************************************************/
-static gboolean
-is_gzipped_file (const gchar* name)
-{
-    unsigned char buf[2];
-    int fd = g_open (name, O_RDONLY, 0);
-
-    if (fd == -1)
-    {
-        return FALSE;
-    }
-
-    if (read (fd, buf, 2) != 2)
-    {
-        close (fd);
-        return FALSE;
-    }
-    close (fd);
-
-    if (buf[0] == 037 && buf[1] == 0213)
-    {
-        return TRUE;
-    }
-
-    return FALSE;
-}
-
 QofBookFileType
 gnc_is_xml_data_file_v2 (const gchar* name, gboolean* with_encoding)
 {
-    if (is_gzipped_file (name))
+    auto compression = gnc_xml_file_compression (name);
+    if (compression != GncXmlCompression::NONE)
     {
-        gzFile file = NULL;
         char first_chunk[256];
-        int num_read;
+        gssize num_read;
+        int fd = g_open (name, O_RDONLY | O_BINARY, 0);
 
-#ifdef G_OS_WIN32
-        {
-            gchar* conv_name = g_win32_locale_filename_from_utf8 (name);
-            if (!conv_name)
-                g_warning ("Could not convert '%s' to system codepage", name);
-            else
-            {
-                file = gzopen (conv_name, "rb");
-                g_free (conv_name);
-            }
-        }
-#else
-        file = gzopen (name, "r");
-#endif
-        if (file == NULL)
+        if (fd == -1)
             return GNC_BOOK_NOT_OURS;
 
-        num_read = gzread (file, first_chunk, sizeof (first_chunk) - 1);
-        gzclose (file);
+        num_read = gnc_xml_decompress_head (fd, compression, first_chunk,
+                                            sizeof (first_chunk) - 1);
+        close (fd);
 
         if (num_read < 1)
             return GNC_BOOK_NOT_OURS;
 
+        first_chunk[num_read] = '\0';
         return gnc_is_our_first_xml_chunk (first_chunk, with_encoding);
     }
 
     return (gnc_is_our_xml_file (name, with_encoding));
 }
 
-
 static void
 replace_character_references (gchar* string)
 {
@@ -1805,11 +1868,11 @@ gnc_xml2_find_ambiguous (const gchar* filename, GList* encodings,
     GHashTable* processed = NULL;
     gint n_impossible = 0;
     GError* error = NULL;
-    gboolean is_compressed;
+    GncXmlCompression compression;
     gboolean clean_return = FALSE;
 
-    is_compressed = is_gzipped_file (filename);
-    file = try_gz_open (filename, "r", is_compressed, FALSE);
+    compression = gnc_xml_file_compression (filename);
+    file = try_gz_open (filename, "r", compression, 0, FALSE);
     if (file == NULL)
     {
         PWARN ("Unable to open file %s", filename);
@@ -1992,7 +2055,7 @@ cleanup_find_ambs:
     if (file)
     {
         fclose (file);
-        if (is_compressed)
+        if (compression != GncXmlCompression::NONE)
             wait_for_gzip (file);
     }
 
@@ -2014,11 +2077,11 @@ parse_with_subst_push_handler (xmlParserCtxtPtr xml_context,
     GIConv ascii = (GIConv) - 1;
     GString* output = NULL;
     GError* error = NULL;
-    gboolean is_compressed;
+    GncXmlCompression compression;
 
     filename = push_data->filename;
-    is_compressed = is_gzipped_file (filename);
-    file = try_gz_open (filename, "r", is_compressed, FALSE);
+    compression = gnc_xml_file_compression (filename);
+    file = try_gz_open (filename, "r", compression, 0, FALSE);
     if (file == NULL)
     {
         PWARN ("Unable to open file %s", filename);
@@ -2132,7 +2195,7 @@ cleanup_push_handler:
     if (file)
     {
         fclose (file);
-        if (is_compressed)
+        if (compression != GncXmlCompression::NONE)
             wait_for_gzip (file);
     }
 }
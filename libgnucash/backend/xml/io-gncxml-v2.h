@@ -41,6 +41,7 @@ extern "C"
 }
 #include "gnc-backend-xml.h"
 #include "sixtp.h"
+#include "io-gncxml-compress.hpp"
 #include <vector>
 
 class GncXmlBackend;
@@ -90,8 +91,21 @@ gboolean qof_session_load_from_xml_file_v2 (GncXmlBackend*, QofBook*,
 
 /* write all book info to a file */
 gboolean gnc_book_write_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
+/** Write the book to filename, compressed as compression at level 1
+ *  (fastest) to 9 (smallest). */
 gboolean gnc_book_write_to_xml_file_v2 (QofBook* book, const char* filename,
-                                        gboolean compress);
+                                        GncXmlCompression compression,
+                                        gint level);
+
+/** Write the parts of the book that a binary snapshot (io-gncbin.hpp) keeps
+ *  as XML: the template transactions, scheduled transactions, budgets and
+ *  business objects. */
+gboolean gnc_book_write_extras_to_xml_filehandle_v2 (QofBook* book, FILE* fh);
+/** Read what gnc_book_write_extras_to_xml_filehandle_v2 wrote into a book
+ *  that has its commodities, accounts and transactions already. */
+gboolean gnc_book_load_extras_from_xml_buffer_v2 (QofBook* book,
+                                                  const char* buffer,
+                                                  gsize size);
 
 /** write just the commodities and accounts to a file */
 gboolean gnc_book_write_accounts_to_xml_filehandle_v2 (QofBackend* be,
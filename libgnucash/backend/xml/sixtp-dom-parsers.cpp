@@ -471,7 +471,9 @@ gboolean
 dom_tree_create_instance_slots (xmlNodePtr node, QofInstance* inst)
 {
     KvpFrame* frame = qof_instance_get_slots (inst);
-    return dom_tree_to_kvp_frame_given (node, frame);
+    auto ret = dom_tree_to_kvp_frame_given (node, frame);
+    qof_instance_slots_changed (inst);
+    return ret;
 }
 
 gchar*
@@ -30,6 +30,7 @@ extern "C"
 #include "gnc-commodity.h"
 #include "qof.h"
 #include "gnc-budget.h"
+#include "gnc-pricedb.h"
 }
 
 #include "gnc-xml-helper.h"
@@ -60,6 +61,7 @@ Account* dom_tree_to_account (xmlNodePtr node, QofBook* book);
 QofBook* dom_tree_to_book (xmlNodePtr node, QofBook* book);
 GNCLot*  dom_tree_to_lot (xmlNodePtr node, QofBook* book);
 Transaction* dom_tree_to_transaction (xmlNodePtr node, QofBook* book);
+GNCPrice* dom_tree_to_price (xmlNodePtr node, QofBook* book);
 GncBudget* dom_tree_to_budget (xmlNodePtr node, QofBook* book);
 
 struct dom_tree_handler
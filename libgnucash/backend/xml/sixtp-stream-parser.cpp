@@ -0,0 +1,677 @@
+/********************************************************************
+ * sixtp-stream-parser.cpp -- build objects straight from sixtp     *
+ *                            events, without a DOM tree            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+extern "C"
+{
+#include <config.h>
+
+#include <glib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <gnc-engine.h>
+}
+
+#include <memory>
+
+#include "sixtp-stream-parser.hpp"
+#include "sixtp-dom-parsers.h"
+#include "sixtp-utils.h"
+
+static QofLogModule log_module = GNC_MOD_IO;
+
+/***********************************************************************/
+
+void
+GncXmlElement::reset (gchar** attrs)
+{
+    m_text.clear ();
+    m_has_text = m_has_children = false;
+    /* dom_tree_to_guid only looks at the first attribute. */
+    m_guid_type = attrs && attrs[0] && strcmp (attrs[0], "type") == 0 &&
+                  (g_strcmp0 (attrs[1], "guid") == 0 ||
+                   g_strcmp0 (attrs[1], "new") == 0);
+}
+
+bool
+GncXmlElement::to_guid (GncGUID* guid) const
+{
+    if (!m_guid_type)
+        return false;
+    /* Like guid_new, text that isn't a GUID leaves a random one. */
+    guid_replace (guid);
+    string_to_guid (text (), guid);
+    return true;
+}
+
+bool
+GncXmlElement::to_numeric (gnc_numeric* num) const
+{
+    auto str = text ();
+    if (!str)
+        return false;
+    if (!string_to_gnc_numeric (str, num))
+        *num = gnc_numeric_zero ();
+    return true;
+}
+
+/***********************************************************************/
+
+void
+GncXmlStreamParser::start (const gchar* tag, gchar** attrs)
+{
+    if (m_depth > 0)
+        m_elements[m_depth - 1].m_has_children = true;
+    if (m_depth == m_elements.size ())
+        m_elements.emplace_back ();
+    m_elements[m_depth].reset (attrs);
+    if (m_depth > 0)
+        start_element (m_depth, tag, attrs);
+    ++m_depth;
+}
+
+void
+GncXmlStreamParser::characters (const gchar* text, int length)
+{
+    if (m_depth == 0 || length <= 0)
+        return;
+    auto& element = m_elements[m_depth - 1];
+    element.m_text.append (text, length);
+    element.m_has_text = element.m_has_children = true;
+}
+
+void
+GncXmlStreamParser::end (const gchar* tag)
+{
+    /* The top element is finish ()'s business. */
+    if (m_depth <= 1)
+        return;
+    --m_depth;
+    end_element (m_depth, tag, m_elements[m_depth]);
+}
+
+/***********************************************************************/
+
+bool
+GncXmlRecordParser::finish (const gchar* tag, gpointer* result)
+{
+    std::unique_ptr<GncXmlRecord> record {take_record ()};
+    return record->make (m_gdata, tag, result);
+}
+
+/***********************************************************************/
+
+std::size_t
+gnc_xml_field_lookup (const GncXmlField* fields, std::size_t count,
+                      const gchar* tag)
+{
+    std::size_t i = 0;
+    for (; i < count; ++i)
+        if (g_strcmp0 (tag, fields[i].tag) == 0)
+            break;
+    return i;
+}
+
+bool
+gnc_xml_fields_all_gotten (const GncXmlField* fields, std::size_t count,
+                           unsigned gotten)
+{
+    bool ret = true;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (fields[i].required && !(gotten & (1u << i)))
+        {
+            PERR ("Not defined and it should be: %s", fields[i].tag);
+            ret = false;
+        }
+    }
+    if (!ret)
+        PERR ("didn't find all of the expected tags in the input");
+    return ret;
+}
+
+/***********************************************************************/
+
+bool
+GncXmlGuid::read (const GncXmlElement& element)
+{
+    if (!element.m_guid_type)
+        return false;
+    m_random = !string_to_guid (element.text (), &m_guid);
+    return true;
+}
+
+const GncGUID*
+GncXmlGuid::get ()
+{
+    if (m_random)
+    {
+        guid_replace (&m_guid);
+        m_random = false;
+    }
+    return &m_guid;
+}
+
+/***********************************************************************/
+
+void
+GncXmlTimeReader::end_element (const gchar* tag, const GncXmlElement& element)
+{
+    if (m_bad || g_strcmp0 (tag, "ts:date") != 0)
+        return;
+
+    /* Only one ts:date is permitted. */
+    auto text = element.text ();
+    if (m_seen || !text)
+    {
+        m_bad = true;
+        return;
+    }
+    m_time = gnc_iso8601_to_time64_gmt (text);
+    m_seen = true;
+}
+
+time64
+GncXmlTimeReader::value () const
+{
+    if (m_bad)
+        return INT64_MAX;
+    if (!m_seen)
+    {
+        PERR ("no ts:date node found.");
+        return INT64_MAX;
+    }
+    return m_time;
+}
+
+/***********************************************************************/
+
+void
+GncXmlCommodityRefReader::end_element (const gchar* tag,
+                                       const GncXmlElement& element)
+{
+    std::string* str;
+    bool* has;
+
+    if (m_bad)
+        return;
+    if (g_strcmp0 ("cmdty:space", tag) == 0)
+    {
+        str = &m_space;
+        has = &m_has_space;
+    }
+    else if (g_strcmp0 ("cmdty:id", tag) == 0)
+    {
+        str = &m_id;
+        has = &m_has_id;
+    }
+    else
+        return;
+
+    auto text = element.text ();
+    if (*has || !text)
+    {
+        m_bad = true;
+        return;
+    }
+    *str = text;
+    *has = true;
+}
+
+static void
+strip (std::string& str)
+{
+    auto end = str.size ();
+    while (end > 0 && g_ascii_isspace (str[end - 1]))
+        --end;
+    std::string::size_type start = 0;
+    while (start < end && g_ascii_isspace (str[start]))
+        ++start;
+    str = str.substr (start, end - start);
+}
+
+gnc_commodity*
+GncXmlCommodityRefReader::value (QofBook* book)
+{
+    gnc_commodity* ret = NULL;
+    auto table = gnc_commodity_table_get_table (book);
+
+    g_return_val_if_fail (table != NULL, NULL);
+
+    if (!m_bad && m_has_space && m_has_id)
+    {
+        strip (m_space);
+        strip (m_id);
+        /* dom_tree_to_commodity_ref makes a commodity for the lookup,
+           which adds the namespace to the table and moves anything but
+           the template commodity out of the template namespace. */
+        auto name_space = m_space.c_str ();
+        if (m_space == GNC_COMMODITY_NS_TEMPLATE && m_id != "template")
+            name_space = "User";
+        auto nsp = gnc_commodity_table_add_namespace (table, name_space, book);
+        ret = gnc_commodity_table_lookup (table,
+                                          gnc_commodity_namespace_get_name (nsp),
+                                          m_id.c_str ());
+    }
+
+    g_return_val_if_fail (ret != NULL, NULL);
+
+    return ret;
+}
+
+/***********************************************************************/
+
+void
+GncXmlSlotReader::reset (KvpFrame* frame)
+{
+    clear ();
+    m_frame = frame;
+}
+
+GncXmlSlotReader::Node&
+GncXmlSlotReader::push (NodeType type)
+{
+    m_nodes.push_back (Node ());
+    auto& node = m_nodes.back ();
+    node.type = type;
+    return node;
+}
+
+static void
+delete_kvp_value (gpointer data)
+{
+    delete static_cast<KvpValue*> (data);
+}
+
+void
+GncXmlSlotReader::clear ()
+{
+    for (auto& node : m_nodes)
+    {
+        delete node.value;
+        g_list_free_full (node.list, delete_kvp_value);
+        if (node.type == NodeType::VALUE && node.value_type == ValueType::FRAME)
+            delete node.frame;
+    }
+    m_nodes.clear ();
+}
+
+void
+GncXmlSlotReader::start_element (const gchar* tag, gchar** attrs)
+{
+    auto type = NodeType::IGNORED;
+    KvpFrame* frame = nullptr;
+
+    if (m_nodes.empty ())
+    {
+        if (g_strcmp0 (tag, "slot") == 0)
+        {
+            type = NodeType::SLOT;
+            frame = m_frame;
+        }
+    }
+    else
+    {
+        auto& parent = m_nodes.back ();
+        if (parent.type == NodeType::SLOT)
+        {
+            if (g_strcmp0 (tag, "slot:key") == 0)
+                type = NodeType::KEY;
+            else if (g_strcmp0 (tag, "slot:value") == 0)
+                type = NodeType::VALUE;
+        }
+        else if (parent.type == NodeType::VALUE)
+        {
+            switch (parent.value_type)
+            {
+            case ValueType::LIST:
+                /* Every element in a list is a value, whatever its name. */
+                type = NodeType::VALUE;
+                break;
+            case ValueType::FRAME:
+                if (g_strcmp0 (tag, "slot") == 0)
+                {
+                    type = NodeType::SLOT;
+                    frame = parent.frame;
+                }
+                break;
+            case ValueType::TIMESPEC:
+                if (g_strcmp0 (tag, "ts:date") == 0)
+                    type = NodeType::DATE;
+                break;
+            case ValueType::GDATE:
+                if (g_strcmp0 (tag, "gdate") == 0)
+                    type = NodeType::DATE;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    auto& node = push (type);
+    node.frame = frame;
+    if (type != NodeType::VALUE)
+        return;
+
+    /* The type attribute must remain 'timespec' to maintain compatibility. */
+    static const struct
+    {
+        const gchar* tag;
+        ValueType type;
+    } value_types[] =
+    {
+        { "integer", ValueType::INTEGER },
+        { "double", ValueType::DOUBLE },
+        { "numeric", ValueType::NUMERIC },
+        { "string", ValueType::STRING },
+        { "guid", ValueType::GUID },
+        { "timespec", ValueType::TIMESPEC },
+        { "gdate", ValueType::GDATE },
+        { "list", ValueType::LIST },
+        { "frame", ValueType::FRAME },
+    };
+    const gchar* type_str = nullptr;
+    for (auto attr = attrs; attr && attr[0]; attr += 2)
+        if (strcmp (attr[0], "type") == 0)
+        {
+            type_str = attr[1];
+            break;
+        }
+    node.value_type = ValueType::UNKNOWN;
+    for (auto& value_type : value_types)
+        if (g_strcmp0 (type_str, value_type.tag) == 0)
+        {
+            node.value_type = value_type.type;
+            break;
+        }
+    if (node.value_type == ValueType::FRAME)
+        node.frame = new KvpFrame;
+    else if (node.value_type == ValueType::GDATE)
+        g_date_clear (&node.date, 1);
+}
+
+void
+GncXmlSlotReader::end_date (Node& value, const gchar* tag,
+                            const GncXmlElement& element)
+{
+    if (value.value_type == ValueType::TIMESPEC)
+    {
+        value.time.end_element (tag, element);
+        return;
+    }
+
+    /* Like dom_tree_to_gdate. */
+    if (value.date_bad)
+        return;
+    auto text = element.text ();
+    gint year, month, day;
+    if (value.date_seen || !text ||
+        sscanf (text, "%d-%d-%d", &year, &month, &day) != 3)
+    {
+        value.date_bad = true;
+        return;
+    }
+    value.date_seen = true;
+    g_date_set_dmy (&value.date, day, static_cast<GDateMonth> (month), year);
+    if (!g_date_valid (&value.date))
+    {
+        PWARN ("invalid date");
+        value.date_bad = true;
+    }
+}
+
+KvpValue*
+GncXmlSlotReader::make_value (Node& node, const GncXmlElement& element)
+{
+    auto text = element.text ();
+
+    switch (node.value_type)
+    {
+    case ValueType::INTEGER:
+    {
+        gint64 daint;
+        if (text && string_to_gint64 (text, &daint))
+            return new KvpValue {daint};
+        return nullptr;
+    }
+    case ValueType::DOUBLE:
+    {
+        double dadoub;
+        if (text && string_to_double (text, &dadoub))
+            return new KvpValue {dadoub};
+        return nullptr;
+    }
+    case ValueType::NUMERIC:
+    {
+        gnc_numeric danum;
+        if (element.to_numeric (&danum))
+            return new KvpValue {danum};
+        return nullptr;
+    }
+    case ValueType::STRING:
+        if (text)
+            return new KvpValue {static_cast<const gchar*> (g_strdup (text))};
+        return nullptr;
+    case ValueType::GUID:
+    {
+        GncGUID guid;
+        if (element.to_guid (&guid))
+            return new KvpValue {guid_copy (&guid)};
+        return nullptr;
+    }
+    case ValueType::TIMESPEC:
+        return new KvpValue {Time64 {node.time.value ()}};
+    case ValueType::GDATE:
+        if (!node.date_seen || node.date_bad)
+            return nullptr;
+        return new KvpValue {node.date};
+    case ValueType::LIST:
+    {
+        auto list = g_list_reverse (node.list);
+        node.list = nullptr;
+        return new KvpValue {list};
+    }
+    case ValueType::FRAME:
+    {
+        auto frame = node.frame;
+        node.frame = nullptr;
+        return new KvpValue {frame};
+    }
+    default:
+        return nullptr;
+    }
+}
+
+void
+GncXmlSlotReader::end_element (const gchar* tag, const GncXmlElement& element)
+{
+    if (m_nodes.empty ())
+        return;
+
+    auto& node = m_nodes.back ();
+    /* Every node but a top level slot has a parent. */
+    auto parent = m_nodes.size () > 1 ? &m_nodes[m_nodes.size () - 2] : nullptr;
+
+    switch (node.type)
+    {
+    case NodeType::KEY:
+    {
+        auto text = element.text ();
+        parent->has_key = text != nullptr;
+        if (text)
+            parent->key = text;
+        break;
+    }
+    case NodeType::VALUE:
+    {
+        auto value = make_value (node, element);
+        if (parent->type == NodeType::SLOT)
+        {
+            delete parent->value;
+            parent->value = value;
+        }
+        else if (value)
+            parent->list = g_list_prepend (parent->list, value);
+        break;
+    }
+    case NodeType::DATE:
+        end_date (*parent, tag, element);
+        break;
+    case NodeType::SLOT:
+        if (node.has_key && node.value)
+        {
+            //We're deleting the old KvpValue returned by set().
+            delete node.frame->set ({node.key}, node.value);
+            node.value = nullptr;
+        }
+        break;
+    default:
+        break;
+    }
+
+    delete node.value;
+    m_nodes.pop_back ();
+}
+
+/***********************************************************************/
+
+void
+GncXmlSlotsRecord::start_element (const gchar* tag, gchar** attrs)
+{
+    if (!m_reader)
+    {
+        m_frame.reset (new KvpFrame);
+        m_reader.reset (new GncXmlSlotReader);
+        m_reader->reset (m_frame.get ());
+    }
+    m_reader->start_element (tag, attrs);
+}
+
+void
+GncXmlSlotsRecord::end_element (const gchar* tag, const GncXmlElement& element)
+{
+    if (m_reader)
+        m_reader->end_element (tag, element);
+}
+
+void
+GncXmlSlotsRecord::add_to (KvpFrame* frame)
+{
+    m_reader.reset ();
+    if (!m_frame)
+        return;
+    for (auto& key : m_frame->get_keys ())
+    {
+        auto name = key.c_str ();
+        auto value = m_frame->set (&name, 1, nullptr);
+        delete frame->set (&name, 1, value);
+    }
+    m_frame.reset ();
+}
+
+/***********************************************************************/
+
+static gboolean
+stream_chars_handler (GSList* sibling_data, gpointer parent_data,
+                      gpointer global_data, gpointer* result,
+                      const char* text, int length)
+{
+    if (parent_data)
+        static_cast<GncXmlStreamParser*> (parent_data)->characters (text, length);
+    return TRUE;
+}
+
+static gboolean
+stream_end_handler (gpointer data_for_children,
+                    GSList* data_from_children, GSList* sibling_data,
+                    gpointer parent_data, gpointer global_data,
+                    gpointer* result, const gchar* tag)
+{
+    auto parser = static_cast<GncXmlStreamParser*> (data_for_children);
+
+    /* Called again with a NULL tag for the document root when the stream
+       parser is the top level parser. */
+    if (!tag)
+        return TRUE;
+
+    g_return_val_if_fail (parser, FALSE);
+
+    if (parent_data)
+    {
+        parser->end (tag);
+        return TRUE;
+    }
+
+    auto ok = parser->finish (tag, result);
+    delete parser;
+    return ok;
+}
+
+static void
+stream_fail_handler (gpointer data_for_children,
+                     GSList* data_from_children,
+                     GSList* sibling_data,
+                     gpointer parent_data,
+                     gpointer global_data,
+                     gpointer* result,
+                     const gchar* tag)
+{
+    /* Every element's frame shares the parser; the top one owns it. */
+    if (!parent_data && tag)
+        delete static_cast<GncXmlStreamParser*> (data_for_children);
+}
+
+sixtp*
+sixtp_stream_parser_setup (sixtp_start_handler starter,
+                           sixtp_result_handler cleanup_result_by_default_func,
+                           sixtp_result_handler cleanup_result_on_fail_func)
+{
+    sixtp* top_level;
+
+    g_return_val_if_fail (starter, NULL);
+
+    if (! (top_level =
+               sixtp_set_any (sixtp_new (), FALSE,
+                              SIXTP_START_HANDLER_ID, starter,
+                              SIXTP_CHARACTERS_HANDLER_ID, stream_chars_handler,
+                              SIXTP_END_HANDLER_ID, stream_end_handler,
+                              SIXTP_FAIL_HANDLER_ID, stream_fail_handler,
+                              SIXTP_NO_MORE_HANDLERS)))
+    {
+        return NULL;
+    }
+
+    if (cleanup_result_by_default_func)
+        sixtp_set_cleanup_result (top_level, cleanup_result_by_default_func);
+
+    if (cleanup_result_on_fail_func)
+        sixtp_set_result_fail (top_level, cleanup_result_on_fail_func);
+
+    if (!sixtp_add_sub_parser (top_level, SIXTP_MAGIC_CATCHER, top_level))
+    {
+        sixtp_destroy (top_level);
+        return NULL;
+    }
+
+    return top_level;
+}
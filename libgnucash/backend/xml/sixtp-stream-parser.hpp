@@ -0,0 +1,339 @@
+/********************************************************************
+ * sixtp-stream-parser.hpp -- build objects straight from sixtp     *
+ *                            events, without a DOM tree            *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ ********************************************************************/
+
+/* Most of the v2 object parsers collect each object's sub-tree into a
+   libxml2 DOM tree with sixtp_dom_parser_new and then walk the tree.
+   For the objects a big file is mostly made of (transactions with
+   their splits and slots, and prices) that costs a tree node for every
+   element and text run, so those have stream parsers instead: a
+   GncXmlStreamParser subclass is handed each element of the object as
+   it opens and closes and fills in the engine object as it goes.
+
+   The readers and GncXmlElement's conversions follow the dom_tree_to_*
+   functions in sixtp-dom-parsers.h, so that both paths give the same
+   objects for the same input. The DOM parsers remain for all the other
+   object types.
+
+   The transaction and price parsers are GncXmlRecordParsers: they only
+   read the object into a GncXmlRecord of plain data, which then makes
+   the engine object. Reading touches neither the book nor anything else
+   shared, so the pipelined loader in io-gncxml-pipeline.hpp does it on
+   worker threads and makes the objects on the main thread.
+*/
+
+#ifndef SIXTP_STREAM_PARSER_HPP
+#define SIXTP_STREAM_PARSER_HPP
+
+extern "C"
+{
+#include <glib.h>
+#include "gnc-commodity.h"
+#include "qof.h"
+}
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <kvp-frame.hpp>
+
+#include "sixtp.h"
+#include "io-gncxml-gen.h"
+
+/** The contents of an element, as far as a stream parser keeps them. */
+class GncXmlElement
+{
+public:
+    /** The text directly inside the element like dom_tree_to_text: ""
+     *  if the element is empty, NULL if it only holds other elements. */
+    const gchar* text () const noexcept
+    {
+        return m_has_text ? m_text.c_str () : m_has_children ? nullptr : "";
+    }
+    /** Whether the element holds any text or elements. */
+    bool has_children () const noexcept { return m_has_children; }
+    /** Like dom_tree_to_guid: false unless the element's first attribute
+     *  is type="guid" or type="new". */
+    bool to_guid (GncGUID* guid) const;
+    /** Like dom_tree_to_gnc_numeric: false if there's no text, zero if
+     *  the text isn't a number. */
+    bool to_numeric (gnc_numeric* num) const;
+
+private:
+    friend class GncXmlStreamParser;
+    friend class GncXmlGuid;
+    void reset (gchar** attrs);
+
+    std::string m_text;
+    bool m_has_text = false;
+    bool m_has_children = false;
+    bool m_guid_type = false;
+};
+
+/** Builds one object from the elements of its sub-tree. The top
+ *  element's start handler creates it, the end handler calls finish()
+ *  and deletes it, and a failed parse just deletes it, so the
+ *  destructor must get rid of a partly built object.
+ */
+class GncXmlStreamParser
+{
+public:
+    explicit GncXmlStreamParser (gxpf_data* gdata) : m_gdata {gdata} {}
+    GncXmlStreamParser (const GncXmlStreamParser&) = delete;
+    GncXmlStreamParser& operator= (const GncXmlStreamParser&) = delete;
+    virtual ~GncXmlStreamParser () = default;
+
+    void start (const gchar* tag, gchar** attrs);
+    void characters (const gchar* text, int length);
+    void end (const gchar* tag);
+    /** The top element has ended: hand on the object, through the
+     *  callback or in *result. */
+    virtual bool finish (const gchar* tag, gpointer* result) = 0;
+
+protected:
+    /** An element below the top one has started; depth is 1 for the top
+     *  element's children. */
+    virtual void start_element (std::size_t depth, const gchar* tag,
+                                gchar** attrs) = 0;
+    /** That element has ended. */
+    virtual void end_element (std::size_t depth, const gchar* tag,
+                              const GncXmlElement& element) = 0;
+
+    QofBook* book () const noexcept
+    {
+        return static_cast<QofBook*> (m_gdata->bookdata);
+    }
+    const GncXmlElement& top () const noexcept { return m_elements.front (); }
+
+    gxpf_data* m_gdata;
+
+private:
+    /* Kept from one element to the next, so the text buffers are reused. */
+    std::vector<GncXmlElement> m_elements;
+    std::size_t m_depth = 0;
+};
+
+/** An object read by a GncXmlRecordParser, waiting to be made. */
+class GncXmlRecord
+{
+public:
+    virtual ~GncXmlRecord () = default;
+    /** Make the object in gdata's book and hand it on like the object's
+     *  stream parser would, through the callback or in *result. False if
+     *  the object couldn't be read or made. Main thread only. */
+    virtual bool make (gxpf_data* gdata, const gchar* tag,
+                       gpointer* result) = 0;
+};
+
+/** A stream parser that only reads its object into a GncXmlRecord, so it
+ *  can run on any thread; it has no gxpf_data then. finish() makes the
+ *  object straight away.
+ */
+class GncXmlRecordParser : public GncXmlStreamParser
+{
+public:
+    using GncXmlStreamParser::GncXmlStreamParser;
+    bool finish (const gchar* tag, gpointer* result) override;
+    /** The top element has ended: hand over the record, which the caller
+     *  then owns. A bad object still gives one, whose make() fails. */
+    virtual GncXmlRecord* take_record () = 0;
+};
+
+typedef GncXmlRecordParser* (*GncXmlRecordParserNew) (void);
+
+/** A child element that a stream parser handles, like the entries of a
+ *  dom_tree_handler array. A parser keeps a bit mask of the fields it
+ *  has seen, indexed like its array of them.
+ */
+struct GncXmlField
+{
+    const gchar* tag;
+    bool required;
+};
+
+/** The index of tag in fields, or count if it isn't there. */
+std::size_t gnc_xml_field_lookup (const GncXmlField* fields, std::size_t count,
+                                  const gchar* tag);
+/** Whether the gotten mask has all the required fields, complaining about
+ *  the missing ones like dom_tree_generic_parse. */
+bool gnc_xml_fields_all_gotten (const GncXmlField* fields, std::size_t count,
+                                unsigned gotten);
+
+/** A GUID read by a record parser. Text that isn't a GUID gives a random
+ *  one like GncXmlElement::to_guid, but get() only makes it on the main
+ *  thread, as the random generator isn't thread safe.
+ */
+class GncXmlGuid
+{
+public:
+    /** Like GncXmlElement::to_guid. */
+    bool read (const GncXmlElement& element);
+    const GncGUID* get ();
+
+private:
+    GncGUID m_guid;
+    bool m_random = false;
+};
+
+/** Reads a time64 from the ts:date inside an element, like
+ *  dom_tree_to_time64. Pass it the end of each of the element's children.
+ */
+class GncXmlTimeReader
+{
+public:
+    void reset () noexcept { m_seen = m_bad = false; }
+    void end_element (const gchar* tag, const GncXmlElement& element);
+    /** The time, or INT64_MAX if it's missing or bad. */
+    time64 value () const;
+
+private:
+    time64 m_time = INT64_MAX;
+    bool m_seen = false;
+    bool m_bad = false;
+};
+
+/** Reads the cmdty:space and cmdty:id inside an element, like
+ *  dom_tree_to_commodity_ref. Pass it the end of each of the element's
+ *  children.
+ */
+class GncXmlCommodityRefReader
+{
+public:
+    void reset () noexcept { m_has_space = m_has_id = m_bad = false; }
+    void end_element (const gchar* tag, const GncXmlElement& element);
+    /** The commodity in book's table, or NULL. */
+    gnc_commodity* value (QofBook* book);
+
+private:
+    std::string m_space;
+    std::string m_id;
+    bool m_has_space = false;
+    bool m_has_id = false;
+    bool m_bad = false;
+};
+
+/** Adds the slots inside an element to a frame, like
+ *  dom_tree_create_instance_slots. Pass it the start and end of every
+ *  element below the slots element.
+ */
+class GncXmlSlotReader
+{
+public:
+    GncXmlSlotReader () = default;
+    GncXmlSlotReader (const GncXmlSlotReader&) = delete;
+    GncXmlSlotReader& operator= (const GncXmlSlotReader&) = delete;
+    ~GncXmlSlotReader () { clear (); }
+
+    void reset (KvpFrame* frame);
+    void start_element (const gchar* tag, gchar** attrs);
+    void end_element (const gchar* tag, const GncXmlElement& element);
+
+private:
+    enum class NodeType { IGNORED, SLOT, KEY, VALUE, DATE };
+    enum class ValueType
+    {
+        UNKNOWN, INTEGER, DOUBLE, NUMERIC, STRING, GUID, TIMESPEC, GDATE,
+        LIST, FRAME
+    };
+    struct Node
+    {
+        NodeType type;
+        ValueType value_type;
+        KvpFrame* frame;     /* SLOT: where it goes; FRAME value: being built */
+        std::string key;     /* SLOT */
+        bool has_key;
+        KvpValue* value;     /* SLOT */
+        GList* list;         /* LIST value, in reverse */
+        GncXmlTimeReader time;  /* TIMESPEC value */
+        GDate date;          /* GDATE value */
+        bool date_seen;
+        bool date_bad;
+    };
+
+    Node& push (NodeType type);
+    KvpFrame* current_frame () const;
+    KvpValue* make_value (Node& node, const GncXmlElement& element);
+    void end_date (Node& value, const gchar* tag, const GncXmlElement& element);
+    void clear ();
+
+    KvpFrame* m_frame = nullptr;
+    std::vector<Node> m_nodes;
+};
+
+/** Reads the elements below a slots element into a frame of its own, for
+ *  record parsers, which parse on worker threads before the object the
+ *  slots belong to exists: add_to() moves them to it later. Pass it what
+ *  you'd pass a GncXmlSlotReader.
+ */
+class GncXmlSlotsRecord
+{
+public:
+    void start_element (const gchar* tag, gchar** attrs);
+    void end_element (const gchar* tag, const GncXmlElement& element);
+    /** Move the slots read into frame, replacing any with the same key. */
+    void add_to (KvpFrame* frame);
+
+private:
+    std::unique_ptr<KvpFrame> m_frame;
+    std::unique_ptr<GncXmlSlotReader> m_reader;
+};
+
+sixtp* sixtp_stream_parser_setup (sixtp_start_handler starter,
+                                  sixtp_result_handler cleanup_result_by_default_func,
+                                  sixtp_result_handler cleanup_result_on_fail_func);
+
+template <class Parser> gboolean
+sixtp_stream_start_handler (GSList* sibling_data, gpointer parent_data,
+                            gpointer global_data, gpointer* data_for_children,
+                            gpointer* result, const gchar* tag, gchar** attrs)
+{
+    GncXmlStreamParser* parser;
+
+    /* Called with no tag for the document root when the stream parser
+       is the top level parser. */
+    if (!tag)
+        return TRUE;
+
+    /* parent_data is only NULL for the object's top element. */
+    if (parent_data)
+        parser = static_cast<GncXmlStreamParser*> (parent_data);
+    else
+        parser = new Parser (static_cast<gxpf_data*> (global_data));
+
+    *data_for_children = parser;
+    parser->start (tag, attrs);
+    return TRUE;
+}
+
+/** Create a parser for the sub-tree of an object, which is built by a
+ *  Parser (a GncXmlStreamParser) instead of going into a DOM tree.
+ */
+template <class Parser> sixtp*
+sixtp_stream_parser_new (sixtp_result_handler cleanup_result_by_default_func,
+                         sixtp_result_handler cleanup_result_on_fail_func)
+{
+    return sixtp_stream_parser_setup (sixtp_stream_start_handler<Parser>,
+                                      cleanup_result_by_default_func,
+                                      cleanup_result_on_fail_func);
+}
+
+#endif /* SIXTP_STREAM_PARSER_HPP */
@@ -0,0 +1,176 @@
+/********************************************************************\
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/* Save each of the xml2 test files as a binary snapshot and check that
+ * the snapshot loads back into the same book. */
+extern "C"
+{
+#include <config.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <cashobjects.h>
+#include <TransLog.h>
+#include <gnc-engine.h>
+#include <gnc-pricedb.h>
+}
+
+#include <string>
+
+#include <test-stuff.h>
+
+#define GNC_LIB_NAME "gncmod-backend-xml"
+#define GNC_LIB_REL_PATH "xml"
+
+static guint
+count (QofBook* book, QofIdTypeConst type)
+{
+    return qof_collection_count (qof_book_get_collection (book, type));
+}
+
+static void
+remove_snapshot (const std::string& snapshot)
+{
+    g_unlink (snapshot.c_str ());
+    g_unlink ((snapshot + ".LCK").c_str ());
+}
+
+static void
+test_file (const char* filename, const std::string& snapshot)
+{
+    auto session = qof_session_new ();
+    qof_session_begin (session, filename, TRUE, FALSE, FALSE);
+    qof_session_load (session, NULL);
+    do_test_args (qof_session_get_error (session) == ERR_BACKEND_NO_ERR,
+                  "load xml2", __FILE__, __LINE__,
+                  "qof error=%d for file [%s]",
+                  qof_session_get_error (session), filename);
+
+    remove_snapshot (snapshot);
+    auto bin_session = qof_session_new ();
+    qof_session_begin (bin_session, ("gncbin://" + snapshot).c_str (), FALSE,
+                       TRUE, FALSE);
+    qof_session_swap_data (session, bin_session);
+    qof_session_save (bin_session, NULL);
+    do_test_args (qof_session_get_error (bin_session) == ERR_BACKEND_NO_ERR,
+                  "save snapshot", __FILE__, __LINE__,
+                  "qof error=%d for file [%s]",
+                  qof_session_get_error (bin_session), filename);
+    qof_session_swap_data (session, bin_session);
+    qof_session_destroy (bin_session);
+
+    /* A plain file URI finds the snapshot backend by the file's header. */
+    auto loaded = qof_session_new ();
+    qof_session_begin (loaded, ("file://" + snapshot).c_str (), FALSE, FALSE,
+                       FALSE);
+    qof_session_load (loaded, NULL);
+    do_test_args (qof_session_get_error (loaded) == ERR_BACKEND_NO_ERR,
+                  "load snapshot", __FILE__, __LINE__,
+                  "qof error=%d for file [%s]",
+                  qof_session_get_error (loaded), filename);
+
+    auto book = qof_session_get_book (session);
+    auto bin_book = qof_session_get_book (loaded);
+    do_test_args (xaccAccountEqual (gnc_book_get_root_account (book),
+                                    gnc_book_get_root_account (bin_book), TRUE),
+                  "accounts and transactions", __FILE__, __LINE__,
+                  "snapshot of [%s] differs", filename);
+    do_test_args (qof_instance_guid_compare (book, bin_book) == 0
+                  && count (book, GNC_ID_TRANS) == count (bin_book, GNC_ID_TRANS)
+                  && count (book, GNC_ID_SPLIT) == count (bin_book, GNC_ID_SPLIT)
+                  && count (book, GNC_ID_LOT) == count (bin_book, GNC_ID_LOT)
+                  && count (book, GNC_ID_SCHEDXACTION)
+                     == count (bin_book, GNC_ID_SCHEDXACTION)
+                  && count (book, GNC_ID_BUDGET) == count (bin_book, GNC_ID_BUDGET)
+                  && gnc_pricedb_get_num_prices (gnc_pricedb_get_db (book))
+                     == gnc_pricedb_get_num_prices (gnc_pricedb_get_db (bin_book)),
+                  "book contents", __FILE__, __LINE__,
+                  "snapshot of [%s] differs", filename);
+
+    qof_session_destroy (loaded);
+    qof_session_destroy (session);
+    remove_snapshot (snapshot);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_setenv ("GNC_UNINSTALLED", "1", TRUE);
+    const char* location = g_getenv ("GNC_TEST_FILES");
+    int files_tested = 0;
+    GDir* xml2_dir;
+
+    qof_init ();
+    cashobjects_register ();
+    do_test (qof_load_backend_library (GNC_LIB_REL_PATH, GNC_LIB_NAME),
+             " loading gnc-backend-xml GModule failed");
+
+    if (!location)
+        location = "test-files/xml2";
+
+    xaccLogDisable ();
+
+    gchar* tmp_name = NULL;
+    int fd = g_file_open_tmp ("test-xml-bin-XXXXXX", &tmp_name, NULL);
+    if (fd == -1)
+    {
+        failure ("could not make a temporary file");
+        exit (get_rv ());
+    }
+    close (fd);
+    std::string snapshot {tmp_name};
+    g_free (tmp_name);
+
+    if ((xml2_dir = g_dir_open (location, 0, NULL)) == NULL)
+    {
+        failure ("unable to open xml2 directory");
+    }
+    else
+    {
+        const gchar* entry;
+
+        while ((entry = g_dir_read_name (xml2_dir)) != NULL)
+        {
+            if (g_str_has_suffix (entry, ".gml2"))
+            {
+                gchar* to_open = g_build_filename (location, entry, (gchar*)NULL);
+                if (!g_file_test (to_open, G_FILE_TEST_IS_DIR))
+                {
+                    test_file (to_open, snapshot);
+                    files_tested++;
+                }
+                g_free (to_open);
+            }
+        }
+        g_dir_close (xml2_dir);
+    }
+
+    remove_snapshot (snapshot);
+    if (files_tested == 0)
+    {
+        failure ("handled 0 files in test-xml-bin");
+    }
+
+    print_test_results ();
+    qof_close ();
+    exit (get_rv ());
+}
@@ -0,0 +1,185 @@
+/********************************************************************\
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+}
+
+#include <string>
+
+#include "io-gncxml-compress.hpp"
+#include "test-stuff.h"
+
+/* Enough for a good number of the gzip writer's blocks. */
+#define NUM_LINES 40000
+
+static std::string
+make_data (int lines)
+{
+    std::string data ("<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n<gnc-v2>\n");
+    for (int i = 0; i < lines; ++i)
+    {
+        gchar* line = g_strdup_printf ("<trn:description>Payment %d of %d"
+                                       "</trn:description>\n", i, rand ());
+        data += line;
+        g_free (line);
+    }
+    return data + "</gnc-v2>\n";
+}
+
+static gchar*
+write_temp_file (const std::string& data)
+{
+    gchar* name = NULL;
+    int fd = g_file_open_tmp ("test-xml-compress-XXXXXX", &name, NULL);
+    if (fd == -1)
+        return NULL;
+    if (write (fd, data.data (), data.size ())
+        != static_cast<gssize> (data.size ()))
+    {
+        close (fd);
+        g_unlink (name);
+        g_free (name);
+        return NULL;
+    }
+    close (fd);
+    return name;
+}
+
+static std::string
+read_file (const gchar* name)
+{
+    gchar* contents = NULL;
+    gsize length = 0;
+    std::string data;
+    if (g_file_get_contents (name, &contents, &length, NULL))
+        data.assign (contents, length);
+    g_free (contents);
+    return data;
+}
+
+/* Read a gzip file with plain zlib, to be sure the writer's blocks make up
+   an ordinary gzip file. */
+static std::string
+gunzip_file (const gchar* name)
+{
+    std::string data;
+    gzFile file = gzopen (name, "rb");
+    if (file == NULL)
+        return data;
+
+    char buffer[4096];
+    int bytes;
+    while ((bytes = gzread (file, buffer, sizeof (buffer))) > 0)
+        data.append (buffer, bytes);
+    if (gzclose (file) != Z_OK || bytes < 0)
+        data.clear ();
+    return data;
+}
+
+static gboolean
+transcode (const gchar* from, const gchar* to, GncXmlCompression type,
+           guint threads, gboolean compress)
+{
+    int in_fd = g_open (from, O_RDONLY, 0);
+    int out_fd = g_open (to, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    gboolean success = in_fd != -1 && out_fd != -1;
+
+    if (success && compress)
+        success = gnc_xml_compress_fd (in_fd, out_fd, type, 6, threads, to);
+    else if (success)
+        success = gnc_xml_decompress_fd (in_fd, out_fd, type, from);
+
+    if (in_fd != -1)
+        close (in_fd);
+    if (out_fd != -1)
+        close (out_fd);
+    return success;
+}
+
+static void
+test_round_trip (GncXmlCompression type, const std::string& data,
+                 guint threads, const char* title)
+{
+    gchar* plain = write_temp_file (data);
+    gchar* packed = write_temp_file ("");
+    gchar* unpacked = write_temp_file ("");
+
+    if (!plain || !packed || !unpacked)
+    {
+        failure ("could not make temporary files");
+        return;
+    }
+
+    gchar* what = g_strdup_printf ("%s, %u threads", title, threads);
+    do_test (transcode (plain, packed, type, threads, TRUE), what);
+    do_test (gnc_xml_file_compression (packed) == type, what);
+    if (type == GncXmlCompression::GZIP)
+        do_test (gunzip_file (packed) == data, what);
+
+    do_test (transcode (packed, unpacked, type, threads, FALSE), what);
+    do_test (read_file (unpacked) == data, what);
+
+    char head[64];
+    int fd = g_open (packed, O_RDONLY, 0);
+    gssize bytes = gnc_xml_decompress_head (fd, type, head, sizeof (head));
+    close (fd);
+    do_test (bytes == static_cast<gssize> (MIN (sizeof (head), data.size ()))
+             && data.compare (0, bytes, head, bytes) == 0, what);
+    g_free (what);
+
+    for (auto name : { plain, packed, unpacked })
+    {
+        g_unlink (name);
+        g_free (name);
+    }
+}
+
+int
+main (int argc, char** argv)
+{
+    auto data = make_data (NUM_LINES);
+
+    test_round_trip (GncXmlCompression::GZIP, data, 1, "gzip");
+    test_round_trip (GncXmlCompression::GZIP, data, 4, "gzip");
+    test_round_trip (GncXmlCompression::GZIP, "", 4, "gzip, empty file");
+    test_round_trip (GncXmlCompression::GZIP, make_data (1), 4,
+                     "gzip, one block");
+    do_test (gnc_xml_compression_supported (GncXmlCompression::GZIP),
+             "gzip is supported");
+#ifdef HAVE_ZSTD
+    test_round_trip (GncXmlCompression::ZSTD, data, 1, "zstd");
+    test_round_trip (GncXmlCompression::ZSTD, data, 4, "zstd");
+    test_round_trip (GncXmlCompression::ZSTD, "", 1, "zstd, empty file");
+#else
+    do_test (!gnc_xml_compression_supported (GncXmlCompression::ZSTD),
+             "zstd is not supported");
+#endif
+
+    print_test_results ();
+    exit (get_rv ());
+}
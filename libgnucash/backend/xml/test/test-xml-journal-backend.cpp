@@ -0,0 +1,295 @@
+/********************************************************************\
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+/* The journal as the XML backend keeps it: commits are noted, incremental
+ * saves append to the journal, loading replays it, and full saves and
+ * closing the file fold it into the data file. */
+extern "C"
+{
+#include <config.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <utime.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <cashobjects.h>
+#include <TransLog.h>
+#include <gnc-engine.h>
+#include <gnc-prefs.h>
+}
+
+#include <string>
+
+#include <test-stuff.h>
+
+#define GNC_LIB_NAME "gncmod-backend-xml"
+#define GNC_LIB_REL_PATH "xml"
+
+static bool
+session_ok (QofSession* session)
+{
+    return qof_session_get_error (session) == ERR_BACKEND_NO_ERR;
+}
+
+static bool
+file_exists (const std::string& filename)
+{
+    return g_file_test (filename.c_str (), G_FILE_TEST_EXISTS);
+}
+
+static guint
+count_transactions (QofBook* book)
+{
+    return qof_collection_count (qof_book_get_collection (book, GNC_ID_TRANS));
+}
+
+static void
+set_description (Transaction* trans, const char* description)
+{
+    xaccTransBeginEdit (trans);
+    xaccTransSetDescription (trans, description);
+    xaccTransCommitEdit (trans);
+}
+
+static Transaction*
+make_transaction (QofBook* book)
+{
+    auto table = gnc_commodity_table_get_table (book);
+    auto usd = gnc_commodity_table_lookup (table, GNC_COMMODITY_NS_CURRENCY,
+                                           "USD");
+    auto root = gnc_book_get_root_account (book);
+    const char* names[] = {"From", "To"};
+    Account* accounts[2];
+    for (int i = 0; i < 2; ++i)
+    {
+        accounts[i] = xaccMallocAccount (book);
+        xaccAccountBeginEdit (accounts[i]);
+        xaccAccountSetName (accounts[i], names[i]);
+        xaccAccountSetType (accounts[i], ACCT_TYPE_BANK);
+        xaccAccountSetCommodity (accounts[i], usd);
+        gnc_account_append_child (root, accounts[i]);
+        xaccAccountCommitEdit (accounts[i]);
+    }
+
+    auto trans = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, usd);
+    xaccTransSetDatePostedSecsNormalized (trans, gnc_time (NULL));
+    xaccTransSetDescription (trans, "base");
+    for (int i = 0; i < 2; ++i)
+    {
+        auto split = xaccMallocSplit (book);
+        xaccSplitSetParent (split, trans);
+        xaccSplitSetAccount (split, accounts[i]);
+        xaccSplitSetAmount (split, gnc_numeric_create (i ? 100 : -100, 100));
+        xaccSplitSetValue (split, gnc_numeric_create (i ? 100 : -100, 100));
+    }
+    xaccTransCommitEdit (trans);
+    return trans;
+}
+
+/* Open the data file in a session of its own, leaving the lock alone. */
+static QofSession*
+open_file (const std::string& uri, const GncGUID* guid, Transaction** trans)
+{
+    auto session = qof_session_new ();
+    qof_session_begin (session, uri.c_str (), TRUE, FALSE, FALSE);
+    qof_session_load (session, NULL);
+    *trans = xaccTransLookup (guid, qof_session_get_book (session));
+    return session;
+}
+
+static void
+test_backend_journal (const std::string& datafile)
+{
+    auto uri = "xml://" + datafile;
+    auto journal = datafile + ".journal";
+    Transaction* loaded;
+
+    auto session = qof_session_new ();
+    qof_session_begin (session, uri.c_str (), FALSE, TRUE, FALSE);
+    auto book = qof_session_get_book (session);
+    auto trans = make_transaction (book);
+    GncGUID guid = *qof_instance_get_guid (QOF_INSTANCE (trans));
+    qof_session_save (session, NULL);
+    do_test (session_ok (session) && !qof_book_session_not_saved (book)
+             && !file_exists (journal), "full save");
+
+    /* A commit is noted and goes to the journal. */
+    set_description (trans, "first");
+    qof_session_save_incremental (session, NULL);
+    do_test (session_ok (session) && file_exists (journal)
+             && !qof_book_session_not_saved (book)
+             && qof_book_session_journaled (book),
+             "incremental save appends to the journal");
+
+    /* Saving in full still does something, and removes the journal. */
+    qof_session_save (session, NULL);
+    do_test (session_ok (session) && !file_exists (journal)
+             && !qof_book_session_journaled (book),
+             "full save folds the journal into the file");
+
+    set_description (trans, "second");
+    qof_session_save_incremental (session, NULL);
+    do_test (session_ok (session) && file_exists (journal),
+             "second incremental save");
+
+    /* Loading replays the journal. */
+    auto other = open_file (uri, &guid, &loaded);
+    auto other_book = qof_session_get_book (other);
+    do_test (session_ok (other) && loaded
+             && g_strcmp0 (xaccTransGetDescription (loaded), "second") == 0
+             && !qof_book_session_not_saved (other_book)
+             && qof_book_session_journaled (other_book),
+             "load replays the journal");
+    /* As if the changes were thrown away, so closing doesn't save. */
+    qof_book_mark_session_dirty (other_book);
+    qof_session_destroy (other);
+    do_test (file_exists (journal), "closing a dirty book keeps the journal");
+
+    /* Closing the file folds the journal into it. */
+    qof_session_destroy (session);
+    do_test (!file_exists (journal), "closing folds the journal into the file");
+    other = open_file (uri, &guid, &loaded);
+    do_test (session_ok (other) && loaded
+             && g_strcmp0 (xaccTransGetDescription (loaded), "second") == 0
+             && !qof_book_session_journaled (qof_session_get_book (other)),
+             "journal folded into the file on closing");
+    qof_session_destroy (other);
+
+    /* A voided transaction is read-only, which mustn't keep the journal
+     * from replacing it. */
+    session = qof_session_new ();
+    qof_session_begin (session, uri.c_str (), FALSE, FALSE, FALSE);
+    qof_session_load (session, NULL);
+    trans = xaccTransLookup (&guid, qof_session_get_book (session));
+    xaccTransVoid (trans, "journal test");
+    qof_session_save (session, NULL);
+    xaccTransUnvoid (trans);
+    qof_session_save_incremental (session, NULL);
+    do_test (session_ok (session) && file_exists (journal),
+             "incremental save of an unvoided transaction");
+
+    other = open_file (uri, &guid, &loaded);
+    do_test (session_ok (other) && loaded && !xaccTransGetVoidStatus (loaded)
+             && count_transactions (qof_session_get_book (other)) == 1,
+             "journal replaces a read-only transaction");
+    qof_session_destroy (other);
+    qof_session_destroy (session);
+
+    /* A journal with a record that won't replay is set aside whole. */
+    session = qof_session_new ();
+    qof_session_begin (session, uri.c_str (), FALSE, FALSE, FALSE);
+    qof_session_load (session, NULL);
+    trans = xaccTransLookup (&guid, qof_session_get_book (session));
+    set_description (trans, "third");
+    qof_session_save_incremental (session, NULL);
+    auto out = g_fopen (journal.c_str (), "ab");
+    fputs ("<journal:save>\n<gnc:transaction version=\"2.0.0\">\n"
+           "<trn:id type=\"guid\">0123456789abcdef0123456789abcdef</trn:id>\n"
+           "</gnc:transaction>\n"
+           "</journal:save>\n", out);
+    fclose (out);
+
+    other = open_file (uri, &guid, &loaded);
+    do_test (session_ok (other) && loaded
+             && g_strcmp0 (xaccTransGetDescription (loaded), "second") == 0,
+             "damaged journal not replayed at all");
+    do_test (!file_exists (journal) && file_exists (journal + ".bad"),
+             "damaged journal moved aside");
+    do_test (qof_book_session_not_saved (qof_session_get_book (other)),
+             "book dirty after setting the journal aside");
+    qof_session_destroy (other);
+    qof_session_destroy (session);
+
+    /* So is a journal whose data file changed since it was begun. */
+    g_unlink ((journal + ".bad").c_str ());
+    session = qof_session_new ();
+    qof_session_begin (session, uri.c_str (), FALSE, FALSE, FALSE);
+    qof_session_load (session, NULL);
+    trans = xaccTransLookup (&guid, qof_session_get_book (session));
+    set_description (trans, "fourth");
+    qof_session_save_incremental (session, NULL);
+    GStatBuf statbuf;
+    g_stat (datafile.c_str (), &statbuf);
+    struct utimbuf times = {statbuf.st_atime, statbuf.st_mtime - 10};
+    g_utime (datafile.c_str (), &times);
+
+    other = open_file (uri, &guid, &loaded);
+    do_test (session_ok (other) && loaded
+             && g_strcmp0 (xaccTransGetDescription (loaded), "third") == 0,
+             "stale journal not replayed");
+    do_test (!file_exists (journal) && file_exists (journal + ".bad"),
+             "stale journal moved aside");
+    do_test (qof_book_session_not_saved (qof_session_get_book (other)),
+             "book dirty after setting the stale journal aside");
+    qof_session_destroy (other);
+    qof_session_destroy (session);
+}
+
+/* Remove the data file and all that the backend put next to it. */
+static void
+remove_dir (const gchar* dirname)
+{
+    auto dir = g_dir_open (dirname, 0, NULL);
+    if (!dir)
+        return;
+
+    const gchar* entry;
+    while ((entry = g_dir_read_name (dir)) != NULL)
+    {
+        auto filename = g_build_filename (dirname, entry, (gchar*)NULL);
+        g_unlink (filename);
+        g_free (filename);
+    }
+    g_dir_close (dir);
+    g_rmdir (dirname);
+}
+
+int
+main (int argc, char** argv)
+{
+    g_setenv ("GNC_UNINSTALLED", "1", TRUE);
+    qof_init ();
+    cashobjects_register ();
+    do_test (qof_load_backend_library (GNC_LIB_REL_PATH, GNC_LIB_NAME),
+             " loading gnc-backend-xml GModule failed");
+    xaccLogDisable ();
+    gnc_prefs_set_file_save_incremental (TRUE);
+
+    auto dirname = g_dir_make_tmp ("test-xml-journal-backend-XXXXXX", NULL);
+    if (!dirname)
+    {
+        failure ("could not make a temporary directory");
+        exit (get_rv ());
+    }
+    auto datafile = g_build_filename (dirname, "book.gnucash", (gchar*)NULL);
+
+    test_backend_journal (datafile);
+
+    g_free (datafile);
+    remove_dir (dirname);
+    g_free (dirname);
+
+    print_test_results ();
+    qof_close ();
+    exit (get_rv ());
+}
@@ -0,0 +1,253 @@
+/********************************************************************\
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Account.h"
+#include "cashobjects.h"
+#include "gnc-engine.h"
+#include "gnc-pricedb.h"
+#include "qofinstance-p.h"
+#include "Transaction.h"
+}
+
+#include "io-gncxml-journal.hpp"
+#include "test-stuff.h"
+
+static Account*
+make_account (QofBook* book, gnc_commodity* commodity, const char* name)
+{
+    auto account = xaccMallocAccount (book);
+    xaccAccountBeginEdit (account);
+    xaccAccountSetName (account, name);
+    xaccAccountSetType (account, ACCT_TYPE_BANK);
+    xaccAccountSetCommodity (account, commodity);
+    gnc_account_append_child (gnc_book_get_root_account (book), account);
+    xaccAccountCommitEdit (account);
+    return account;
+}
+
+static Split*
+make_split (QofBook* book, Transaction* trans, Account* account, gint64 amount)
+{
+    auto split = xaccMallocSplit (book);
+    xaccSplitSetParent (split, trans);
+    xaccSplitSetAccount (split, account);
+    xaccSplitSetAmount (split, gnc_numeric_create (amount, 100));
+    xaccSplitSetValue (split, gnc_numeric_create (amount, 100));
+    return split;
+}
+
+static Transaction*
+make_transaction (QofBook* book, Account* from, Account* to,
+                  const char* description, gint64 amount)
+{
+    auto trans = xaccMallocTransaction (book);
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, xaccAccountGetCommodity (from));
+    xaccTransSetDatePostedSecsNormalized (trans, gnc_time (NULL));
+    xaccTransSetDescription (trans, description);
+    make_split (book, trans, from, -amount);
+    make_split (book, trans, to, amount);
+    xaccTransCommitEdit (trans);
+    return trans;
+}
+
+static GNCPrice*
+make_price (QofBook* book, gnc_commodity* commodity, gnc_commodity* currency)
+{
+    auto price = gnc_price_create (book);
+    gnc_price_begin_edit (price);
+    gnc_price_set_commodity (price, commodity);
+    gnc_price_set_currency (price, currency);
+    gnc_price_set_time64 (price, gnc_time (NULL));
+    gnc_price_set_source_string (price, "user:price");
+    gnc_price_set_typestr (price, "last");
+    gnc_price_set_value (price, gnc_numeric_create (12345, 100));
+    gnc_price_commit_edit (price);
+    gnc_pricedb_add_price (gnc_pricedb_get_db (book), price);
+    gnc_price_unref (price);
+    return price;
+}
+
+static void
+set_description (Transaction* trans, const char* description)
+{
+    xaccTransBeginEdit (trans);
+    xaccTransSetDescription (trans, description);
+    xaccTransCommitEdit (trans);
+}
+
+static void
+destroy_transaction (Transaction* trans)
+{
+    xaccTransBeginEdit (trans);
+    xaccTransDestroy (trans);
+    xaccTransCommitEdit (trans);
+}
+
+/* What the backend's commit does with an instance just edited. */
+static void
+note_changed (GncXmlJournal& journal, gpointer inst)
+{
+    qof_instance_set_dirty (QOF_INSTANCE (inst));
+    journal.note (QOF_INSTANCE (inst));
+}
+
+static void
+test_journal (QofBook* book, const std::string& datafile)
+{
+    auto table = gnc_commodity_table_get_table (book);
+    auto usd = gnc_commodity_table_insert (table,
+        gnc_commodity_new (book, "US Dollar", GNC_COMMODITY_NS_CURRENCY, "USD",
+                           NULL, 100));
+    auto stock = gnc_commodity_table_insert (table,
+        gnc_commodity_new (book, "Stock", "NASDAQ", "STK", NULL, 1000));
+    auto db = gnc_pricedb_get_db (book);
+    auto checking = make_account (book, usd, "Checking");
+    auto savings = make_account (book, usd, "Savings");
+
+    /* The book as the data file has it. */
+    auto trans1 = make_transaction (book, checking, savings, "base", 10000);
+    GncGUID guid1 = *qof_instance_get_guid (QOF_INSTANCE (trans1));
+
+    GncXmlJournal journal{datafile};
+    do_test (journal.size () == 0 && journal.can_append (), "no journal yet");
+
+    set_description (trans1, "changed");
+    auto trans2 = make_transaction (book, savings, checking, "new", 2500);
+    auto price = make_price (book, stock, usd);
+    GncGUID guid2 = *qof_instance_get_guid (QOF_INSTANCE (trans2));
+    GncGUID price_guid = *qof_instance_get_guid (QOF_INSTANCE (price));
+    note_changed (journal, trans1);
+    note_changed (journal, trans2);
+    note_changed (journal, price);
+    do_test (journal.append (book) && journal.size () > 0, "append a save");
+
+    /* Back to the book as loaded from the data file. */
+    set_description (trans1, "base");
+    destroy_transaction (trans2);
+    gnc_pricedb_remove_price (db, price);
+
+    GncXmlJournal loaded{datafile};
+    /* Replaying puts new copies of the transactions in the book. */
+    do_test (loaded.replay (book), "replay the journal");
+    trans1 = xaccTransLookup (&guid1, book);
+    do_test (trans1
+             && g_strcmp0 (xaccTransGetDescription (trans1), "changed") == 0,
+             "changed transaction replayed");
+    trans2 = xaccTransLookup (&guid2, book);
+    do_test (trans2 && xaccTransCountSplits (trans2) == 2
+             && g_strcmp0 (xaccTransGetDescription (trans2), "new") == 0,
+             "new transaction replayed");
+    price = gnc_price_lookup (&price_guid, book);
+    do_test (price && gnc_pricedb_get_num_prices (db) == 1
+             && gnc_numeric_equal (gnc_price_get_value (price),
+                                   gnc_numeric_create (12345, 100)),
+             "new price replayed");
+
+    /* A second save, deleting what the first added. */
+    note_changed (loaded, trans2);
+    destroy_transaction (trans2);
+    note_changed (loaded, price);
+    gnc_pricedb_remove_price (db, price);
+    do_test (loaded.append (book), "append a second save");
+
+    set_description (trans1, "base");
+    GncXmlJournal reloaded{datafile};
+    do_test (reloaded.replay (book), "replay both saves");
+    trans1 = xaccTransLookup (&guid1, book);
+    do_test (trans1
+             && g_strcmp0 (xaccTransGetDescription (trans1), "changed") == 0
+             && !xaccTransLookup (&guid2, book)
+             && gnc_pricedb_get_num_prices (db) == 0,
+             "deletions replayed");
+
+    /* Accounts aren't journaled. */
+    do_test (reloaded.can_append (), "transactions can be appended");
+    note_changed (reloaded, checking);
+    do_test (!reloaded.can_append (), "account changes can't be appended");
+    reloaded.reset ();
+    do_test (reloaded.can_append () && reloaded.size () == 0,
+             "reset removes the journal");
+
+    /* A save cut short ends the journal. */
+    set_description (trans1, "torn");
+    note_changed (reloaded, trans1);
+    do_test (reloaded.append (book), "append before a torn save");
+    auto out = g_fopen ((datafile + ".journal").c_str (), "ab");
+    fputs ("<journal:save>\n<gnc:transaction version=\"2.0.0\">\n", out);
+    fclose (out);
+    set_description (trans1, "base");
+    GncXmlJournal torn{datafile};
+    do_test (torn.replay (book), "replay a torn journal");
+    trans1 = xaccTransLookup (&guid1, book);
+    do_test (trans1 && g_strcmp0 (xaccTransGetDescription (trans1), "torn") == 0,
+             "complete saves of a torn journal replayed");
+    do_test (!torn.can_append (), "no appending to a torn journal");
+
+    /* A journal that doesn't belong to the data file is ignored. */
+    out = g_fopen (datafile.c_str (), "ab");
+    fputs ("rewritten\n", out);
+    fclose (out);
+    set_description (trans1, "base");
+    GncXmlJournal stale{datafile};
+    do_test (stale.replay (book)
+             && g_strcmp0 (xaccTransGetDescription (trans1), "base") == 0
+             && stale.size () == 0,
+             "stale journal ignored and removed");
+}
+
+int
+main (int argc, char** argv)
+{
+    qof_init ();
+    cashobjects_register ();
+
+    gchar* datafile = NULL;
+    int fd = g_file_open_tmp ("test-xml-journal-XXXXXX", &datafile, NULL);
+    if (fd == -1)
+    {
+        failure ("could not make a temporary file");
+        exit (get_rv ());
+    }
+    if (write (fd, "<gnc-v2/>\n", 10) != 10)
+        failure ("could not write the data file");
+    close (fd);
+
+    auto book = qof_book_new ();
+    test_journal (book, datafile);
+    qof_book_destroy (book);
+
+    g_unlink ((std::string{datafile} + ".journal").c_str ());
+    g_unlink (datafile);
+    g_free (datafile);
+
+    print_test_results ();
+    qof_close ();
+    exit (get_rv ());
+}
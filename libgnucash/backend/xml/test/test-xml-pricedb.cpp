@@ -33,6 +33,7 @@ extern "C"
 #include "cashobjects.h"
 #include "gnc-engine.h"
 #include "gnc-pricedb.h"
+#include "gnc-prefs.h"
 
 #include "test-engine-stuff.h"
 }
@@ -42,6 +43,7 @@ extern "C"
 #include "sixtp.h"
 #include "sixtp-parsers.h"
 #include "sixtp-dom-parsers.h"
+#include "sixtp-stream-parser.hpp"
 #include "io-gncxml-v2.h"
 #include "test-file-stuff.h"
 #include "test-stuff.h"
@@ -153,6 +155,9 @@ main (int argc, char** argv)
     //qof_log_set_level(GNC_MOD_PRICE, QOF_LOG_DETAIL);
     session = qof_session_new ();
     test_generation ();
+    /* And again through the DOM parser, which must give the same. */
+    gnc_prefs_set_file_load_stream_parsers (FALSE);
+    test_generation ();
     print_test_results ();
     qof_close ();
     exit (get_rv ());
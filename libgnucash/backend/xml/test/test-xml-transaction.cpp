@@ -37,6 +37,7 @@ extern "C"
 #include <gnc-engine.h>
 #include <cashobjects.h>
 #include <TransLog.h>
+#include <gnc-prefs.h>
 
 #include <test-engine-stuff.h>
 #include <unittest-support.h>
@@ -50,7 +51,9 @@ extern "C"
 #include "../gnc-xml.h"
 #include "../sixtp-parsers.h"
 #include "../sixtp-dom-parsers.h"
+#include "../sixtp-stream-parser.hpp"
 #include "../io-gncxml-gen.h"
+#include "../io-gncxml-pipeline.hpp"
 #include "test-file-stuff.h"
 #include <test-stuff.h>
 static QofBook* book;
@@ -370,6 +373,43 @@ test_add_transaction (const char* tag, gpointer globaldata, gpointer data)
     return retval;
 }
 
+static void
+move_splits_to_new_accounts (Transaction* trn, gnc_commodity* com)
+{
+    /* xaccAccountInsertSplit can reorder the splits. */
+    GList* list = g_list_copy (xaccTransGetSplitList (trn));
+    GList* node = list;
+    for (; node; node = node->next)
+    {
+        Split* s = static_cast<decltype (s)> (node->data);
+        Account* a = xaccMallocAccount (book);
+
+        xaccAccountBeginEdit (a);
+        xaccAccountSetCommodity (a, com);
+        xaccAccountSetCommoditySCU (a, xaccSplitGetAmount (s).denom);
+        xaccAccountInsertSplit (a, s);
+        xaccAccountCommitEdit (a);
+    }
+    g_list_free (list);
+}
+
+static void
+add_accounts_for_parsed_splits (Transaction* trn)
+{
+    GList* node = xaccTransGetSplitList (trn);
+    for (; node; node = node->next)
+    {
+        Split* s = static_cast<decltype (s)> (node->data);
+        Account* a1 = xaccSplitGetAccount (s);
+        Account* a2 = xaccMallocAccount (book);
+
+        xaccAccountBeginEdit (a2);
+        xaccAccountSetCommoditySCU (a2, xaccAccountGetCommoditySCU (a1));
+        xaccAccountSetGUID (a2, xaccAccountGetGUID (a1));
+        xaccAccountCommitEdit (a2);
+    }
+}
+
 static void
 test_transaction (void)
 {
@@ -395,23 +435,7 @@ test_transaction (void)
             return;
         }
 
-        {
-            /* xaccAccountInsertSplit can reorder the splits. */
-            GList* list = g_list_copy (xaccTransGetSplitList (ran_trn));
-            GList* node = list;
-            for (; node; node = node->next)
-            {
-                Split* s = static_cast<decltype (s)> (node->data);
-                Account* a = xaccMallocAccount (book);
-
-                xaccAccountBeginEdit (a);
-                xaccAccountSetCommodity (a, new_com);
-                xaccAccountSetCommoditySCU (a, xaccSplitGetAmount (s).denom);
-                xaccAccountInsertSplit (a, s);
-                xaccAccountCommitEdit (a);
-            }
-            g_list_free (list);
-        }
+        move_splits_to_new_accounts (ran_trn, new_com);
 
         com = xaccTransGetCurrency (ran_trn);
 
@@ -449,20 +473,7 @@ test_transaction (void)
 
         close (fd);
 
-        {
-            GList* node = xaccTransGetSplitList (ran_trn);
-            for (; node; node = node->next)
-            {
-                Split* s = static_cast<decltype (s)> (node->data);
-                Account* a1 = xaccSplitGetAccount (s);
-                Account* a2 = xaccMallocAccount (book);
-
-                xaccAccountBeginEdit (a2);
-                xaccAccountSetCommoditySCU (a2, xaccAccountGetCommoditySCU (a1));
-                xaccAccountSetGUID (a2, xaccAccountGetGUID (a1));
-                xaccAccountCommitEdit (a2);
-            }
-        }
+        add_accounts_for_parsed_splits (ran_trn);
 
         {
             sixtp* parser;
@@ -503,6 +514,181 @@ test_transaction (void)
     }
 }
 
+struct pipeline_data_struct
+{
+    std::vector<Transaction*> trns;
+    std::vector<gnc_commodity*> coms;
+    /* What the pipeline made, kept for the serial parse to compare. */
+    std::vector<xmlNodePtr> pipelined;
+    std::size_t parsed;
+};
+typedef struct pipeline_data_struct pipeline_data;
+
+static gboolean
+test_add_pipeline_transaction (const char* tag, gpointer globaldata,
+                               gpointer data)
+{
+    Transaction* trans = static_cast<decltype (trans)> (data);
+    pipeline_data* gdata = static_cast<decltype (gdata)> (globaldata);
+    auto i = gdata->parsed++;
+
+    if (i >= gdata->trns.size ())
+    {
+        failure_args ("gnc_transaction_sixtp_parser_create_pipelined",
+                      __FILE__, __LINE__, "too many transactions");
+        really_get_rid_of_transaction (trans);
+        return FALSE;
+    }
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, gdata->coms[i]);
+    xaccTransCommitEdit (trans);
+
+    /* The transactions must come out in file order. */
+    do_test_args (xaccTransEqual (gdata->trns[i], trans, TRUE, TRUE, TRUE,
+                                  FALSE),
+                  "gnc_transaction_sixtp_parser_create_pipelined",
+                  __FILE__, __LINE__, "%" G_GSIZE_FORMAT, i);
+
+    gdata->pipelined.push_back (gnc_transaction_dom_tree_create (trans));
+    really_get_rid_of_transaction (trans);
+    return TRUE;
+}
+
+/* The serial parse of the same file must give what the pipeline gave. */
+static gboolean
+test_add_serial_transaction (const char* tag, gpointer globaldata,
+                             gpointer data)
+{
+    Transaction* trans = static_cast<decltype (trans)> (data);
+    pipeline_data* gdata = static_cast<decltype (gdata)> (globaldata);
+    auto i = gdata->parsed++;
+
+    if (i >= gdata->pipelined.size ())
+    {
+        failure_args ("gnc_transaction_sixtp_parser_create",
+                      __FILE__, __LINE__, "too many transactions");
+        really_get_rid_of_transaction (trans);
+        return FALSE;
+    }
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetCurrency (trans, gdata->coms[i]);
+    xaccTransCommitEdit (trans);
+
+    auto msg = node_and_transaction_equal (gdata->pipelined[i], trans);
+    do_test_args (msg == nullptr, "pipelined and serial parse agree",
+                  __FILE__, __LINE__, "%" G_GSIZE_FORMAT ": %s", i,
+                  msg ? msg : "");
+
+    really_get_rid_of_transaction (trans);
+    return TRUE;
+}
+
+static void
+test_transaction_pipeline (void)
+{
+    pipeline_data data;
+    gchar* filename1;
+    FILE* file;
+    int fd;
+
+    filename1 = g_strdup_printf ("test_file_XXXXXX");
+    fd = g_mkstemp (filename1);
+    file = fdopen (fd, "w");
+    fprintf (file, "<?xml version=\"1.0\" encoding=\"utf-8\" ?>\n<gnc-v2>\n");
+    for (int i = 0; i < 200; i++)
+    {
+        Transaction* ran_trn;
+        xmlNodePtr test_node;
+
+        get_random_account_tree (book);
+        ran_trn = get_random_transaction (book);
+        if (!ran_trn)
+        {
+            failure_args ("transaction_xml", __FILE__, __LINE__,
+                          "get_random_transaction returned NULL");
+            continue;
+        }
+        move_splits_to_new_accounts (ran_trn, get_random_commodity (book));
+
+        test_node = gnc_transaction_dom_tree_create (ran_trn);
+        xmlElemDump (file, NULL, test_node);
+        fprintf (file, "\n");
+        xmlFreeNode (test_node);
+
+        data.trns.push_back (ran_trn);
+        data.coms.push_back (xaccTransGetCurrency (ran_trn));
+    }
+    fprintf (file, "</gnc-v2>\n");
+    fclose (file);
+
+    for (auto trn : data.trns)
+        add_accounts_for_parsed_splits (trn);
+
+    {
+        GncXmlPipeline pipeline {3};
+        sixtp* top_parser = sixtp_new ();
+        sixtp* main_parser = sixtp_new ();
+        const char* msg =
+            "[xaccAccountScrubCommodity()] Account \"\" does not have a commodity!";
+        const char* logdomain = "gnc.engine.scrub";
+        GLogLevelFlags loglevel = static_cast<decltype (loglevel)>
+                                  (G_LOG_LEVEL_CRITICAL);
+        TestErrorStruct check = { loglevel, const_cast<char*> (logdomain),
+                                  const_cast<char*> (msg)
+                                };
+        g_log_set_handler (logdomain, loglevel,
+                           (GLogFunc)test_checked_handler, &check);
+
+        sixtp_add_some_sub_parsers (top_parser, TRUE,
+                                    "gnc-v2", main_parser,
+                                    NULL, NULL);
+        sixtp_add_some_sub_parsers (
+            main_parser, TRUE,
+            "gnc:transaction",
+            gnc_transaction_sixtp_parser_create_pipelined (&pipeline, "gnc-v2"),
+            NULL, NULL);
+
+        data.parsed = 0;
+        file = g_fopen (filename1, "r");
+        do_test (pipeline.parse (top_parser, file, test_add_pipeline_transaction,
+                                 &data, book),
+                 "GncXmlPipeline::parse");
+        do_test (data.parsed == data.trns.size (),
+                 "GncXmlPipeline::parse transaction count");
+        fclose (file);
+        sixtp_destroy (top_parser);
+
+        top_parser = sixtp_new ();
+        main_parser = sixtp_new ();
+        sixtp_add_some_sub_parsers (top_parser, TRUE,
+                                    "gnc-v2", main_parser,
+                                    NULL, NULL);
+        sixtp_add_some_sub_parsers (main_parser, TRUE,
+                                    "gnc:transaction",
+                                    gnc_transaction_sixtp_parser_create (),
+                                    NULL, NULL);
+
+        data.parsed = 0;
+        file = g_fopen (filename1, "r");
+        do_test (gnc_xml_parse_fd (top_parser, file,
+                                   test_add_serial_transaction, &data, book),
+                 "gnc_xml_parse_fd");
+        do_test (data.parsed == data.pipelined.size (),
+                 "gnc_xml_parse_fd transaction count");
+        fclose (file);
+        sixtp_destroy (top_parser);
+    }
+
+    for (auto node : data.pipelined)
+        xmlFreeNode (node);
+    for (auto trn : data.trns)
+        really_get_rid_of_transaction (trn);
+    g_unlink (filename1);
+    g_free (filename1);
+}
+
 static gboolean
 test_real_transaction (const char* tag, gpointer global_data, gpointer data)
 {
@@ -536,6 +722,10 @@ main (int argc, char** argv)
     else
     {
         test_transaction ();
+        test_transaction_pipeline ();
+        /* And again through the DOM parser, which must give the same. */
+        gnc_prefs_set_file_load_stream_parsers (FALSE);
+        test_transaction ();
     }
 
     print_test_results ();
@@ -32,8 +32,14 @@ static gchar *namespace_regexp    = NULL;
 static gboolean is_debugging      = FALSE;
 static gboolean extras_enabled    = FALSE;
 static gboolean use_compression   = TRUE; // This is also the default in the prefs backend
+static gint compression_level     = 6;    // This is also the default in the prefs backend
+static gboolean use_zstd          = FALSE; // This is also the default in the prefs backend
+static gboolean save_incremental  = FALSE; // This is also the default in the prefs backend
+static gint journal_max_size      = 16;   // MiB, this is also the default in the prefs backend
 static gint file_retention_policy = 1;    // 1 = "days", the default in the prefs backend
 static gint file_retention_days   = 30;   // This is also the default in the prefs backend
+static gint file_load_threads     = 0;    // 0 = automatic, also the default in the prefs backend
+static gboolean load_stream_parsers = TRUE;
 
 PrefsBackend *prefsbackend = NULL;
 
@@ -89,6 +95,54 @@ gnc_prefs_set_file_save_compressed(gboolean compressed)
     use_compression = compressed;
 }
 
+gint
+gnc_prefs_get_file_compression_level(void)
+{
+    return compression_level;
+}
+
+void
+gnc_prefs_set_file_compression_level(gint level)
+{
+    compression_level = CLAMP(level, 1, 9);
+}
+
+gboolean
+gnc_prefs_get_file_save_zstd(void)
+{
+    return use_zstd;
+}
+
+void
+gnc_prefs_set_file_save_zstd(gboolean zstd)
+{
+    use_zstd = zstd;
+}
+
+gboolean
+gnc_prefs_get_file_save_incremental(void)
+{
+    return save_incremental;
+}
+
+void
+gnc_prefs_set_file_save_incremental(gboolean incremental)
+{
+    save_incremental = incremental;
+}
+
+gint
+gnc_prefs_get_file_journal_max_size(void)
+{
+    return journal_max_size;
+}
+
+void
+gnc_prefs_set_file_journal_max_size(gint size)
+{
+    journal_max_size = MAX(size, 1);
+}
+
 gint
 gnc_prefs_get_file_retention_policy(void)
 {
@@ -113,6 +167,30 @@ gnc_prefs_set_file_retention_days(gint days)
     file_retention_days = days;
 }
 
+gint
+gnc_prefs_get_file_load_threads(void)
+{
+    return file_load_threads;
+}
+
+void
+gnc_prefs_set_file_load_threads(gint threads)
+{
+    file_load_threads = MAX(threads, 0);
+}
+
+gboolean
+gnc_prefs_get_file_load_stream_parsers(void)
+{
+    return load_stream_parsers;
+}
+
+void
+gnc_prefs_set_file_load_stream_parsers(gboolean stream)
+{
+    load_stream_parsers = stream;
+}
+
 guint
 gnc_prefs_get_long_version()
 {
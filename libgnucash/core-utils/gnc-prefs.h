@@ -109,12 +109,42 @@ void gnc_prefs_set_extra(gboolean enabled);
 gboolean gnc_prefs_get_file_save_compressed(void);
 void gnc_prefs_set_file_save_compressed(gboolean compressed);
 
+/** The compression level for saved files, 1 (fastest) to 9 (smallest). */
+gint gnc_prefs_get_file_compression_level(void);
+void gnc_prefs_set_file_compression_level(gint level);
+
+/** Whether compressed files are saved with zstd instead of gzip. */
+gboolean gnc_prefs_get_file_save_zstd(void);
+void gnc_prefs_set_file_save_zstd(gboolean zstd);
+
+/** Whether auto-saves only append what changed to the data file's journal
+ *  instead of rewriting the file. */
+gboolean gnc_prefs_get_file_save_incremental(void);
+void gnc_prefs_set_file_save_incremental(gboolean incremental);
+
+/** The size in MiB above which the journal is folded into a rewritten data
+ *  file. */
+gint gnc_prefs_get_file_journal_max_size(void);
+void gnc_prefs_set_file_journal_max_size(gint size);
+
 gint gnc_prefs_get_file_retention_policy(void);
 void gnc_prefs_set_file_retention_policy(gint policy);
 
 gint gnc_prefs_get_file_retention_days(void);
 void gnc_prefs_set_file_retention_days(gint days);
 
+/** The number of worker threads XML data files are parsed on. 0, the
+ *  default, picks one from the size of the file and the number of
+ *  processors; 1 parses everything on the loading thread. */
+gint gnc_prefs_get_file_load_threads(void);
+void gnc_prefs_set_file_load_threads(gint threads);
+
+/** Whether transactions and prices are parsed straight from the XML
+ *  stream, the default, or through DOM trees as before, to compare the
+ *  two. The DOM parsers always load on a single thread. */
+gboolean gnc_prefs_get_file_load_stream_parsers(void);
+void gnc_prefs_set_file_load_stream_parsers(gboolean stream);
+
 guint gnc_prefs_get_long_version( void );
 
 /** @} */
@@ -42,8 +42,13 @@
 #include "qofinstance-p.h"
 #include "gnc-features.h"
 #include "guid.hpp"
+#include "gnc-split-index.hpp"
 
+#include <algorithm>
+#include <map>
 #include <numeric>
+#include <tuple>
+#include <vector>
 
 static QofLogModule log_module = GNC_MOD_ACCOUNT;
 
@@ -63,7 +68,50 @@ static const std::string AB_ACCOUNT_UID("account-uid");
 static const std::string AB_BANK_CODE("bank-code");
 static const std::string AB_TRANS_RETRIEVAL("trans-retrieval");
 
-static gnc_numeric GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing);
+/* The running balances that each split carries. */
+typedef enum
+{
+    SPLIT_BALANCE,
+    SPLIT_NOCLOSING_BALANCE,
+    SPLIT_CLEARED_BALANCE,
+    SPLIT_RECONCILED_BALANCE,
+} SplitBalanceType;
+
+/* Subtree totals cached on each account by
+ * xaccAccountGetXxxBalanceInCurrencyRecursive() and its as-of-date
+ * sibling, so that redrawing an account tree doesn't walk every
+ * descendant and convert every balance again. An account's entries are
+ * dropped whenever its own balances or a descendant's change, see
+ * account_balances_changed(); entries that needed a currency conversion
+ * also go stale when a price of one of the commodities involved changes.
+ *
+ * The uncached sum adds the balances one account after the other,
+ * rounding each time; a total is only used when that rounding had nothing
+ * to do, so that the order of the additions doesn't matter. */
+struct GncSubtreeBalances
+{
+    /* Dated lookup?, balance type, report commodity, as-of date. */
+    using Key = std::tuple<bool, SplitBalanceType, const gnc_commodity*,
+                           time64>;
+    struct Entry
+    {
+        gnc_numeric balance;
+        /* Every balance was a multiple of the report commodity's unit. */
+        bool exact;
+        /* The commodities converted to the report commodity, and the sum
+         * of their price generations and the report commodity's. */
+        std::vector<const gnc_commodity*> commodities;
+        guint64 price_stamp;
+    };
+    /* As-of dates are open-ended, so don't let them pile up. */
+    static const std::size_t max_entries = 64;
+    std::map<Key, Entry> entries;
+};
+
+static void account_balances_changed (const Account *acc);
+
+static gnc_numeric GetBalanceAsOfDate (Account *acc, time64 date,
+                                       SplitBalanceType type);
 
 using FinalProbabilityVec=std::vector<std::pair<std::string, int32_t>>;
 using ProbabilityVec=std::vector<std::pair<std::string, struct AccountProbability>>;
@@ -292,7 +340,7 @@ gnc_account_init(Account* acc)
     priv->starting_reconciled_balance = gnc_numeric_zero();
     priv->balance_dirty = FALSE;
 
-    priv->splits = NULL;
+    priv->splits = new GncSplitIndex;
     priv->sort_dirty = FALSE;
 }
 
@@ -305,6 +353,13 @@ gnc_account_dispose (GObject *acctp)
 static void
 gnc_account_finalize(GObject* acctp)
 {
+    AccountPrivate *priv = GET_PRIVATE(acctp);
+
+    delete priv->splits;
+    priv->splits = nullptr;
+    delete priv->subtree_balances;
+    priv->subtree_balances = nullptr;
+
     G_OBJECT_CLASS(gnc_account_parent_class)->finalize(acctp);
 }
 
@@ -1277,24 +1332,20 @@ xaccFreeAccount (Account *acc)
     /* NB there shouldn't be any splits by now ... they should
      * have been all been freed by CommitEdit().  We can remove this
      * check once we know the warning isn't occurring any more. */
-    if (priv->splits)
+    if (!priv->splits->empty())
     {
-        GList *slist;
         PERR (" instead of calling xaccFreeAccount(), please call \n"
               " xaccAccountBeginEdit(); xaccAccountDestroy(); \n");
 
         qof_instance_reset_editlevel(acc);
 
-        slist = g_list_copy(priv->splits);
-        for (lp = slist; lp; lp = lp->next)
+        for (auto s : priv->splits->snapshot())
         {
-            Split *s = (Split *) lp->data;
             g_assert(xaccSplitGetAccount(s) == acc);
             xaccSplitDestroy (s);
         }
-        g_list_free(slist);
-/* Nothing here (or in xaccAccountCommitEdit) NULLs priv->splits, so this asserts every time.
-        g_assert(priv->splits == NULL);
+/* Nothing here (or in xaccAccountCommitEdit) empties priv->splits, so this asserts every time.
+        g_assert(priv->splits->empty());
 */
     }
 
@@ -1384,7 +1435,7 @@ xaccAccountCommitEdit (Account *acc)
     priv = GET_PRIVATE(acc);
     if (qof_instance_get_destroying(acc))
     {
-        GList *lp, *slist;
+        GList *lp;
         QofCollection *col;
 
         qof_instance_increase_editlevel(acc);
@@ -1401,18 +1452,12 @@ xaccAccountCommitEdit (Account *acc)
            themselves will be destroyed by the transaction code */
         if (!qof_book_shutting_down(book))
         {
-            slist = g_list_copy(priv->splits);
-            for (lp = slist; lp; lp = lp->next)
-            {
-                Split *s = static_cast<Split *>(lp->data);
+            for (auto s : priv->splits->snapshot())
                 xaccSplitDestroy (s);
-            }
-            g_list_free(slist);
         }
         else
         {
-            g_list_free(priv->splits);
-            priv->splits = NULL;
+            priv->splits->clear();
         }
 
         /* It turns out there's a case where this assertion does not hold:
@@ -1420,7 +1465,7 @@ xaccAccountCommitEdit (Account *acc)
            deleting all the splits in it.  The splits will just get
            recreated and put right back into the same account!
 
-           g_assert(priv->splits == NULL || qof_book_shutting_down(acc->inst.book));
+           g_assert(priv->splits->empty() || qof_book_shutting_down(acc->inst.book));
         */
 
         if (!qof_book_shutting_down(book))
@@ -1723,36 +1768,27 @@ xaccAccountEqual(const Account *aa, const Account *ab, gboolean check_guids)
     /* no parent; always compare downwards. */
 
     {
-        GList *la = priv_aa->splits;
-        GList *lb = priv_ab->splits;
+        const GncSplitIndex *la = priv_aa->splits;
+        const GncSplitIndex *lb = priv_ab->splits;
 
-        if ((la && !lb) || (!la && lb))
+        if (la->empty() != lb->empty())
         {
             PWARN ("only one has splits");
             return FALSE;
         }
 
-        if (la && lb)
+        if (la->size() != lb->size())
         {
-            /* presume that the splits are in the same order */
-            while (la && lb)
-            {
-                Split *sa = (Split *) la->data;
-                Split *sb = (Split *) lb->data;
-
-                if (!xaccSplitEqual(sa, sb, check_guids, TRUE, FALSE))
-                {
-                    PWARN ("splits differ");
-                    return(FALSE);
-                }
-
-                la = la->next;
-                lb = lb->next;
-            }
+            PWARN ("number of splits differs");
+            return(FALSE);
+        }
 
-            if ((la != NULL) || (lb != NULL))
+        /* presume that the splits are in the same order */
+        for (std::size_t i = 0; i < la->size(); ++i)
+        {
+            if (!xaccSplitEqual((*la)[i], (*lb)[i], check_guids, TRUE, FALSE))
             {
-                PWARN ("number of splits differs");
+                PWARN ("splits differ");
                 return(FALSE);
             }
         }
@@ -1795,6 +1831,88 @@ gnc_account_set_balance_dirty (Account *acc)
 
     priv = GET_PRIVATE(acc);
     priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
+    priv->splits->mark_stale (0);
+}
+
+void
+gnc_account_set_split_balance_dirty (Account *acc, const Split *split,
+                                     gboolean reconcile_only)
+{
+    AccountPrivate *priv;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    /* A split that isn't a member gives size(), which just redoes the
+     * account totals; its insertion marks its real position. */
+    priv->splits->mark_stale (priv->splits->index_of (split), reconcile_only);
+    priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
+}
+
+void
+gnc_account_check_split_balance (Account *acc, const Split *split)
+{
+    AccountPrivate *priv;
+    gnc_numeric amt, balance, noclosing, cleared, reconciled;
+    gboolean ok;
+    std::size_t pos;
+
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+
+    if (qof_instance_get_destroying(acc))
+        return;
+
+    priv = GET_PRIVATE(acc);
+    const auto& splits = *priv->splits;
+    pos = splits.index_of (split);
+    /* Nothing to check if the balances are going to be redone anyway. */
+    if (pos >= splits.stale_from())
+        return;
+
+    if (pos == 0)
+    {
+        balance = priv->starting_balance;
+        noclosing = priv->starting_noclosing_balance;
+        cleared = priv->starting_cleared_balance;
+        reconciled = priv->starting_reconciled_balance;
+    }
+    else
+    {
+        auto prev = splits[pos - 1];
+        balance = prev->balance;
+        noclosing = prev->noclosing_balance;
+        cleared = prev->cleared_balance;
+        reconciled = prev->reconciled_balance;
+    }
+
+    amt = xaccSplitGetAmount (split);
+    if (!xaccTransGetIsClosingTxn (split->parent))
+        noclosing = gnc_numeric_add_fixed (noclosing, amt);
+    ok = gnc_numeric_equal (gnc_numeric_add_fixed (balance, amt),
+                            split->balance) &&
+        gnc_numeric_equal (noclosing, split->noclosing_balance);
+
+    if (ok && pos < splits.cleared_stale_from())
+    {
+        if (NREC != split->reconciled)
+            cleared = gnc_numeric_add_fixed (cleared, amt);
+        if (YREC == split->reconciled || FREC == split->reconciled)
+            reconciled = gnc_numeric_add_fixed (reconciled, amt);
+        ok = gnc_numeric_equal (cleared, split->cleared_balance) &&
+            gnc_numeric_equal (reconciled, split->reconciled_balance);
+    }
+
+    if (!ok)
+    {
+        priv->splits->mark_stale (pos);
+        priv->balance_dirty = TRUE;
+        account_balances_changed (acc);
+    }
 }
 
 /********************************************************************\
@@ -1804,26 +1922,20 @@ gboolean
 gnc_account_insert_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
+    gboolean keep_sorted;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (node)
+    /* While the account is being edited just append; the splits are
+     * sorted once when the edit is committed. */
+    keep_sorted = (qof_instance_get_editlevel(acc) == 0);
+    if (!priv->splits->insert(s, keep_sorted))
         return FALSE;
 
-    if (qof_instance_get_editlevel(acc) == 0)
-    {
-        priv->splits = g_list_insert_sorted(priv->splits, s,
-                                            (GCompareFunc)xaccSplitOrder);
-    }
-    else
-    {
-        priv->splits = g_list_prepend(priv->splits, s);
+    if (!keep_sorted)
         priv->sort_dirty = TRUE;
-    }
 
     //FIXME: find better event
     qof_event_gen (&acc->inst, QOF_EVENT_MODIFY, NULL);
@@ -1831,6 +1943,7 @@ gnc_account_insert_split (Account *acc, Split *s)
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_ADDED, s);
 
     priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
 //  DRH: Should the below be added? It is present in the delete path.
 //  xaccAccountRecomputeBalance(acc);
     return TRUE;
@@ -1840,23 +1953,21 @@ gboolean
 gnc_account_remove_split (Account *acc, Split *s)
 {
     AccountPrivate *priv;
-    GList *node;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
     g_return_val_if_fail(GNC_IS_SPLIT(s), FALSE);
 
     priv = GET_PRIVATE(acc);
-    node = g_list_find(priv->splits, s);
-    if (NULL == node)
+    if (!priv->splits->remove(s))
         return FALSE;
 
-    priv->splits = g_list_delete_link(priv->splits, node);
     //FIXME: find better event type
     qof_event_gen(&acc->inst, QOF_EVENT_MODIFY, NULL);
     // And send the account-based event, too
     qof_event_gen(&acc->inst, GNC_EVENT_ITEM_REMOVED, s);
 
     priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
     xaccAccountRecomputeBalance(acc);
     return TRUE;
 }
@@ -1871,9 +1982,14 @@ xaccAccountSortSplits (Account *acc, gboolean force)
     priv = GET_PRIVATE(acc);
     if (!priv->sort_dirty || (!force && qof_instance_get_editlevel(acc) > 0))
         return;
-    priv->splits = g_list_sort(priv->splits, (GCompareFunc)xaccSplitOrder);
+    /* The splits are usually still in order, in which case the running
+     * balances don't need to be recomputed. */
+    if (priv->splits->sort())
+    {
+        priv->balance_dirty = TRUE;
+        account_balances_changed (acc);
+    }
     priv->sort_dirty = FALSE;
-    priv->balance_dirty = TRUE;
 }
 
 static void
@@ -2071,7 +2187,7 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
 
     /* optimizations */
     from_priv = GET_PRIVATE(accfrom);
-    if (!from_priv->splits || accfrom == accto)
+    if (from_priv->splits->empty() || accfrom == accto)
         return;
 
     /* check for book mix-up */
@@ -2080,8 +2196,11 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
 
     xaccAccountBeginEdit(accfrom);
     xaccAccountBeginEdit(accto);
+    /* Moving a split removes it from accfrom, so work from a copy. */
+    auto splits = from_priv->splits->snapshot();
     /* Begin editing both accounts and all transactions in accfrom. */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPreSplitMove, NULL);
+    for (auto s : splits)
+        xaccPreSplitMove (s, NULL);
 
     /* Concatenate accfrom's lists of splits and lots to accto's lists. */
     //to_priv->splits = g_list_concat(to_priv->splits, from_priv->splits);
@@ -2098,10 +2217,11 @@ xaccAccountMoveAllSplits (Account *accfrom, Account *accto)
      * Convert each split's amount to accto's commodity.
      * Commit to editing each transaction.
      */
-    g_list_foreach(from_priv->splits, (GFunc)xaccPostSplitMove, (gpointer)accto);
+    for (auto s : splits)
+        xaccPostSplitMove (s, accto);
 
     /* Finally empty accfrom. */
-    g_assert(from_priv->splits == NULL);
+    g_assert(from_priv->splits->empty());
     g_assert(from_priv->lots == NULL);
     xaccAccountCommitEdit(accfrom);
     xaccAccountCommitEdit(accto);
@@ -2146,7 +2266,6 @@ xaccAccountRecomputeBalance (Account * acc)
     gnc_numeric  noclosing_balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
-    GList *lp;
 
     if (NULL == acc) return;
 
@@ -2156,19 +2275,41 @@ xaccAccountRecomputeBalance (Account * acc)
     if (qof_instance_get_destroying(acc)) return;
     if (qof_book_shutting_down(qof_instance_get_book(acc))) return;
 
-    balance            = priv->starting_balance;
-    noclosing_balance  = priv->starting_noclosing_balance;
-    cleared_balance    = priv->starting_cleared_balance;
-    reconciled_balance = priv->starting_reconciled_balance;
+    /* Only the splits from the lowest stale position on need their
+     * running balances redone. balance_dirty without a watermark, as set
+     * directly by older code, means all of them. */
+    const auto& splits = *priv->splits;
+    std::size_t from = 0, stale_from = 0;
+    if (splits.has_stale_balances())
+    {
+        from = splits.cleared_stale_from();
+        stale_from = splits.stale_from();
+    }
 
-    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT,
-           priv->accountName, balance.num, balance.denom);
-    for (lp = priv->splits; lp; lp = lp->next)
+    if (from == 0)
     {
-        Split *split = (Split *) lp->data;
-        gnc_numeric amt = xaccSplitGetAmount (split);
+        balance            = priv->starting_balance;
+        noclosing_balance  = priv->starting_noclosing_balance;
+        cleared_balance    = priv->starting_cleared_balance;
+        reconciled_balance = priv->starting_reconciled_balance;
+    }
+    else
+    {
+        auto prev = splits[from - 1];
+        balance            = prev->balance;
+        noclosing_balance  = prev->noclosing_balance;
+        cleared_balance    = prev->cleared_balance;
+        reconciled_balance = prev->reconciled_balance;
+    }
 
-        balance = gnc_numeric_add_fixed(balance, amt);
+    PINFO ("acct=%s starting baln=%" G_GINT64_FORMAT "/%" G_GINT64_FORMAT
+           " from split %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT,
+           priv->accountName, balance.num,
+           balance.denom, from, splits.size());
+    for (auto pos = from; pos < splits.size(); ++pos)
+    {
+        auto split = splits[pos];
+        gnc_numeric amt = xaccSplitGetAmount (split);
 
         if (NREC != split->reconciled)
         {
@@ -2182,14 +2323,24 @@ xaccAccountRecomputeBalance (Account * acc)
                 gnc_numeric_add_fixed(reconciled_balance, amt);
         }
 
+        split->cleared_balance = cleared_balance;
+        split->reconciled_balance = reconciled_balance;
+
+        /* Between the two watermarks only the reconcile state changed. */
+        if (pos < stale_from)
+        {
+            balance = split->balance;
+            noclosing_balance = split->noclosing_balance;
+            continue;
+        }
+
+        balance = gnc_numeric_add_fixed(balance, amt);
+
         if (!(xaccTransGetIsClosingTxn (split->parent)))
             noclosing_balance = gnc_numeric_add_fixed(noclosing_balance, amt);
 
         split->balance = balance;
         split->noclosing_balance = noclosing_balance;
-        split->cleared_balance = cleared_balance;
-        split->reconciled_balance = reconciled_balance;
-
     }
 
     priv->balance = balance;
@@ -2197,6 +2348,8 @@ xaccAccountRecomputeBalance (Account * acc)
     priv->cleared_balance = cleared_balance;
     priv->reconciled_balance = reconciled_balance;
     priv->balance_dirty = FALSE;
+    priv->splits->mark_fresh ();
+    account_balances_changed (acc);
 }
 
 /********************************************************************\
@@ -2312,6 +2465,8 @@ xaccAccountSetType (Account *acc, GNCAccountType tip)
     xaccAccountBeginEdit(acc);
     priv->type = tip;
     priv->balance_dirty = TRUE; /* new type may affect balance computation */
+    account_balances_changed (acc);
+    priv->splits->mark_stale (0);
     mark_account(acc);
     xaccAccountCommitEdit(acc);
 }
@@ -2463,7 +2618,6 @@ void
 xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
 {
     AccountPrivate *priv;
-    GList *lp;
 
     /* errors */
     g_return_if_fail(GNC_IS_ACCOUNT(acc));
@@ -2482,9 +2636,8 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
     priv->non_standard_scu = FALSE;
 
     /* iterate over splits */
-    for (lp = priv->splits; lp; lp = lp->next)
+    for (auto s : priv->splits->snapshot())
     {
-        Split *s = (Split *) lp->data;
         Transaction *trans = xaccSplitGetParent (s);
 
         xaccTransBeginEdit (trans);
@@ -2494,6 +2647,8 @@ xaccAccountSetCommodity (Account * acc, gnc_commodity * com)
 
     priv->sort_dirty = TRUE;  /* Not needed. */
     priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
+    priv->splits->mark_stale (0);
     mark_account (acc);
 
     xaccAccountCommitEdit(acc);
@@ -2646,6 +2801,7 @@ gnc_account_append_child (Account *new_parent, Account *child)
     }
     cpriv->parent = new_parent;
     ppriv->children = g_list_append(ppriv->children, child);
+    account_balances_changed (new_parent);
     qof_instance_set_dirty(&new_parent->inst);
     qof_instance_set_dirty(&child->inst);
 
@@ -2686,6 +2842,7 @@ gnc_account_remove_child (Account *parent, Account *child)
     ed.idx = g_list_index(ppriv->children, child);
 
     ppriv->children = g_list_remove(ppriv->children, child);
+    account_balances_changed (parent);
 
     /* Now send the event. */
     qof_event_gen(&child->inst, QOF_EVENT_REMOVE, &ed);
@@ -3280,6 +3437,8 @@ gnc_account_set_start_balance (Account *acc, const gnc_numeric start_baln)
     priv = GET_PRIVATE(acc);
     priv->starting_balance = start_baln;
     priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
+    priv->splits->mark_stale (0);
 }
 
 void
@@ -3293,6 +3452,8 @@ gnc_account_set_start_cleared_balance (Account *acc,
     priv = GET_PRIVATE(acc);
     priv->starting_cleared_balance = start_baln;
     priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
+    priv->splits->mark_stale (0);
 }
 
 void
@@ -3306,6 +3467,8 @@ gnc_account_set_start_reconciled_balance (Account *acc,
     priv = GET_PRIVATE(acc);
     priv->starting_reconciled_balance = start_baln;
     priv->balance_dirty = TRUE;
+    account_balances_changed (acc);
+    priv->splits->mark_stale (0);
 }
 
 gnc_numeric
@@ -3333,7 +3496,6 @@ gnc_numeric
 xaccAccountGetProjectedMinimumBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
     time64 today;
     gnc_numeric lowest = gnc_numeric_zero ();
     int seen_a_transaction = 0;
@@ -3342,9 +3504,9 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (auto iter = priv->splits->rbegin(); iter != priv->splits->rend(); ++iter)
     {
-        Split *split = static_cast<Split*>(node->data);
+        Split *split = *iter;
 
         if (!seen_a_transaction)
         {
@@ -3368,76 +3530,137 @@ xaccAccountGetProjectedMinimumBalance (const Account *acc)
 \********************************************************************/
 
 static gnc_numeric
-GetBalanceAsOfDate (Account *acc, time64 date, gboolean ignclosing)
+split_running_balance (const Split *split, SplitBalanceType type)
+{
+    switch (type)
+    {
+    case SPLIT_NOCLOSING_BALANCE:
+        return xaccSplitGetNoclosingBalance (split);
+    case SPLIT_CLEARED_BALANCE:
+        return xaccSplitGetClearedBalance (split);
+    case SPLIT_RECONCILED_BALANCE:
+        return xaccSplitGetReconciledBalance (split);
+    default:
+        return xaccSplitGetBalance (split);
+    }
+}
+
+static gnc_numeric
+account_running_balance (const AccountPrivate *priv, SplitBalanceType type)
+{
+    switch (type)
+    {
+    case SPLIT_NOCLOSING_BALANCE:
+        return priv->noclosing_balance;
+    case SPLIT_CLEARED_BALANCE:
+        return priv->cleared_balance;
+    case SPLIT_RECONCILED_BALANCE:
+        return priv->reconciled_balance;
+    default:
+        return priv->balance;
+    }
+}
+
+/* The balance of an account whose first npos splits were posted before
+ * the date of interest. */
+static gnc_numeric
+balance_before_position (const AccountPrivate *priv, std::size_t npos,
+                         SplitBalanceType type)
+{
+    /* There were no splits posted after the given date, so the latest
+     * account balance should be good enough. */
+    if (npos == priv->splits->size())
+        return account_running_balance (priv, type);
+
+    /* AsOf date must be before any entries, return zero. */
+    if (npos == 0)
+        return gnc_numeric_zero();
+
+    /* Otherwise the running balance of the last split before the date. */
+    return split_running_balance ((*priv->splits)[npos - 1], type);
+}
+
+static gnc_numeric
+GetBalanceAsOfDate (Account *acc, time64 date, SplitBalanceType type)
 {
-    /* Ideally this could use xaccAccountForEachSplit, but
-     * it doesn't exist yet and I'm uncertain of exactly how
-     * it would work at this time, since it differs from
-     * xaccAccountForEachTransaction by using gpointer return
-     * values rather than gints.
-     */
     AccountPrivate *priv;
-    GList   *lp;
-    gboolean found = FALSE;
-    gnc_numeric balance;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
     xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
     xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
+    /* The splits are in posted-date order, so the ones before date are
+     * found with a binary search over the index. */
     priv = GET_PRIVATE(acc);
-    if (ignclosing)
-        balance = priv->noclosing_balance;
-    else
-        balance = priv->balance;
+    return balance_before_position (priv,
+                                    priv->splits->count_posted_before (date),
+                                    type);
+}
 
-    lp = priv->splits;
-    while ( lp && !found )
-    {
-        time64 trans_time = xaccTransRetDatePosted( xaccSplitGetParent( (Split *)lp->data ));
-        if ( trans_time >= date )
-            found = TRUE;
-        else
-            lp = lp->next;
-    }
+static void
+GetBalancesAsOfDates (Account *acc, const time64 *dates, gsize n,
+                      gnc_numeric *balances, SplitBalanceType type)
+{
+    AccountPrivate *priv;
+    std::size_t npos = 0;
 
-    if ( lp )
-    {
-        if ( lp->prev )
-        {
-            /* Since lp is now pointing to a split which was past the reconcile
-             * date, get the running balance of the previous split.
-             */
-            if (ignclosing)
-                balance = xaccSplitGetNoclosingBalance( (Split *)lp->prev->data );
-            else
-                balance = xaccSplitGetBalance( (Split *)lp->prev->data );
-        }
-        else
-        {
-            /* AsOf date must be before any entries, return zero. */
-            balance = gnc_numeric_zero();
-        }
-    }
+    g_return_if_fail(GNC_IS_ACCOUNT(acc));
+    g_return_if_fail(n == 0 || (dates && balances));
 
-    /* Otherwise there were no splits posted after the given date,
-     * so the latest account balance should be good enough.
-     */
+    xaccAccountSortSplits (acc, TRUE); /* just in case, normally a noop */
+    xaccAccountRecomputeBalance (acc); /* just in case, normally a noop */
 
-    return( balance );
+    priv = GET_PRIVATE(acc);
+    for (gsize i = 0; i < n; ++i)
+    {
+        /* For ascending dates each search resumes where the previous one
+         * stopped, so the whole series is one pass over the index. */
+        if (i > 0 && dates[i] < dates[i - 1])
+            npos = 0;
+        npos = priv->splits->count_posted_before (dates[i], npos);
+        balances[i] = balance_before_position (priv, npos, type);
+    }
 }
 
 gnc_numeric
 xaccAccountGetBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, FALSE);
+    return GetBalanceAsOfDate (acc, date, SPLIT_BALANCE);
 }
 
 static gnc_numeric
 xaccAccountGetNoclosingBalanceAsOfDate (Account *acc, time64 date)
 {
-    return GetBalanceAsOfDate (acc, date, TRUE);
+    return GetBalanceAsOfDate (acc, date, SPLIT_NOCLOSING_BALANCE);
+}
+
+void
+xaccAccountGetBalancesAsOfDates (Account *acc, const time64 *dates, gsize n,
+                                 gnc_numeric *balances)
+{
+    GetBalancesAsOfDates (acc, dates, n, balances, SPLIT_BALANCE);
+}
+
+void
+xaccAccountGetNoclosingBalancesAsOfDates (Account *acc, const time64 *dates,
+                                          gsize n, gnc_numeric *balances)
+{
+    GetBalancesAsOfDates (acc, dates, n, balances, SPLIT_NOCLOSING_BALANCE);
+}
+
+void
+xaccAccountGetClearedBalancesAsOfDates (Account *acc, const time64 *dates,
+                                        gsize n, gnc_numeric *balances)
+{
+    GetBalancesAsOfDates (acc, dates, n, balances, SPLIT_CLEARED_BALANCE);
+}
+
+void
+xaccAccountGetReconciledBalancesAsOfDates (Account *acc, const time64 *dates,
+                                           gsize n, gnc_numeric *balances)
+{
+    GetBalancesAsOfDates (acc, dates, n, balances, SPLIT_RECONCILED_BALANCE);
 }
 
 /*
@@ -3452,16 +3675,15 @@ gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)
 {
     AccountPrivate *priv;
-    GList *node;
     time64 today;
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), gnc_numeric_zero());
 
     priv = GET_PRIVATE(acc);
     today = gnc_time64_get_today_end();
-    for (node = g_list_last(priv->splits); node; node = node->prev)
+    for (auto iter = priv->splits->rbegin(); iter != priv->splits->rend(); ++iter)
     {
-        Split *split = static_cast<Split*>(node->data);
+        Split *split = *iter;
 
         if (xaccTransGetDate (xaccSplitGetParent (split)) <= today)
             return xaccSplitGetBalance (split);
@@ -3617,14 +3839,157 @@ xaccAccountBalanceAsOfDateHelper (Account *acc, gpointer data)
                                    GNC_HOW_RND_ROUND_HALF_UP);
 }
 
+/*
+ * Drop the cached subtree totals of acc and of every account above it,
+ * whose totals include acc's balances.
+ */
+static void
+account_balances_changed (const Account *acc)
+{
+    while (acc)
+    {
+        AccountPrivate *priv = GET_PRIVATE(acc);
+        if (priv->subtree_balances)
+            priv->subtree_balances->entries.clear();
+        acc = priv->parent;
+    }
+}
 
+/*
+ * Map the balance functions whose results only change along with the
+ * account's splits to the balance they return. The present and projected
+ * minimum balances also depend on the current time, so they aren't
+ * cached.
+ */
+static gboolean
+cacheable_balance_fn (xaccGetBalanceFn fn, SplitBalanceType *type)
+{
+    if (fn == xaccAccountGetBalance)
+        *type = SPLIT_BALANCE;
+    else if (fn == xaccAccountGetClearedBalance)
+        *type = SPLIT_CLEARED_BALANCE;
+    else if (fn == xaccAccountGetReconciledBalance)
+        *type = SPLIT_RECONCILED_BALANCE;
+    else
+        return FALSE;
+    return TRUE;
+}
+
+static gboolean
+cacheable_balance_as_of_date_fn (xaccGetBalanceAsOfDateFn fn,
+                                 SplitBalanceType *type)
+{
+    if (fn == xaccAccountGetBalanceAsOfDate)
+        *type = SPLIT_BALANCE;
+    else if (fn == xaccAccountGetNoclosingBalanceAsOfDate)
+        *type = SPLIT_NOCLOSING_BALANCE;
+    else
+        return FALSE;
+    return TRUE;
+}
+
+/*
+ * The sum of the price generations a converted subtree total depends on;
+ * it only stays the same while none of them changes.
+ */
+static guint64
+subtree_price_stamp (GNCPriceDB *pdb, const gnc_commodity *report_commodity,
+                     const std::vector<const gnc_commodity*>& commodities)
+{
+    guint64 stamp;
+
+    if (!pdb || commodities.empty())
+        return 0;
+    stamp = gnc_pricedb_get_commodity_generation (pdb, report_commodity);
+    for (auto commodity : commodities)
+        stamp += gnc_pricedb_get_commodity_generation (pdb, commodity);
+    return stamp;
+}
+
+/* Adding value to a sum with the commodity's fraction doesn't round. */
+static bool
+on_fraction (gnc_numeric value, const gnc_commodity *commodity)
+{
+    auto fraction = gnc_commodity_get_fraction (commodity);
+    return gnc_numeric_check (gnc_numeric_convert (value, fraction,
+                                                   GNC_HOW_RND_NEVER))
+        == GNC_ERROR_OK;
+}
+
+/*
+ * Sum the balances of acc and all of its descendants in report_commodity,
+ * reusing and filling in the cached subtree totals.  own(acc) returns an
+ * account's own balance in its own commodity.  The total is only good if
+ * the returned entry is exact, see GncSubtreeBalances.
+ */
+template <typename OwnBalanceFn> static GncSubtreeBalances::Entry
+xaccAccountGetCachedSubtreeBalance (const Account *acc,
+                                    const GncSubtreeBalances::Key& key,
+                                    const gnc_commodity *report_commodity,
+                                    GNCPriceDB *pdb, OwnBalanceFn own)
+{
+    AccountPrivate *priv = GET_PRIVATE(acc);
+    GncSubtreeBalances::Entry entry;
+
+    if (priv->subtree_balances)
+    {
+        auto& entries = priv->subtree_balances->entries;
+        auto iter = entries.find (key);
+        if (iter != entries.end() &&
+            iter->second.price_stamp ==
+            subtree_price_stamp (pdb, report_commodity,
+                                 iter->second.commodities))
+            return iter->second;
+    }
+
+    entry.balance = xaccAccountConvertBalanceToCurrency (acc, own (acc),
+                                                         priv->commodity,
+                                                         report_commodity);
+    entry.exact = on_fraction (entry.balance, report_commodity);
+    if (priv->commodity &&
+        !gnc_commodity_equiv (priv->commodity, report_commodity))
+        entry.commodities.push_back (priv->commodity);
+    for (GList *node = priv->children; node; node = g_list_next (node))
+    {
+        auto child = static_cast<const Account*>(node->data);
+        auto child_entry =
+            xaccAccountGetCachedSubtreeBalance (child, key, report_commodity,
+                                                pdb, own);
+        for (auto commodity : child_entry.commodities)
+            if (std::find (entry.commodities.begin(), entry.commodities.end(),
+                           commodity) == entry.commodities.end())
+                entry.commodities.push_back (commodity);
+        if (!entry.exact || !child_entry.exact)
+        {
+            entry.exact = false;
+            continue;
+        }
+        entry.balance = gnc_numeric_add (entry.balance, child_entry.balance,
+                                         gnc_commodity_get_fraction (report_commodity),
+                                         GNC_HOW_RND_ROUND_HALF_UP);
+        entry.exact = gnc_numeric_check (entry.balance) == GNC_ERROR_OK;
+    }
+    entry.price_stamp = subtree_price_stamp (pdb, report_commodity,
+                                             entry.commodities);
+
+    /* Store after the children: computing their balances may have brought
+     * them up to date, which drops this account's entries. */
+    if (!priv->subtree_balances)
+        priv->subtree_balances = new GncSubtreeBalances;
+    auto& entries = priv->subtree_balances->entries;
+    if (entries.size() >= GncSubtreeBalances::max_entries)
+        entries.clear();
+    entries[key] = entry;
+    return entry;
+}
 
 /*
  * Common function that iterates recursively over all accounts below
- * the specified account.  It uses xaccAccountBalanceHelper to sum up
- * the balances of all its children, and uses the specified function
- * 'fn' for extracting the balance.  This function may extract the
- * current value, the reconciled value, etc.
+ * the specified account.  It sums up the balances of all its children,
+ * and uses the specified function 'fn' for extracting the balance.  This
+ * function may extract the current value, the reconciled value, etc.
+ * Totals of balances that don't depend on the current time are cached
+ * per account, see GncSubtreeBalances.
  *
  * If 'report_commodity' is NULL, just use the account's commodity.
  * If 'include_children' is FALSE, this function doesn't recurse at all.
@@ -3636,6 +4001,7 @@ xaccAccountGetXxxBalanceInCurrencyRecursive (const Account *acc,
         gboolean include_children)
 {
     gnc_numeric balance;
+    SplitBalanceType type;
 
     if (!acc) return gnc_numeric_zero ();
     if (!report_commodity)
@@ -3643,6 +4009,17 @@ xaccAccountGetXxxBalanceInCurrencyRecursive (const Account *acc,
     if (!report_commodity)
         return gnc_numeric_zero();
 
+    if (include_children && fn && cacheable_balance_fn (fn, &type))
+    {
+        GncSubtreeBalances::Key key (false, type, report_commodity, 0);
+        GNCPriceDB *pdb = gnc_pricedb_get_db (gnc_account_get_book (acc));
+        auto entry = xaccAccountGetCachedSubtreeBalance (acc, key,
+                                                         report_commodity,
+                                                         pdb, fn);
+        if (entry.exact)
+            return entry.balance;
+    }
+
     balance = xaccAccountGetXxxBalanceInCurrency (acc, fn, report_commodity);
 
     /* If needed, sum up the children converting to the *requested*
@@ -3672,6 +4049,7 @@ xaccAccountGetXxxBalanceAsOfDateInCurrencyRecursive (
     gnc_commodity *report_commodity, gboolean include_children)
 {
     gnc_numeric balance;
+    SplitBalanceType type;
 
     g_return_val_if_fail(acc, gnc_numeric_zero());
     if (!report_commodity)
@@ -3679,6 +4057,20 @@ xaccAccountGetXxxBalanceAsOfDateInCurrencyRecursive (
     if (!report_commodity)
         return gnc_numeric_zero();
 
+    if (include_children && fn && cacheable_balance_as_of_date_fn (fn, &type))
+    {
+        GncSubtreeBalances::Key key (true, type, report_commodity, date);
+        GNCPriceDB *pdb = gnc_pricedb_get_db (gnc_account_get_book (acc));
+        auto entry = xaccAccountGetCachedSubtreeBalance (
+                         acc, key, report_commodity, pdb,
+                         [fn, date](const Account *a)
+                         {
+                             return fn (const_cast<Account*>(a), date);
+                         });
+        if (entry.exact)
+            return entry.balance;
+    }
+
     balance = xaccAccountGetXxxBalanceAsOfDateInCurrency(
                   acc, date, fn, report_commodity);
 
@@ -3805,13 +4197,11 @@ xaccAccountGetNoclosingBalanceChangeForPeriod (Account *acc, time64 t1,
 
 /* THIS API NEEDS TO CHANGE.
  *
- * This code exposes the internal structure of the account object to
- * external callers by returning the actual list used by the object.
- * It should instead return a copy of the split list that the caller
- * is required to free.  That change would provide the freedom of
- * allowing the internal organization to change data structures if
- * necessary for whatever reason, while leaving the external API
- * unchanged. */
+ * The splits are no longer stored in a GList; this returns a GList
+ * mirror that the split index builds on first use and then keeps in
+ * step with the account.  Callers should not free it.  It should
+ * instead return a copy of the split list that the caller is required
+ * to free, so that accounts nobody asks for a list don't carry one. */
 /* XXX: violates the const'ness by forcing a sort before returning
  * the splitlist */
 SplitList *
@@ -3819,7 +4209,7 @@ xaccAccountGetSplitList (const Account *acc)
 {
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), NULL);
     xaccAccountSortSplits((Account*)acc, FALSE);  // normally a noop
-    return GET_PRIVATE(acc)->splits;
+    return GET_PRIVATE(acc)->splits->list();
 }
 
 gint64
@@ -3829,7 +4219,7 @@ xaccAccountCountSplits (const Account *acc, gboolean include_children)
 
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), 0);
 
-    nr = g_list_length(xaccAccountGetSplitList(acc));
+    nr = GET_PRIVATE(acc)->splits->size();
     if (include_children && (gnc_account_n_children(acc) != 0))
     {
         for (i=0; i < gnc_account_n_children(acc); i++)
@@ -3949,8 +4339,9 @@ const char *
 xaccAccountGetTaxUSCode (const Account *acc)
 {
     GValue v = G_VALUE_INIT;
+    static const KvpPath path {{"tax-US", "code"}};
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
-    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, {"tax-US", "code"});
+    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, path);
     return G_VALUE_HOLDS_STRING (&v) ? g_value_get_string (&v) : NULL;
 }
 
@@ -3972,8 +4363,9 @@ const char *
 xaccAccountGetTaxUSPayerNameSource (const Account *acc)
 {
     GValue v = G_VALUE_INIT;
+    static const KvpPath path {{"tax-US", "payer-name-source"}};
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
-    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, {"tax-US", "payer-name-source"});
+    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, path);
     return G_VALUE_HOLDS_STRING (&v) ? g_value_get_string (&v) : NULL;
  }
 
@@ -3996,8 +4388,9 @@ xaccAccountGetTaxUSCopyNumber (const Account *acc)
 {
     gint64 copy_number = 0;
     GValue v = G_VALUE_INIT;
+    static const KvpPath path {{"tax-US", "copy-number"}};
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
-    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, {"tax-US", "copy-number"});
+    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, path);
     if (G_VALUE_HOLDS_INT64 (&v))
         copy_number = g_value_get_int64 (&v);
 
@@ -4402,8 +4795,9 @@ xaccAccountGetReconcileLastDate (const Account *acc, time64 *last_date)
 {
     gint64 date = 0;
     GValue v = G_VALUE_INIT;
+    static const KvpPath path {{KEY_RECONCILE_INFO, "last-date"}};
     g_return_val_if_fail(GNC_IS_ACCOUNT(acc), FALSE);
-    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, {KEY_RECONCILE_INFO, "last-date"});
+    qof_instance_get_path_kvp (QOF_INSTANCE(acc), &v, path);
     if (G_VALUE_HOLDS_INT64 (&v))
         date = g_value_get_int64 (&v);
 
@@ -4839,7 +5233,6 @@ finder_help_function(const Account *acc, const char *description,
                      Split **split, Transaction **trans )
 {
     AccountPrivate *priv;
-    GList *slp;
 
     /* First, make sure we set the data to NULL BEFORE we start */
     if (split) *split = NULL;
@@ -4852,9 +5245,9 @@ finder_help_function(const Account *acc, const char *description,
      * list is in date order, and the most recent matches should be
      * returned!?  */
     priv = GET_PRIVATE(acc);
-    for (slp = g_list_last(priv->splits); slp; slp = slp->prev)
+    for (auto slp = priv->splits->rbegin(); slp != priv->splits->rend(); ++slp)
     {
-        Split *lsplit = static_cast<Split*>(slp->data);
+        Split *lsplit = *slp;
         Transaction *ltrans = xaccSplitGetParent(lsplit);
 
         if (g_strcmp0 (description, xaccTransGetDescription (ltrans)) == 0)
@@ -4971,8 +5364,8 @@ gnc_account_merge_children (Account *parent)
             gnc_account_merge_children (acc_a);
 
             /* consolidate transactions */
-            while (priv_b->splits)
-                xaccSplitSetAccount (static_cast <Split*> (priv_b->splits->data), acc_a);
+            while (!priv_b->splits->empty())
+                xaccSplitSetAccount (priv_b->splits->front(), acc_a);
 
             /* move back one before removal. next iteration around the loop
              * will get the node after node_b */
@@ -5014,7 +5407,9 @@ xaccAccountBeginStagedTransactionTraversals (const Account *account)
     if (!account)
         return;
     priv = GET_PRIVATE(account);
-    xaccSplitsBeginStagedTransactionTraversals(priv->splits);
+    for (auto s : *priv->splits)
+        if (s->parent)
+            s->parent->marker = 0;
 }
 
 gboolean
@@ -5031,16 +5426,11 @@ xaccTransactionTraverse (Transaction *trans, int stage)
     return FALSE;
 }
 
-static void do_one_split (Split *s, gpointer data)
-{
-    Transaction *trans = s->parent;
-    trans->marker = 0;
-}
-
 static void do_one_account (Account *account, gpointer data)
 {
     AccountPrivate *priv = GET_PRIVATE(account);
-    g_list_foreach(priv->splits, (GFunc)do_one_split, NULL);
+    for (auto s : *priv->splits)
+        s->parent->marker = 0;
 }
 
 /* Replacement for xaccGroupBeginStagedTransactionTraversals */
@@ -5061,24 +5451,20 @@ xaccAccountStagedTransactionTraversal (const Account *acc,
                                        void *cb_data)
 {
     AccountPrivate *priv;
-    GList *split_p;
-    GList *next;
     Transaction *trans;
-    Split *s;
     int retval;
 
     if (!acc) return 0;
 
     priv = GET_PRIVATE(acc);
-    for (split_p = priv->splits; split_p; split_p = next)
+    /* Walk a copy of the split index, just in case some naughty thunk
+     * removes splits from this account, and skip any split that is no
+     * longer in the account by the time we reach it. */
+    for (auto s : priv->splits->snapshot())
     {
-        /* Get the next element in the split list now, just in case some
-         * naughty thunk destroys the one we're using. This reduces, but
-         * does not eliminate, the possibility of undefined results if
-         * a thunk removes splits from this account. */
-        next = g_list_next(split_p);
+        if (!priv->splits->contains(s))
+            continue;
 
-        s = static_cast <Split*> (split_p->data);
         trans = s->parent;
         if (trans && (trans->marker < stage))
         {
@@ -5101,9 +5487,8 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
         void *cb_data)
 {
     const AccountPrivate *priv;
-    GList *acc_p, *split_p;
+    GList *acc_p;
     Transaction *trans;
-    Split *s;
     int retval;
 
     if (!acc) return 0;
@@ -5118,9 +5503,8 @@ gnc_account_tree_staged_transaction_traversal (const Account *acc,
     }
 
     /* Now this account */
-    for (split_p = priv->splits; split_p; split_p = g_list_next(split_p))
+    for (auto s : priv->splits->snapshot())
     {
-        s = static_cast <Split*> (split_p->data);
         trans = s->parent;
         if (trans && (trans->marker < stage))
         {
@@ -5946,7 +6330,15 @@ gboolean xaccAccountRegister (void)
         { NULL },
     };
 
+    /* Not the balances: they are cached lazily. */
+    static const char *thread_safe[] =
+    {
+        ACCOUNT_NAME_, ACCOUNT_CODE_, ACCOUNT_DESCRIPTION_, ACCOUNT_TYPE_,
+        ACCOUNT_PARENT, QOF_PARAM_BOOK, QOF_PARAM_GUID, nullptr
+    };
+
     qof_class_register (GNC_ID_ACCOUNT, (QofSortFunc) qof_xaccAccountOrder, params);
+    qof_class_register_thread_safe (GNC_ID_ACCOUNT, thread_safe);
 
     return qof_object_register (&account_object_def);
 }
@@ -558,6 +558,34 @@ gnc_numeric xaccAccountGetProjectedMinimumBalance (const Account *account);
 gnc_numeric xaccAccountGetBalanceAsOfDate (Account *account,
         time64 date);
 
+/** Get the balances of the account as of each of a series of dates.
+ *
+ *  This is equivalent to calling xaccAccountGetBalanceAsOfDate() for
+ *  each date, but when the dates are in ascending order the account's
+ *  splits are only traversed once.
+ *
+ *  @param account The account.
+ *  @param dates An array of n dates, preferably sorted ascending.
+ *  @param n The number of dates.
+ *  @param balances An array of n gnc_numerics to receive the balances.
+ */
+void xaccAccountGetBalancesAsOfDates (Account *account, const time64 *dates,
+                                      gsize n, gnc_numeric *balances);
+/** As xaccAccountGetBalancesAsOfDates(), ignoring closing entries. */
+void xaccAccountGetNoclosingBalancesAsOfDates (Account *account,
+                                               const time64 *dates, gsize n,
+                                               gnc_numeric *balances);
+/** As xaccAccountGetBalancesAsOfDates(), only including cleared
+ *  transactions. */
+void xaccAccountGetClearedBalancesAsOfDates (Account *account,
+                                             const time64 *dates, gsize n,
+                                             gnc_numeric *balances);
+/** As xaccAccountGetBalancesAsOfDates(), only including reconciled
+ *  transactions. */
+void xaccAccountGetReconciledBalancesAsOfDates (Account *account,
+                                                const time64 *dates, gsize n,
+                                                gnc_numeric *balances);
+
 /* These two functions convert a given balance from one commodity to
    another.  The account argument is only used to get the Book, and
    may have nothing to do with the supplied balance.  Likewise, the
@@ -998,11 +1026,12 @@ gboolean xaccAccountIsEquityType(GNCAccountType t);
 
 /** The xaccAccountGetSplitList() routine returns a pointer to a GList of
  *    the splits in the account.
- * @note This GList is the account's internal
- *    data structure: do not delete it when done; treat it as a read-only
- *    structure.  Note that some routines (such as xaccAccountRemoveSplit())
- *    modify this list directly, and could leave you with a corrupted
- *    pointer.
+ * @note This GList is owned by the account, which builds it from its
+ *    internal split index the first time it is requested and keeps it
+ *    up to date afterwards: do not delete it when done; treat it as a
+ *    read-only structure.  Note that some routines (such as
+ *    xaccAccountRemoveSplit()) unlink nodes from this list, and could
+ *    leave you with a corrupted pointer.
  * @note This should be changed so that the returned value is a copy
  * of the list. No other part of the code should have access to the
  * internal data structure used by this object.
@@ -47,6 +47,9 @@ extern "C" {
 
 #define GNC_ID_ROOT_ACCOUNT        "RootAccount"
 
+typedef struct GncSplitIndex GncSplitIndex;
+typedef struct GncSubtreeBalances GncSubtreeBalances;
+
 /** STRUCTS *********************************************************/
 
 /** This is the data that describes an account.
@@ -115,8 +118,13 @@ typedef struct AccountPrivate
     gnc_numeric reconciled_balance;
 
     gboolean balance_dirty;     /* balances in splits incorrect */
+    /* Totals over this account and its descendants, by balance type and
+     * report commodity; created on first use, see Account.cpp. */
+    GncSubtreeBalances *subtree_balances;
 
-    GList *splits;              /* list of split pointers */
+    /* The splits in this account, kept in xaccSplitOrder() order in a
+     * contiguous array; see gnc-split-index.hpp. */
+    GncSplitIndex *splits;
     gboolean sort_dirty;        /* sort order of splits is bad */
 
     LotList   *lots;		/* list of lot pointers */
@@ -141,6 +149,19 @@ void xaccAccountSetGUID (Account *account, const GncGUID *guid);
 /* Register Accounts with the engine */
 gboolean xaccAccountRegister (void);
 
+/* Tell the account that the running balances of split, and of every split
+ * after it, need to be recomputed. Pass TRUE for reconcile_only when only
+ * the split's reconcile state changed; then only the cleared and
+ * reconciled balances are redone. */
+void gnc_account_set_split_balance_dirty (Account *acc, const Split *split,
+                                          gboolean reconcile_only);
+
+/* Called when split is committed: marks its running balances dirty if they
+ * no longer follow from its amount and the balances of the split before
+ * it, catching changes that weren't reported through
+ * gnc_account_set_split_balance_dirty(). */
+void gnc_account_check_split_balance (Account *acc, const Split *split);
+
 /* Structure for accessing static functions for testing */
 typedef struct
 {
@@ -124,6 +124,10 @@ gnc_split_init(Split* split)
 
     split->gains = GAINS_STATUS_UNKNOWN;
     split->gains_split = NULL;
+
+    split->cache_valid = 0;
+    split->split_type = NULL;
+    split->online_id = NULL;
 }
 
 static void
@@ -137,6 +141,57 @@ gnc_split_finalize(GObject* splitp)
 {
     G_OBJECT_CLASS(gnc_split_parent_class)->finalize(splitp);
 }
+/* The cached kvp values are filled under a lock for the same reason as
+ * those of a Transaction: a parallel query may read them from several
+ * threads. */
+G_LOCK_DEFINE_STATIC (split_cache);
+
+static char *
+split_kvp_dup_string (const Split *split, const char *key)
+{
+    GValue v = G_VALUE_INIT;
+    char *ret = NULL;
+    qof_instance_get_kvp (QOF_INSTANCE (split), &v, 1, key);
+    if (G_VALUE_HOLDS_STRING (&v))
+        ret = g_value_dup_string (&v);
+    if (G_IS_VALUE (&v))
+        g_value_unset (&v);
+    return ret;
+}
+
+static void
+split_cache_fill (const Split *split, SplitCachedField field)
+{
+    Split *s = (Split *) split;
+
+    if (g_atomic_int_get (&s->cache_valid) & field)
+        return;
+
+    G_LOCK (split_cache);
+    if (!(s->cache_valid & field))
+    {
+        switch (field)
+        {
+        case SPLIT_CACHED_TYPE:
+            g_free (s->split_type);
+            s->split_type = split_kvp_dup_string (s, "split-type");
+            break;
+        case SPLIT_CACHED_ONLINE_ID:
+            g_free (s->online_id);
+            s->online_id = split_kvp_dup_string (s, "online_id");
+            break;
+        }
+        g_atomic_int_or (&s->cache_valid, field);
+    }
+    G_UNLOCK (split_cache);
+}
+
+static void
+gnc_split_kvp_changed (QofInstance *inst)
+{
+    g_atomic_int_set (&GNC_SPLIT (inst)->cache_valid, 0);
+}
+
 /* Note that g_value_set_object() refs the object, as does
  * g_object_get(). But g_object_get() only unrefs once when it disgorges
  * the object, leaving an unbalanced ref, which leaks. So instead of
@@ -202,7 +257,14 @@ gnc_split_get_property(GObject         *object,
             qof_instance_get_kvp (QOF_INSTANCE (split), value, 2, GNC_SX_ID, GNC_SX_SHARES);
             break;
         case PROP_ONLINE_ACCOUNT:
-            qof_instance_get_kvp (QOF_INSTANCE (split), value, 1, "online_id");
+            split_cache_fill (split, SPLIT_CACHED_ONLINE_ID);
+            if (split->online_id)
+            {
+                if (G_IS_VALUE (value))
+                    g_value_unset (value);
+                g_value_init (value, G_TYPE_STRING);
+                g_value_set_string (value, split->online_id);
+            }
             break;
         case PROP_GAINS_SPLIT:
             qof_instance_get_kvp (QOF_INSTANCE (split), value, 1, "gains-split");
@@ -298,11 +360,13 @@ static void
 gnc_split_class_init(SplitClass* klass)
 {
     GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+    QofInstanceClass* instance_class = QOF_INSTANCE_CLASS(klass);
 
     gobject_class->dispose = gnc_split_dispose;
     gobject_class->finalize = gnc_split_finalize;
     gobject_class->set_property = gnc_split_set_property;
     gobject_class->get_property = gnc_split_get_property;
+    instance_class->kvp_changed = gnc_split_kvp_changed;
 
     g_object_class_install_property
         (gobject_class,
@@ -703,6 +767,8 @@ xaccFreeSplit (Split *split)
     }
     CACHE_REMOVE(split->memo);
     CACHE_REMOVE(split->action);
+    g_free (split->split_type);
+    g_free (split->online_id);
 
     /* Just in case someone looks up freed memory ... */
     split->memo        = (char *) 1;
@@ -716,6 +782,9 @@ xaccFreeSplit (Split *split)
     split->orig_acc    = NULL;
 
     split->date_reconciled = 0;
+    split->cache_valid = 0;
+    split->split_type = NULL;
+    split->online_id = NULL;
     G_OBJECT_CLASS (QOF_INSTANCE_GET_CLASS (&split->inst))->dispose(G_OBJECT (split));
     // Is this right?
     if (split->gains_split) split->gains_split->gains_split = NULL;
@@ -727,13 +796,26 @@ void mark_split (Split *s)
 {
     if (s->acc)
     {
-        g_object_set(s->acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        g_object_set(s->acc, "sort-dirty", TRUE, NULL);
+        gnc_account_set_split_balance_dirty (s->acc, s, FALSE);
     }
 
     /* set dirty flag on lot too. */
     if (s->lot) gnc_lot_set_closed_unknown(s->lot);
 }
 
+/* A change of reconcile state only affects the account's cleared and
+ * reconciled balances, and doesn't concern the lot. */
+static void
+mark_split_reconcile (Split *s)
+{
+    if (s->acc)
+    {
+        g_object_set(s->acc, "sort-dirty", TRUE, NULL);
+        gnc_account_set_split_balance_dirty (s->acc, s, TRUE);
+    }
+}
+
 /*
  * Helper routine for xaccSplitEqual.
  */
@@ -1017,7 +1099,8 @@ xaccSplitCommitEdit(Split *s)
 
     if (acc)
     {
-        g_object_set(acc, "sort-dirty", TRUE, "balance-dirty", TRUE, NULL);
+        g_object_set(acc, "sort-dirty", TRUE, NULL);
+        gnc_account_check_split_balance (acc, s);
         xaccAccountRecomputeBalance(acc);
     }
 }
@@ -1749,7 +1832,7 @@ qofSplitSetReconcile (Split *split, char recn)
         case FREC:
         case VREC:
             split->reconciled = recn;
-            mark_split (split);
+            mark_split_reconcile (split);
             xaccAccountRecomputeBalance (split->acc);
             break;
         default:
@@ -1772,7 +1855,7 @@ xaccSplitSetReconcile (Split *split, char recn)
         case FREC:
         case VREC:
             split->reconciled = recn;
-            mark_split (split);
+            mark_split_reconcile (split);
             qof_instance_set_dirty(QOF_INSTANCE(split));
             xaccAccountRecomputeBalance (split->acc);
             break;
@@ -1956,14 +2039,9 @@ xaccSplitGetBook (const Split *split)
 const char *
 xaccSplitGetType(const Split *s)
 {
-    GValue v = G_VALUE_INIT;
-    const char *split_type = NULL;
-
     if (!s) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (s), &v, 1, "split-type");
-    if (G_VALUE_HOLDS_STRING (&v))
-        split_type = g_value_get_string (&v);
-    return split_type ? split_type : "normal";
+    split_cache_fill (s, SPLIT_CACHED_TYPE);
+    return s->split_type ? s->split_type : "normal";
 }
 
 /* reconfigure a split to be a stock split - after this, you shouldn't
@@ -2324,7 +2402,16 @@ gboolean xaccSplitRegister (void)
             { NULL },
         };
 
+    static const char *thread_safe[] =
+        {
+            SPLIT_DATE_RECONCILED, SPLIT_MEMO, SPLIT_ACTION, SPLIT_RECONCILE,
+            SPLIT_AMOUNT, SPLIT_SHARE_PRICE, SPLIT_VALUE, SPLIT_LOT,
+            SPLIT_TRANS, SPLIT_ACCOUNT, SPLIT_ACCOUNT_GUID, QOF_PARAM_BOOK,
+            QOF_PARAM_GUID, NULL
+        };
+
     qof_class_register (GNC_ID_SPLIT, (QofSortFunc)xaccSplitOrder, params);
+    qof_class_register_thread_safe (GNC_ID_SPLIT, thread_safe);
     qof_class_register (SPLIT_ACCT_FULLNAME,
                         (QofSortFunc)xaccSplitCompareAccountFullNames, NULL);
     qof_class_register (SPLIT_CORR_ACCT_NAME,
@@ -2333,6 +2420,24 @@ gboolean xaccSplitRegister (void)
     qof_class_register (SPLIT_CORR_ACCT_CODE,
                         (QofSortFunc)xaccSplitCompareOtherAccountCodes, NULL);
 
+    /* Registers, finds and reports select splits by account, transaction,
+     * date range or amount; let those queries avoid scanning every split
+     * in the book. */
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          TRANS_DATE_POSTED,
+                                                          NULL));
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_ACCOUNT,
+                                                          QOF_PARAM_GUID,
+                                                          NULL));
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_TRANS,
+                                                          QOF_PARAM_GUID,
+                                                          NULL));
+    qof_query_register_index (GNC_ID_SPLIT,
+                              qof_query_build_param_list (SPLIT_VALUE, NULL));
+
     return qof_object_register (&split_object_def);
 }
 
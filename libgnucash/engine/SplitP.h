@@ -126,8 +126,23 @@ struct split_s
     gnc_numeric  noclosing_balance;
     gnc_numeric  cleared_balance;
     gnc_numeric  reconciled_balance;
+
+    /* Values kept in kvp that are read far more often than they change are
+     * cached as in a Transaction: a value is valid while its SplitCachedField
+     * bit is set in cache_valid, and the bits are cleared whenever the kvp
+     * frame changes. */
+    guint cache_valid;
+    char * split_type;
+    char * online_id;
 };
 
+/* The kvp values cached in a Split, see cache_valid. */
+typedef enum
+{
+    SPLIT_CACHED_TYPE      = 1 << 0,
+    SPLIT_CACHED_ONLINE_ID = 1 << 1,
+} SplitCachedField;
+
 struct _SplitClass
 {
     QofInstanceClass parent_class;
@@ -271,9 +271,11 @@ gnc_transaction_init(Transaction* trans)
     trans->date_posted  = 0;
     trans->marker = 0;
     trans->orig = NULL;
+    trans->cache_valid = 0;
     trans->readonly_reason = NULL;
-    trans->reason_cache_valid = FALSE;
-    trans->isClosingTxn_cached = -1;
+    trans->notes = NULL;
+    trans->doclink = NULL;
+    trans->void_reason = NULL;
     LEAVE (" ");
 }
 
@@ -391,15 +393,83 @@ gnc_transaction_set_property(GObject* object,
     }
 }
 
+/* The cached kvp values are filled under this lock: a parallel query (see
+ * qof_query_set_parallel) may call the getters of one transaction from
+ * several threads, e.g. through the splits of a split query. */
+G_LOCK_DEFINE_STATIC (trans_cache);
+
+static char *
+trans_kvp_dup_string (const Transaction *trans, const char *key)
+{
+    GValue v = G_VALUE_INIT;
+    char *ret = NULL;
+    qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, key);
+    if (G_VALUE_HOLDS_STRING (&v))
+        ret = g_value_dup_string (&v);
+    if (G_IS_VALUE (&v))
+        g_value_unset (&v);
+    return ret;
+}
+
+static void
+trans_cache_fill (const Transaction *trans, TransCachedField field)
+{
+    Transaction *t = (Transaction *) trans;
+    GValue v = G_VALUE_INIT;
+
+    if (g_atomic_int_get (&t->cache_valid) & field)
+        return;
+
+    G_LOCK (trans_cache);
+    if (!(t->cache_valid & field))
+    {
+        switch (field)
+        {
+        case TRANS_CACHED_READ_ONLY:
+            g_free (t->readonly_reason);
+            t->readonly_reason = trans_kvp_dup_string (t, TRANS_READ_ONLY_REASON);
+            break;
+        case TRANS_CACHED_NOTES:
+            g_free (t->notes);
+            t->notes = trans_kvp_dup_string (t, trans_notes_str);
+            break;
+        case TRANS_CACHED_DOCLINK:
+            g_free (t->doclink);
+            t->doclink = trans_kvp_dup_string (t, assoc_uri_str);
+            break;
+        case TRANS_CACHED_VOID:
+            g_free (t->void_reason);
+            t->void_reason = trans_kvp_dup_string (t, void_reason_str);
+            break;
+        case TRANS_CACHED_IS_CLOSING:
+            qof_instance_get_kvp (QOF_INSTANCE (t), &v, 1, trans_is_closing_str);
+            t->is_closing = G_VALUE_HOLDS_INT64 (&v) && g_value_get_int64 (&v);
+            if (G_IS_VALUE (&v))
+                g_value_unset (&v);
+            break;
+        }
+        g_atomic_int_or (&t->cache_valid, field);
+    }
+    G_UNLOCK (trans_cache);
+}
+
+static void
+gnc_transaction_kvp_changed (QofInstance *inst)
+{
+    g_atomic_int_set (&GNC_TRANSACTION (inst)->cache_valid, 0);
+}
+
 static void
 gnc_transaction_class_init(TransactionClass* klass)
 {
     GObjectClass* gobject_class = G_OBJECT_CLASS(klass);
+    QofInstanceClass* instance_class = QOF_INSTANCE_CLASS(klass);
 
     gobject_class->dispose = gnc_transaction_dispose;
     gobject_class->finalize = gnc_transaction_finalize;
     gobject_class->set_property = gnc_transaction_set_property;
     gobject_class->get_property = gnc_transaction_get_property;
+    instance_class->kvp_changed = gnc_transaction_kvp_changed;
 
     g_object_class_install_property
     (gobject_class,
@@ -623,6 +693,7 @@ dupe_trans (const Transaction *from)
      * use this transaction, we'll have to fix this up.
      */
     to->inst.e_type = NULL;
+    to->is_rollback_copy = TRUE;
     qof_instance_set_guid(to, guid_null());
     qof_instance_copy_book(to, from);
     qof_instance_copy_kvp (QOF_INSTANCE(to), QOF_INSTANCE(from));
@@ -796,6 +867,7 @@ static void
 xaccFreeTransaction (Transaction *trans)
 {
     GList *node;
+    gboolean owned_only;
 
     if (!trans) return;
 
@@ -807,9 +879,17 @@ xaccFreeTransaction (Transaction *trans)
         return;
     }
 
-    /* free up the destination splits */
+    /* free up the destination splits. While the book is torn down we
+     * only own the splits that still think they belong to us, apart from
+     * a rollback copy, whose copied splits still name the original. */
+    owned_only = !trans->is_rollback_copy &&
+        qof_book_shutting_down (qof_instance_get_book (trans));
     for (node = trans->splits; node; node = node->next)
-        xaccFreeSplit (node->data);
+    {
+        Split *s = node->data;
+        if (s && (!owned_only || s->parent == trans))
+            xaccFreeSplit (s);
+    }
     g_list_free (trans->splits);
     trans->splits = NULL;
 
@@ -817,14 +897,20 @@ xaccFreeTransaction (Transaction *trans)
     CACHE_REMOVE(trans->num);
     CACHE_REMOVE(trans->description);
     g_free (trans->readonly_reason);
+    g_free (trans->notes);
+    g_free (trans->doclink);
+    g_free (trans->void_reason);
 
     /* Just in case someone looks up freed memory ... */
     trans->num         = (char *) 1;
     trans->description = NULL;
     trans->date_entered = 0;
     trans->date_posted = 0;
+    trans->cache_valid = 0;
     trans->readonly_reason = NULL;
-    trans->reason_cache_valid = FALSE;
+    trans->notes = NULL;
+    trans->doclink = NULL;
+    trans->void_reason = NULL;
     if (trans->orig)
     {
         xaccFreeTransaction (trans->orig);
@@ -1476,6 +1562,17 @@ xaccTransDestroy (Transaction *trans)
     }
 }
 
+void
+xaccTransDestroyReplayed (Transaction *trans)
+{
+    if (!trans) return;
+
+    xaccTransBeginEdit(trans);
+    trans->keep_gains = TRUE;
+    qof_instance_set_destroying(trans, TRUE);
+    xaccTransCommitEdit(trans);
+}
+
 static void
 destroy_gains (Transaction *trans)
 {
@@ -1505,7 +1602,7 @@ do_destroy (Transaction *trans)
     /* If there are capital-gains transactions associated with this,
      * they need to be destroyed too unless we're shutting down in
      * which case all transactions will be destroyed. */
-    if (!shutting_down)
+    if (!shutting_down && !trans->keep_gains)
         destroy_gains (trans);
 
     /* Make a log in the journal before destruction.  */
@@ -1860,6 +1957,7 @@ xaccTransRollbackEdit (Transaction *trans)
 
     trans->orig = NULL;
     qof_instance_set_destroying(trans, FALSE);
+    trans->keep_gains = FALSE;
 
     /* Put back to zero. */
     qof_instance_decrease_editlevel(trans);
@@ -2085,10 +2183,6 @@ void xaccTransClearReadOnly (Transaction *trans)
         qof_instance_set_kvp (QOF_INSTANCE (trans), NULL, 1, TRANS_READ_ONLY_REASON);
         qof_instance_set_dirty(QOF_INSTANCE(trans));
         xaccTransCommitEdit(trans);
-
-        g_free (trans->readonly_reason);
-        trans->readonly_reason = NULL;
-        trans->reason_cache_valid = TRUE;
     }
 }
 
@@ -2104,10 +2198,6 @@ xaccTransSetReadOnly (Transaction *trans, const char *reason)
         qof_instance_set_kvp (QOF_INSTANCE (trans), &v, 1, TRANS_READ_ONLY_REASON);
         qof_instance_set_dirty(QOF_INSTANCE(trans));
         xaccTransCommitEdit(trans);
-
-        g_free (trans->readonly_reason);
-        trans->readonly_reason = g_strdup (reason);
-        trans->reason_cache_valid = TRUE;
     }
 }
 
@@ -2207,12 +2297,10 @@ xaccTransSetIsClosingTxn (Transaction *trans, gboolean is_closing)
         g_value_init (&v, G_TYPE_INT64);
         g_value_set_int64 (&v, 1);
         qof_instance_set_kvp (QOF_INSTANCE (trans), &v, 1, trans_is_closing_str);
-        trans->isClosingTxn_cached = 1;
     }
     else
     {
         qof_instance_set_kvp (QOF_INSTANCE (trans), NULL, 1, trans_is_closing_str);
-        trans->isClosingTxn_cached = 0;
     }
     qof_instance_set_dirty(QOF_INSTANCE(trans));
     xaccTransCommitEdit(trans);
@@ -2347,42 +2435,25 @@ xaccTransGetDescription (const Transaction *trans)
 const char *
 xaccTransGetAssociation (const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     if (!trans) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, assoc_uri_str);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    trans_cache_fill (trans, TRANS_CACHED_DOCLINK);
+    return trans->doclink;
 }
 
 const char *
 xaccTransGetNotes (const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     if (!trans) return NULL;
-    qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, trans_notes_str);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    trans_cache_fill (trans, TRANS_CACHED_NOTES);
+    return trans->notes;
 }
 
 gboolean
 xaccTransGetIsClosingTxn (const Transaction *trans)
 {
     if (!trans) return FALSE;
-    if (trans->isClosingTxn_cached == -1)
-    {
-        Transaction* trans_nonconst = (Transaction*) trans;
-        GValue v = G_VALUE_INIT;
-        qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, trans_is_closing_str);
-        if (G_VALUE_HOLDS_INT64 (&v))
-            trans_nonconst->isClosingTxn_cached = (g_value_get_int64 (&v) ? 1 : 0);
-        else
-            trans_nonconst->isClosingTxn_cached = 0;
-    }
-    return (trans->isClosingTxn_cached == 1)
-            ? TRUE
-            : FALSE;
+    trans_cache_fill (trans, TRANS_CACHED_IS_CLOSING);
+    return trans->is_closing;
 }
 
 /********************************************************************\
@@ -2487,23 +2558,7 @@ xaccTransGetReadOnly (Transaction *trans)
     if (!trans)
         return NULL;
 
-    if (!trans->reason_cache_valid)
-    {
-        GValue v = G_VALUE_INIT;
-        qof_instance_get_kvp (QOF_INSTANCE(trans), &v, 1, TRANS_READ_ONLY_REASON);
-
-        /* Clear possible old cache value first */
-        g_free (trans->readonly_reason);
-        trans->readonly_reason = NULL;
-
-        /* Then set the new one */
-        if (G_VALUE_HOLDS_STRING (&v))
-        {
-            trans->readonly_reason = g_value_dup_string (&v);
-            g_value_unset (&v);
-        }
-        trans->reason_cache_valid = TRUE;
-    }
+    trans_cache_fill (trans, TRANS_CACHED_READ_ONLY);
     return trans->readonly_reason;
 }
 
@@ -2721,26 +2776,19 @@ xaccTransVoid(Transaction *trans, const char *reason)
 gboolean
 xaccTransGetVoidStatus(const Transaction *trans)
 {
-    const char *s = NULL;
-    GValue v = G_VALUE_INIT;
     g_return_val_if_fail(trans, FALSE);
 
-    qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, void_reason_str);
-    if (G_VALUE_HOLDS_STRING (&v))
-         s = g_value_get_string (&v);
-    return s && strlen(s);
+    trans_cache_fill (trans, TRANS_CACHED_VOID);
+    return trans->void_reason && *trans->void_reason;
 }
 
 const char *
 xaccTransGetVoidReason(const Transaction *trans)
 {
-    GValue v = G_VALUE_INIT;
     g_return_val_if_fail(trans, FALSE);
 
-    qof_instance_get_kvp (QOF_INSTANCE (trans), &v, 1, void_reason_str);
-    if (G_VALUE_HOLDS_STRING (&v))
-         return g_value_get_string (&v);
-    return NULL;
+    trans_cache_fill (trans, TRANS_CACHED_VOID);
+    return trans->void_reason;
 }
 
 time64
@@ -2941,15 +2989,19 @@ xaccTransFindSplitByAccount(const Transaction *trans, const Account *acc)
 \********************************************************************/
 /* QofObject function implementation */
 
+/* Everything in the book is about to go, so there's no point in an edit
+ * cycle, in rebalancing anything or in taking the splits out of their
+ * accounts' indexes, which the accounts drop wholesale when they're
+ * freed right after the transactions. Events are suspended while the
+ * book ends. */
 static void
-destroy_tx_on_book_close(QofInstance *ent, gpointer data)
+free_tx_on_book_close(QofInstance *ent, gpointer data)
 {
-    Transaction* tx = GNC_TRANSACTION(ent);
-
-    xaccTransDestroy(tx);
+    xaccFreeTransaction (GNC_TRANSACTION(ent));
 }
 
-/** Handles book end - frees all transactions from the book
+/** Handles book end - frees all transactions and their splits from the
+ * book in one sweep.
  *
  * @param book Book being closed
  */
@@ -2959,7 +3011,7 @@ gnc_transaction_book_end(QofBook* book)
     QofCollection *col;
 
     col = qof_book_get_collection(book, GNC_ID_TRANS);
-    qof_collection_foreach(col, destroy_tx_on_book_close, NULL);
+    qof_collection_foreach(col, free_tx_on_book_close, NULL);
 }
 
 #ifdef _MSC_VER
@@ -3075,7 +3127,17 @@ gboolean xaccTransRegister (void)
             { NULL },
         };
 
+    /* The kvp backed getters fill their caches under trans_cache. */
+    static const char *thread_safe[] =
+        {
+            TRANS_NUM, TRANS_DESCRIPTION, TRANS_DATE_ENTERED, TRANS_DATE_POSTED,
+            TRANS_NOTES, TRANS_ASSOCIATION, TRANS_IS_CLOSING,
+            TRANS_VOID_STATUS, TRANS_VOID_REASON, TRANS_SPLITLIST,
+            QOF_PARAM_BOOK, QOF_PARAM_GUID, NULL
+        };
+
     qof_class_register (GNC_ID_TRANS, (QofSortFunc)xaccTransOrder, params);
+    qof_class_register_thread_safe (GNC_ID_TRANS, thread_safe);
 
     return qof_object_register (&trans_object_def);
 }
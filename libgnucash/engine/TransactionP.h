@@ -111,21 +111,43 @@ struct transaction_s
      */
     Transaction *orig;
 
+    /* Values kept in kvp that are read far more often than they change,
+     * e.g. by the sort and balance loops, are cached here. A value is valid
+     * while its TransCachedField bit is set in cache_valid; the bits are
+     * cleared whenever the kvp frame changes. The cached strings are only
+     * freed when they are read again, so a string returned by a getter stays
+     * valid until after the next change.
+     */
+    guint cache_valid;
+
     /* The readonly_reason is a string that indicates why a transaction
      * is marked as read-only. If NULL, the transaction is read-write.
-     * This value is stored in kvp, but we cache a copy here for
-     * performance reasons. reason_cache_valid indicates whether the
-     * cached value is valid.
      */
     char * readonly_reason;
-    gboolean reason_cache_valid;
-
-    /* Cached bool value to indicate whether this is a closing txn. This is
-     * cached from the KVP value because it is queried a lot. Tri-state value: -1
-     * = uninitialized; 0 = FALSE, 1 = TRUE. */
-    gint isClosingTxn_cached;
+    char * notes;
+    char * doclink;
+    char * void_reason;
+    gboolean is_closing;
+
+    /* Set by xaccTransDestroyReplayed: the capital gains transactions are
+     * left alone when this one is destroyed. */
+    gboolean keep_gains;
+
+    /* Set by dupe_trans on the rollback copy kept in orig: its splits are
+     * copies it owns, although they name the original as their parent. */
+    gboolean is_rollback_copy;
 };
 
+/* The kvp values cached in a Transaction, see cache_valid. */
+typedef enum
+{
+    TRANS_CACHED_READ_ONLY  = 1 << 0,
+    TRANS_CACHED_NOTES      = 1 << 1,
+    TRANS_CACHED_DOCLINK    = 1 << 2,
+    TRANS_CACHED_VOID       = 1 << 3,
+    TRANS_CACHED_IS_CLOSING = 1 << 4,
+} TransCachedField;
+
 struct _TransactionClass
 {
     QofInstanceClass parent_class;
@@ -178,6 +200,12 @@ QofBackend * xaccTransactionGetBackend (Transaction *trans);
 void xaccEnableDataScrubbing(void);
 void xaccDisableDataScrubbing(void);
 
+/* Destroy the transaction as a backend replaying recorded changes does:
+ *   whether it is read-only doesn't matter, and its capital gains
+ *   transactions are left alone, as whatever happened to them was
+ *   recorded too. */
+void xaccTransDestroyReplayed (Transaction *trans);
+
 void xaccTransRemoveSplit (Transaction *trans, const Split *split);
 void check_open (const Transaction *trans);
 
@@ -118,7 +118,7 @@ gnc_localtime_r (const time64 *secs, struct tm* time)
 {
     try
     {
-        *time = static_cast<struct tm>(GncDateTime(*secs));
+        GncDateTime::local_tm(secs, 1, time);
         return time;
     }
     catch(std::invalid_argument&)
@@ -1217,8 +1217,8 @@ GDate time64_to_gdate (time64 t)
     GDate result;
 
     g_date_clear (&result, 1);
-    GncDateTime time(t);
-    auto date = time.date().year_month_day();
+    ymd date;
+    GncDateTime::local_dates(&t, 1, &date);
     g_date_set_dmy (&result, date.day, static_cast<GDateMonth>(date.month),
                     date.year);
     g_assert(g_date_valid (&result));
@@ -34,8 +34,11 @@ extern "C"
 #include <boost/regex.hpp>
 #include <libintl.h>
 #include <locale.h>
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -151,6 +154,14 @@ const std::vector<GncDateFormat> GncDate::c_formats ({
     }
 });
 
+static PTime
+ptime_from_unix(const time64 time)
+{
+    return PTime(unix_epoch.date(),
+                 boost::posix_time::hours(time / 3600) +
+                 boost::posix_time::seconds(time % 3600));
+}
+
 /** Private implementation of GncDateTime. See the documentation for that class.
  */
 static LDT
@@ -158,9 +169,7 @@ LDT_from_unix_local(const time64 time)
 {
     try
     {
-        PTime temp(unix_epoch.date(),
-                   boost::posix_time::hours(time / 3600) +
-                   boost::posix_time::seconds(time % 3600));
+        auto temp = ptime_from_unix(time);
         auto tz = tzp->get(temp.date().year());
         return LDT(temp, tz);
     }
@@ -213,16 +222,161 @@ LDT_from_struct_tm(const struct tm tm)
 
 using TD = boost::posix_time::time_duration;
 
+/* The UTC offsets of a TimeZoneProvider's zone as a sorted table of the
+ * times at which they change, so that converting a time64 to local time
+ * is a binary search instead of finding the zone for the year and
+ * working through its DST rules. The table covers the years that dates
+ * are usually in; times outside them are looked up the slow way.
+ */
+class TZOffsetTable
+{
+public:
+    struct Offset
+    {
+        time64 start; // The UTC time from which the offset applies
+        long seconds;
+        bool is_dst;
+    };
+
+    TZOffsetTable(const TimeZoneProvider* provider);
+    Offset lookup(time64 time) const;
+
+private:
+    static const int first_year = 1900;
+    static const int end_year = 2200;
+
+    const TimeZoneProvider* m_provider;
+    std::vector<Offset> m_offsets;
+    time64 m_begin;
+    time64 m_end;
+};
+
+static time64
+unix_from_ptime(const PTime& time)
+{
+    return (time - unix_epoch).ticks() / ticks_per_second;
+}
+
+static TZOffsetTable::Offset
+offset_at(const PTime& utc, const TZ_Ptr& tz)
+{
+    LDT ldt(utc, tz);
+    return {unix_from_ptime(utc), (ldt.local_time() - utc).total_seconds(),
+            ldt.is_dst()};
+}
+
+TZOffsetTable::TZOffsetTable(const TimeZoneProvider* provider) :
+    m_provider{provider},
+    m_begin{unix_from_ptime(PTime(Date(first_year, boost::gregorian::Jan, 1)))},
+    m_end{unix_from_ptime(PTime(Date(end_year, boost::gregorian::Jan, 1)))}
+{
+    for (auto year = first_year; year < end_year; ++year)
+    {
+        /* The zone is chosen by the UTC year, so the offset can change at
+         * the start of the year as well as at the DST transitions.
+         */
+        auto tz = provider->get(year);
+        PTime year_start(Date(year, boost::gregorian::Jan, 1));
+        std::vector<PTime> changes{year_start};
+        if (tz->has_dst())
+        {
+            auto base = tz->base_utc_offset();
+            auto dst_start = tz->dst_local_start_time(year) - base;
+            auto dst_end = tz->dst_local_end_time(year) - base - tz->dst_offset();
+            changes.push_back(std::min(dst_start, dst_end));
+            changes.push_back(std::max(dst_start, dst_end));
+        }
+        for (const auto& change : changes)
+        {
+            if (change < year_start || change.date().year() != year)
+                continue;
+            auto offset = offset_at(change, tz);
+            if (m_offsets.empty() ||
+                offset.seconds != m_offsets.back().seconds ||
+                offset.is_dst != m_offsets.back().is_dst)
+                m_offsets.push_back(offset);
+        }
+    }
+}
+
+TZOffsetTable::Offset
+TZOffsetTable::lookup(time64 time) const
+{
+    if (time >= m_begin && time < m_end)
+    {
+        auto next = std::upper_bound(m_offsets.begin(), m_offsets.end(), time,
+                                     [](time64 t, const Offset& offset)
+                                     { return t < offset.start; });
+        return *(next - 1);
+    }
+    try
+    {
+        auto utc = ptime_from_unix(time);
+        return offset_at(utc, m_provider->get(utc.date().year()));
+    }
+    catch(boost::gregorian::bad_year&)
+    {
+        throw(std::invalid_argument("Time value is outside the supported year range."));
+    }
+}
+
+/* The table for the current TimeZoneProvider, built the first time it's
+ * needed. It's shared so that a table in use by another thread survives
+ * _set_tzp replacing it.
+ */
+static std::mutex offset_table_mutex;
+static std::shared_ptr<const TZOffsetTable> current_offset_table;
+
+static std::shared_ptr<const TZOffsetTable>
+offset_table()
+{
+    std::lock_guard<std::mutex> lock(offset_table_mutex);
+    if (!current_offset_table)
+        current_offset_table = std::make_shared<const TZOffsetTable>(tzp);
+    return current_offset_table;
+}
+
 void
 _set_tzp(TimeZoneProvider& new_tzp)
 {
+    std::lock_guard<std::mutex> lock(offset_table_mutex);
     tzp = &new_tzp;
+    current_offset_table.reset();
 }
 
 void
 _reset_tzp()
 {
+    std::lock_guard<std::mutex> lock(offset_table_mutex);
     tzp = &ltzp;
+    current_offset_table.reset();
+}
+
+/* Break a UTC time down into local time with offset as
+ * static_cast<struct tm>(GncDateTime) would.
+ */
+static struct tm
+local_tm_from_unix(const time64 time, const TZOffsetTable::Offset& offset)
+{
+    constexpr time64 secs_per_day = 24 * 3600;
+    auto local = time + offset.seconds;
+    auto days = local / secs_per_day;
+    auto secs = local % secs_per_day;
+    if (secs < 0)
+    {
+        secs += secs_per_day;
+        --days;
+    }
+    auto date = unix_epoch.date() + boost::gregorian::days(days);
+    struct tm tm = boost::gregorian::to_tm(date);
+    tm.tm_hour = secs / 3600;
+    tm.tm_min = secs % 3600 / 60;
+    tm.tm_sec = secs % 60;
+    tm.tm_isdst = offset.is_dst ? 1 : 0;
+#if HAVE_STRUCT_TM_GMTOFF
+    tm.tm_gmtoff = offset.seconds;
+#endif
+    return tm;
 }
 
 class GncDateTimeImpl
@@ -246,6 +400,10 @@ public:
     std::string format_zulu(const char* format) const;
     std::string format_iso8601() const;
     static std::string timestamp();
+    static void local_tm(const time64* times, std::size_t count, struct tm* out);
+    static void local_dates(const time64* times, std::size_t count, ymd* out);
+    static void format(const time64* times, std::size_t count,
+                       const char* format, std::string* out);
 private:
     LDT m_time;
     static const TD time_of_day[3];
@@ -612,6 +770,97 @@ bool operator==(const GncDateImpl& a, const GncDateImpl& b) { return a.m_greg ==
 bool operator<=(const GncDateImpl& a, const GncDateImpl& b) { return a.m_greg <= b.m_greg; }
 bool operator>=(const GncDateImpl& a, const GncDateImpl& b) { return a.m_greg >= b.m_greg; }
 bool operator!=(const GncDateImpl& a, const GncDateImpl& b) { return a.m_greg != b.m_greg; }
+void
+GncDateTimeImpl::local_tm(const time64* times, std::size_t count, struct tm* out)
+{
+    auto table = offset_table();
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = local_tm_from_unix(times[i], table->lookup(times[i]));
+}
+
+void
+GncDateTimeImpl::local_dates(const time64* times, std::size_t count, ymd* out)
+{
+    auto table = offset_table();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto tm = local_tm_from_unix(times[i], table->lookup(times[i]));
+        out[i] = {tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday};
+    }
+}
+
+#ifndef __MINGW32__
+static bool
+has_zone_flag(const std::string& format)
+{
+    for (auto pos = format.find('%');
+         pos != std::string::npos && pos + 1 < format.size();
+         pos = format.find('%', pos + 2))
+        if (strchr("zZqQ", format[pos + 1]))
+            return true;
+    return false;
+}
+#endif
+
+void
+GncDateTimeImpl::format(const time64* times, std::size_t count,
+                        const char* format, std::string* out)
+{
+#ifdef __MINGW32__
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = GncDateTimeImpl(times[i]).format(format);
+#else
+    /* Making the facet and imbuing the stream costs far more than the
+     * formatting, so do it once for all of the times.
+     */
+    auto normalized = normalize_format(format);
+    std::stringstream ss;
+    try
+    {
+        if (has_zone_flag(normalized))
+        {
+            using Facet = boost::local_time::local_time_facet;
+            ss.imbue(std::locale(gnc_get_locale(), new Facet(normalized.c_str())));
+            TZ_Ptr tz;
+            int tz_year = 0;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto utc = ptime_from_unix(times[i]);
+                int year = utc.date().year();
+                if (!tz || year != tz_year)
+                {
+                    tz = tzp->get(year);
+                    tz_year = year;
+                }
+                ss.str("");
+                ss << LDT(utc, tz);
+                out[i] = ss.str();
+            }
+        }
+        else
+        {
+            /* Without a zone to print the local time is all that's
+             * needed, and the offset table gives it directly.
+             */
+            using Facet = boost::posix_time::time_facet;
+            ss.imbue(std::locale(gnc_get_locale(), new Facet(normalized.c_str())));
+            auto table = offset_table();
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                auto offset = table->lookup(times[i]);
+                ss.str("");
+                ss << ptime_from_unix(times[i] + offset.seconds);
+                out[i] = ss.str();
+            }
+        }
+    }
+    catch(boost::gregorian::bad_year&)
+    {
+        throw(std::invalid_argument("Time value is outside the supported year range."));
+    }
+#endif
+}
+
 
 /* =================== Presentation-class Implementations ====================*/
 /* GncDateTime */
@@ -686,6 +935,25 @@ GncDateTime::timestamp()
     return GncDateTimeImpl::timestamp();
 }
 
+void
+GncDateTime::local_tm(const time64* times, std::size_t count, struct tm* out)
+{
+    GncDateTimeImpl::local_tm(times, count, out);
+}
+
+void
+GncDateTime::local_dates(const time64* times, std::size_t count, ymd* out)
+{
+    GncDateTimeImpl::local_dates(times, count, out);
+}
+
+void
+GncDateTime::format(const time64* times, std::size_t count,
+                    const char* format, std::string* out)
+{
+    GncDateTimeImpl::format(times, count, format, out);
+}
+
 /* GncDate */
 GncDate::GncDate() : m_impl{new GncDateImpl} {}
 GncDate::GncDate(int year, int month, int day) :
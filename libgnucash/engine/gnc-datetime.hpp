@@ -25,6 +25,7 @@
 #ifndef __GNC_DATETIME_HPP__
 #define  __GNC_DATETIME_HPP__
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -156,7 +157,39 @@ public:
  *  @return a std::string in the format YYYYMMDDHHMMSS.
  */
     static std::string timestamp();
-    
+/** Convert an array of times to local time as struct tms.
+ *
+ *  The result is the same as casting a GncDateTime constructed from
+ *  each time, but the UTC offsets come from a table of the current
+ *  timezone's transitions and no GncDateTime is made, so prefer this
+ *  when converting many times.
+ *  @param times The times, in seconds from the POSIX epoch.
+ *  @param count The number of times.
+ *  @param out An array of count struct tm to receive the local times.
+ *  @exception std::invalid_argument if a year is outside the constraints.
+ */
+    static void local_tm(const time64* times, std::size_t count, struct tm* out);
+/** Obtain the local dates of an array of times, as GncDateTime::date()
+ *  would for each of them.
+ *  @param times The times, in seconds from the POSIX epoch.
+ *  @param count The number of times.
+ *  @param out An array of count ymd to receive the dates.
+ *  @exception std::invalid_argument if a year is outside the constraints.
+ */
+    static void local_dates(const time64* times, std::size_t count, ymd* out);
+/** Format an array of times in the current timezone as
+ *  GncDateTime::format() would for each of them, sharing the output
+ *  facet between them.
+ *  @param times The times, in seconds from the POSIX epoch.
+ *  @param count The number of times.
+ *  @param format A cstr describing the way the date and time are
+ *  presented, as for GncDateTime::format().
+ *  @param out An array of count std::string to receive the results.
+ *  @exception std::invalid_argument if a year is outside the constraints.
+ */
+    static void format(const time64* times, std::size_t count,
+                       const char* format, std::string* out);
+
 private:
     std::unique_ptr<GncDateTimeImpl> m_impl;
 };
@@ -672,12 +672,25 @@ gnc_lot_get_latest_split (GNCLot *lot)
 
 /* ============================================================= */
 
+/* The accounts drop their lot lists wholesale when they're freed later
+ * in the teardown, so a lot needn't take itself out of its account's
+ * list, which would cost a list search per lot. */
 static void
-destroy_lot_on_book_close(QofInstance *ent, gpointer data)
+free_lot_on_book_close(QofInstance *ent, gpointer data)
 {
     GNCLot* lot = GNC_LOT(ent);
+    GNCLotPrivate* priv = GET_PRIVATE(lot);
+    GList *node;
 
-    gnc_lot_destroy(lot);
+    for (node = priv->splits; node; node = node->next)
+    {
+        Split *s = node->data;
+        s->lot = NULL;
+    }
+    g_list_free (priv->splits);
+    priv->splits = NULL;
+    priv->account = NULL;
+    g_object_unref (lot);
 }
 
 static void
@@ -686,7 +699,7 @@ gnc_lot_book_end(QofBook* book)
     QofCollection *col;
 
     col = qof_book_get_collection(book, GNC_ID_LOT);
-    qof_collection_foreach(col, destroy_lot_on_book_close, NULL);
+    qof_collection_foreach(col, free_lot_on_book_close, NULL);
 }
 
 #ifdef _MSC_VER
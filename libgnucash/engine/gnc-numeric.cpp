@@ -40,6 +40,7 @@ extern "C"
 #include <boost/locale/encoding_utf.hpp>
 #include <sstream>
 #include <cstdlib>
+#include <algorithm>
 
 #include "gnc-numeric.hpp"
 #include "gnc-rational.hpp"
@@ -439,6 +440,70 @@ GncNumeric::cmp(GncNumeric b)
     return an.cmp(bn);
 }
 
+/* Add or subtract the numerators of two values with the same denominator,
+ * returning false if the result overflows 64 bits. */
+static inline bool
+add_same_denom(int64_t a, int64_t b, bool subtract, int64_t& result) noexcept
+{
+    if (subtract)
+    {
+        result = static_cast<int64_t>(static_cast<uint64_t>(a) -
+                                      static_cast<uint64_t>(b));
+        return ((a ^ b) & (a ^ result)) >= 0;
+    }
+    result = static_cast<int64_t>(static_cast<uint64_t>(a) +
+                                  static_cast<uint64_t>(b));
+    return ((a ^ result) & (b ^ result)) >= 0;
+}
+
+/* The sum of the numerators of count values sharing a denominator. Each
+ * numerator is split into its high and low 32 bits so that the inner loop
+ * accumulates without carries and can be vectorized; the halves are combined
+ * in 128 bits once per chunk. */
+template <typename T, typename NumFunc> static GncInt128
+sum_numerators(const T* values, size_t count, NumFunc num)
+{
+    /* Small enough that neither half sum can overflow. */
+    static const size_t chunk = size_t{1} << 30;
+    GncInt128 total;
+    while (count)
+    {
+        auto n = std::min(count, chunk);
+        int64_t high{0};
+        uint64_t low{0};
+        for (size_t i = 0; i < n; ++i)
+        {
+            auto v = num(values[i]);
+            high += v >> 32;
+            low += static_cast<uint32_t>(v);
+        }
+        total += GncInt128(high) * GncInt128(INT64_C(1) << 32) + GncInt128(low);
+        values += n;
+        count -= n;
+    }
+    return total;
+}
+
+GncNumeric
+GncNumeric::sum(const GncNumeric* values, size_t count)
+{
+    GncNumeric total;
+    if (!count)
+        return total;
+    auto den = values[0].m_den;
+    if (den > 0 && std::all_of(values, values + count,
+                               [den](const GncNumeric& v)
+                               { return v.m_den == den; }))
+    {
+        auto num = sum_numerators(values, count,
+                                  [](const GncNumeric& v) { return v.m_num; });
+        return GncNumeric(GncRational(num, den));
+    }
+    for (size_t i = 0; i < count; ++i)
+        total += values[i];
+    return total;
+}
+
 GncNumeric
 operator+(GncNumeric a, GncNumeric b)
 {
@@ -446,6 +511,10 @@ operator+(GncNumeric a, GncNumeric b)
         return b;
     if (b.num() == 0)
         return a;
+    int64_t sum;
+    if (a.denom() == b.denom() && a.denom() > 0 &&
+        add_same_denom(a.num(), b.num(), false, sum))
+        return GncNumeric(sum, a.denom());
     GncRational ar(a), br(b);
     auto rr = ar + br;
     return static_cast<GncNumeric>(rr);
@@ -746,6 +815,17 @@ denom_lcd(gnc_numeric a, gnc_numeric b, int64_t denom, int how)
     return denom;
 }
 
+/* Whether adding a and b with denom and how can only give the sum of their
+ * numerators over their common denominator. */
+static inline bool
+same_denom_fast_p(gnc_numeric a, gnc_numeric b, int64_t denom, int how)
+{
+    auto dtype = how & GNC_NUMERIC_DENOM_MASK;
+    return a.denom == b.denom && a.denom > 0 &&
+        (denom == GNC_DENOM_AUTO || denom == a.denom) &&
+        (dtype == GNC_HOW_DENOM_FIXED || dtype == GNC_HOW_DENOM_LCD);
+}
+
 /* *******************************************************************
  *  gnc_numeric_add
  ********************************************************************/
@@ -758,6 +838,12 @@ gnc_numeric_add(gnc_numeric a, gnc_numeric b,
     {
         return gnc_numeric_error(GNC_ERROR_ARG);
     }
+    if (same_denom_fast_p(a, b, denom, how))
+    {
+        int64_t result;
+        if (add_same_denom(a.num, b.num, false, result))
+            return gnc_numeric_create(result, a.denom);
+    }
     denom = denom_lcd(a, b, denom, how);
     try
     {
@@ -812,6 +898,12 @@ gnc_numeric_sub(gnc_numeric a, gnc_numeric b,
     {
         return gnc_numeric_error(GNC_ERROR_ARG);
     }
+    if (same_denom_fast_p(a, b, denom, how))
+    {
+        int64_t result;
+        if (add_same_denom(a.num, b.num, true, result))
+            return gnc_numeric_create(result, a.denom);
+    }
     denom = denom_lcd(a, b, denom, how);
     try
     {
@@ -853,6 +945,33 @@ gnc_numeric_sub(gnc_numeric a, gnc_numeric b,
     }
 }
 
+/* *******************************************************************
+ *  gnc_numeric_sum_array
+ ********************************************************************/
+
+gnc_numeric
+gnc_numeric_sum_array(const gnc_numeric *values, gsize count,
+                      gint64 denom, gint how)
+{
+    gnc_numeric sum = gnc_numeric_zero();
+    if (count && same_denom_fast_p(values[0], values[0], denom, how))
+    {
+        auto den = values[0].denom;
+        if (std::all_of(values, values + count,
+                        [den](const gnc_numeric& v) { return v.denom == den; }))
+        {
+            auto num = sum_numerators(values, count,
+                                      [](const gnc_numeric& v) { return v.num; });
+            if (!num.isBig())
+                return gnc_numeric_create(static_cast<int64_t>(num), den);
+        }
+    }
+    /* Mixed denominators, or a sum too big for the easy way. */
+    for (gsize i = 0; i < count && !gnc_numeric_check(sum); ++i)
+        sum = gnc_numeric_add(sum, values[i], denom, how);
+    return sum;
+}
+
 /* *******************************************************************
  *  gnc_numeric_mul
  ********************************************************************/
@@ -430,6 +430,14 @@ gnc_numeric gnc_numeric_abs(gnc_numeric a);
 static inline
 gnc_numeric gnc_numeric_add_fixed(gnc_numeric a, gnc_numeric b)
 {
+    /* Amounts in one commodity share its denominator; their sum needs no
+     * conversion unless it overflows. */
+    if (a.denom == b.denom && a.denom > 0)
+    {
+        gint64 sum = (gint64)((guint64)a.num + (guint64)b.num);
+        if (((a.num ^ sum) & (b.num ^ sum)) >= 0)
+            return gnc_numeric_create(sum, a.denom);
+    }
     return gnc_numeric_add(a, b, GNC_DENOM_AUTO,
                            GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
 }
@@ -441,9 +449,31 @@ gnc_numeric gnc_numeric_add_fixed(gnc_numeric a, gnc_numeric b)
 static inline
 gnc_numeric gnc_numeric_sub_fixed(gnc_numeric a, gnc_numeric b)
 {
+    if (a.denom == b.denom && a.denom > 0)
+    {
+        gint64 diff = (gint64)((guint64)a.num - (guint64)b.num);
+        if (((a.num ^ b.num) & (a.num ^ diff)) >= 0)
+            return gnc_numeric_create(diff, a.denom);
+    }
     return gnc_numeric_sub(a, b, GNC_DENOM_AUTO,
                            GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
 }
+
+/**
+ * Sum count values, giving the same result as adding them one after the
+ * other with gnc_numeric_add(sum, value, denom, how) starting from zero,
+ * except that only the final sum has to fit in 64 bits when all the values
+ * share one denominator, the usual case of amounts in a single commodity.
+ * That case is summed in one pass without any conversions.
+ * @param values The values to sum.
+ * @param count The number of values.
+ * @param denom The denominator of the sum, or GNC_DENOM_AUTO.
+ * @param how The rounding and denominator flags, see @ref Arguments.
+ * @return The sum, zero if count is 0, or an error if any value is
+ * invalid.
+ */
+gnc_numeric gnc_numeric_sum_array(const gnc_numeric *values, gsize count,
+                                  gint64 denom, gint how);
 /** @} */
 
 
@@ -255,6 +255,17 @@ public:
     void operator*=(GncNumeric b);
     void operator/=(GncNumeric b);
     /* @} */
+    /**
+     * Sum count values. The result is the same as adding them one after the
+     * other, but values which all have the same denominator, as amounts in
+     * one commodity do, are summed in a single pass without any conversions.
+     *
+     * @param values The values to sum.
+     * @param count The number of values.
+     * @return The sum, zero if count is 0.
+     * @exception std::overflow_error if the sum overflows 128 bits.
+     */
+    static GncNumeric sum(const GncNumeric* values, size_t count);
     /** Compare function
      *  \defgroup gnc_numeric_comparison
      *  @param b GncNumeric or int to compare to.
@@ -58,6 +58,11 @@ struct gnc_price_db_s
     GHashTable *commodity_hash;
     gboolean bulk_update;		 /* TRUE while reading XML file, etc. */
     gboolean reset_nth_price_cache;
+    guint64 generation;          /* bumped on every price change */
+    GHashTable *commodity_generations; /* commodity -> bumps of the prices
+                                        * it's part of */
+    GHashTable *conversion_cache; /* prices found for conversions, see
+                                   * gnc_pricedb_convert_balance_nearest_price_t64 */
 };
 
 struct _GncPriceDBClass
@@ -37,12 +37,13 @@ static QofLogModule log_module = GNC_MOD_PRICE;
 
 static gboolean add_price(GNCPriceDB *db, GNCPrice *p);
 static gboolean remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup);
+static void pricedb_changed (GNCPriceDB *db, const GNCPrice *p);
 static GNCPrice *lookup_nearest_in_time(GNCPriceDB *db, const gnc_commodity *c,
                                         const gnc_commodity *currency,
                                         time64 t, gboolean sameday);
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                            gboolean (*f)(GList *p, gpointer user_data),
+                            gboolean (*f)(GPtrArray *p, gpointer user_data),
                             gpointer user_data);
 
 enum
@@ -460,6 +461,7 @@ gnc_pricedb_commit_edit (GNCPriceDB *pdb)
 static void
 gnc_price_set_dirty (GNCPrice *p)
 {
+    if (p->db) pricedb_changed (p->db, p);
     qof_instance_set_dirty(&p->inst);
     qof_event_gen(&p->inst, QOF_EVENT_MODIFY, NULL);
 }
@@ -822,15 +824,155 @@ gnc_price_list_equal(PriceList *prices1, PriceList *prices2)
     return TRUE;
 }
 
+/* ==================================================================== */
+/* price series
+
+   The prices of each commodity/currency pair are kept in a GPtrArray
+   in the order of a price list, newest first, so that the prices
+   around a given time are found with a binary search and the prices
+   of a period are a contiguous range.  The series holds a reference
+   on each of its prices.
+ */
+
+/* Return the position of the newest price in series that is earlier
+ * than t, or not later than t if inclusive; series->len if there is
+ * none.
+ */
+static guint
+price_series_search (const GPtrArray *series, time64 t, gboolean inclusive)
+{
+    guint lo = 0, hi = series->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        time64 price_t = gnc_price_get_time64 (g_ptr_array_index (series, mid));
+        if (price_t < t || (inclusive && price_t == t))
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+/* Return the position at which p belongs in series. */
+static guint
+price_series_position (const GPtrArray *series, const GNCPrice *p)
+{
+    guint lo = 0, hi = series->len;
+
+    while (lo < hi)
+    {
+        guint mid = lo + (hi - lo) / 2;
+        if (compare_prices_by_date (p, g_ptr_array_index (series, mid)) <= 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+static inline GNCPrice *
+price_series_nth (const GPtrArray *series, guint n)
+{
+    return series && n < series->len ? g_ptr_array_index (series, n) : NULL;
+}
+
+/* Prices on the same day are adjacent, so only the neighbours of pos
+ * need to be checked for one with the same value as p. */
+static gboolean
+price_series_has_duplicate (const GPtrArray *series, guint pos,
+                            const GNCPrice *p)
+{
+    time64 day = time64CanonicalDayTime (gnc_price_get_time64 (p));
+    guint i;
+
+    for (i = pos; i < series->len; ++i)
+    {
+        GNCPrice *other = g_ptr_array_index (series, i);
+        if (time64CanonicalDayTime (gnc_price_get_time64 (other)) != day)
+            break;
+        if (gnc_numeric_equal (gnc_price_get_value (other),
+                               gnc_price_get_value (p)))
+            return TRUE;
+    }
+    for (i = pos; i > 0; --i)
+    {
+        GNCPrice *other = g_ptr_array_index (series, i - 1);
+        if (time64CanonicalDayTime (gnc_price_get_time64 (other)) != day)
+            break;
+        if (gnc_numeric_equal (gnc_price_get_value (other),
+                               gnc_price_get_value (p)))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/* Like gnc_price_list_insert(), for a series. */
+static void
+price_series_insert (GPtrArray *series, GNCPrice *p, gboolean check_dupl)
+{
+    guint pos = price_series_position (series, p);
+
+    gnc_price_ref (p);
+    if (check_dupl && price_series_has_duplicate (series, pos, p))
+        return;
+    g_ptr_array_insert (series, pos, p);
+}
+
+/* Like gnc_price_list_remove(), for a series. */
+static void
+price_series_remove (GPtrArray *series, GNCPrice *p)
+{
+    guint pos = price_series_position (series, p);
+
+    if (pos < series->len && g_ptr_array_index (series, pos) == p)
+        g_ptr_array_remove_index (series, pos);
+    else if (!g_ptr_array_remove (series, p))
+        return;
+    gnc_price_unref (p);
+}
+
+/* Return a price list of the prices in series, without references. */
+static PriceList *
+price_series_to_list (const GPtrArray *series)
+{
+    GList *result = NULL;
+    guint i;
+
+    for (i = series->len; i > 0; --i)
+        result = g_list_prepend (result, g_ptr_array_index (series, i - 1));
+    return result;
+}
+
+/* Of two prices, return the one that comes first in a price list, or
+ * the other one if either is NULL. */
+static GNCPrice *
+price_newer (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) <= 0 ? a : b;
+}
+
+/* Of two prices, return the one that comes last in a price list, or
+ * the other one if either is NULL. */
+static GNCPrice *
+price_older (GNCPrice *a, GNCPrice *b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return compare_prices_by_date (a, b) <= 0 ? b : a;
+}
+
 /* ==================================================================== */
 /* GNCPriceDB functions
 
    Structurally a GNCPriceDB contains a hash mapping price commodities
    (of type gnc_commodity*) to hashes mapping price currencies (of
-   type gnc_commodity*) to GNCPrice lists (see gnc-pricedb.h for a
-   description of GNCPrice lists).  The top-level key is the commodity
-   you want the prices for, and the second level key is the commodity
-   that the value is expressed in terms of.
+   type gnc_commodity*) to GNCPrice series, see above.  The top-level
+   key is the commodity you want the prices for, and the second level
+   key is the commodity that the value is expressed in terms of.
  */
 
 /* GObject Initialization */
@@ -890,18 +1032,18 @@ destroy_pricedb_currency_hash_data(gpointer key,
                                    gpointer data,
                                    gpointer user_data)
 {
-    GList *price_list = (GList *) data;
-    GList *node;
-    GNCPrice *p;
+    GPtrArray *series = (GPtrArray *) data;
+    guint i;
 
-    for (node = price_list; node; node = node->next)
+    for (i = 0; i < series->len; ++i)
     {
-        p = node->data;
+        GNCPrice *p = g_ptr_array_index (series, i);
 
         p->db = NULL;
+        gnc_price_unref (p);
     }
 
-    gnc_price_list_destroy(price_list);
+    g_ptr_array_free (series, TRUE);
 }
 
 static void
@@ -929,6 +1071,14 @@ gnc_pricedb_destroy(GNCPriceDB *db)
     }
     g_hash_table_destroy (db->commodity_hash);
     db->commodity_hash = NULL;
+    /* The prices are out of the database now, so the cache can drop
+     * their last references without complaint. */
+    if (db->conversion_cache)
+        g_hash_table_destroy (db->conversion_cache);
+    db->conversion_cache = NULL;
+    if (db->commodity_generations)
+        g_hash_table_destroy (db->commodity_generations);
+    db->commodity_generations = NULL;
     /* qof_instance_release (&db->inst); */
     g_object_unref(db);
 }
@@ -997,6 +1147,26 @@ gnc_pricedb_get_num_prices(GNCPriceDB *db)
     return count;
 }
 
+guint64
+gnc_pricedb_get_generation(const GNCPriceDB *db)
+{
+    g_return_val_if_fail(db, 0);
+    return db->generation;
+}
+
+guint64
+gnc_pricedb_get_commodity_generation(const GNCPriceDB *db,
+                                     const gnc_commodity *c)
+{
+    guint64 *generation;
+
+    g_return_val_if_fail(db, 0);
+    if (!db->commodity_generations)
+        return 0;
+    generation = g_hash_table_lookup (db->commodity_generations, c);
+    return generation ? *generation : 0;
+}
+
 /* ==================================================================== */
 
 typedef struct
@@ -1011,7 +1181,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
     GNCPriceDBEqualData *equal_data = user_data;
     gnc_commodity *currency = key;
-    GList *price_list1 = val;
+    GList *price_list1 = price_series_to_list (val);
     GList *price_list2;
 
     price_list2 = gnc_pricedb_get_prices (equal_data->db2,
@@ -1021,6 +1191,7 @@ pricedb_equal_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
     if (!gnc_price_list_equal (price_list1, price_list2))
         equal_data->equal = FALSE;
 
+    g_list_free (price_list1);
     gnc_price_list_destroy (price_list2);
 }
 
@@ -1070,7 +1241,7 @@ add_price(GNCPriceDB *db, GNCPrice *p)
 {
     /* This function will use p, adding a ref, so treat p as read-only
        if this function succeeds. */
-    GList *price_list;
+    GPtrArray *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1131,21 +1302,15 @@ add_price(GNCPriceDB *db, GNCPrice *p)
         g_hash_table_insert(db->commodity_hash, commodity, currency_hash);
     }
 
-    price_list = g_hash_table_lookup(currency_hash, currency);
-    if (!gnc_price_list_insert(&price_list, p, !db->bulk_update))
-    {
-        LEAVE ("gnc_price_list_insert failed");
-        return FALSE;
-    }
-
-    if (!price_list)
+    series = g_hash_table_lookup(currency_hash, currency);
+    if (!series)
     {
-        LEAVE (" no price list");
-        return FALSE;
+        series = g_ptr_array_new ();
+        g_hash_table_insert(currency_hash, currency, series);
     }
-
-    g_hash_table_insert(currency_hash, currency, price_list);
+    price_series_insert (series, p, !db->bulk_update);
     p->db = db;
+    pricedb_changed (db, p);
 
     qof_event_gen (&p->inst, QOF_EVENT_ADD, NULL);
 
@@ -1195,7 +1360,7 @@ gnc_pricedb_add_price(GNCPriceDB *db, GNCPrice *p)
 static gboolean
 remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
 {
-    GList *price_list;
+    GPtrArray *series;
     gnc_commodity *commodity;
     gnc_commodity *currency;
     GHashTable *currency_hash;
@@ -1231,24 +1396,19 @@ remove_price(GNCPriceDB *db, GNCPrice *p, gboolean cleanup)
     }
 
     qof_event_gen (&p->inst, QOF_EVENT_REMOVE, NULL);
-    price_list = g_hash_table_lookup(currency_hash, currency);
+    pricedb_changed (db, p);
+    series = g_hash_table_lookup(currency_hash, currency);
     gnc_price_ref(p);
-    if (!gnc_price_list_remove(&price_list, p))
-    {
-        gnc_price_unref(p);
-        LEAVE (" cannot remove price list");
-        return FALSE;
-    }
+    if (series)
+        price_series_remove (series, p);
 
-    /* if the price list is empty, then remove this currency from the
+    /* if the price series is empty, then remove this currency from the
        commodity hash */
-    if (price_list)
-    {
-        g_hash_table_insert(currency_hash, currency, price_list);
-    }
-    else
+    if (!series || series->len == 0)
     {
         g_hash_table_remove(currency_hash, currency);
+        if (series)
+            g_ptr_array_free (series, TRUE);
 
         if (cleanup)
         {
@@ -1356,14 +1516,13 @@ pricedb_remove_foreach_pricelist (gpointer key,
                                   gpointer val,
                                   gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
     remove_info *data = (remove_info *) user_data;
 
     ENTER("key %p, value %p, data %p", key, val, user_data);
 
-    /* now check each item in the list */
-    g_list_foreach(node, (GFunc)check_one_price_date, data);
+    /* now check each item in the series */
+    g_ptr_array_foreach(series, (GFunc)check_one_price_date, data);
 
     LEAVE(" ");
 }
@@ -1673,30 +1832,33 @@ static void
 hash_values_helper(gpointer key, gpointer value, gpointer data)
 {
     GList ** l = data;
+    GList *price_list = price_series_to_list (value);
     if (*l)
     {
         GList *new_l;
-        new_l = pricedb_price_list_merge(*l, value);
+        new_l = pricedb_price_list_merge(*l, price_list);
         g_list_free (*l);
+        g_list_free (price_list);
         *l = new_l;
     }
     else
-        *l = g_list_copy (value);
+        *l = price_list;
 }
 
 static PriceList *
 price_list_from_hashtable (GHashTable *hash, const gnc_commodity *currency)
 {
-    GList *price_list = NULL, *result = NULL ;
+    GPtrArray *series = NULL;
+    GList *result = NULL;
     if (currency)
     {
-        price_list = g_hash_table_lookup(hash, currency);
-        if (!price_list)
+        series = g_hash_table_lookup(hash, currency);
+        if (!series)
         {
             LEAVE (" no price list");
             return NULL;
         }
-        result = g_list_copy (price_list);
+        result = price_series_to_list (series);
     }
     else
     {
@@ -1785,24 +1947,89 @@ pricedb_get_prices_internal(GNCPriceDB *db, const gnc_commodity *commodity,
     return forward_list;
 }
 
+static GPtrArray *
+pricedb_get_series (GNCPriceDB *db, const gnc_commodity *commodity,
+                    const gnc_commodity *currency)
+{
+    GHashTable *currency_hash;
+
+    if (!db->commodity_hash) return NULL;
+    currency_hash = g_hash_table_lookup (db->commodity_hash, commodity);
+    return currency_hash ? g_hash_table_lookup (currency_hash, currency) : NULL;
+}
+
+/* The prices of a commodity in terms of a currency, and those of the
+ * currency in terms of the commodity.  The lookups below search both
+ * series and pick what a walk over their merge, as returned by
+ * pricedb_get_prices_internal(), would have found.
+ */
+typedef struct
+{
+    GPtrArray *forward;
+    GPtrArray *reverse;
+} PricePairSeries;
+
+static gboolean
+pricedb_get_pair_series (GNCPriceDB *db, const gnc_commodity *commodity,
+                         const gnc_commodity *currency, PricePairSeries *pair)
+{
+    pair->forward = pricedb_get_series (db, commodity, currency);
+    pair->reverse = pricedb_get_series (db, currency, commodity);
+    return pair->forward || pair->reverse;
+}
+
+/* Return the newest price of the pair that is earlier than t, or not
+ * later than t if inclusive. */
+static GNCPrice *
+price_pair_newest_before (const PricePairSeries *pair, time64 t,
+                          gboolean inclusive)
+{
+    GNCPrice *forward = NULL, *reverse = NULL;
+
+    if (pair->forward)
+        forward = price_series_nth (pair->forward,
+                                    price_series_search (pair->forward, t,
+                                                         inclusive));
+    if (pair->reverse)
+        reverse = price_series_nth (pair->reverse,
+                                    price_series_search (pair->reverse, t,
+                                                         inclusive));
+    return price_newer (forward, reverse);
+}
+
+/* Return the oldest price of the pair that is later than t. */
+static GNCPrice *
+price_pair_oldest_after (const PricePairSeries *pair, time64 t)
+{
+    GNCPrice *forward = NULL, *reverse = NULL;
+    guint pos;
+
+    if (pair->forward &&
+        (pos = price_series_search (pair->forward, t, TRUE)) > 0)
+        forward = price_series_nth (pair->forward, pos - 1);
+    if (pair->reverse &&
+        (pos = price_series_search (pair->reverse, t, TRUE)) > 0)
+        reverse = price_series_nth (pair->reverse, pos - 1);
+    return price_older (forward, reverse);
+}
+
 GNCPrice *gnc_pricedb_lookup_latest(GNCPriceDB *db,
                           const gnc_commodity *commodity,
                           const gnc_commodity *currency)
 {
-    GList *price_list;
+    PricePairSeries pair;
     GNCPrice *result;
 
     if (!db || !commodity || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, commodity, currency);
 
-    price_list = pricedb_get_prices_internal(db, commodity, currency, TRUE);
-    if (!price_list) return NULL;
-    /* This works magically because prices are inserted in date-sorted
-     * order, and the latest date always comes first. So return the
-     * first in the list.  */
-    result = price_list->data;
+    if (!pricedb_get_pair_series (db, commodity, currency, &pair))
+        return NULL;
+    /* The series are sorted newest first, so the latest price is the
+     * first of one of them. */
+    result = price_newer (price_series_nth (pair.forward, 0),
+                          price_series_nth (pair.reverse, 0));
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE("price is %p", result);
     return result;
 }
@@ -1825,54 +2052,49 @@ typedef struct
 */
 
 static gboolean
-price_list_scan_any_currency(GList *price_list, gpointer data)
+price_list_scan_any_currency(GPtrArray *series, gpointer data)
 {
     UsesCommodity *helper = (UsesCommodity*)data;
-    GList *node = price_list;
+    GNCPrice *price;
     gnc_commodity *com;
     gnc_commodity *cur;
+    guint pos;
 
-    if (!price_list)
+    if (!series || series->len == 0)
         return TRUE;
 
-    com = gnc_price_get_commodity(node->data);
-    cur = gnc_price_get_currency(node->data);
+    price = g_ptr_array_index(series, 0);
+    com = gnc_price_get_commodity(price);
+    cur = gnc_price_get_currency(price);
 
-    /* if this price list isn't for the commodity we are interested in,
+    /* if this price series isn't for the commodity we are interested in,
        ignore it. */
     if (com != helper->com && cur != helper->com)
         return TRUE;
 
-    /* The price list is sorted in decreasing order of time.  Find the first
-       price on it that is older than the requested time and add it and the
-       previous price to the result list. */
-    while (node != NULL)
+    /* The price series is sorted in decreasing order of time.  Find the
+       first price in it that is older than the requested time and add it
+       and the previous price to the result list. */
+    pos = price_series_search(series, helper->t, FALSE);
+    if (pos < series->len)
     {
-        GNCPrice *price = node->data;
-        time64 price_t = gnc_price_get_time64(price);
-        if (price_t < helper->t)
+        /* If there is a previous price add it to the results. */
+        if (pos > 0)
         {
-            /* If there is a previous price add it to the results. */
-            if (node->prev)
-            {
-                GNCPrice *prev_price = node->prev->data;
-                gnc_price_ref(prev_price);
-                *helper->list = g_list_prepend(*helper->list, prev_price);
-            }
-            /* Add the first price before the desired time */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
-            /* No point in looking further, they will all be older */
-            break;
-        }
-        else if (node->next == NULL)
-        {
-            /* The last price is later than given time, add it */
-            gnc_price_ref(price);
-            *helper->list = g_list_prepend(*helper->list, price);
+            GNCPrice *prev_price = g_ptr_array_index(series, pos - 1);
+            gnc_price_ref(prev_price);
+            *helper->list = g_list_prepend(*helper->list, prev_price);
         }
-        node = node->next;
+        /* Add the first price before the desired time */
+        price = g_ptr_array_index(series, pos);
     }
+    else
+    {
+        /* The last price is later than given time, add it */
+        price = g_ptr_array_index(series, series->len - 1);
+    }
+    gnc_price_ref(price);
+    *helper->list = g_list_prepend(*helper->list, price);
 
     return TRUE;
 }
@@ -2077,7 +2299,7 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
                        const gnc_commodity *commodity,
                        const gnc_commodity *currency)
 {
-    GList *price_list;
+    GPtrArray *series;
     GHashTable *currency_hash;
     gint size;
 
@@ -2092,8 +2314,8 @@ gnc_pricedb_has_prices(GNCPriceDB *db,
 
     if (currency)
     {
-        price_list = g_hash_table_lookup(currency_hash, currency);
-        if (price_list)
+        series = g_hash_table_lookup(currency_hash, currency);
+        if (series)
         {
             LEAVE("yes");
             return TRUE;
@@ -2137,9 +2359,9 @@ static void
 price_count_helper(gpointer key, gpointer value, gpointer data)
 {
     int *result = data;
-    GList *price_list = value;
+    GPtrArray *series = value;
 
-    *result += g_list_length(price_list);
+    *result += series->len;
 }
 
 int
@@ -2167,11 +2389,12 @@ static void
 list_combine (gpointer element, gpointer data)
 {
     GList *list = *(GList**)data;
+    GList *price_list = price_series_to_list (element);
     if (list == NULL)
-        *(GList**)data = g_list_copy (element);
+        *(GList**)data = price_list;
     else
     {
-        GList *new_list = g_list_concat ((GList *)list, g_list_copy (element));
+        GList *new_list = g_list_concat ((GList *)list, price_list);
         *(GList**)data = new_list;
     }
 }
@@ -2255,27 +2478,23 @@ gnc_pricedb_lookup_at_time64(GNCPriceDB *db,
                              const gnc_commodity *currency,
                              time64 t)
 {
-    GList *price_list;
-    GList *item = NULL;
+    PricePairSeries pair;
+    GNCPrice *p;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    item = price_list;
-    while (item)
+    if (!pricedb_get_pair_series (db, c, currency, &pair))
     {
-        GNCPrice *p = item->data;
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time == t)
-        {
-            gnc_price_ref(p);
-            g_list_free (price_list);
-            LEAVE("price is %p", p);
-            return p;
-        }
-        item = item->next;
+        LEAVE (" ");
+        return NULL;
+    }
+    p = price_pair_newest_before (&pair, t, TRUE);
+    if (p && gnc_price_get_time64(p) == t)
+    {
+        gnc_price_ref(p);
+        LEAVE("price is %p", p);
+        return p;
     }
-    g_list_free (price_list);
     LEAVE (" ");
     return NULL;
 }
@@ -2287,36 +2506,25 @@ lookup_nearest_in_time(GNCPriceDB *db,
                        time64 t,
                        gboolean sameday)
 {
-    GList *price_list;
+    PricePairSeries pair;
     GNCPrice *current_price = NULL;
     GNCPrice *next_price = NULL;
     GNCPrice *result = NULL;
-    GList *item = NULL;
 
     if (!db || !c || !currency) return NULL;
     if (t == INT64_MAX) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-
-    /* default answer */
-    current_price = item->data;
-
-    /* find the first candidate past the one we want.  Remember that
-       prices are in most-recent-first order. */
-    while (!next_price && item)
-    {
-        GNCPrice *p = item->data;
-        time64 price_time = gnc_price_get_time64(p);
-        if (price_time <= t)
-        {
-            next_price = item->data;
-            break;
-        }
-        current_price = item->data;
-        item = item->next;
-    }
+    if (!pricedb_get_pair_series (db, c, currency, &pair)) return NULL;
+
+    /* next_price is the newest price not later than t and current_price
+       the oldest one later than t.  Remember that prices are in
+       most-recent-first order: if every price is later than t,
+       current_price is the oldest of all, and if none is, it is the same
+       as next_price. */
+    next_price = price_pair_newest_before (&pair, t, TRUE);
+    current_price = price_pair_oldest_after (&pair, t);
+    if (!current_price)
+        current_price = next_price;
 
     if (current_price)      /* How can this be null??? */
     {
@@ -2388,7 +2596,6 @@ lookup_nearest_in_time(GNCPriceDB *db,
     }
 
     gnc_price_ref(result);
-    g_list_free (price_list);
     LEAVE (" ");
     return result;
 }
@@ -2409,34 +2616,173 @@ gnc_pricedb_lookup_latest_before_t64 (GNCPriceDB *db,
                                       gnc_commodity *currency,
                                       time64 t)
 {
-    GList *price_list;
+    PricePairSeries pair;
     GNCPrice *current_price = NULL;
-    /*  GNCPrice *next_price = NULL;
-        GNCPrice *result = NULL;*/
-    GList *item = NULL;
-    time64 price_time;
 
     if (!db || !c || !currency) return NULL;
     ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
-    price_list = pricedb_get_prices_internal (db, c, currency, TRUE);
-    if (!price_list) return NULL;
-    item = price_list;
-    do
-    {
-        price_time = gnc_price_get_time64 (item->data);
-        if (price_time <= t)
-            current_price = item->data;
-        item = item->next;
-    }
-    while (price_time > t && item);
+    if (!pricedb_get_pair_series (db, c, currency, &pair)) return NULL;
+    current_price = price_pair_newest_before (&pair, t, TRUE);
     gnc_price_ref(current_price);
-    g_list_free (price_list);
     LEAVE (" ");
     return current_price;
 }
 
+gboolean
+gnc_pricedb_get_price_range (GNCPriceDB *db,
+                             const gnc_commodity *c,
+                             const gnc_commodity *currency,
+                             time64 start, time64 end,
+                             GNCPriceRange *range)
+{
+    GPtrArray *series;
+    guint first, last;
+
+    g_return_val_if_fail (range != NULL, FALSE);
+    range->prices = NULL;
+    range->count = 0;
+    if (!db || !c || !currency || start > end) return FALSE;
+    ENTER ("db=%p commodity=%p currency=%p", db, c, currency);
+    series = pricedb_get_series (db, c, currency);
+    if (!series)
+    {
+        LEAVE ("no prices");
+        return FALSE;
+    }
+    first = price_series_search (series, end, TRUE);
+    last = price_series_search (series, start, FALSE);
+    if (first < last)
+    {
+        range->prices = (GNCPrice * const *) series->pdata + first;
+        range->count = last - first;
+    }
+    LEAVE ("%u prices", range->count);
+    return range->count > 0;
+}
+
+typedef struct
+{
+    GNCPrice *from;
+    GNCPrice *to;
+} PriceTuple;
+
+/* ==================================================================== */
+/* Conversion cache
+
+   Converting a balance takes a direct price between the two commodities
+   or, failing that, two prices through a third commodity.  Finding the
+   latter means collecting the prices of both commodities against all
+   others and intersecting them, and reports convert many balances
+   between the same commodities at the same date.  So the prices found
+   are remembered per (from, to, time), INT64_MAX standing for the
+   latest prices, until the next change of the database.  The cache holds
+   a reference on each price in it.
+ */
+
+/* Start over rather than grow without bound. */
+#define CONVERSION_CACHE_MAX 65536
+
+typedef struct
+{
+    const gnc_commodity *from;
+    const gnc_commodity *to;
+    time64 t;
+} PriceConversionKey;
+
+typedef struct
+{
+    gboolean have_direct;
+    GNCPrice *direct;
+    gboolean have_cross;
+    PriceTuple cross;
+} PriceConversion;
+
+static guint
+conversion_key_hash (gconstpointer key)
+{
+    const PriceConversionKey *k = key;
+    return g_direct_hash (k->from) * 31 + g_direct_hash (k->to) +
+        (guint) (k->t ^ (k->t >> 32));
+}
+
+static gboolean
+conversion_key_equal (gconstpointer a, gconstpointer b)
+{
+    const PriceConversionKey *ka = a, *kb = b;
+    return ka->from == kb->from && ka->to == kb->to && ka->t == kb->t;
+}
+
+static void
+conversion_free (gpointer data)
+{
+    PriceConversion *conv = data;
+    gnc_price_unref (conv->direct);
+    gnc_price_unref (conv->cross.from);
+    gnc_price_unref (conv->cross.to);
+    g_free (conv);
+}
+
+static void
+bump_commodity_generation (GNCPriceDB *db, const gnc_commodity *c)
+{
+    guint64 *generation;
+
+    if (!c)
+        return;
+    if (!db->commodity_generations)
+        db->commodity_generations = g_hash_table_new_full (g_direct_hash,
+                                                           g_direct_equal,
+                                                           NULL, g_free);
+    generation = g_hash_table_lookup (db->commodity_generations, c);
+    if (!generation)
+    {
+        generation = g_new0 (guint64, 1);
+        g_hash_table_insert (db->commodity_generations, (gpointer)c,
+                             generation);
+    }
+    (*generation)++;
+}
+
+/* Called whenever price p is added, removed or modified. */
+static void
+pricedb_changed (GNCPriceDB *db, const GNCPrice *p)
+{
+    db->generation++;
+    bump_commodity_generation (db, p->commodity);
+    bump_commodity_generation (db, p->currency);
+    if (db->conversion_cache)
+        g_hash_table_remove_all (db->conversion_cache);
+}
+
+static PriceConversion *
+pricedb_get_conversion (GNCPriceDB *db, const gnc_commodity *from,
+                        const gnc_commodity *to, time64 t)
+{
+    PriceConversionKey key = {from, to, t};
+    PriceConversionKey *new_key;
+    PriceConversion *conv;
+
+    if (!db->conversion_cache)
+        db->conversion_cache = g_hash_table_new_full (conversion_key_hash,
+                                                      conversion_key_equal,
+                                                      g_free,
+                                                      conversion_free);
+    conv = g_hash_table_lookup (db->conversion_cache, &key);
+    if (conv)
+        return conv;
+
+    if (g_hash_table_size (db->conversion_cache) >= CONVERSION_CACHE_MAX)
+        g_hash_table_remove_all (db->conversion_cache);
+    new_key = g_new (PriceConversionKey, 1);
+    *new_key = key;
+    conv = g_new0 (PriceConversion, 1);
+    g_hash_table_insert (db->conversion_cache, new_key, conv);
+    return conv;
+}
+
 static gnc_numeric
-direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
+direct_balance_conversion (GNCPriceDB *db, PriceConversion *conv,
+                           gnc_numeric bal,
                            const gnc_commodity *from, const gnc_commodity *to,
                            time64 t)
 {
@@ -2446,10 +2792,15 @@ direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
         return retval;
     if (gnc_numeric_zero_p(bal))
         return retval;
-    if (t != INT64_MAX)
-        price = gnc_pricedb_lookup_nearest_in_time64(db, from, to, t);
-    else
-        price = gnc_pricedb_lookup_latest(db, from, to);
+    if (!conv->have_direct)
+    {
+        if (t != INT64_MAX)
+            conv->direct = gnc_pricedb_lookup_nearest_in_time64(db, from, to, t);
+        else
+            conv->direct = gnc_pricedb_lookup_latest(db, from, to);
+        conv->have_direct = TRUE;
+    }
+    price = conv->direct;
     if (price == NULL)
         return retval;
     if (gnc_price_get_commodity(price) == from)
@@ -2460,17 +2811,10 @@ direct_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
         retval = gnc_numeric_div (bal, gnc_price_get_value (price),
                                   gnc_commodity_get_fraction (to),
                                   GNC_HOW_RND_ROUND);
-    gnc_price_unref (price);
     return retval;
 
 }
 
-typedef struct
-{
-    GNCPrice *from;
-    GNCPrice *to;
-} PriceTuple;
-
 static PriceTuple
 extract_common_prices (PriceList *from_prices, PriceList *to_prices,
                        const gnc_commodity *from, const gnc_commodity *to)
@@ -2544,17 +2888,21 @@ convert_balance(gnc_numeric bal, const gnc_commodity *from,
 
 }
 static gnc_numeric
-indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
+indirect_balance_conversion (GNCPriceDB *db, PriceConversion *conv,
+                             gnc_numeric bal,
                              const gnc_commodity *from, const gnc_commodity *to,
                              time64 t )
 {
     GList *from_prices = NULL, *to_prices = NULL;
-    PriceTuple tuple;
     gnc_numeric zero = gnc_numeric_zero();
     if (from == NULL || to == NULL)
         return zero;
     if (gnc_numeric_zero_p(bal))
         return zero;
+    if (conv->have_cross)
+        return conv->cross.from ? convert_balance(bal, from, to, conv->cross) :
+            zero;
+    conv->have_cross = TRUE;
     if (t == INT64_MAX)
     {
         from_prices = gnc_pricedb_lookup_latest_any_currency(db, from);
@@ -2572,12 +2920,15 @@ indirect_balance_conversion (GNCPriceDB *db, gnc_numeric bal,
                                                                     to, t);
     }
     if (from_prices == NULL || to_prices == NULL)
+    {
+        gnc_price_list_destroy(from_prices);
         return zero;
-    tuple = extract_common_prices(from_prices, to_prices, from, to);
+    }
+    conv->cross = extract_common_prices(from_prices, to_prices, from, to);
     gnc_price_list_destroy(from_prices);
     gnc_price_list_destroy(to_prices);
-    if (tuple.from)
-        return convert_balance(bal, from, to, tuple);
+    if (conv->cross.from)
+        return convert_balance(bal, from, to, conv->cross);
     return zero;
 }
 
@@ -2591,24 +2942,10 @@ gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
         const gnc_commodity *balance_currency,
         const gnc_commodity *new_currency)
 {
-    gnc_numeric new_value;
-
-    if (gnc_numeric_zero_p (balance) ||
-            gnc_commodity_equiv (balance_currency, new_currency))
-        return balance;
-
-    /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
-                                          new_currency, INT64_MAX);
-    if (!gnc_numeric_zero_p(new_value))
-        return new_value;
-
-    /*
-     * no direct price found, try if we find a price in another currency
-     * and convert in two stages
-     */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
-                                       new_currency, INT64_MAX);
+    return gnc_pricedb_convert_balance_nearest_price_t64 (pdb, balance,
+                                                          balance_currency,
+                                                          new_currency,
+                                                          INT64_MAX);
 }
 
 gnc_numeric
@@ -2619,13 +2956,18 @@ gnc_pricedb_convert_balance_nearest_price_t64(GNCPriceDB *pdb,
                                               time64 t)
 {
     gnc_numeric new_value;
+    PriceConversion *conv;
 
     if (gnc_numeric_zero_p (balance) ||
         gnc_commodity_equiv (balance_currency, new_currency))
         return balance;
+    if (!pdb || !balance_currency || !new_currency)
+        return gnc_numeric_zero ();
+
+    conv = pricedb_get_conversion (pdb, balance_currency, new_currency, t);
 
     /* Look for a direct price. */
-    new_value = direct_balance_conversion(pdb, balance, balance_currency,
+    new_value = direct_balance_conversion(pdb, conv, balance, balance_currency,
                                           new_currency, t);
     if (!gnc_numeric_zero_p(new_value))
         return new_value;
@@ -2634,7 +2976,7 @@ gnc_pricedb_convert_balance_nearest_price_t64(GNCPriceDB *pdb,
      * no direct price found, try if we find a price in another currency
      * and convert in two stages
      */
-    return indirect_balance_conversion(pdb, balance, balance_currency,
+    return indirect_balance_conversion(pdb, conv, balance, balance_currency,
                                        new_currency, t);
 }
 
@@ -2653,16 +2995,15 @@ typedef struct
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
     GNCPriceDBForeachData *foreach_data = (GNCPriceDBForeachData *) user_data;
+    guint i;
 
     /* stop traversal when func returns FALSE */
-    while (foreach_data->ok && node)
+    for (i = 0; foreach_data->ok && i < series->len; ++i)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index (series, i);
         foreach_data->ok = foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
@@ -2699,18 +3040,18 @@ unstable_price_traversal(GNCPriceDB *db,
 typedef struct
 {
     gboolean ok;
-    gboolean (*func)(GList *p, gpointer user_data);
+    gboolean (*func)(GPtrArray *p, gpointer user_data);
     gpointer user_data;
 } GNCPriceListForeachData;
 
 static void
 pricedb_pricelist_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
+    GPtrArray *series = (GPtrArray *) val;
     GNCPriceListForeachData *foreach_data = (GNCPriceListForeachData *) user_data;
     if (foreach_data->ok)
     {
-        foreach_data->ok = foreach_data->func(price_list, foreach_data->user_data);
+        foreach_data->ok = foreach_data->func(series, foreach_data->user_data);
     }
 }
 
@@ -2723,7 +3064,7 @@ pricedb_pricelist_foreach_currencies_hash(gpointer key, gpointer val, gpointer u
 
 static gboolean
 pricedb_pricelist_traversal(GNCPriceDB *db,
-                         gboolean (*f)(GList *p, gpointer user_data),
+                         gboolean (*f)(GPtrArray *p, gpointer user_data),
                          gpointer user_data)
 {
     GNCPriceListForeachData foreach_data;
@@ -2795,12 +3136,12 @@ stable_price_traversal(GNCPriceDB *db,
         for (j = price_lists; j; j = j->next)
         {
             HashEntry *pricelist_entry = (HashEntry *) j->data;
-            GList *price_list = (GList *) pricelist_entry->value;
-            GList *node;
+            GPtrArray *series = (GPtrArray *) pricelist_entry->value;
+            guint k;
 
-            for (node = (GList *) price_list; node; node = node->next)
+            for (k = 0; k < series->len; ++k)
             {
-                GNCPrice *price = (GNCPrice *) node->data;
+                GNCPrice *price = (GNCPrice *) g_ptr_array_index (series, k);
 
                 /* stop traversal when f returns FALSE */
                 if (FALSE == ok) break;
@@ -3020,15 +3361,14 @@ VoidGNCPriceDBForeachData;
 static void
 void_pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)
 {
-    GList *price_list = (GList *) val;
-    GList *node = price_list;
+    GPtrArray *series = (GPtrArray *) val;
     VoidGNCPriceDBForeachData *foreach_data = (VoidGNCPriceDBForeachData *) user_data;
+    guint i;
 
-    while (node)
+    for (i = 0; i < series->len; ++i)
     {
-        GNCPrice *p = (GNCPrice *) node->data;
+        GNCPrice *p = (GNCPrice *) g_ptr_array_index (series, i);
         foreach_data->func(p, foreach_data->user_data);
-        node = node->next;
     }
 }
 
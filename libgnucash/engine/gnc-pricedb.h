@@ -558,6 +558,40 @@ PriceList * gnc_pricedb_lookup_latest_before_any_currency_t64(GNCPriceDB *db,
                                                          const gnc_commodity *c,
                                                               time64 t);
 
+/** A view of consecutive prices of one commodity in one currency, newest
+ * first, straight from the price database's storage.
+ *
+ * The view holds no references on the prices and is only valid until the
+ * next change of the database; compare gnc_pricedb_get_generation() to
+ * tell.
+ */
+typedef struct
+{
+    GNCPrice * const *prices;
+    guint count;
+} GNCPriceRange;
+
+/** @brief Find the prices of a commodity in a currency in a period
+ * without copying them.
+ *
+ * Unlike the lookup functions this only returns prices of c expressed in
+ * currency, not those in the other direction.  Finding the range takes
+ * O(log n) in the number of prices of the pair.
+ * @param db The pricedb
+ * @param c The commodity
+ * @param currency The currency the prices are expressed in
+ * @param start The time of the oldest price to include
+ * @param end The time of the newest price to include
+ * @param range Set to the prices with times from start to end inclusive,
+ * or to an empty range if there are none.
+ * @return TRUE if the range isn't empty.
+ */
+gboolean gnc_pricedb_get_price_range (GNCPriceDB *db,
+                                      const gnc_commodity *c,
+                                      const gnc_commodity *currency,
+                                      time64 start, time64 end,
+                                      GNCPriceRange *range);
+
 
 /** @brief Convert a balance from one currency to another using the most recent
  * price between the two.
@@ -583,6 +617,12 @@ gnc_pricedb_convert_balance_latest_price(GNCPriceDB *pdb,
  * @param new_currency The commodity to which the balance should be converted
  * @param t The time nearest to which price should be used.
  * @return A new balance or gnc_numeric_zero if no price is available.
+ *
+ * If there is no direct price between the two commodities, the balance
+ * is converted through a third commodity that has prices with both.  The
+ * prices used for each combination of commodities and time are remembered
+ * until a price is added, removed or changed, so converting many balances
+ * between the same commodities at the same time looks them up only once.
  */
 gnc_numeric
 gnc_pricedb_convert_balance_nearest_price_t64(GNCPriceDB *pdb,
@@ -642,6 +682,25 @@ void gnc_pricedb_nth_price_reset_cache (GNCPriceDB *db);
  */
 guint gnc_pricedb_get_num_prices(GNCPriceDB *db);
 
+/** @brief Return a counter that changes whenever a price in the database is
+ * added, removed or modified.
+ *
+ * Code that caches results computed from prices can record it and compare
+ * later to tell whether the cached results may be stale.
+ */
+guint64 gnc_pricedb_get_generation(const GNCPriceDB *db);
+
+/** @brief Return a counter that changes whenever a price of commodity c, or
+ * a price in currency c, is added, removed or modified.
+ *
+ * Every price a conversion between two commodities may use has one of them
+ * as its commodity or currency, so comparing the sum of their counters
+ * tells whether a converted amount may be stale, without being disturbed
+ * by changes to unrelated prices.
+ */
+guint64 gnc_pricedb_get_commodity_generation(const GNCPriceDB *db,
+                                             const gnc_commodity *c);
+
 /** @brief Test equality of two pricedbs
  *
  * For XML Backend Testing */
@@ -0,0 +1,228 @@
+/********************************************************************\
+ * gnc-split-index.cpp -- Sorted, contiguous index of an account's  *
+ *                        splits.                                   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+}
+
+#include <algorithm>
+#include <cstdint>
+
+#include "gnc-split-index.hpp"
+#include "Transaction.h"
+
+static bool
+split_less (const Split* a, const Split* b)
+{
+    return xaccSplitOrder (a, b) < 0;
+}
+
+GncSplitIndex::~GncSplitIndex()
+{
+    g_list_free (m_list);
+}
+
+bool
+GncSplitIndex::insert (Split* split, bool keep_sorted)
+{
+    if (!m_members.emplace (split, nullptr).second)
+        return false;
+
+    auto pos = m_splits.size();
+    if (keep_sorted && m_sorted)
+        pos = std::upper_bound (m_splits.begin(), m_splits.end(), split,
+                                split_less) - m_splits.begin();
+    else if (!m_splits.empty())
+        m_sorted = false;
+
+    list_insert (pos, split);
+    m_splits.insert (m_splits.begin() + pos, split);
+    mark_stale (pos);
+    invalidate_dates ();
+    return true;
+}
+
+bool
+GncSplitIndex::remove (Split* split)
+{
+    auto member = m_members.find (split);
+    if (member == m_members.end())
+        return false;
+    if (member->second)
+        m_list = g_list_delete_link (m_list, member->second);
+    m_members.erase (member);
+
+    auto pos = index_of (split);
+    m_splits.erase (m_splits.begin() + pos);
+    mark_stale (pos);
+    invalidate_dates ();
+    return true;
+}
+
+std::size_t
+GncSplitIndex::index_of (const Split* split) const noexcept
+{
+    /* A split whose transaction is being edited may have a sort key that
+     * no longer matches its position, so a failed binary search isn't
+     * conclusive. */
+    if (m_sorted)
+    {
+        auto iter = std::lower_bound (m_splits.begin(), m_splits.end(),
+                                      split, split_less);
+        if (iter != m_splits.end() && *iter == split)
+            return iter - m_splits.begin();
+    }
+    return std::find (m_splits.begin(), m_splits.end(), split) -
+        m_splits.begin();
+}
+
+bool
+GncSplitIndex::sort ()
+{
+    /* Called whenever a split in the account was committed, which is also
+     * when a posted date may have changed. */
+    invalidate_dates ();
+    m_sorted = true;
+    /* Sort keys can change without the index being told, so always check
+     * the real order; it is normally intact and the check is linear. */
+    auto unsorted = std::is_sorted_until (m_splits.begin(), m_splits.end(),
+                                          split_less);
+    if (unsorted == m_splits.end())
+        return false;
+
+    /* The sorted prefix keeps its place up to where the smallest of the
+     * remaining splits will land; everything from there on may move. */
+    auto lowest = *std::min_element (unsorted, m_splits.end(), split_less);
+    mark_stale (std::upper_bound (m_splits.begin(), unsorted, lowest,
+                                  split_less) - m_splits.begin());
+    std::sort (m_splits.begin(), m_splits.end(), split_less);
+    if (m_have_list)
+        list_relink ();
+    return true;
+}
+
+void
+GncSplitIndex::clear () noexcept
+{
+    m_splits.clear();
+    m_members.clear();
+    g_list_free (m_list);
+    m_list = nullptr;
+    m_have_list = false;
+    m_sorted = true;
+    mark_fresh ();
+    invalidate_dates ();
+}
+
+std::size_t
+GncSplitIndex::count_posted_before (time64 date, std::size_t from) const
+{
+    if (m_posted.size() != m_splits.size())
+    {
+        m_posted.clear();
+        m_posted.reserve (m_splits.size());
+        /* Splits without a transaction sort last, so give them the
+         * latest possible date to keep the array ordered. */
+        for (auto split : m_splits)
+        {
+            auto trans = xaccSplitGetParent (split);
+            m_posted.push_back (trans ? xaccTransRetDatePosted (trans) :
+                                INT64_MAX);
+        }
+    }
+    from = std::min (from, m_posted.size());
+    return std::lower_bound (m_posted.begin() + from, m_posted.end(), date) -
+        m_posted.begin();
+}
+
+GList*
+GncSplitIndex::list ()
+{
+    if (m_have_list)
+        return m_list;
+
+    for (auto split : m_splits)
+    {
+        auto node = g_list_alloc ();
+        node->data = split;
+        m_members[split] = node;
+    }
+    list_relink ();
+    m_have_list = true;
+    return m_list;
+}
+
+/* Keep the GList mirror in step with an insertion at pos, before the
+ * split is added to m_splits. Existing nodes are never reallocated, so
+ * iterators held by callers remain usable. */
+void
+GncSplitIndex::list_insert (std::size_t pos, Split* split)
+{
+    if (!m_have_list)
+        return;
+
+    auto node = g_list_alloc ();
+    node->data = split;
+    m_members[split] = node;
+    if (pos < m_splits.size())
+    {
+        auto sibling = node_of (m_splits[pos]);
+        node->prev = sibling->prev;
+        node->next = sibling;
+        if (sibling->prev)
+            sibling->prev->next = node;
+        else
+            m_list = node;
+        sibling->prev = node;
+    }
+    else if (!m_splits.empty())
+    {
+        auto last = node_of (m_splits.back());
+        node->prev = last;
+        last->next = node;
+    }
+    else
+    {
+        m_list = node;
+    }
+}
+
+/* Link the mirror's nodes in the order of m_splits. */
+void
+GncSplitIndex::list_relink ()
+{
+    GList* prev = nullptr;
+    m_list = nullptr;
+    for (auto split : m_splits)
+    {
+        auto node = node_of (split);
+        node->prev = prev;
+        node->next = nullptr;
+        if (prev)
+            prev->next = node;
+        else
+            m_list = node;
+        prev = node;
+    }
+}
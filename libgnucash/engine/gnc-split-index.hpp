@@ -0,0 +1,227 @@
+/********************************************************************\
+ * gnc-split-index.hpp -- Sorted, contiguous index of an account's  *
+ *                        splits.                                   *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+/** @file gnc-split-index.hpp
+ *
+ * The engine-private container that holds the splits of an Account.
+ *
+ * Splits are kept in a std::vector ordered by xaccSplitOrder(), so that
+ * the position of a new split is found with a binary search and walks
+ * over the account touch contiguous memory. A hash map of the member
+ * splits answers "is this split in the account" without depending on
+ * the sort order, which may be stale while a transaction is being
+ * edited.
+ *
+ * Inserting or removing a split in the middle moves the pointers after
+ * it, which is linear like the g_list_insert_sorted() it replaces. A tree
+ * wouldn't make the operation cheaper: the running balances of all the
+ * splits after the changed position have to be recomputed anyway (see
+ * below), and the balance code and count_posted_before() rely on indexed
+ * access. Splits loaded or added while the account is being edited are
+ * appended and sorted once at commit.
+ *
+ * Because xaccSplitOrder() sorts on the transaction's posted date first,
+ * the index also serves as a posted-date index: the dates are cached in a
+ * parallel array so that finding the splits posted before a given date is
+ * a binary search that doesn't chase pointers into the transactions.
+ *
+ * xaccAccountGetSplitList() has always returned the account's own GList,
+ * and callers hold on to it while they modify the account. To keep that
+ * working the index can materialize a GList mirror on demand; once it
+ * exists it is updated node-by-node along with the vector so that the
+ * nodes a caller is holding stay valid, just as they did when the GList
+ * was the primary store. Each member's node is found through the hash
+ * map, so keeping the mirror in step costs O(1).
+ *
+ * Each split carries running balances that depend on every split before
+ * it, so a change only invalidates the balances from its own position
+ * on. The index keeps a watermark of the lowest such position, lowered by
+ * insertions, removals, reorderings and explicit mark_stale() calls, so
+ * that xaccAccountRecomputeBalance() only has to redo the suffix. A
+ * separate watermark covers changes of reconcile state, which only affect
+ * the cleared and reconciled balances.
+ */
+
+#ifndef GNC_SPLIT_INDEX_HPP
+#define GNC_SPLIT_INDEX_HPP
+
+#include <glib.h>
+#include <cstddef>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+#include "Split.h"
+#include "gnc-date.h"
+
+/** Sorted split container for Account.
+ *
+ * It's a struct because AccountPrivate, which is visible to C code, needs
+ * to declare a pointer to it.
+ */
+struct GncSplitIndex
+{
+    using SplitVec = std::vector<Split*>;
+    using const_iterator = SplitVec::const_iterator;
+    using const_reverse_iterator = SplitVec::const_reverse_iterator;
+
+    GncSplitIndex() = default;
+    GncSplitIndex(const GncSplitIndex&) = delete;
+    GncSplitIndex& operator=(const GncSplitIndex&) = delete;
+    ~GncSplitIndex();
+
+    /** @return true if split is a member of the index. O(1). */
+    bool contains (const Split* split) const noexcept
+    {
+        return m_members.find (split) != m_members.end();
+    }
+
+    /** Add a split.
+     * @param split The split to add.
+     * @param keep_sorted If true and the index is currently sorted, the
+     * split is placed at its xaccSplitOrder position; otherwise it is
+     * appended and the index is marked unsorted.
+     * @return false if the split was already present.
+     */
+    bool insert (Split* split, bool keep_sorted);
+
+    /** Remove a split.
+     * @return false if the split wasn't present.
+     */
+    bool remove (Split* split);
+
+    /** Restore xaccSplitOrder order.
+     * @return true if any split changed position.
+     */
+    bool sort ();
+
+    /** Drop all splits without touching them. */
+    void clear () noexcept;
+
+    /** @return the position of split in the index, or size() if it isn't
+     * a member. Uses a binary search when the index is sorted.
+     */
+    std::size_t index_of (const Split* split) const noexcept;
+
+    /** @return true unless a split was appended out of order since the
+     * last sort().
+     */
+    bool is_sorted () const noexcept { return m_sorted; }
+
+    /** @return the number of splits posted strictly before date, which is
+     * also the position of the first split posted on or after it. The
+     * index must be sorted. O(log n).
+     * @param date The date to look for.
+     * @param from A position already known to be at or before the
+     * result, e.g. the result for an earlier date; lets a caller walk an
+     * ascending series of dates in a single pass.
+     */
+    std::size_t count_posted_before (time64 date,
+                                     std::size_t from = 0) const;
+
+    /** Note that the running balances of the split at pos and of every
+     * split after it need recomputing.
+     * @param pos The position of the first changed split.
+     * @param reconcile_only If true only the reconcile state changed, so
+     * just the cleared and reconciled balances are affected.
+     */
+    void mark_stale (std::size_t pos, bool reconcile_only = false) noexcept
+    {
+        auto& from = reconcile_only ? m_cleared_stale_from : m_stale_from;
+        if (pos < from)
+            from = pos;
+    }
+
+    /** @return true if any balance was marked stale since the last
+     * mark_fresh().
+     */
+    bool has_stale_balances () const noexcept
+    {
+        return m_stale_from != s_fresh || m_cleared_stale_from != s_fresh;
+    }
+
+    /** @return the position of the first split whose balances all need
+     * recomputing, or size() if there is none.
+     */
+    std::size_t stale_from () const noexcept
+    {
+        return m_stale_from < m_splits.size() ? m_stale_from : m_splits.size();
+    }
+
+    /** @return the position of the first split whose cleared and
+     * reconciled balances need recomputing, or size() if there is none.
+     * This is never after stale_from().
+     */
+    std::size_t cleared_stale_from () const noexcept
+    {
+        return m_cleared_stale_from < stale_from() ? m_cleared_stale_from :
+            stale_from();
+    }
+
+    /** Record that all running balances are up to date. */
+    void mark_fresh () noexcept
+    {
+        m_stale_from = m_cleared_stale_from = s_fresh;
+    }
+
+    /** @return a GList of the splits in index order. The list is owned by
+     * the index and remains valid, tracking insertions and removals, until
+     * the index is destroyed or clear()ed.
+     */
+    GList* list ();
+
+    std::size_t size () const noexcept { return m_splits.size(); }
+    bool empty () const noexcept { return m_splits.empty(); }
+    Split* operator[] (std::size_t pos) const noexcept { return m_splits[pos]; }
+    Split* front () const noexcept { return m_splits.front(); }
+    Split* back () const noexcept { return m_splits.back(); }
+    const_iterator begin () const noexcept { return m_splits.cbegin(); }
+    const_iterator end () const noexcept { return m_splits.cend(); }
+    const_reverse_iterator rbegin () const noexcept { return m_splits.crbegin(); }
+    const_reverse_iterator rend () const noexcept { return m_splits.crend(); }
+    /** A copy of the splits, for loops that may modify the account. */
+    SplitVec snapshot () const { return m_splits; }
+
+private:
+    void list_insert (std::size_t pos, Split* split);
+    void list_relink ();
+    GList* node_of (const Split* split) const { return m_members.at (split); }
+    void invalidate_dates () const noexcept { m_posted.clear(); }
+
+    static constexpr std::size_t s_fresh =
+        std::numeric_limits<std::size_t>::max();
+
+    SplitVec m_splits;
+    /* The member splits with their node in the GList mirror, or nullptr
+     * while there is no mirror. */
+    std::unordered_map<const Split*, GList*> m_members;
+    GList* m_list = nullptr;
+    bool m_have_list = false;
+    bool m_sorted = true;
+    /* Posted dates of m_splits, rebuilt on demand; empty when stale. */
+    mutable std::vector<time64> m_posted;
+    /* Balance watermarks, see mark_stale(); s_fresh when up to date. */
+    std::size_t m_stale_from = s_fresh;
+    std::size_t m_cleared_stale_from = s_fresh;
+};
+
+#endif /* GNC_SPLIT_INDEX_HPP */
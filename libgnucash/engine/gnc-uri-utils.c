@@ -92,6 +92,7 @@ gboolean gnc_uri_is_file_scheme (const gchar *scheme)
     return (scheme &&
             (!g_ascii_strcasecmp (scheme, "file") ||
              !g_ascii_strcasecmp (scheme, "xml") ||
+             !g_ascii_strcasecmp (scheme, "gncbin") ||
              !g_ascii_strcasecmp (scheme, "sqlite3")));
 }
 
@@ -0,0 +1,224 @@
+/********************************************************************
+ * guid-map.hpp -- Open-addressing hash map keyed by GncGUID.       *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+ *******************************************************************/
+/** @addtogroup Entity
+    @{ */
+/** @file guid-map.hpp
+    @brief A hash map from GncGUID to a small value.
+
+    GncGUIDMap is an open-addressing table using Robin Hood probing:
+    the keys are stored by value in one flat array, so a lookup is a
+    hash and a short linear scan with no pointer chasing and no heap
+    node per entry. Erasure uses backward shifting, so there are no
+    tombstones and probe sequences stay short however the table is
+    used.
+
+    GUIDs are random, so the hash is just the two halves of the GUID
+    folded together. They're still put through a multiplicative mix
+    because hand-made GUIDs (test data, imported files) can differ in
+    only a byte or two.
+*/
+
+#ifndef GUID_MAP_HPP
+#define GUID_MAP_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+extern "C"
+{
+#include "guid.h"
+}
+
+template <typename T>
+class GncGUIDMap
+{
+public:
+    GncGUIDMap () = default;
+
+    /** The number of entries in the map. */
+    std::size_t size () const noexcept { return m_size; }
+    bool empty () const noexcept { return m_size == 0; }
+
+    /** Remove every entry, keeping the allocated table. */
+    void clear () noexcept
+    {
+        for (auto& slot : m_slots)
+            slot.dist = 0;
+        m_size = 0;
+    }
+
+    /** Make room for at least count entries without rehashing. */
+    void reserve (std::size_t count)
+    {
+        auto capacity = m_slots.size ();
+        if (capacity == 0)
+            capacity = min_capacity;
+        while (count * max_load_den > capacity * max_load_num)
+            capacity *= 2;
+        if (capacity != m_slots.size ())
+            rehash (capacity);
+    }
+
+    /** Look up a GUID.
+     *  @return A pointer to the stored value, or nullptr if guid isn't in
+     *  the map. The pointer is invalidated by any insertion or erasure.
+     */
+    const T* find (const GncGUID& guid) const noexcept
+    {
+        if (m_size == 0)
+            return nullptr;
+        auto mask = m_slots.size () - 1;
+        auto pos = home (guid);
+        for (uint32_t dist = 1; ; ++dist, pos = (pos + 1) & mask)
+        {
+            const auto& slot = m_slots[pos];
+            /* A Robin Hood table never lets a key sit behind one that's
+             * closer to its home, so we can stop early. */
+            if (slot.dist < dist)
+                return nullptr;
+            if (slot.dist == dist && guid_eq (slot.key, guid))
+                return &slot.value;
+        }
+    }
+
+    T* find (const GncGUID& guid) noexcept
+    {
+        return const_cast<T*>(static_cast<const GncGUIDMap*>(this)->find (guid));
+    }
+
+    /** Add guid with value, replacing the value if guid is already in
+     *  the map.
+     */
+    void insert_or_assign (const GncGUID& guid, const T& value)
+    {
+        if (auto found = find (guid))
+        {
+            *found = value;
+            return;
+        }
+        if ((m_size + 1) * max_load_den > m_slots.size () * max_load_num)
+            rehash (m_slots.empty () ? min_capacity : m_slots.size () * 2);
+        place (Slot {guid, value, 1});
+        ++m_size;
+    }
+
+    /** Remove guid from the map.
+     *  @return true if it was there.
+     */
+    bool erase (const GncGUID& guid) noexcept
+    {
+        if (m_size == 0)
+            return false;
+        auto mask = m_slots.size () - 1;
+        auto pos = home (guid);
+        for (uint32_t dist = 1; ; ++dist, pos = (pos + 1) & mask)
+        {
+            auto& slot = m_slots[pos];
+            if (slot.dist < dist)
+                return false;
+            if (slot.dist == dist && guid_eq (slot.key, guid))
+                break;
+        }
+        /* Pull the following displaced entries back one place. */
+        for (auto next = (pos + 1) & mask; m_slots[next].dist > 1;
+             pos = next, next = (next + 1) & mask)
+        {
+            m_slots[pos] = m_slots[next];
+            --m_slots[pos].dist;
+        }
+        m_slots[pos].dist = 0;
+        --m_size;
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        GncGUID key;
+        T value;
+        uint32_t dist;  /* probe distance plus one, 0 for an empty slot */
+    };
+
+    /* Robin Hood probing keeps probe lengths short up to a high load. */
+    enum : std::size_t
+    {
+        min_capacity = 16,
+        max_load_num = 7,
+        max_load_den = 8
+    };
+
+    static bool guid_eq (const GncGUID& a, const GncGUID& b) noexcept
+    {
+        return memcmp (a.reserved, b.reserved, GUID_DATA_SIZE) == 0;
+    }
+
+    std::size_t home (const GncGUID& guid) const noexcept
+    {
+        uint64_t lo, hi;
+        memcpy (&lo, guid.reserved, sizeof lo);
+        memcpy (&hi, guid.reserved + sizeof lo, sizeof hi);
+        auto hash = (lo ^ hi) * UINT64_C(0x9e3779b97f4a7c15);
+        return static_cast<std::size_t>(hash >> m_shift);
+    }
+
+    void place (Slot entry) noexcept
+    {
+        auto mask = m_slots.size () - 1;
+        for (auto pos = home (entry.key); ; pos = (pos + 1) & mask)
+        {
+            auto& slot = m_slots[pos];
+            if (slot.dist == 0)
+            {
+                slot = entry;
+                return;
+            }
+            /* Take the place of an entry that's nearer its home. */
+            if (slot.dist < entry.dist)
+                std::swap (slot, entry);
+            ++entry.dist;
+        }
+    }
+
+    void rehash (std::size_t capacity)
+    {
+        std::vector<Slot> old (capacity, Slot {});
+        old.swap (m_slots);
+        m_shift = 64;
+        for (auto cap = capacity; cap > 1; cap >>= 1)
+            --m_shift;
+        for (auto& slot : old)
+            if (slot.dist)
+            {
+                slot.dist = 1;
+                place (slot);
+            }
+    }
+
+    std::vector<Slot> m_slots;
+    std::size_t m_size = 0;
+    unsigned m_shift = 64;
+};
+
+#endif /* GUID_MAP_HPP */
+/** @} */
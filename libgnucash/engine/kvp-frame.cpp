@@ -45,14 +45,57 @@ static QofLogModule log_module = "qof.kvp";
 
 static const char delim = '/';
 
+KvpPath::KvpPath (Path const & path) noexcept
+{
+    m_keys.reserve (path.size ());
+    for (auto const & key : path)
+        m_keys.push_back (g_strdup (key.c_str ()));
+}
+
+KvpPath::KvpPath (KvpPath const & rhs) noexcept
+{
+    m_keys.reserve (rhs.m_keys.size ());
+    for (auto key : rhs.m_keys)
+        m_keys.push_back (g_strdup (key));
+}
+
+KvpPath &
+KvpPath::operator= (KvpPath const & rhs) noexcept
+{
+    if (this != &rhs)
+    {
+        KvpPath copy {rhs};
+        std::swap (m_keys, copy.m_keys);
+    }
+    return *this;
+}
+
+KvpPath::~KvpPath () noexcept
+{
+    for (auto key : m_keys)
+        g_free (key);
+}
+
+/* The keys of a Path as C strings; the Path must outlive the result. */
+static std::vector<char const *>
+path_keys (Path const & path) noexcept
+{
+    std::vector<char const *> keys;
+    keys.reserve (path.size ());
+    for (auto const & key : path)
+        keys.push_back (key.c_str ());
+    return keys;
+}
+
 KvpFrameImpl::KvpFrameImpl(const KvpFrameImpl & rhs) noexcept
 {
+    m_valuemap.reserve (rhs.m_valuemap.size ());
     std::for_each(rhs.m_valuemap.begin(), rhs.m_valuemap.end(),
         [this](const map_type::value_type & a)
         {
             auto key = static_cast<char *>(qof_string_cache_insert(a.first));
             auto val = new KvpValueImpl(*a.second);
-            this->m_valuemap.insert({key,val});
+            this->m_valuemap.emplace_back(key,val);
         }
     );
 }
@@ -68,94 +111,167 @@ KvpFrameImpl::~KvpFrameImpl() noexcept
     m_valuemap.clear();
 }
 
+KvpFrameImpl::map_type::iterator
+KvpFrameImpl::lower_bound (char const * key) noexcept
+{
+    /* Keys are cached strings, so an equal key is usually the same pointer. */
+    return std::lower_bound (m_valuemap.begin (), m_valuemap.end (), key,
+        [](map_type::value_type const & a, char const * k)
+        {
+            return a.first != k && std::strcmp (a.first, k) < 0;
+        });
+}
+
+KvpFrameImpl::map_type::iterator
+KvpFrameImpl::find (char const * key) noexcept
+{
+    auto spot = lower_bound (key);
+    if (spot != m_valuemap.end () &&
+        (spot->first == key || !std::strcmp (spot->first, key)))
+        return spot;
+    return m_valuemap.end ();
+}
+
+KvpFrameImpl::map_type::const_iterator
+KvpFrameImpl::find (char const * key) const noexcept
+{
+    return const_cast<KvpFrameImpl*>(this)->find (key);
+}
+
 KvpFrame *
-KvpFrame::get_child_frame_or_nullptr (Path const & path) noexcept
+KvpFrame::get_child_frame_or_nullptr (char const * const * keys, std::size_t count) noexcept
 {
-    if (!path.size ())
-        return this;
-    auto key = path.front ();
-    if (m_valuemap.find (key.c_str ()) == m_valuemap.end ())
-        return nullptr;
-    auto child = m_valuemap.at (key.c_str ())->get <KvpFrame *> ();
-    Path send;
-    std::copy (path.begin () + 1, path.end (), std::back_inserter (send));
-    return child->get_child_frame_or_nullptr (send);
+    auto frame = this;
+    for (std::size_t i = 0; frame && i < count; ++i)
+    {
+        auto spot = frame->find (keys[i]);
+        if (spot == frame->m_valuemap.end ())
+            return nullptr;
+        frame = spot->second->get <KvpFrame *> ();
+    }
+    return frame;
 }
 
 KvpFrame *
-KvpFrame::get_child_frame_or_create (Path const & path) noexcept
+KvpFrame::get_child_frame_or_create (char const * const * keys, std::size_t count) noexcept
 {
-    if (!path.size ())
-        return this;
-    auto key = path.front ();
-    auto spot = m_valuemap.find (key.c_str ());
-    if (spot == m_valuemap.end () || spot->second->get_type () != KvpValue::Type::FRAME)
-        delete set_impl (key.c_str (), new KvpValue {new KvpFrame});
-    Path send;
-    std::copy (path.begin () + 1, path.end (), std::back_inserter (send));
-    auto child_val = m_valuemap.at (key.c_str ());
-    auto child = child_val->get <KvpFrame *> ();
-    return child->get_child_frame_or_create (send);
+    auto frame = this;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        auto spot = frame->find (keys[i]);
+        if (spot == frame->m_valuemap.end () || spot->second->get_type () != KvpValue::Type::FRAME)
+        {
+            auto child = new KvpFrame;
+            delete frame->set_impl (keys[i], new KvpValue {child});
+            frame = child;
+        }
+        else
+            frame = spot->second->get <KvpFrame *> ();
+    }
+    return frame;
 }
 
 
 KvpValue *
-KvpFrame::set_impl (std::string const & key, KvpValue * value) noexcept
+KvpFrame::set_impl (char const * key, KvpValue * value) noexcept
 {
     KvpValue * ret {};
-    auto spot = m_valuemap.find (key.c_str ());
-    if (spot != m_valuemap.end ())
+    auto spot = lower_bound (key);
+    if (spot != m_valuemap.end () &&
+        (spot->first == key || !std::strcmp (spot->first, key)))
     {
-        qof_string_cache_remove (spot->first);
         ret = spot->second;
+        if (value)
+        {
+            spot->second = value;
+            return ret;
+        }
+        qof_string_cache_remove (spot->first);
         m_valuemap.erase (spot);
     }
-    if (value)
+    else if (value)
     {
-        auto cachedkey = static_cast <char const *> (qof_string_cache_insert (key.c_str ()));
-        m_valuemap.emplace (cachedkey, value);
+        auto cachedkey = static_cast <char const *> (qof_string_cache_insert (key));
+        m_valuemap.emplace (spot, cachedkey, value);
     }
     return ret;
 }
 
 KvpValue *
-KvpFrameImpl::set (Path path, KvpValue* value) noexcept
+KvpFrameImpl::set (char const * const * keys, std::size_t count, KvpValue* value) noexcept
 {
-    if (path.empty())
+    if (!count)
         return nullptr;
-    auto key = path.back ();
-    path.pop_back ();
-    auto target = get_child_frame_or_nullptr (path);
+    auto target = get_child_frame_or_nullptr (keys, count - 1);
     if (!target)
         return nullptr;
-    return target->set_impl (key, value);
+    return target->set_impl (keys[count - 1], value);
 }
 
 KvpValue *
-KvpFrameImpl::set_path (Path path, KvpValue* value) noexcept
+KvpFrameImpl::set_path (char const * const * keys, std::size_t count, KvpValue* value) noexcept
 {
-    auto key = path.back();
-    path.pop_back();
-    auto target = get_child_frame_or_create (path);
+    if (!count)
+        return nullptr;
+    auto target = get_child_frame_or_create (keys, count - 1);
     if (!target)
         return nullptr;
-    return target->set_impl (key, value);
+    return target->set_impl (keys[count - 1], value);
 }
 
 KvpValue *
-KvpFrameImpl::get_slot (Path path) noexcept
+KvpFrameImpl::get_slot (char const * const * keys, std::size_t count) noexcept
 {
-    auto key = path.back();
-    path.pop_back();
-    auto target = get_child_frame_or_nullptr (path);
+    if (!count)
+        return nullptr;
+    auto target = get_child_frame_or_nullptr (keys, count - 1);
     if (!target)
         return nullptr;
-    auto spot = target->m_valuemap.find (key.c_str ());
+    auto spot = target->find (keys[count - 1]);
     if (spot != target->m_valuemap.end ())
         return spot->second;
     return nullptr;
 }
 
+KvpValue *
+KvpFrameImpl::set (Path path, KvpValue* value) noexcept
+{
+    auto keys = path_keys (path);
+    return set (keys.data (), keys.size (), value);
+}
+
+KvpValue *
+KvpFrameImpl::set_path (Path path, KvpValue* value) noexcept
+{
+    auto keys = path_keys (path);
+    return set_path (keys.data (), keys.size (), value);
+}
+
+KvpValue *
+KvpFrameImpl::get_slot (Path path) noexcept
+{
+    auto keys = path_keys (path);
+    return get_slot (keys.data (), keys.size ());
+}
+
+KvpValue *
+KvpFrameImpl::set (KvpPath const & path, KvpValue* value) noexcept
+{
+    return set (path.keys (), path.size (), value);
+}
+
+KvpValue *
+KvpFrameImpl::set_path (KvpPath const & path, KvpValue* value) noexcept
+{
+    return set_path (path.keys (), path.size (), value);
+}
+
+KvpValue *
+KvpFrameImpl::get_slot (KvpPath const & path) noexcept
+{
+    return get_slot (path.keys (), path.size ());
+}
+
 std::string
 KvpFrameImpl::to_string() const noexcept
 {
@@ -218,7 +334,7 @@ int compare(const KvpFrameImpl & one, const KvpFrameImpl & two) noexcept
 {
     for (const auto & a : one.m_valuemap)
     {
-        auto otherspot = two.m_valuemap.find(a.first);
+        auto otherspot = two.find(a.first);
         if (otherspot == two.m_valuemap.end())
         {
             return 1;
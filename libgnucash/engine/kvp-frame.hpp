@@ -85,7 +85,6 @@
 #define GNC_KVP_FRAME_TYPE
 
 #include "kvp-value.hpp"
-#include <map>
 #include <string>
 #include <vector>
 #include <cstring>
@@ -94,6 +93,36 @@
 using Path = std::vector<std::string>;
 using KvpEntry = std::pair <std::vector <std::string>, KvpValue*>;
 
+/** A precompiled KVP path.
+ *
+ * Looking a slot up by Path copies the keys for every frame on the way down;
+ * a KvpPath is built once, typically as a function-local static, and walks
+ * the frames without allocating:
+ *
+ *     static const KvpPath path {{"lot-mgmt", "gains-split"}};
+ *     auto value = frame->get_slot (path);
+ *
+ * It owns copies of its keys so it doesn't depend on the string cache, which
+ * may be destroyed and recreated while the handle lives on.
+ */
+class KvpPath
+{
+public:
+    explicit KvpPath (Path const & path) noexcept;
+    /** @return The number of keys in the path. */
+    std::size_t size () const noexcept { return m_keys.size (); }
+    bool empty () const noexcept { return m_keys.empty (); }
+    /** @return The path's keys, outermost frame first. */
+    char const * const * keys () const noexcept { return m_keys.data (); }
+
+    KvpPath (KvpPath const &) noexcept;
+    KvpPath & operator= (KvpPath const &) noexcept;
+    ~KvpPath () noexcept;
+
+private:
+    std::vector<char *> m_keys;
+};
+
 /** Implements KvpFrame.
  *  It's a struct because QofInstance needs to use the typename to declare a
  *  KvpFrame* member, and QofInstance's API is C until its children are all
@@ -108,17 +137,12 @@ using KvpEntry = std::pair <std::vector <std::string>, KvpValue*>;
  */
 struct KvpFrameImpl
 {
-    class cstring_comparer
-    {
-    public:
-	/* Returns true if one is less than two. */
-	bool operator()(const char * one, const char * two) const
-	    {
-		auto ret = std::strcmp(one, two) < 0;
-		return ret;
-	    }
-    };
-    using map_type = std::map<const char *, KvpValue*, cstring_comparer>;
+    /* Most frames hold only a handful of slots, so they're kept in a vector
+     * sorted by key rather than in a tree: one allocation per frame instead of
+     * one per slot, and the slots are adjacent when searched. Keys are strings
+     * from the string cache.
+     */
+    using map_type = std::vector<std::pair<const char *, KvpValue*>>;
 
     public:
     KvpFrameImpl() noexcept {};
@@ -169,6 +193,10 @@ struct KvpFrameImpl
      * @return The old value if there was one or nullptr.
      */
     KvpValue* set_path(Path path, KvpValue* newvalue) noexcept;
+    /** Like set(Path, KvpValue*) with a precompiled path. */
+    KvpValue* set(KvpPath const & path, KvpValue* newvalue) noexcept;
+    /** Like set_path(Path, KvpValue*) with a precompiled path. */
+    KvpValue* set_path(KvpPath const & path, KvpValue* newvalue) noexcept;
     /**
      * Make a string representation of the frame. Mostly useful for debugging.
      * @return A std::string representing the frame and all its children.
@@ -192,6 +220,15 @@ struct KvpFrameImpl
      * @return The value at the key or nullptr.
      */
     KvpValue* get_slot(Path keys) noexcept;
+    /** Like get_slot(Path) with a precompiled path. */
+    KvpValue* get_slot(KvpPath const & path) noexcept;
+
+    /** The versions of set, set_path and get_slot for callers that already
+     * have the path as an array of count C strings.
+     */
+    KvpValue* set(char const * const * keys, std::size_t count, KvpValue* newvalue) noexcept;
+    KvpValue* set_path(char const * const * keys, std::size_t count, KvpValue* newvalue) noexcept;
+    KvpValue* get_slot(char const * const * keys, std::size_t count) noexcept;
 
     /** The function should be of the form:
      * <anything> func (char const *, KvpValue *, data_type &);
@@ -229,10 +266,14 @@ struct KvpFrameImpl
     private:
     map_type m_valuemap;
 
-    KvpFrame * get_child_frame_or_nullptr (Path const &) noexcept;
-    KvpFrame * get_child_frame_or_create (Path const &) noexcept;
+    map_type::iterator lower_bound (char const *) noexcept;
+    map_type::iterator find (char const *) noexcept;
+    map_type::const_iterator find (char const *) const noexcept;
+    KvpFrame * get_child_frame_or_nullptr (char const * const *, std::size_t) noexcept;
+    KvpFrame * get_child_frame_or_create (char const * const *, std::size_t) noexcept;
     void flatten_kvp_impl(std::vector <std::string>, std::vector <KvpEntry> &) const noexcept;
-    KvpValue * set_impl (std::string const &, KvpValue *) noexcept;
+    KvpValue * set_impl (char const *, KvpValue *) noexcept;
+
 };
 
 template<typename func_type>
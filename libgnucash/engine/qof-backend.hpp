@@ -261,6 +261,11 @@ public:
 /** Perform a sync in a way that prevents data loss on a DBI backend.
  */
     virtual void safe_sync(QofBook *) = 0;
+/** Store only what changed since the last sync, if the backend can do that
+ *  more cheaply than a sync; used for auto-saves. Backends that write
+ *  every change as it happens or always write everything just sync.
+ */
+    virtual void sync_incremental(QofBook* book) { sync(book); }
 /**   Extract the chart of accounts from the current database and create a new
  *   database with it. Implemented only in the XML backend at present.
  */
@@ -37,46 +37,258 @@ extern "C"
 #include "qof.h"
 }
 
+#include <vector>
+
 /* Uncomment if you need to log anything.
 static QofLogModule log_module = QOF_MOD_UTIL;
 */
 /* =================================================================== */
 /* The QOF string cache                                                */
 /*                                                                     */
-/* The cache is a GHashTable where a copy of the string is the key,    */
-/* and a ref count is the value                                        */
+/* Cached strings are stored in large arena blocks, each right after a */
+/* small header holding its reference count and atom, so caching a new */
+/* string costs no allocation of its own.  A GHashTable of the cached  */
+/* strings finds them by content.  A block is freed once none of its   */
+/* strings is referenced any more, the block being filled included,    */
+/* so that a cache emptied by churn gives all of its memory back.      */
+/*                                                                     */
+/* All access goes through a single lock so that strings can be cached */
+/* from several threads, e.g. by a parallel loader.                    */
 /* =================================================================== */
 
-static GHashTable* qof_string_cache = NULL;
+namespace
+{
 
-static GHashTable*
-qof_get_string_cache(void)
+struct StringBlock
 {
-    if (!qof_string_cache)
+    StringBlock* prev;
+    StringBlock* next;
+    gsize size;         /* bytes of string storage after the block */
+    gsize used;
+    guint live;         /* strings in the block that are still cached */
+};
+
+struct StringHeader
+{
+    StringBlock* block;
+    guint refcount;
+    QofStringAtom atom;
+};
+
+/* Strings taking more than a quarter of a block get a block of their
+ * own, so that they don't waste the rest of the current one. */
+constexpr gsize block_size = 64 * 1024;
+constexpr gsize big_string = block_size / 4;
+
+struct StringCache
+{
+    GHashTable* strings;
+    /* The block being filled comes first. */
+    StringBlock* blocks = nullptr;
+    /* The string of each atom; atoms[0] stands for no string. */
+    std::vector<char*> atoms {nullptr};
+    std::vector<QofStringAtom> free_atoms;
+    QofStringCacheStats stats {};
+
+    StringCache () : strings {g_hash_table_new (g_str_hash, g_str_equal)} {}
+    ~StringCache ();
+    StringCache (const StringCache&) = delete;
+    StringCache& operator= (const StringCache&) = delete;
+
+    char* insert (const char* key, QofStringAtom* atom);
+    void remove (const char* key);
+    QofStringAtom atom_of (const char* key) const;
+
+private:
+    char* allocate (gsize len, StringBlock** block);
+    void release (StringBlock* block);
+    QofStringAtom new_atom (char* str);
+};
+
+inline StringHeader*
+header_of (gpointer str)
+{
+    return reinterpret_cast<StringHeader*>(str) - 1;
+}
+
+inline char*
+block_data (StringBlock* block)
+{
+    return reinterpret_cast<char*>(block + 1);
+}
+
+} // anonymous namespace
+
+StringCache::~StringCache ()
+{
+    g_hash_table_destroy (strings);
+    while (blocks)
     {
-        qof_string_cache = g_hash_table_new_full(
-                               g_str_hash,               /* hash_func          */
-                               g_str_equal,              /* key_equal_func     */
-                               g_free,                   /* key_destroy_func   */
-                               g_free);                  /* value_destroy_func */
+        auto next = blocks->next;
+        g_free (blocks);
+        blocks = next;
     }
+}
+
+char*
+StringCache::allocate (gsize len, StringBlock** block)
+{
+    constexpr auto align = alignof (StringHeader);
+    gsize need = (sizeof (StringHeader) + len + 1 + align - 1) & ~(align - 1);
+    StringBlock* dest = blocks;
+
+    if (!dest || dest->used + need > dest->size)
+    {
+        gsize size = need > big_string ? need : block_size;
+        dest = static_cast<StringBlock*>(g_malloc (sizeof (StringBlock) + size));
+        dest->size = size;
+        dest->used = 0;
+        dest->live = 0;
+        dest->prev = nullptr;
+        /* A big string's block is full at once, so keep filling the
+         * current one. */
+        if (need > big_string && blocks)
+        {
+            dest->prev = blocks;
+            dest->next = blocks->next;
+            blocks->next = dest;
+        }
+        else
+        {
+            dest->next = blocks;
+            blocks = dest;
+        }
+        if (dest->next)
+            dest->next->prev = dest;
+        stats.arena_bytes += sizeof (StringBlock) + size;
+    }
+
+    auto header = reinterpret_cast<StringHeader*>(block_data (dest) + dest->used);
+    dest->used += need;
+    dest->live++;
+    *block = dest;
+    return reinterpret_cast<char*>(header + 1);
+}
+
+void
+StringCache::release (StringBlock* block)
+{
+    if (--block->live)
+        return;
+    /* The next allocation goes on filling the block after it, or starts
+     * a new one. */
+    if (block == blocks)
+        blocks = block->next;
+    if (block->prev)
+        block->prev->next = block->next;
+    if (block->next)
+        block->next->prev = block->prev;
+    stats.arena_bytes -= sizeof (StringBlock) + block->size;
+    g_free (block);
+}
+
+QofStringAtom
+StringCache::new_atom (char* str)
+{
+    if (!free_atoms.empty ())
+    {
+        auto atom = free_atoms.back ();
+        free_atoms.pop_back ();
+        atoms[atom] = str;
+        return atom;
+    }
+    atoms.push_back (str);
+    return atoms.size () - 1;
+}
+
+char*
+StringCache::insert (const char* key, QofStringAtom* atom)
+{
+    gpointer cached;
+    StringHeader* header;
+
+    if (g_hash_table_lookup_extended (strings, key, &cached, nullptr))
+    {
+        header = header_of (cached);
+        header->refcount++;
+        stats.hits++;
+    }
+    else
+    {
+        StringBlock* block;
+        gsize len = strlen (key);
+        cached = allocate (len, &block);
+        memcpy (cached, key, len + 1);
+        header = header_of (cached);
+        header->block = block;
+        header->refcount = 1;
+        header->atom = new_atom (static_cast<char*>(cached));
+        g_hash_table_add (strings, cached);
+        stats.misses++;
+        stats.strings++;
+        stats.bytes += len + 1;
+    }
+    if (atom)
+        *atom = header->atom;
+    return static_cast<char*>(cached);
+}
+
+void
+StringCache::remove (const char* key)
+{
+    gpointer cached;
+
+    if (!g_hash_table_lookup_extended (strings, key, &cached, nullptr))
+        return;
+    auto header = header_of (cached);
+    if (--header->refcount)
+        return;
+
+    g_hash_table_remove (strings, cached);
+    atoms[header->atom] = nullptr;
+    free_atoms.push_back (header->atom);
+    stats.strings--;
+    stats.bytes -= strlen (static_cast<char*>(cached)) + 1;
+    release (header->block);
+}
+
+QofStringAtom
+StringCache::atom_of (const char* key) const
+{
+    gpointer cached;
+
+    if (!g_hash_table_lookup_extended (strings, key, &cached, nullptr))
+        return QOF_STRING_ATOM_NONE;
+    return header_of (cached)->atom;
+}
+
+static StringCache* qof_string_cache = NULL;
+G_LOCK_DEFINE_STATIC (qof_string_cache);
+
+/* Call with the lock held. */
+static StringCache*
+qof_get_string_cache(void)
+{
+    if (!qof_string_cache)
+        qof_string_cache = new StringCache;
     return qof_string_cache;
 }
 
 void
 qof_string_cache_init(void)
 {
+    G_LOCK (qof_string_cache);
     (void)qof_get_string_cache();
+    G_UNLOCK (qof_string_cache);
 }
 
 void
 qof_string_cache_destroy (void)
 {
-    if (qof_string_cache)
-    {
-        g_hash_table_destroy(qof_string_cache);
-    }
+    G_LOCK (qof_string_cache);
+    delete qof_string_cache;
     qof_string_cache = NULL;
+    G_UNLOCK (qof_string_cache);
 }
 
 /* If the key exists in the cache, check the refcount.  If 1, just
@@ -86,21 +298,9 @@ qof_string_cache_remove(const char * key)
 {
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
-        {
-            guint* refcount = (guint*)value;
-            if (*refcount == 1)
-            {
-                g_hash_table_remove(cache, key);
-            }
-            else
-            {
-                --(*refcount);
-            }
-        }
+        G_LOCK (qof_string_cache);
+        qof_get_string_cache()->remove (key);
+        G_UNLOCK (qof_string_cache);
     }
 }
 
@@ -109,27 +309,58 @@ qof_string_cache_remove(const char * key)
 char *
 qof_string_cache_insert(const char * key)
 {
+    return qof_string_cache_insert_atom (key, NULL);
+}
+
+char *
+qof_string_cache_insert_atom (const char * key, QofStringAtom *atom)
+{
+    char *cached = NULL;
+
+    if (atom)
+        *atom = QOF_STRING_ATOM_NONE;
     if (key)
     {
-        GHashTable* cache = qof_get_string_cache();
-        gpointer value;
-        gpointer cache_key;
-        if (g_hash_table_lookup_extended(cache, key, &cache_key, &value))
-        {
-            guint* refcount = (guint*)value;
-            ++(*refcount);
-            return static_cast <char *> (cache_key);
-        }
-        else
-        {
-            gpointer new_key = g_strdup(static_cast<const char*>(key));
-            guint* refcount = static_cast<unsigned int*>(g_malloc(sizeof(guint)));
-            *refcount = 1;
-            g_hash_table_insert(cache, new_key, refcount);
-            return static_cast <char *> (new_key);
-        }
+        G_LOCK (qof_string_cache);
+        cached = qof_get_string_cache()->insert (key, atom);
+        G_UNLOCK (qof_string_cache);
     }
-    return NULL;
+    return cached;
+}
+
+QofStringAtom
+qof_string_cache_atom (const char * key)
+{
+    QofStringAtom atom;
+
+    if (!key)
+        return QOF_STRING_ATOM_NONE;
+    G_LOCK (qof_string_cache);
+    atom = qof_get_string_cache()->atom_of (key);
+    G_UNLOCK (qof_string_cache);
+    return atom;
+}
+
+const char *
+qof_string_cache_atom_to_string (QofStringAtom atom)
+{
+    const char *str = NULL;
+
+    G_LOCK (qof_string_cache);
+    auto cache = qof_get_string_cache();
+    if (atom < cache->atoms.size ())
+        str = cache->atoms[atom];
+    G_UNLOCK (qof_string_cache);
+    return str;
+}
+
+void
+qof_string_cache_get_stats (QofStringCacheStats *stats)
+{
+    g_return_if_fail (stats);
+    G_LOCK (qof_string_cache);
+    *stats = qof_get_string_cache()->stats;
+    G_UNLOCK (qof_string_cache);
 }
 
 char *
@@ -66,10 +66,32 @@ extern "C"
  * Note that all the work is done when inserting or removing.  Once
  * cached the strings are just plain C strings.
  *
- * The string cache is demand-created on first use.
+ * Each cached string also has an atom, a small integer that stays the
+ * same for as long as the string is cached, so code that keeps many
+ * references can store and compare 32-bit atoms instead of pointers.
+ * Once a string has left the cache its atom may be reused for another.
+ *
+ * The string cache is demand-created on first use.  It may be used from
+ * several threads at once.
  *
  **/
 
+/** The atom of a cached string. */
+typedef guint32 QofStringAtom;
+
+/** The atom of no string. */
+#define QOF_STRING_ATOM_NONE 0
+
+/** Counters of the string cache's activity since it was created. */
+typedef struct
+{
+    guint64 hits;        /**< insertions of a string already cached */
+    guint64 misses;      /**< insertions of a new string */
+    guint64 strings;     /**< distinct strings cached now */
+    guint64 bytes;       /**< bytes of the strings cached now */
+    guint64 arena_bytes; /**< bytes allocated to store them */
+} QofStringCacheStats;
+
 /** Initialize the string cache */
 void qof_string_cache_init(void);
 
@@ -86,6 +108,23 @@ void qof_string_cache_remove(const char * key);
 */
 char * qof_string_cache_insert(const char * key);
 
+/** Like qof_string_cache_insert(), also returning the atom of the string
+ * in atom, QOF_STRING_ATOM_NONE if key is NULL.
+ */
+char * qof_string_cache_insert_atom(const char * key, QofStringAtom *atom);
+
+/** @return the atom of the cached string equal to key, or
+ * QOF_STRING_ATOM_NONE if there is none.  Doesn't add a reference.
+ */
+QofStringAtom qof_string_cache_atom(const char * key);
+
+/** @return the cached string of atom, or NULL if no string has it.
+ */
+const char * qof_string_cache_atom_to_string(QofStringAtom atom);
+
+/** Fill stats with the string cache's counters. */
+void qof_string_cache_get_stats(QofStringCacheStats *stats);
+
 /** Same as CACHE_REPLACE below, but safe to call from C++.
  */
 char * qof_string_cache_replace(const char * dst, const char * src);
@@ -56,6 +56,12 @@ extern "C"
  */
 void qof_book_set_backend (QofBook *book, QofBackend *be);
 
+/** Increment the book's change counter; see qof_book_get_generation().
+ *    Called by QofInstance, there's normally no need to call it
+ *    elsewhere.
+ */
+void qof_book_bump_generation (QofBook *book);
+
 /* Register books with the engine */
 gboolean qof_book_register (void);
 
@@ -140,6 +140,7 @@ qof_book_init (QofBook *book)
     book->book_open = 'y';
     book->read_only = FALSE;
     book->session_dirty = FALSE;
+    book->session_journaled = FALSE;
     book->version = 0;
     book->cached_num_field_source_isvalid = FALSE;
     book->cached_num_days_autoreadonly_isvalid = FALSE;
@@ -424,6 +425,8 @@ qof_book_destroy (QofBook *book)
     ENTER ("book=%p", book);
 
     book->shutting_down = TRUE;
+    /* From here on qof_event_gen drops the events of the book's objects,
+     * those of other books are still delivered. */
     qof_event_force (&book->inst, QOF_EVENT_DESTROY, NULL);
 
     /* Call the list of finalizers, let them do their thing.
@@ -463,12 +466,21 @@ qof_book_session_not_saved (const QofBook *book)
 
 }
 
-void
-qof_book_mark_session_saved (QofBook *book)
+gboolean
+qof_book_session_journaled (const QofBook *book)
+{
+    if (!book) return FALSE;
+    return book->session_journaled;
+}
+
+static void
+mark_session_clean (QofBook *book, gboolean journaled)
 {
     if (!book) return;
 
     book->dirty_time = 0;
+    /* Set before the callback, which may look at it too. */
+    book->session_journaled = journaled;
     if (book->session_dirty)
     {
         /* Set the session clean upfront, because the callback will check. */
@@ -478,6 +490,18 @@ qof_book_mark_session_saved (QofBook *book)
     }
 }
 
+void
+qof_book_mark_session_saved (QofBook *book)
+{
+    mark_session_clean (book, FALSE);
+}
+
+void
+qof_book_mark_session_journaled (QofBook *book)
+{
+    mark_session_clean (book, TRUE);
+}
+
 void qof_book_mark_session_dirty (QofBook *book)
 {
     if (!book) return;
@@ -506,6 +530,20 @@ qof_book_get_session_dirty_time (const QofBook *book)
     return book->dirty_time;
 }
 
+guint64
+qof_book_get_generation (const QofBook *book)
+{
+    g_return_val_if_fail (book, 0);
+    return book->generation;
+}
+
+void
+qof_book_bump_generation (QofBook *book)
+{
+    if (book)
+        book->generation++;
+}
+
 void
 qof_book_set_dirty_cb(QofBook *book, QofBookDirtyCB cb, gpointer user_data)
 {
@@ -647,6 +685,19 @@ qof_book_foreach_collection (const QofBook *book,
     g_hash_table_foreach (book->hash_of_collections, foreach_cb, &iter);
 }
 
+gsize
+qof_book_get_instance_memory (const QofBook *book, QofIdType entity_type)
+{
+    QofCollection *col;
+
+    g_return_val_if_fail (book, 0);
+    if (!entity_type) return 0;
+
+    /* Don't create a collection just to say it's empty. */
+    col = static_cast<QofCollection*>(g_hash_table_lookup (book->hash_of_collections, entity_type));
+    return col ? qof_collection_get_instance_memory (col) : 0;
+}
+
 /* ====================================================================== */
 
 void qof_book_mark_closed (QofBook *book)
@@ -1346,7 +1397,10 @@ gboolean qof_book_register (void)
         { NULL },
     };
 
+    static const char *thread_safe[] = { QOF_PARAM_GUID, QOF_PARAM_KVP, nullptr };
+
     qof_class_register (QOF_ID_BOOK, NULL, params);
+    qof_class_register_thread_safe (QOF_ID_BOOK, thread_safe);
 
     return TRUE;
 }
@@ -93,6 +93,10 @@ struct _QofBook
      */
     gboolean session_dirty;
 
+    /* TRUE if the last save only went to a journal that the next full save
+     * still has to fold into the data file. */
+    gboolean session_journaled;
+
     /* The time when the book was first dirtied.  This is a secondary
      * indicator. It should only be used when session_saved is FALSE. */
     time64 dirty_time;
@@ -161,6 +165,11 @@ struct _QofBook
     gint cached_num_days_autoreadonly;
     /* Whether the above cached value is valid. */
     gboolean cached_num_days_autoreadonly_isvalid;
+
+    /* Incremented whenever an instance in the book is created, edited
+     * or destroyed, so that caches of derived data, like the query
+     * engine's indexes, can tell when they are stale. */
+    guint64 generation;
 };
 
 struct _QofBookClass
@@ -234,6 +243,12 @@ QofCollection  * qof_book_get_collection (const QofBook *, QofIdType);
 typedef void (*QofCollectionForeachCB) (QofCollection *, gpointer user_data);
 void qof_book_foreach_collection (const QofBook *, QofCollectionForeachCB, gpointer);
 
+/** Return the number of bytes taken by the instance structs of the book's
+ *  entities of the given type, e.g. GNC_ID_SPLIT, as counted by
+ *  qof_collection_get_instance_memory(). This is bookkeeping only: GObject
+ *  allocates each instance on its own and the book has no say in where. */
+gsize qof_book_get_instance_memory (const QofBook *book, QofIdType entity_type);
+
 /** The qof_book_set_data() allows arbitrary pointers to structs
  *    to be stored in QofBook. This is the "preferred" method for
  *    extending QofBook to hold new data types.  This is also
@@ -310,7 +325,10 @@ GDate* qof_book_get_autoreadonly_gdate (const QofBook *book);
  *  if it uses transaction number field */
 gboolean qof_book_use_split_action_for_num_field (const QofBook *book);
 
-/** Is the book shutting down? */
+/** Is the book shutting down? While it is, objects are freed in bulk by
+ *  their types' book_end functions without edit cycles, unlinking from
+ *  each other or events, so code called during teardown shouldn't rely on
+ *  any of those. */
 gboolean qof_book_shutting_down (const QofBook *book);
 
 /** qof_book_not_saved() returns the value of the session_dirty flag,
@@ -332,6 +350,19 @@ gboolean qof_book_session_not_saved (const QofBook *book);
  */
 void qof_book_mark_session_saved(QofBook *book);
 
+/** The qof_book_mark_session_journaled() routine marks the book as
+ *    saved, like qof_book_mark_session_saved(), but only to a journal
+ *    that a full save still has to fold into the book's file. Used by
+ *    backends after an incremental save.
+ */
+void qof_book_mark_session_journaled(QofBook *book);
+
+/** qof_book_session_journaled() returns TRUE if the book's changes were
+ *    last saved to a journal only; a full save is still worth doing then
+ *    even though the book is not dirty.
+ */
+gboolean qof_book_session_journaled (const QofBook *book);
+
 /** The qof_book_mark_dirty() routine marks the book as having been
  *    modified. It can be used by frontend when the used has made a
  *    change at the book level.
@@ -341,6 +372,13 @@ void qof_book_mark_session_dirty(QofBook *book);
 /** Retrieve the earliest modification time on the book. */
 time64 qof_book_get_session_dirty_time(const QofBook *book);
 
+/** Retrieve the book's change counter. It is incremented whenever an
+ *    instance in the book is created, marked dirty, committed or
+ *    destroyed; unlike the session dirty flag it is never reset, so
+ *    comparing two values tells whether anything changed in between.
+ */
+guint64 qof_book_get_generation (const QofBook *book);
+
 /** Set the function to call when a book transitions from clean to
  *    dirty, or vice versa.
  */
@@ -34,6 +34,7 @@ static QofLogModule log_module = QOF_MOD_CLASS;
 
 static GHashTable *classTable = NULL;
 static GHashTable *sortTable = NULL;
+static GHashTable *threadSafeTable = NULL;
 static gboolean initialized = FALSE;
 
 static gboolean clear_table (gpointer key, gpointer value, gpointer user_data)
@@ -61,6 +62,7 @@ qof_class_init(void)
 
     classTable = g_hash_table_new (g_str_hash, g_str_equal);
     sortTable = g_hash_table_new (g_str_hash, g_str_equal);
+    threadSafeTable = g_hash_table_new (g_direct_hash, g_direct_equal);
 }
 
 void
@@ -72,6 +74,7 @@ qof_class_shutdown (void)
     g_hash_table_foreach_remove (classTable, clear_table, NULL);
     g_hash_table_destroy (classTable);
     g_hash_table_destroy (sortTable);
+    g_hash_table_destroy (threadSafeTable);
 }
 
 QofSortFunc
@@ -124,6 +127,35 @@ qof_class_register (QofIdTypeConst obj_name,
     }
 }
 
+void
+qof_class_register_thread_safe (QofIdTypeConst obj_name,
+                                const char * const *param_names)
+{
+    int i;
+
+    if (!obj_name || !param_names) return;
+    if (!check_init()) return;
+
+    for (i = 0; param_names[i]; i++)
+    {
+        const QofParam *prm = qof_class_get_parameter (obj_name,
+                                                       param_names[i]);
+        if (!prm)
+        {
+            PWARN ("no parameter %s in %s", param_names[i], obj_name);
+            continue;
+        }
+        g_hash_table_add (threadSafeTable, (gpointer)prm);
+    }
+}
+
+gboolean
+qof_class_param_is_thread_safe (const QofParam *param)
+{
+    if (!param || !initialized) return FALSE;
+    return g_hash_table_contains (threadSafeTable, param);
+}
+
 gboolean
 qof_class_is_registered (QofIdTypeConst obj_name)
 {
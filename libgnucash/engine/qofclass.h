@@ -146,6 +146,10 @@ typedef struct _QofParam QofParam;
  * identify the expected getter_func return type at runtime.  It
  * also provides a place for the user to hang additional user-defined
  * data.
+ *
+ * A parallel query (see qof_query_set_parallel()) calls the getters of
+ * its terms from several threads at once, but only if every one of them
+ * was registered with qof_class_register_thread_safe().
  */
 typedef gpointer (*QofAccessFunc)(gpointer object, /*@ null @*/ const QofParam *param);
 
@@ -251,6 +255,22 @@ QofAccessFunc qof_class_get_parameter_getter (QofIdTypeConst obj_name,
 QofSetterFunc qof_class_get_parameter_setter (QofIdTypeConst obj_name,
         const char *parameter);
 
+/** Mark parameters of obj_name as safe to get from several threads at
+ *  once, which lets queries on them run in parallel.  Their getters must
+ *  only read the object: no begin/commit edits, no events, no string
+ *  cache and no lazily filled caches unless these are locked.  Returning
+ *  newly allocated data is fine.
+ *
+ *  The "param_names" argument must be a NULL-terminated array of names
+ *  registered with qof_class_register() before.
+ */
+void qof_class_register_thread_safe (QofIdTypeConst obj_name,
+                                     const char * const *param_names);
+
+/** Return TRUE if param was registered with
+ *  qof_class_register_thread_safe(). */
+gboolean qof_class_param_is_thread_safe (const QofParam *param);
+
 /** Type definition for the class callback function. */
 typedef void (*QofClassForeachCB) (QofIdTypeConst, gpointer);
 
@@ -34,6 +34,13 @@ typedef struct
     gpointer user_data;
 
     gint handler_id;
+
+    /* Filters set by qof_event_set_handler_filter: the wanted events and
+     * a NULL-terminated array of the wanted entity types, or NULL. */
+    QofEventId event_mask;
+    gchar **types;
+    /* Whether coalesced events are delivered as one call with a mask. */
+    gboolean batch;
 } HandlerInfo;
 
 /* generates an event even when events are suspended! */
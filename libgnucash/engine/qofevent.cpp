@@ -28,15 +28,31 @@ extern "C"
 #include <glib.h>
 }
 
+#include <unordered_map>
+#include <vector>
+
 #include "qof.h"
 #include "qofevent-p.h"
 
+/* The events of a batch, one entry per entity, in the order the entities
+ * first generated one, with the entity's event ids in the order they
+ * were first generated. The queue holds a reference to each entity. */
+struct QueuedEvents
+{
+    QofInstance *entity;
+    QofEventId events;
+    std::vector<QofEventId> ids;
+};
+
 /* Static Variables ************************************************/
 static guint   suspend_counter   = 0;
 static gint    next_handler_id   = 1;
 static guint   handler_run_level = 0;
 static guint   pending_deletes   = 0;
 static GList   *handlers  =   NULL;
+static guint   batch_level       = 0;
+static std::vector<QueuedEvents> queued_events;
+static std::unordered_map<QofInstance*, std::size_t> queued_index;
 
 /* This static indicates the debugging module that this .o belongs to.  */
 static QofLogModule log_module = QOF_MOD_ENGINE;
@@ -72,8 +88,8 @@ find_next_handler_id(void)
     return handler_id;
 }
 
-gint
-qof_event_register_handler (QofEventHandler handler, gpointer user_data)
+static gint
+register_handler (QofEventHandler handler, gpointer user_data, gboolean batch)
 {
     HandlerInfo *hi;
     gint handler_id;
@@ -96,12 +112,71 @@ qof_event_register_handler (QofEventHandler handler, gpointer user_data)
     hi->handler = handler;
     hi->user_data = user_data;
     hi->handler_id = handler_id;
+    hi->event_mask = ~QOF_EVENT_NONE;
+    hi->batch = batch;
 
     handlers = g_list_prepend (handlers, hi);
     LEAVE ("(handler=%p, data=%p) handler_id=%d", handler, user_data, handler_id);
     return handler_id;
 }
 
+gint
+qof_event_register_handler (QofEventHandler handler, gpointer user_data)
+{
+    return register_handler (handler, user_data, FALSE);
+}
+
+gint
+qof_event_register_batch_handler (QofEventHandler handler, gpointer user_data)
+{
+    return register_handler (handler, user_data, TRUE);
+}
+
+static HandlerInfo *
+find_handler (gint handler_id)
+{
+    for (GList *node = handlers; node; node = node->next)
+    {
+        HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        if (hi->handler_id == handler_id)
+            return hi;
+    }
+    return NULL;
+}
+
+static void
+free_handler (HandlerInfo *hi)
+{
+    g_strfreev (hi->types);
+    g_free (hi);
+}
+
+void
+qof_event_set_handler_filter (gint handler_id, const QofIdType *types,
+                              QofEventId event_mask)
+{
+    HandlerInfo *hi = find_handler (handler_id);
+    guint count = 0;
+
+    if (!hi)
+    {
+        PERR ("no such handler: %d", handler_id);
+        return;
+    }
+
+    g_strfreev (hi->types);
+    hi->types = NULL;
+    if (types)
+    {
+        while (types[count])
+            count++;
+        hi->types = g_new0 (gchar*, count + 1);
+        for (guint i = 0; i < count; i++)
+            hi->types[i] = g_strdup (types[i]);
+    }
+    hi->event_mask = event_mask ? event_mask : ~QOF_EVENT_NONE;
+}
+
 void
 qof_event_unregister_handler (gint handler_id)
 {
@@ -131,7 +206,7 @@ qof_event_unregister_handler (gint handler_id)
         {
             handlers = g_list_remove_link (handlers, node);
             g_list_free_1 (node);
-            g_free (hi);
+            free_handler (hi);
         }
         else
         {
@@ -167,16 +242,38 @@ qof_event_resume (void)
     suspend_counter--;
 }
 
+/* The part of events which hi wants from entity. */
+static QofEventId
+handler_events (const HandlerInfo *hi, const QofInstance *entity,
+                QofEventId events)
+{
+    events &= hi->event_mask;
+    if (!events || !hi->types)
+        return events;
+
+    for (gchar **type = hi->types; *type; type++)
+        if (g_strcmp0 (*type, entity->e_type) == 0)
+            return events;
+    return QOF_EVENT_NONE;
+}
+
+/* Deliver the n_ids event ids in ids, more than one when they're
+ * coalesced. Batch handlers get them or'ed together, others one at a
+ * time in the order of ids. */
 static void
-qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
-                             gpointer event_data)
+qof_event_generate_internal (QofInstance *entity, const QofEventId *ids,
+                             std::size_t n_ids, gpointer event_data)
 {
     GList *node;
     GList *next_node = NULL;
+    QofEventId events = QOF_EVENT_NONE;
 
     g_return_if_fail(entity);
 
-    switch (event_id)
+    for (std::size_t i = 0; i < n_ids; i++)
+        events |= ids[i];
+
+    switch (events)
     {
     case QOF_EVENT_NONE:
     {
@@ -189,14 +286,31 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
     for (node = handlers; node; node = next_node)
     {
         HandlerInfo *hi = static_cast<HandlerInfo*>(node->data);
+        QofEventId wanted;
 
         next_node = node->next;
-        if (hi->handler)
+        if (!hi->handler)
+            continue;
+        wanted = handler_events (hi, entity, events);
+        if (!wanted)
+            continue;
+
+        PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
+              hi->handler, event_data);
+        if (hi->batch)
         {
-            PINFO("id=%d hi=%p han=%p data=%p", hi->handler_id, hi,
-                  hi->handler, event_data);
-            hi->handler (entity, event_id, hi->user_data, event_data);
+            hi->handler (entity, wanted, hi->user_data, event_data);
+            continue;
         }
+        /* Other handlers expect a single event id at a time. */
+        for (std::size_t i = 0; i < n_ids; i++)
+            for (guint bit = 1; (ids[i] & wanted) && hi->handler; bit <<= 1)
+            {
+                if (!(ids[i] & wanted & bit))
+                    continue;
+                wanted &= ~bit;
+                hi->handler (entity, bit, hi->user_data, event_data);
+            }
     }
     handler_run_level--;
 
@@ -214,7 +328,7 @@ qof_event_generate_internal (QofInstance *entity, QofEventId event_id,
                 /* remove this node from the list, then free this node */
                 handlers = g_list_remove_link (handlers, node);
                 g_list_free_1 (node);
-                g_free (hi);
+                free_handler (hi);
             }
         }
         pending_deletes = 0;
@@ -227,7 +341,23 @@ qof_event_force (QofInstance *entity, QofEventId event_id, gpointer event_data)
     if (!entity)
         return;
 
-    qof_event_generate_internal (entity, event_id, event_data);
+    qof_event_generate_internal (entity, &event_id, 1, event_data);
+}
+
+/* Take entity's events out of the queue and deliver them now. */
+static void
+deliver_queued (QofInstance *entity)
+{
+    auto found = queued_index.find (entity);
+    std::vector<QofEventId> ids;
+
+    if (found == queued_index.end ())
+        return;
+    ids.swap (queued_events[found->second].ids);
+    queued_events[found->second].entity = NULL;
+    queued_index.erase (found);
+    qof_event_generate_internal (entity, ids.data (), ids.size (), NULL);
+    g_object_unref (entity);
 }
 
 void
@@ -239,7 +369,72 @@ qof_event_gen (QofInstance *entity, QofEventId event_id, gpointer event_data)
     if (suspend_counter)
         return;
 
-    qof_event_generate_internal (entity, event_id, event_data);
+    /* Listeners have been told that the whole book is going; they don't
+     * need to hear about each of its objects as well. */
+    if (qof_book_shutting_down (qof_instance_get_book (entity)))
+        return;
+
+    if (batch_level && event_id != QOF_EVENT_NONE)
+    {
+        if (event_id == QOF_EVENT_DESTROY)
+            deliver_queued (entity);
+        else if (!event_data)
+        {
+            auto found = queued_index.find (entity);
+            if (found != queued_index.end ())
+            {
+                auto& queued = queued_events[found->second];
+                if (event_id & ~queued.events)
+                    queued.ids.push_back (event_id & ~queued.events);
+                queued.events |= event_id;
+            }
+            else
+            {
+                queued_index.emplace (entity, queued_events.size ());
+                queued_events.push_back ({entity, event_id, {event_id}});
+                g_object_ref (entity);
+            }
+            return;
+        }
+    }
+
+    qof_event_generate_internal (entity, &event_id, 1, event_data);
+}
+
+void
+qof_event_begin_batch (void)
+{
+    batch_level++;
+}
+
+void
+qof_event_end_batch (void)
+{
+    std::vector<QueuedEvents> events;
+
+    if (batch_level == 0)
+    {
+        PERR ("batch level underflow");
+        return;
+    }
+    if (--batch_level)
+        return;
+
+    /* Handlers may generate events of their own, which are delivered
+     * straight away now the batch is over. */
+    events.swap (queued_events);
+    queued_index.clear ();
+    for (auto& queued : events)
+    {
+        if (!queued.entity)
+            continue;
+        /* An entity that was disposed while queued, like a split freed
+         * without an event, has nothing left to tell the handlers. */
+        if (queued.entity->e_type)
+            qof_event_generate_internal (queued.entity, queued.ids.data (),
+                                         queued.ids.size (), NULL);
+        g_object_unref (queued.entity);
+    }
 }
 
 /* =========================== END OF FILE ======================= */
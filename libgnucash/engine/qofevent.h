@@ -104,6 +104,35 @@ gint qof_event_register_handler (QofEventHandler handler, gpointer handler_data)
  */
 void qof_event_unregister_handler (gint handler_id);
 
+/** \brief Register a handler for coalesced events.
+ *
+ * Inside a batch (see qof_event_begin_batch()) the handler is called once
+ * for each entity that generated events, with event_type the bitwise OR of
+ * all of them; ordinary handlers get a separate call for each kind. Outside
+ * a batch the two kinds of handler are called alike.
+ *
+ * @param handler:   handler to register
+ * @param handler_data: data provided when handler is invoked
+ *
+ * @return id identifying handler
+ */
+gint qof_event_register_batch_handler (QofEventHandler handler,
+                                       gpointer handler_data);
+
+/** \brief Restrict the events passed to a handler.
+ *
+ * A handler which only cares about a few kinds of entity or event can
+ * say so, and it won't be called at all for the others.
+ *
+ * @param handler_id: the id of the handler
+ * @param types: a NULL-terminated array of the entity types whose events
+ * the handler wants, or NULL for all types. The array is copied.
+ * @param event_mask: the events the handler wants, or QOF_EVENT_NONE for
+ * all of them.
+ */
+void qof_event_set_handler_filter (gint handler_id, const QofIdType *types,
+                                   QofEventId event_mask);
+
 /** \brief Invoke all registered event handlers using the given arguments.
 
    Certain default events are used by QOF:
@@ -117,6 +146,9 @@ void qof_event_unregister_handler (gint handler_id);
 
    Any other events are entirely the concern of the application.
 
+   Events of objects whose book is being destroyed are dropped, see
+   qof_book_shutting_down().
+
  \note QofEventHandler routines do \b NOT support generating
  events from a GncGUID and QofIdType - you must specify a genuine QofInstance.
 
@@ -139,6 +171,27 @@ void qof_event_suspend (void);
 /** Resume engine event generation. */
 void qof_event_resume (void);
 
+/** \brief Start a batch of events.
+ *
+ *   Until the matching qof_event_end_batch(), events without event_data
+ *   are queued instead of being delivered, and repeats of an event from
+ *   the same entity are merged, so that a bulk operation like an import
+ *   produces one QOF_EVENT_MODIFY per account instead of one per split.
+ *   Events carrying event_data, which may point at the caller's stack,
+ *   are still delivered at once, and so is QOF_EVENT_DESTROY, after the
+ *   entity's queued events. Handlers registered without
+ *   qof_event_register_batch_handler() get an entity's merged events one
+ *   at a time, in the order they were first generated.
+ *
+ *   Batches may be nested; the queue is delivered when the outermost one
+ *   ends.
+ */
+void qof_event_begin_batch (void);
+
+/** End a batch of events, delivering the queued ones if it's the
+ *  outermost. */
+void qof_event_end_batch (void);
+
 #ifdef __cplusplus
 }
 #endif
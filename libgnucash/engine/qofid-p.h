@@ -51,6 +51,10 @@ void qof_collection_mark_clean (QofCollection *);
 void qof_collection_mark_dirty (QofCollection *);
 void qof_collection_print_dirty (const QofCollection *col, gpointer dummy);
 
+/** Increment the collection's change counter; called by QofInstance
+ *  along with qof_book_bump_generation(). */
+void qof_collection_bump_generation (QofCollection *);
+
 /* @} */
 /* @} */
 /* @} */
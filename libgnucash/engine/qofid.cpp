@@ -29,30 +29,139 @@ extern "C"
 #include <glib.h>
 }
 
+#include <vector>
+
 #include "qof.h"
+#include "guid-map.hpp"
 #include "qofid-p.h"
 #include "qofinstance-p.h"
 
 static QofLogModule log_module = QOF_MOD_ENGINE;
 
+/* The entities are kept in a dense array in insertion order, and the map
+ * takes each entity's GncGUID to its position in the array.
+ * Removing an entity leaves a NULL tombstone in its slot so that the
+ * positions of the others, and any iteration in progress, aren't
+ * disturbed; the tombstones are squeezed out once they make up half the
+ * array and nobody is iterating.
+ */
 struct QofCollection_s
 {
     QofIdType    e_type;
     gboolean     is_dirty;
 
-    GHashTable * hash_of_entities;
+    GncGUIDMap<std::size_t> hash_of_entities;
+    std::vector<QofInstance*> entities;
+    guint        tombstones;
+    gsize        instance_bytes;  /* size of the live entities' structs */
+    guint64      generation;      /* see qof_collection_get_generation */
+    GType        sized_type;      /* the type instance_size is for */
+    gsize        instance_size;
+    mutable guint iterators;  /* iterations in progress */
     gpointer     data;       /* place where object class can hang arbitrary data */
 };
 
+/* Don't bother compacting small collections. */
+#define MIN_TOMBSTONES_TO_COMPACT 32
+
+/* The memory GObject allocated for the entity: its instance struct and
+ * the private structs of it and its parent types, which sit in front.
+ * The entities of a collection share one type, so it's only looked up
+ * when the type changes. */
+static gsize
+instance_size (QofCollection *col, QofInstance *ent)
+{
+    GTypeQuery query;
+    gpointer klass = G_OBJECT_GET_CLASS (ent);
+
+    if (G_TYPE_FROM_CLASS (klass) == col->sized_type)
+        return col->instance_size;
+
+    g_type_query (G_TYPE_FROM_CLASS (klass), &query);
+    /* The private offset is negative, the private data being in front. */
+    col->sized_type = G_TYPE_FROM_CLASS (klass);
+    col->instance_size = query.instance_size -
+        (gssize) g_type_class_get_instance_private_offset (klass);
+    return col->instance_size;
+}
+
+static void
+collection_append (QofCollection *col, QofInstance *ent)
+{
+    const GncGUID *guid = qof_instance_get_guid(ent);
+    col->hash_of_entities.insert_or_assign (*guid, col->entities.size());
+    col->entities.push_back (ent);
+    col->instance_bytes += instance_size (col, ent);
+}
+
+static void
+collection_compact (QofCollection *col)
+{
+    std::size_t live = 0;
+
+    if (col->iterators)
+        return;
+
+    /* A tombstone at the end can simply be dropped. */
+    while (!col->entities.empty() && col->entities.back() == NULL)
+    {
+        col->entities.pop_back();
+        col->tombstones--;
+    }
+    if (col->tombstones < MIN_TOMBSTONES_TO_COMPACT ||
+        col->tombstones < col->entities.size() / 2)
+        return;
+
+    /* Slide the live entities down, keeping their order. */
+    for (std::size_t slot = 0; slot < col->entities.size(); slot++)
+    {
+        QofInstance *ent = col->entities[slot];
+        if (!ent)
+            continue;
+        if (slot != live)
+        {
+            col->entities[live] = ent;
+            col->hash_of_entities.insert_or_assign (*qof_instance_get_guid(ent),
+                                                    live);
+        }
+        live++;
+    }
+    col->entities.resize (live);
+    col->entities.shrink_to_fit ();
+    col->tombstones = 0;
+}
+
+static void
+collection_remove (QofCollection *col, const GncGUID *guid)
+{
+    auto found = col->hash_of_entities.find (*guid);
+    std::size_t slot;
+
+    if (!found)
+        return;
+    slot = *found;
+    col->hash_of_entities.erase (*guid);
+    col->instance_bytes -= instance_size (col, col->entities[slot]);
+    col->entities[slot] = NULL;
+    col->tombstones++;
+    collection_compact (col);
+}
+
 /* =============================================================== */
 
 QofCollection *
 qof_collection_new (QofIdType type)
 {
     QofCollection *col;
-    col = g_new0(QofCollection, 1);
+    col = new QofCollection_s;
     col->e_type = static_cast<QofIdType>(CACHE_INSERT (type));
-    col->hash_of_entities = guid_hash_table_new();
+    col->is_dirty = FALSE;
+    col->tombstones = 0;
+    col->instance_bytes = 0;
+    col->generation = 0;
+    col->sized_type = G_TYPE_INVALID;
+    col->instance_size = 0;
+    col->iterators = 0;
     col->data = NULL;
     return col;
 }
@@ -61,11 +170,9 @@ void
 qof_collection_destroy (QofCollection *col)
 {
     CACHE_REMOVE (col->e_type);
-    g_hash_table_destroy(col->hash_of_entities);
     col->e_type = NULL;
-    col->hash_of_entities = NULL;
     col->data = NULL;   /** XXX there should be a destroy notifier for this */
-    g_free (col);
+    delete col;
 }
 
 /* =============================================================== */
@@ -89,7 +196,7 @@ qof_collection_remove_entity (QofInstance *ent)
     col = qof_instance_get_collection(ent);
     if (!col) return;
     guid = qof_instance_get_guid(ent);
-    g_hash_table_remove (col->hash_of_entities, guid);
+    collection_remove (col, guid);
     qof_instance_set_collection(ent, NULL);
 }
 
@@ -103,7 +210,7 @@ qof_collection_insert_entity (QofCollection *col, QofInstance *ent)
     if (guid_equal(guid, guid_null())) return;
     g_return_if_fail (col->e_type == ent->e_type);
     qof_collection_remove_entity (ent);
-    g_hash_table_insert (col->hash_of_entities, (gpointer)guid, ent);
+    collection_append (col, ent);
     qof_instance_set_collection(ent, col);
 }
 
@@ -129,7 +236,7 @@ qof_collection_add_entity (QofCollection *coll, QofInstance *ent)
     {
         return FALSE;
     }
-    g_hash_table_insert (coll->hash_of_entities, (gpointer)guid, ent);
+    collection_append (coll, ent);
     return TRUE;
 }
 
@@ -213,12 +320,11 @@ qof_collection_compare (QofCollection *target, QofCollection *merge)
 QofInstance *
 qof_collection_lookup_entity (const QofCollection *col, const GncGUID * guid)
 {
-    QofInstance *ent;
+    const std::size_t *slot;
     g_return_val_if_fail (col, NULL);
     if (guid == NULL) return NULL;
-    ent = static_cast<QofInstance*>(g_hash_table_lookup (col->hash_of_entities,
-							 guid));
-    return ent;
+    slot = col->hash_of_entities.find (*guid);
+    return slot ? col->entities[*slot] : NULL;
 }
 
 QofCollection *
@@ -246,10 +352,17 @@ qof_collection_count (const QofCollection *col)
 {
     guint c;
 
-    c = g_hash_table_size(col->hash_of_entities);
+    c = col->hash_of_entities.size();
     return c;
 }
 
+gsize
+qof_collection_get_instance_memory (const QofCollection *col)
+{
+    g_return_val_if_fail (col, 0);
+    return col->instance_bytes;
+}
+
 /* =============================================================== */
 
 gboolean
@@ -276,6 +389,19 @@ qof_collection_mark_dirty (QofCollection *col)
     }
 }
 
+guint64
+qof_collection_get_generation (const QofCollection *col)
+{
+    return col ? col->generation : 0;
+}
+
+void
+qof_collection_bump_generation (QofCollection *col)
+{
+    if (col)
+        col->generation++;
+}
+
 void
 qof_collection_print_dirty (const QofCollection *col, gpointer dummy)
 {
@@ -303,40 +429,68 @@ qof_collection_set_data (QofCollection *col, gpointer user_data)
 
 /* =============================================================== */
 
-struct _iterate
+void
+qof_collection_iter_init (QofCollectionIter *iter, const QofCollection *col)
 {
-    QofInstanceForeachCB      fcn;
-    gpointer                data;
-};
+    g_return_if_fail (iter);
+    iter->col = col;
+    iter->pos = 0;
+    iter->end = col ? col->entities.size() : 0;
+    if (col)
+        col->iterators++;
+}
 
-static void
-foreach_cb (gpointer item, gpointer arg)
+QofInstance *
+qof_collection_iter_next (QofCollectionIter *iter)
 {
-    struct _iterate *iter = static_cast<_iterate*>(arg);
-    QofInstance *ent = static_cast<QofInstance*>(item);
+    g_return_val_if_fail (iter, NULL);
+    if (!iter->col)
+        return NULL;
 
-    iter->fcn (ent, iter->data);
+    /* Entities added since the iteration started lie beyond iter->end. */
+    while (iter->pos < iter->end)
+    {
+        QofInstance *ent = iter->col->entities[iter->pos++];
+        if (ent)
+            return ent;
+    }
+    qof_collection_iter_finish (iter);
+    return NULL;
+}
+
+void
+qof_collection_iter_finish (QofCollectionIter *iter)
+{
+    QofCollection *col;
+
+    g_return_if_fail (iter);
+    if (!iter->col)
+        return;
+
+    /* Compaction was held off while iterating; the collection itself
+     * isn't const to its owner. */
+    col = const_cast<QofCollection*>(iter->col);
+    iter->col = NULL;
+    if (--col->iterators == 0)
+        collection_compact (col);
 }
 
 void
 qof_collection_foreach (const QofCollection *col, QofInstanceForeachCB cb_func,
                         gpointer user_data)
 {
-    struct _iterate iter;
-    GList *entries;
+    QofCollectionIter iter;
+    QofInstance *ent;
 
     g_return_if_fail (col);
     g_return_if_fail (cb_func);
 
-    iter.fcn = cb_func;
-    iter.data = user_data;
-
-    PINFO("Hash Table size of %s before is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s before is %d", col->e_type, col->hash_of_entities.size());
 
-    entries = g_hash_table_get_values (col->hash_of_entities);
-    g_list_foreach (entries, foreach_cb, &iter);
-    g_list_free (entries);
+    qof_collection_iter_init (&iter, col);
+    while ((ent = qof_collection_iter_next (&iter)))
+        cb_func (ent, user_data);
 
-    PINFO("Hash Table size of %s after is %d", col->e_type, g_hash_table_size(col->hash_of_entities));
+    PINFO("Hash Table size of %s after is %d", col->e_type, col->hash_of_entities.size());
 }
 /* =============================================================== */
@@ -154,6 +154,11 @@ QofCollection * qof_collection_new (QofIdType type);
 /** return the number of entities in the collection. */
 guint qof_collection_count (const QofCollection *col);
 
+/** Return the number of bytes taken by the structs of the entities in the
+ *  collection, including their GObject private data. The strings, lists
+ *  and kvp frames they point to aren't counted. */
+gsize qof_collection_get_instance_memory (const QofCollection *col);
+
 /** destroy the collection */
 void qof_collection_destroy (QofCollection *col);
 
@@ -167,10 +172,48 @@ QofInstance * qof_collection_lookup_entity (const QofCollection *, const GncGUID
 /** Callback type for qof_collection_foreach */
 typedef void (*QofInstanceForeachCB) (QofInstance *, gpointer user_data);
 
-/** Call the callback for each entity in the collection. */
+/** Call the callback for each entity in the collection, in the order
+ *  they were added. The callback may add or remove entities: entities
+ *  removed before their turn are skipped and entities added are not
+ *  visited. */
 void qof_collection_foreach (const QofCollection *, QofInstanceForeachCB,
                              gpointer user_data);
 
+/** An iterator over the entities in a collection, for walking it without
+ *  a callback. It lives on the stack and allocates nothing.
+ *
+ *  @code
+ *  QofCollectionIter iter;
+ *  QofInstance *inst;
+ *  qof_collection_iter_init (&iter, col);
+ *  while ((inst = qof_collection_iter_next (&iter)))
+ *      ...
+ *  @endcode
+ *
+ *  Iteration follows the same rules as qof_collection_foreach(). While an
+ *  iterator is open the collection defers reclaiming the slots of removed
+ *  entities, so an iterator abandoned before qof_collection_iter_next()
+ *  returns NULL must be closed with qof_collection_iter_finish().
+ *  C++ code should use QofCollectionRange from qofid.hpp instead.
+ */
+typedef struct
+{
+    const QofCollection *col;
+    gsize pos;
+    gsize end;
+} QofCollectionIter;
+
+/** Start iterating over col. */
+void qof_collection_iter_init (QofCollectionIter *iter,
+                               const QofCollection *col);
+
+/** @return the next entity, or NULL when there are no more, in which
+ *  case the iterator is finished. */
+QofInstance * qof_collection_iter_next (QofCollectionIter *iter);
+
+/** Close an iterator early. Harmless on a finished iterator. */
+void qof_collection_iter_finish (QofCollectionIter *iter);
+
 /** Store and retrieve arbitrary object-defined data
  *
  * XXX We need to add a callback for when the collection is being
@@ -183,6 +226,12 @@ void qof_collection_set_data (QofCollection *col, gpointer user_data);
 /** Return value of 'dirty' flag on collection */
 gboolean qof_collection_is_dirty (const QofCollection *col);
 
+/** Return the collection's change counter. Like the book's, see
+ *  qof_book_get_generation(), but it only counts the changes to the
+ *  collection's own entities.
+ */
+guint64 qof_collection_get_generation (const QofCollection *col);
+
 /** @name QOF_TYPE_COLLECT: Linking one entity to many of one type
 
 \note These are \b NOT the same as the main collections in the book.
@@ -0,0 +1,96 @@
+/********************************************************************\
+ * qofid.hpp -- C++ access to QOF entity collections                *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+/** @addtogroup Entity
+    @{ */
+/** @file qofid.hpp
+    @brief Range-based iteration over a QofCollection.
+*/
+
+#ifndef QOF_ID_HPP
+#define QOF_ID_HPP
+
+#include <iterator>
+
+extern "C"
+{
+#include "qofid.h"
+}
+
+/** The entities of a collection as a range, for use in range-based for
+ *  loops:
+ *
+ *  @code
+ *  for (auto inst : QofCollectionRange (col))
+ *      ...
+ *  @endcode
+ *
+ *  It wraps a QofCollectionIter, so it allocates nothing and follows the
+ *  same rules about entities added or removed along the way. The range
+ *  can be iterated only once and closes the underlying iterator when it
+ *  is destroyed.
+ */
+class QofCollectionRange
+{
+public:
+    class iterator : public std::iterator<std::input_iterator_tag, QofInstance*>
+    {
+    public:
+        iterator () = default;
+        QofInstance* operator* () const noexcept { return m_inst; }
+        iterator& operator++ () noexcept
+        {
+            m_inst = qof_collection_iter_next (m_iter);
+            return *this;
+        }
+        bool operator== (const iterator& other) const noexcept
+        {
+            return m_inst == other.m_inst;
+        }
+        bool operator!= (const iterator& other) const noexcept
+        {
+            return m_inst != other.m_inst;
+        }
+    private:
+        friend class QofCollectionRange;
+        explicit iterator (QofCollectionIter* iter) noexcept :
+            m_iter{iter}, m_inst{qof_collection_iter_next (iter)} {}
+        QofCollectionIter* m_iter = nullptr;
+        QofInstance* m_inst = nullptr;
+    };
+
+    explicit QofCollectionRange (const QofCollection* col) noexcept
+    {
+        qof_collection_iter_init (&m_iter, col);
+    }
+    QofCollectionRange (const QofCollectionRange&) = delete;
+    QofCollectionRange& operator= (const QofCollectionRange&) = delete;
+    ~QofCollectionRange () { qof_collection_iter_finish (&m_iter); }
+
+    iterator begin () noexcept { return iterator{&m_iter}; }
+    iterator end () noexcept { return iterator{}; }
+
+private:
+    QofCollectionIter m_iter;
+};
+
+#endif /* QOF_ID_HPP */
+/** @} */
@@ -71,6 +71,9 @@ void qof_instance_copy_guid (gpointer to, gconstpointer from);
 /** Return the pointer to the kvp_data */
 /*@ dependent @*/
 KvpFrame* qof_instance_get_slots (const QofInstance *);
+/** Tell the instance that the frame qof_instance_get_slots returned was
+ *  changed directly, so that it drops the values it caches from it. */
+void qof_instance_slots_changed (QofInstance *);
 void qof_instance_set_editlevel(gpointer inst, gint level);
 void qof_instance_increase_editlevel (gpointer ptr);
 void qof_instance_decrease_editlevel (gpointer ptr);
@@ -165,6 +168,13 @@ void qof_instance_get_path_kvp (QofInstance *, GValue *, std::vector<std::string
 
 void qof_instance_set_path_kvp (QofInstance *, GValue const *, std::vector<std::string> const &);
 
+/** Versions of qof_instance_get_path_kvp and qof_instance_set_path_kvp with
+ * a precompiled path, see KvpPath.
+ */
+void qof_instance_get_path_kvp (QofInstance *, GValue *, KvpPath const &);
+
+void qof_instance_set_path_kvp (QofInstance *, GValue const *, KvpPath const &);
+
 bool qof_instance_has_path_slot (QofInstance const *, std::vector<std::string> const &);
 
 void qof_instance_slot_path_delete (QofInstance const *, std::vector<std::string> const &);
@@ -139,6 +139,7 @@ static void qof_instance_class_init(QofInstanceClass *klass)
     klass->get_display_name = NULL;
     klass->refers_to_object = NULL;
     klass->get_typed_referring_object_list = NULL;
+    klass->kvp_changed = NULL;
 
     g_object_class_install_property
     (object_class,
@@ -269,6 +270,15 @@ qof_instance_init (QofInstance *inst)
     priv->infant = TRUE;
 }
 
+/* Note a change of the instance in its book's and collection's change
+ * counters. */
+static void
+bump_generation (QofInstancePrivate *priv)
+{
+    qof_book_bump_generation (priv->book);
+    qof_collection_bump_generation (priv->collection);
+}
+
 void
 qof_instance_init_data (QofInstance *inst, QofIdType type, QofBook *book)
 {
@@ -310,6 +320,7 @@ qof_instance_init_data (QofInstance *inst, QofIdType type, QofBook *book)
     priv->collection = col;
 
     qof_collection_insert_entity (col, inst);
+    bump_generation (priv);
 }
 
 static void
@@ -321,6 +332,7 @@ qof_instance_dispose (GObject *instp)
     priv = GET_PRIVATE(instp);
     if (!priv->collection)
         return;
+    bump_generation (priv);
     qof_collection_remove_entity(inst);
 
     CACHE_REMOVE(inst->e_type);
@@ -569,6 +581,15 @@ qof_instance_books_equal (gconstpointer ptr1, gconstpointer ptr2)
     return (priv1->book == priv2->book);
 }
 
+/* Tell the instance's class that its kvp frame has changed. */
+static void
+kvp_changed (const QofInstance *inst)
+{
+    auto klass = QOF_INSTANCE_GET_CLASS (inst);
+    if (klass->kvp_changed)
+        klass->kvp_changed (const_cast<QofInstance*>(inst));
+}
+
 /* Watch out: This function is still used (as a "friend") in src/import-export/aqb/gnc-ab-kvp.c */
 KvpFrame*
 qof_instance_get_slots (const QofInstance *inst)
@@ -577,6 +598,13 @@ qof_instance_get_slots (const QofInstance *inst)
     return inst->kvp_data;
 }
 
+void
+qof_instance_slots_changed (QofInstance *inst)
+{
+    if (!inst) return;
+    kvp_changed (inst);
+}
+
 void
 qof_instance_set_slots (QofInstance *inst, KvpFrame *frm)
 {
@@ -592,6 +620,7 @@ qof_instance_set_slots (QofInstance *inst, KvpFrame *frm)
 
     priv->dirty = TRUE;
     inst->kvp_data = frm;
+    kvp_changed (inst);
 }
 
 void
@@ -713,6 +742,7 @@ qof_instance_set_dirty(QofInstance* inst)
 
     priv = GET_PRIVATE(inst);
     priv->dirty = TRUE;
+    bump_generation (priv);
 }
 
 gboolean
@@ -980,6 +1010,7 @@ gboolean qof_commit_edit (QofInstance *inst)
     priv->editlevel--;
     if (0 < priv->editlevel) return FALSE;
 
+    bump_generation (priv);
     if (0 > priv->editlevel)
     {
         PERR ("unbalanced call - resetting (was %d)", priv->editlevel);
@@ -1056,23 +1087,51 @@ qof_instance_has_kvp (QofInstance *inst)
 void qof_instance_set_path_kvp (QofInstance * inst, GValue const * value, std::vector<std::string> const & path)
 {
     delete inst->kvp_data->set_path (path, kvp_value_from_gvalue (value));
+    kvp_changed (inst);
+}
+
+void qof_instance_set_path_kvp (QofInstance * inst, GValue const * value, KvpPath const & path)
+{
+    delete inst->kvp_data->set_path (path, kvp_value_from_gvalue (value));
+    kvp_changed (inst);
+}
+
+/* The varargs functions pass their keys straight to the frame, no
+ * std::string is made for them. */
+#define KVP_VA_KEYS 8
+
+static char const * const *
+va_keys (char const ** local, std::vector<char const *> & more,
+         unsigned count, va_list args)
+{
+    auto keys = local;
+    if (count > KVP_VA_KEYS)
+    {
+        more.resize (count);
+        keys = more.data ();
+    }
+    for (unsigned i{0}; i < count; ++i)
+        keys[i] = va_arg (args, char const *);
+    return keys;
 }
 
 void
 qof_instance_set_kvp (QofInstance * inst, GValue const * value, unsigned count, ...)
 {
-    std::vector<std::string> path;
+    char const * local[KVP_VA_KEYS];
+    std::vector<char const *> more;
     va_list args;
     va_start (args, count);
-    for (unsigned i{0}; i < count; ++i)
-        path.push_back (va_arg (args, char const *));
+    auto keys = va_keys (local, more, count, args);
     va_end (args);
-    delete inst->kvp_data->set_path (path, kvp_value_from_gvalue (value));
+    delete inst->kvp_data->set_path (keys, count, kvp_value_from_gvalue (value));
+    kvp_changed (inst);
 }
 
-void qof_instance_get_path_kvp (QofInstance * inst, GValue * value, std::vector<std::string> const & path)
+static void
+get_kvp_value (KvpValue const * kval, GValue * value)
 {
-    auto temp = gvalue_from_kvp_value (inst->kvp_data->get_slot (path));
+    auto temp = gvalue_from_kvp_value (kval);
     if (G_IS_VALUE (temp))
     {
         if (G_IS_VALUE (value))
@@ -1083,24 +1142,26 @@ void qof_instance_get_path_kvp (QofInstance * inst, GValue * value, std::vector<
     }
 }
 
+void qof_instance_get_path_kvp (QofInstance * inst, GValue * value, std::vector<std::string> const & path)
+{
+    get_kvp_value (inst->kvp_data->get_slot (path), value);
+}
+
+void qof_instance_get_path_kvp (QofInstance * inst, GValue * value, KvpPath const & path)
+{
+    get_kvp_value (inst->kvp_data->get_slot (path), value);
+}
+
 void
 qof_instance_get_kvp (QofInstance * inst, GValue * value, unsigned count, ...)
 {
-    std::vector<std::string> path;
+    char const * local[KVP_VA_KEYS];
+    std::vector<char const *> more;
     va_list args;
     va_start (args, count);
-    for (unsigned i{0}; i < count; ++i)
-        path.push_back (va_arg (args, char const *));
+    auto keys = va_keys (local, more, count, args);
     va_end (args);
-    auto temp = gvalue_from_kvp_value (inst->kvp_data->get_slot (path));
-    if (G_IS_VALUE (temp))
-    {
-        if (G_IS_VALUE (value))
-            g_value_unset (value);
-        g_value_init (value, G_VALUE_TYPE (temp));
-        g_value_copy (temp, value);
-        gnc_gvalue_free (temp);
-    }
+    get_kvp_value (inst->kvp_data->get_slot (keys, count), value);
 }
 
 void
@@ -1108,12 +1169,15 @@ qof_instance_copy_kvp (QofInstance *to, const QofInstance *from)
 {
     delete to->kvp_data;
     to->kvp_data = new KvpFrame(*from->kvp_data);
+    kvp_changed (to);
 }
 
 void
 qof_instance_swap_kvp (QofInstance *a, QofInstance *b)
 {
     std::swap(a->kvp_data, b->kvp_data);
+    kvp_changed (a);
+    kvp_changed (b);
 }
 
 int
@@ -1141,6 +1205,7 @@ qof_instance_kvp_add_guid (const QofInstance *inst, const char* path,
     container->set({key}, new KvpValue(const_cast<GncGUID*>(guid)));
     container->set({"date"}, new KvpValue(t));
     delete inst->kvp_data->set_path({path}, new KvpValue(container));
+    kvp_changed (inst);
 }
 
 inline static gboolean
@@ -1231,7 +1296,7 @@ qof_instance_kvp_remove_guid (const QofInstance *inst, const char *path,
         PWARN ("Instance KVP on path %s contains the wrong type.", path);
         break;
     }
-    return;
+    kvp_changed (inst);
 }
 
 void
@@ -1270,6 +1335,8 @@ qof_instance_kvp_merge_guids (const QofInstance *target,
         PWARN ("Instance KVP on path %s contains the wrong type.", path);
         break;
     }
+    kvp_changed (target);
+    kvp_changed (donor);
 }
 
 bool qof_instance_has_path_slot (QofInstance const * inst, std::vector<std::string> const & path)
@@ -1286,12 +1353,14 @@ qof_instance_has_slot (const QofInstance *inst, const char *path)
 void qof_instance_slot_path_delete (QofInstance const * inst, std::vector<std::string> const & path)
 {
     delete inst->kvp_data->set (path, nullptr);
+    kvp_changed (inst);
 }
 
 void
 qof_instance_slot_delete (QofInstance const *inst, char const * path)
 {
     delete inst->kvp_data->set ({path}, nullptr);
+    kvp_changed (inst);
 }
 
 void qof_instance_slot_path_delete_if_empty (QofInstance const * inst, std::vector<std::string> const & path)
@@ -1303,6 +1372,7 @@ void qof_instance_slot_path_delete_if_empty (QofInstance const * inst, std::vect
         if (frame && frame->empty())
             delete inst->kvp_data->set (path, nullptr);
     }
+    kvp_changed (inst);
 }
 
 void
@@ -1315,6 +1385,7 @@ qof_instance_slot_delete_if_empty (QofInstance const *inst, char const * path)
         if (frame && frame->empty ())
             delete inst->kvp_data->set ({path}, nullptr);
     }
+    kvp_changed (inst);
 }
 
 std::vector <std::pair <std::string, KvpValue*>>
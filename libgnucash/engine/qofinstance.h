@@ -84,6 +84,10 @@ struct _QofInstanceClass
 
     /* Returns a list of my type of object which refers to an object */
     GList* (*get_typed_referring_object_list)(const QofInstance* inst, const QofInstance* ref);
+
+    /* Called after the object's kvp frame has or may have changed, so that
+     * values cached from it can be dropped. */
+    void (*kvp_changed)(QofInstance* inst);
 };
 
 /** Return the GType of a QofInstance */
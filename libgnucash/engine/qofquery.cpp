@@ -38,6 +38,11 @@ extern "C"
 #include "qofclass-p.h"
 #include "qofquery-p.h"
 #include "qofquerycore-p.h"
+#include "qofqueryindex.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
 
 static QofLogModule log_module = QOF_MOD_QUERY;
 
@@ -103,6 +108,10 @@ struct _QofQuery
      * again until it's really necessary */
     gint              changed;
 
+    /* The number of threads to test objects with, see
+     * qof_query_set_parallel() */
+    gint              parallel;
+
     GList *           results;
 };
 
@@ -111,6 +120,8 @@ typedef struct _QofQueryCB
     QofQuery *        query;
     GList *           list;
     gint              count;
+    /* If set, matches are appended here, in order, instead of to list */
+    std::vector<gpointer> * matches;
 } QofQueryCB;
 
 /* initial_term will be owned by the new Query */
@@ -567,6 +578,15 @@ static void compile_terms (QofQuery *q)
     LEAVE (" query=%p", q);
 }
 
+static void add_match (QofQueryCB* ql, gpointer object)
+{
+    if (ql->matches)
+        ql->matches->push_back (object);
+    else
+        ql->list = g_list_prepend (ql->list, object);
+    ql->count++;
+}
+
 static void check_item_cb (gpointer object, gpointer user_data)
 {
     QofQueryCB* ql = static_cast<QofQueryCB*>(user_data);
@@ -574,11 +594,354 @@ static void check_item_cb (gpointer object, gpointer user_data)
     if (!object || !ql) return;
 
     if (check_object (ql->query, object))
+        add_match (ql, object);
+    return;
+}
+
+/* ==================================================================== */
+/* Query planning.  A query is a sum of products, so it can skip the full
+ * scan only if every OR-term has an AND-term that an index can answer:
+ * the objects those terms select are then a superset of the result, and
+ * check_object() sorts them out.  For each OR-term the planner takes the
+ * indexed term selecting the fewest objects, and it falls back to the
+ * scan when all of them together wouldn't be fewer than the collection.
+ */
+
+struct QueryAccess
+{
+    QofQueryIndex *index;
+    const QofQueryTerm *term;
+    /* Estimated number of objects; the population if the index is stale */
+    std::size_t rows;
+    bool fresh;
+};
+
+struct QueryOrPlan
+{
+    std::vector<QueryAccess> considered;
+    /* The position of the chosen access in considered, or -1 to scan */
+    int chosen;
+    std::size_t rows;
+};
+
+struct QueryBookPlan
+{
+    QofBook *book;
+    std::size_t population;
+    std::vector<QueryOrPlan> or_terms;
+    bool use_indexes;
+    std::size_t rows;
+};
+
+/* Plan the query for one book.  If acquire is set the indexes the query
+ * could use are brought up to date when that's worth it, see
+ * QofQueryIndex::acquire(); otherwise stale ones are just skipped. */
+static QueryBookPlan
+plan_query (const QofQuery *q, QofBook *book, bool acquire)
+{
+    QueryBookPlan plan;
+    std::size_t rows = 0;
+    bool all_indexed = true;
+
+    plan.book = book;
+    plan.population =
+        qof_collection_count (qof_book_get_collection (book, q->search_for));
+    plan.use_indexes = false;
+    plan.rows = plan.population;
+
+    const auto& indexes = qof_query_book_indexes (book, q->search_for);
+    if (indexes.empty () || !q->terms)
+        return plan;
+
+    for (GList *or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
     {
-        ql->list = g_list_prepend (ql->list, object);
-        ql->count++;
+        QueryOrPlan or_plan;
+        or_plan.chosen = -1;
+        or_plan.rows = plan.population;
+
+        for (GList *and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
+             and_ptr = and_ptr->next)
+        {
+            auto qt = static_cast<const QofQueryTerm*>(and_ptr->data);
+            for (auto index : indexes)
+            {
+                if (!index->covers (qt))
+                    continue;
+
+                bool fresh = acquire ? index->acquire () : index->is_fresh ();
+                auto estimate = fresh ? index->estimate (qt) : plan.population;
+                or_plan.considered.push_back ({index, qt, estimate, fresh});
+                if (fresh && estimate < or_plan.rows)
+                {
+                    or_plan.rows = estimate;
+                    or_plan.chosen = or_plan.considered.size () - 1;
+                }
+            }
+        }
+        if (or_plan.chosen < 0)
+            all_indexed = false;
+        rows += or_plan.rows;
+        plan.or_terms.push_back (std::move (or_plan));
     }
-    return;
+
+    if (all_indexed && rows < plan.population)
+    {
+        plan.use_indexes = true;
+        plan.rows = rows;
+    }
+    return plan;
+}
+
+/* The objects the plan's indexes select, in collection order just like a
+ * scan would visit them. */
+static QofQueryIndexHits
+plan_candidates (const QueryBookPlan& plan)
+{
+    QofQueryIndexHits hits;
+
+    hits.reserve (plan.rows);
+    for (const auto& or_plan : plan.or_terms)
+    {
+        const auto& access = or_plan.considered[or_plan.chosen];
+        access.index->collect (access.term, hits);
+    }
+
+    auto by_ordinal = [](const QofQueryIndexHit& a, const QofQueryIndexHit& b)
+        { return a.ordinal < b.ordinal; };
+    auto same_ordinal = [](const QofQueryIndexHit& a, const QofQueryIndexHit& b)
+        { return a.ordinal == b.ordinal; };
+    std::sort (hits.begin (), hits.end (), by_ordinal);
+    hits.erase (std::unique (hits.begin (), hits.end (), same_ordinal),
+                hits.end ());
+    return hits;
+}
+
+static void
+run_plan (const QueryBookPlan& plan, QofQueryCB *qcb)
+{
+    for (const auto& hit : plan_candidates (plan))
+        check_item_cb (hit.inst, qcb);
+}
+
+/* ==================================================================== */
+/* Parallel runs.  The objects of a book are split into one slice per
+ * thread, and each slice is tested by a worker from a shared pool
+ * against its own copy of the query terms: copying a term copies its
+ * predicate data, so state like a compiled regex is never shared.  The
+ * slices' matches are put back together in order, so the result is the
+ * same as that of a serial run.
+ */
+
+/* With an automatic thread count, each thread gets at least this many
+ * objects to test. */
+#define QUERY_PARALLEL_MIN_OBJECTS 4096
+
+struct QueryBatch
+{
+    GMutex lock;
+    GCond done;
+    guint pending;
+};
+
+struct QueryWorker
+{
+    QueryBatch *batch;
+    QofQuery query;
+    const gpointer *first;
+    const gpointer *last;
+    std::vector<gpointer> matches;
+};
+
+static GThreadPool *query_pool = NULL;
+
+static void
+query_worker_run (gpointer data, gpointer user_data)
+{
+    auto worker = static_cast<QueryWorker*>(data);
+
+    for (auto object = worker->first; object != worker->last; ++object)
+        if (check_object (&worker->query, *object))
+            worker->matches.push_back (*object);
+
+    g_mutex_lock (&worker->batch->lock);
+    if (--worker->batch->pending == 0)
+        g_cond_signal (&worker->batch->done);
+    g_mutex_unlock (&worker->batch->lock);
+}
+
+/* Only terms whose getters are all registered as thread safe may be
+ * tested on the workers; anything else runs on the calling thread. */
+static gboolean
+terms_thread_safe (const QofQuery *q)
+{
+    for (auto or_ptr = q->terms; or_ptr; or_ptr = or_ptr->next)
+        for (auto and_ptr = static_cast<GList*>(or_ptr->data); and_ptr;
+             and_ptr = and_ptr->next)
+        {
+            auto qt = static_cast<const QofQueryTerm*>(and_ptr->data);
+            for (auto node = qt->param_fcns; node; node = node->next)
+                if (!qof_class_param_is_thread_safe
+                        (static_cast<const QofParam*>(node->data)))
+                {
+                    PINFO ("parameter %s isn't thread safe, running serially",
+                           static_cast<const QofParam*>(node->data)->param_name);
+                    return FALSE;
+                }
+        }
+    return TRUE;
+}
+
+static guint
+query_threads (const QofQuery *q, std::size_t objects)
+{
+    guint threads;
+
+    if (q->parallel == 0 || q->parallel == 1)
+        return 1;
+    if (!terms_thread_safe (q))
+        return 1;
+    if (q->parallel < 0)
+        threads = MIN (g_get_num_processors (),
+                       objects / QUERY_PARALLEL_MIN_OBJECTS);
+    else
+        threads = MIN (static_cast<std::size_t>(q->parallel), objects);
+    return MAX (threads, 1);
+}
+
+static void
+collect_object_cb (gpointer object, gpointer user_data)
+{
+    static_cast<std::vector<gpointer>*>(user_data)->push_back (object);
+}
+
+static void
+run_parallel (const QueryBookPlan& plan, guint threads, QofQueryCB *qcb)
+{
+    QofQuery *q = qcb->query;
+    std::vector<gpointer> objects;
+    std::vector<QueryWorker> workers (threads);
+    QueryBatch batch;
+
+    if (plan.use_indexes)
+    {
+        for (const auto& hit : plan_candidates (plan))
+            objects.push_back (hit.inst);
+    }
+    else
+    {
+        objects.reserve (plan.population);
+        qof_object_foreach (q->search_for, plan.book, collect_object_cb,
+                            &objects);
+    }
+    PINFO ("testing %" G_GSIZE_FORMAT " objects on %u threads",
+           objects.size (), threads);
+
+    if (!query_pool)
+        query_pool = g_thread_pool_new (query_worker_run, NULL, threads,
+                                        FALSE, NULL);
+    else if (g_thread_pool_get_max_threads (query_pool) < (gint)threads)
+        g_thread_pool_set_max_threads (query_pool, threads, NULL);
+
+    g_mutex_init (&batch.lock);
+    g_cond_init (&batch.done);
+    batch.pending = threads;
+
+    auto slice = (objects.size () + threads - 1) / threads;
+    for (guint i = 0; i < threads; ++i)
+    {
+        auto& worker = workers[i];
+        worker.batch = &batch;
+        memset (&worker.query, 0, sizeof (worker.query));
+        worker.query.terms = copy_or_terms (q->terms);
+        worker.first = objects.data () + MIN (i * slice, objects.size ());
+        worker.last = objects.data () + MIN ((i + 1) * slice, objects.size ());
+    }
+    for (auto& worker : workers)
+        g_thread_pool_push (query_pool, &worker, NULL);
+
+    g_mutex_lock (&batch.lock);
+    while (batch.pending)
+        g_cond_wait (&batch.done, &batch.lock);
+    g_mutex_unlock (&batch.lock);
+
+    for (auto& worker : workers)
+    {
+        for (auto object : worker.matches)
+            add_match (qcb, object);
+        free_members (&worker.query);
+    }
+    g_cond_clear (&batch.done);
+    g_mutex_clear (&batch.lock);
+}
+
+/* ==================================================================== */
+/* Ordering.  A full run sorts the matches with a stable sort and keeps
+ * the last max_results of them.  Top-N selection and the cursor only
+ * order the part they need, so they break ties on the position among the
+ * matches to end up with exactly the objects, and the order, of the full
+ * sort.
+ */
+
+struct QueryRanked
+{
+    gpointer object;
+    std::size_t pos;
+};
+
+struct QueryRankedLess
+{
+    QofQuery *query;
+    bool operator() (const QueryRanked& a, const QueryRanked& b) const
+    {
+        int retval = sort_func (a.object, b.object, query);
+        return retval ? retval < 0 : a.pos < b.pos;
+    }
+};
+
+static gboolean
+query_is_sorted (const QofQuery *q)
+{
+    return q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
+        (q->primary_sort.use_default && q->defaultSort);
+}
+
+/* Given the ranked matches, in the order they were found, move the last
+ * max_results of the sort order to the end of the vector, from the
+ * returned position on.  Only that tail is left to be sorted. */
+static std::size_t
+query_select_last (QofQuery *q, std::vector<QueryRanked>& ranked,
+                   gint max_results)
+{
+    if (max_results < 0 ||
+        ranked.size () <= static_cast<std::size_t>(max_results))
+        return 0;
+
+    auto cut = ranked.size () - max_results;
+    if (query_is_sorted (q) && max_results > 0)
+        std::nth_element (ranked.begin (), ranked.begin () + cut,
+                          ranked.end (), QueryRankedLess{q});
+    return cut;
+}
+
+/* Sort the matches and crop them to max_results for a query that has both,
+ * sorting only the objects that are kept.  Takes over matches. */
+static GList *
+query_sort_top (QofQuery *q, GList *matches)
+{
+    std::vector<QueryRanked> ranked;
+    std::size_t pos = 0;
+    GList *result = NULL;
+
+    for (GList *node = matches; node; node = node->next)
+        ranked.push_back ({node->data, pos++});
+    g_list_free (matches);
+
+    auto cut = ranked.begin () + query_select_last (q, ranked,
+                                                    q->max_results);
+    std::sort (cut, ranked.end (), QueryRankedLess{q});
+    for (auto iter = ranked.rbegin (); iter.base () != cut; ++iter)
+        result = g_list_prepend (result, iter->object);
+    return result;
 }
 
 static int param_list_cmp (const QofQueryParamList *l1, const QofQueryParamList *l2)
@@ -736,7 +1099,8 @@ static GList * qof_query_run_internal (QofQuery *q,
     g_return_val_if_fail (run_cb, NULL);
     ENTER (" q=%p", q);
 
-    /* XXX: Prioritize the query terms? */
+    /* Which objects get tested is decided per book by plan_query(), in
+     * the run callback. */
 
     /* prepare the Query for processing */
     if (q->changed)
@@ -772,15 +1136,19 @@ static GList * qof_query_run_internal (QofQuery *q,
      */
     matching_objects = g_list_reverse(matching_objects);
 
+    /* With a limit, only the objects that will be kept need sorting. */
+    if (query_is_sorted (q) && (object_count > q->max_results) &&
+        (q->max_results > -1))
+    {
+        matching_objects = query_sort_top (q, matching_objects);
+    }
     /* Now sort the matching objects based on the search criteria */
-    if (q->primary_sort.comp_fcn || q->primary_sort.obj_cmp ||
-            (q->primary_sort.use_default && q->defaultSort))
+    else if (query_is_sorted (q))
     {
         matching_objects = g_list_sort_with_data(matching_objects, sort_func, q);
     }
-
     /* Crop the list to limit the number of splits. */
-    if ((object_count > q->max_results) && (q->max_results > -1))
+    else if ((object_count > q->max_results) && (q->max_results > -1))
     {
         if (q->max_results > 0)
         {
@@ -839,9 +1207,17 @@ static void qof_query_run_cb(QofQueryCB* qcb, gpointer cb_arg)
             }
         }
 #endif
-        /* And then iterate over all the objects */
-        qof_object_foreach (qcb->query->search_for, book,
-                            (QofInstanceForeachCB) check_item_cb, qcb);
+        /* And then iterate over the objects the indexes select, or over
+         * all of them */
+        auto plan = plan_query (qcb->query, book, true);
+        auto threads = query_threads (qcb->query, plan.rows);
+        if (threads > 1)
+            run_parallel (plan, threads, qcb);
+        else if (plan.use_indexes)
+            run_plan (plan, qcb);
+        else
+            qof_object_foreach (qcb->query->search_for, book,
+                                (QofInstanceForeachCB) check_item_cb, qcb);
     }
 }
 
@@ -876,6 +1252,253 @@ qof_query_run_subquery (QofQuery *subq, const QofQuery* primaryq)
                                   (gpointer)primaryq);
 }
 
+/* ==================================================================== */
+/* Cursors.  A query without sort or limit can be answered while walking
+ * the collections, so its cursor holds little more than its position.
+ * Any other query needs all the matches before the first result is
+ * known; the cursor collects them once and sorts a batch at a time.
+ *
+ * Positions in index candidates or in the collected matches are only
+ * good while the book is unchanged.  If it changes, the cursor starts
+ * over, skipping the objects it has already returned.
+ */
+
+struct _QofQueryCursor
+{
+    QofQuery *query;
+    std::size_t batch_size;
+    gboolean streaming;
+    /* Objects already returned, filled in when the cursor starts over */
+    std::unordered_set<gpointer> returned;
+
+    /* Streaming: the book being walked, a node of query->books, and the
+     * position in it, either among the candidates from the book's
+     * indexes or in its collection. */
+    GList *book;
+    gboolean book_started;
+    gboolean use_hits;
+    QofQueryIndexHits hits;
+    std::size_t hit_pos;
+    guint64 generation;
+    QofCollectionIter iter;
+    gboolean iter_open;
+
+    /* Collected: the matches from start on are the results, those before
+     * pos have been returned.  The books' generations tell whether the
+     * objects are still there. */
+    std::vector<QueryRanked> ranked;
+    std::size_t start;
+    std::size_t pos;
+    gint max_results;
+    std::vector<guint64> generations;
+};
+
+static void
+cursor_collect (QofQueryCursor *cursor)
+{
+    QofQuery *q = cursor->query;
+    QofQueryCB qcb;
+    std::vector<gpointer> matches;
+
+    memset (&qcb, 0, sizeof (qcb));
+    qcb.query = q;
+    qcb.matches = &matches;
+    qof_query_run_cb (&qcb, NULL);
+
+    cursor->ranked.clear ();
+    for (auto object : matches)
+        if (cursor->returned.find (object) == cursor->returned.end ())
+            cursor->ranked.push_back ({object, cursor->ranked.size ()});
+
+    cursor->generations.clear ();
+    for (GList *node = q->books; node; node = node->next)
+        cursor->generations.push_back (
+            qof_book_get_generation (static_cast<QofBook*>(node->data)));
+
+    cursor->start = cursor->pos =
+        query_select_last (q, cursor->ranked, cursor->max_results);
+}
+
+static gboolean
+cursor_books_changed (const QofQueryCursor *cursor)
+{
+    auto generation = cursor->generations.begin ();
+    for (GList *node = cursor->query->books; node; node = node->next)
+        if (*generation++ !=
+            qof_book_get_generation (static_cast<QofBook*>(node->data)))
+            return TRUE;
+    return FALSE;
+}
+
+static GList *
+cursor_next_collected (QofQueryCursor *cursor)
+{
+    GList *batch = NULL;
+
+    if (cursor_books_changed (cursor))
+    {
+        PINFO ("book changed, collecting the matches again");
+        for (auto iter = cursor->ranked.begin () + cursor->start;
+             iter != cursor->ranked.begin () + cursor->pos; ++iter)
+            cursor->returned.insert (iter->object);
+        if (cursor->max_results >= 0)
+            cursor->max_results -= cursor->pos - cursor->start;
+        cursor_collect (cursor);
+    }
+
+    auto first = cursor->ranked.begin () + cursor->pos;
+    auto count = std::min (cursor->batch_size,
+                           cursor->ranked.size () - cursor->pos);
+    auto last = first + count;
+    if (query_is_sorted (cursor->query))
+        std::partial_sort (first, last, cursor->ranked.end (),
+                           QueryRankedLess{cursor->query});
+
+    while (last != first)
+        batch = g_list_prepend (batch, (--last)->object);
+    cursor->pos += count;
+    return batch;
+}
+
+/* The next object of the books to test, or NULL at the end. */
+static gpointer
+cursor_stream_next (QofQueryCursor *cursor)
+{
+    while (cursor->book)
+    {
+        QofBook *book = static_cast<QofBook*>(cursor->book->data);
+
+        if (!cursor->book_started)
+        {
+            auto plan = plan_query (cursor->query, book, true);
+            cursor->use_hits = plan.use_indexes;
+            if (cursor->use_hits)
+            {
+                cursor->hits = plan_candidates (plan);
+                cursor->hit_pos = 0;
+                cursor->generation = qof_book_get_generation (book);
+            }
+            else
+            {
+                qof_collection_iter_init (&cursor->iter,
+                                          qof_book_get_collection (book, cursor->query->search_for));
+                cursor->iter_open = TRUE;
+            }
+            cursor->book_started = TRUE;
+        }
+
+        if (cursor->use_hits &&
+            cursor->generation != qof_book_get_generation (book))
+        {
+            PINFO ("book changed, walking the rest of its collection");
+            for (std::size_t pos = 0; pos < cursor->hit_pos; ++pos)
+                cursor->returned.insert (cursor->hits[pos].inst);
+            cursor->hits.clear ();
+            cursor->use_hits = FALSE;
+            qof_collection_iter_init (&cursor->iter,
+                                      qof_book_get_collection (book, cursor->query->search_for));
+            cursor->iter_open = TRUE;
+        }
+
+        if (cursor->use_hits)
+        {
+            if (cursor->hit_pos < cursor->hits.size ())
+                return cursor->hits[cursor->hit_pos++].inst;
+            cursor->hits.clear ();
+        }
+        else
+        {
+            QofInstance *inst;
+            while (cursor->iter_open &&
+                   (inst = qof_collection_iter_next (&cursor->iter)))
+                if (cursor->returned.find (inst) == cursor->returned.end ())
+                    return inst;
+            cursor->iter_open = FALSE;
+        }
+
+        cursor->returned.clear ();
+        cursor->book = cursor->book->next;
+        cursor->book_started = FALSE;
+    }
+    return NULL;
+}
+
+static GList *
+cursor_next_streamed (QofQueryCursor *cursor)
+{
+    GList *batch = NULL;
+    std::size_t count = 0;
+    gpointer object;
+
+    while (count < cursor->batch_size && (object = cursor_stream_next (cursor)))
+    {
+        if (check_object (cursor->query, object))
+        {
+            batch = g_list_prepend (batch, object);
+            ++count;
+        }
+    }
+    return g_list_reverse (batch);
+}
+
+QofQueryCursor *
+qof_query_run_cursor (QofQuery *q, gint batch_size)
+{
+    QofQueryCursor *cursor;
+    const QofObject *obj;
+
+    g_return_val_if_fail (q, NULL);
+    g_return_val_if_fail (q->search_for, NULL);
+    g_return_val_if_fail (q->books, NULL);
+    g_return_val_if_fail (batch_size > 0, NULL);
+    ENTER (" q=%p", q);
+
+    if (q->changed)
+    {
+        query_clear_compiles (q);
+        compile_terms (q);
+    }
+
+    cursor = new QofQueryCursor{};
+    cursor->query = q;
+    cursor->batch_size = batch_size;
+    cursor->max_results = q->max_results;
+
+    /* Streaming visits the collections directly, so it's only possible
+     * when that's what the object's foreach does. */
+    obj = qof_object_lookup (q->search_for);
+    cursor->streaming = !query_is_sorted (q) && q->max_results < 0 &&
+        obj && obj->foreach == qof_collection_foreach;
+
+    if (cursor->streaming)
+        cursor->book = q->books;
+    else
+        cursor_collect (cursor);
+
+    LEAVE (" cursor=%p streaming=%d", cursor, cursor->streaming);
+    return cursor;
+}
+
+GList *
+qof_query_cursor_next (QofQueryCursor *cursor)
+{
+    g_return_val_if_fail (cursor, NULL);
+
+    if (cursor->streaming)
+        return cursor_next_streamed (cursor);
+    return cursor_next_collected (cursor);
+}
+
+void
+qof_query_cursor_destroy (QofQueryCursor *cursor)
+{
+    if (!cursor) return;
+
+    if (cursor->iter_open)
+        qof_collection_iter_finish (&cursor->iter);
+    delete cursor;
+}
+
 GList *
 qof_query_last_run (QofQuery *query)
 {
@@ -1050,6 +1673,7 @@ QofQuery * qof_query_invert (QofQuery *q)
     case 0:
         retval = qof_query_create();
         retval->max_results = q->max_results;
+        retval->parallel    = q->parallel;
         break;
 
         /* This is the DeMorgan expansion for a single AND expression. */
@@ -1057,6 +1681,7 @@ QofQuery * qof_query_invert (QofQuery *q)
     case 1:
         retval = qof_query_create();
         retval->max_results = q->max_results;
+        retval->parallel    = q->parallel;
         retval->books = g_list_copy (q->books);
         retval->search_for = q->search_for;
         retval->changed = 1;
@@ -1090,6 +1715,7 @@ QofQuery * qof_query_invert (QofQuery *q)
         retval = qof_query_merge(iright, ileft, QOF_QUERY_AND);
         retval->books          = g_list_copy (q->books);
         retval->max_results    = q->max_results;
+        retval->parallel       = q->parallel;
         retval->search_for     = q->search_for;
         retval->changed        = 1;
 
@@ -1150,6 +1776,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
             g_list_concat(copy_or_terms(q1->terms), copy_or_terms(q2->terms));
         retval->books           = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
         break;
 
@@ -1157,6 +1784,7 @@ qof_query_merge(QofQuery *q1, QofQuery *q2, QofQueryOp op)
         retval = qof_query_create();
         retval->books          = merge_books (q1->books, q2->books);
         retval->max_results    = q1->max_results;
+        retval->parallel       = q1->parallel;
         retval->changed        = 1;
 
         /* g_list_append() can take forever, so let's build the list in
@@ -1274,6 +1902,12 @@ void qof_query_set_max_results (QofQuery *q, int n)
     q->max_results = n;
 }
 
+void qof_query_set_parallel (QofQuery *q, gint n_threads)
+{
+    if (!q) return;
+    q->parallel = n_threads;
+}
+
 void qof_query_add_guid_list_match (QofQuery *q, QofQueryParamList *param_list,
                                     GList *guid_list, QofGuidMatch options,
                                     QofQueryOp op)
@@ -1349,6 +1983,12 @@ void qof_query_init (void)
 
 void qof_query_shutdown (void)
 {
+    if (query_pool)
+    {
+        g_thread_pool_free (query_pool, FALSE, TRUE);
+        query_pool = NULL;
+    }
+    qof_query_index_shutdown ();
     qof_class_shutdown ();
     qof_query_core_shutdown ();
 }
@@ -1554,6 +2194,80 @@ qof_query_print (QofQuery * query)
     LEAVE (" ");
 }
 
+gchar *
+qof_query_explain (QofQuery *query)
+{
+    GString *str;
+    GList *node;
+
+    g_return_val_if_fail (query, NULL);
+
+    str = g_string_new (NULL);
+    g_string_append_printf (str, "Query for %s in %u book(s)\n",
+                            query->search_for ? query->search_for : "(nothing)",
+                            g_list_length (query->books));
+    if (!query->search_for)
+        return g_string_free (str, FALSE);
+
+    if (query->changed)
+    {
+        query_clear_compiles (query);
+        compile_terms (query);
+    }
+
+    for (node = query->books; node; node = node->next)
+    {
+        QofBook *book = static_cast<QofBook*>(node->data);
+        gchar guidstr[GUID_ENCODING_LENGTH+1];
+        int or_count = 0;
+
+        guid_to_string_buff (qof_instance_get_guid (book), guidstr);
+        auto plan = plan_query (query, book, false);
+        g_string_append_printf (str, "Book %s: %" G_GSIZE_FORMAT " objects\n",
+                                guidstr, plan.population);
+        if (!query->terms)
+            g_string_append (str, "  No terms, every object matches\n");
+
+        for (const auto& or_plan : plan.or_terms)
+        {
+            ++or_count;
+            if (or_plan.chosen < 0)
+                g_string_append_printf (str, "  OR-term %d: no usable index\n",
+                                        or_count);
+            else
+                g_string_append_printf (str, "  OR-term %d: index on %s, "
+                                        "estimated %" G_GSIZE_FORMAT " rows\n",
+                                        or_count,
+                                        or_plan.considered[or_plan.chosen].index->name ().c_str (),
+                                        or_plan.rows);
+            for (const auto& access : or_plan.considered)
+            {
+                if (access.fresh)
+                    g_string_append_printf (str, "    candidate %s: %"
+                                            G_GSIZE_FORMAT " rows\n",
+                                            access.index->name ().c_str (),
+                                            access.rows);
+                else
+                    g_string_append_printf (str, "    candidate %s: stale\n",
+                                            access.index->name ().c_str ());
+            }
+        }
+
+        if (plan.use_indexes)
+            g_string_append_printf (str, "  Plan: index lookup, estimated %"
+                                    G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT
+                                    " objects\n", plan.rows, plan.population);
+        else
+            g_string_append_printf (str, "  Plan: full scan of %"
+                                    G_GSIZE_FORMAT " objects\n",
+                                    plan.population);
+        g_string_append_printf (str, "  Threads: %u\n",
+                                query_threads (query, plan.rows));
+    }
+
+    return g_string_free (str, FALSE);
+}
+
 static void
 qof_query_printOutput (GList * output)
 {
@@ -89,6 +89,9 @@ extern "C"
 /** A Query */
 typedef struct _QofQuery QofQuery;
 
+/** A position in the results of a query, see qof_query_run_cursor() */
+typedef struct _QofQueryCursor QofQueryCursor;
+
 /** Query Term Operators, for combining Query Terms */
 typedef enum
 {
@@ -214,7 +217,8 @@ void qof_query_add_boolean_match (QofQuery *q,
  *  previously set with the qof_query_search_for() or the
  *  qof_query_create_for() routines.  The returned list will have
  *  been sorted using the indicated sort order, and trimmed to the
- *  max_results length.
+ *  max_results length.  When there is a limit, only the objects that are
+ *  kept are fully sorted.
  *
  *  Do NOT free the resulting list.  This list is managed internally
  *  by QofQuery.
@@ -237,6 +241,38 @@ GList * qof_query_last_run (QofQuery *query);
 GList * qof_query_run_subquery (QofQuery *subquery,
                                 const QofQuery* primary_query);
 
+/** Start reading the results of a query in batches, in the same order
+ *  and subject to the same max_results limit as qof_query_run().
+ *
+ *  A query with neither a sort order nor a limit is evaluated as the
+ *  cursor advances, so reading only the first few batches only costs
+ *  what it takes to find them and no result list is ever built. Any
+ *  other query has to find all of its matches before it knows the first
+ *  result; the cursor then only sorts as much as has been read, which
+ *  for the first batches is far less than sorting everything.
+ *
+ *  The book may change while the cursor is open: objects destroyed in
+ *  the meantime won't be returned and objects created may or may not be,
+ *  but an object is never returned twice. The query must not be changed
+ *  or destroyed before the cursor.
+ *
+ *  @param query The query to run.
+ *  @param batch_size The maximum number of objects
+ *  qof_query_cursor_next() returns at a time; must be positive.
+ *  @return a new cursor; free it with qof_query_cursor_destroy().
+ */
+QofQueryCursor * qof_query_run_cursor (QofQuery *query, gint batch_size);
+
+/** Read the next batch of results from a cursor.
+ *  @return a list of at most batch_size objects, or NULL once all the
+ *  results have been read. The list belongs to the caller, who must free
+ *  it with g_list_free(); the objects belong to the book.
+ */
+GList * qof_query_cursor_next (QofQueryCursor *cursor);
+
+/** Free a cursor, whether or not all of its results have been read. */
+void qof_query_cursor_destroy (QofQueryCursor *cursor);
+
 /** Remove all query terms from query.  query matches nothing
  *  after qof_query_clear().
  */
@@ -360,6 +396,26 @@ void qof_query_set_sort_increasing (QofQuery *q, gboolean prim_inc,
  */
 void qof_query_set_max_results (QofQuery *q, int n);
 
+/**
+ * Test the objects of each book on several threads when the query is
+ * run.  This only pays off for queries over many objects with costly
+ * terms, such as regular expression matches; the results are the same
+ * as those of a serial run, in the same order.
+ *
+ * n_threads is the number of threads to use: 0 or 1 runs the query on
+ * the calling thread, which is the default, and -1 picks a number from
+ * the processors available and the number of objects to test.
+ *
+ * Queries with a term on a parameter that wasn't registered with
+ * qof_class_register_thread_safe() always run on the calling thread.
+ * A parallel run calls the parameter getters of the terms and the
+ * predicates concurrently from the worker threads, so the objects and everything the getters reach must not be
+ * changed from any thread until qof_query_run() returns.  The calling
+ * thread blocks until all workers are done; qof_query_run() itself
+ * remains non-reentrant.
+ */
+void qof_query_set_parallel (QofQuery *q, gint n_threads);
+
 /** Compare two queries for equality.
  * Query terms are compared each to each.
  * This is a simplistic
@@ -376,6 +432,37 @@ gboolean qof_query_equal (const QofQuery *q1, const QofQuery *q2);
  */
 void qof_query_print (QofQuery *query);
 
+/** Describe how the query would be run: for each book, the access path
+ *  chosen for each OR-term and the estimated number of objects it
+ *  yields, whether the query will use secondary indexes or scan the
+ *  whole collection, and on how many threads. Unlike running the query this doesn't build any
+ *  index, so an index that is stale is reported as such.
+ *
+ *  @return a newly allocated string; free it with g_free().
+ */
+gchar * qof_query_explain (QofQuery *query);
+
+/** Ask the query engine to keep a secondary index over the objects of
+ *  obj_type, keyed on the value at the end of param_list.
+ *
+ *  When every OR-term of a query on obj_type has an AND-term on an
+ *  indexed path, the query only tests the objects the most selective of
+ *  those terms can match instead of every object in the book. Date and
+ *  numeric paths answer all comparisons except QOF_COMPARE_NEQ; GUID
+ *  paths answer QOF_GUID_MATCH_ANY. Inverted terms never use an index.
+ *
+ *  Indexes are built on demand, per book, and rebuilt after the book
+ *  changes; see qof_book_get_generation(). The objects must be kept in
+ *  the book's collection for obj_type and be visited by the type's
+ *  foreach, which is the case when it is qof_collection_foreach().
+ *
+ *  @param obj_type The type of object searched for.
+ *  @param param_list The parameter path, as for qof_query_add_term(). The
+ *  query engine takes ownership of the list.
+ */
+void qof_query_register_index (QofIdTypeConst obj_type,
+                               QofQueryParamList *param_list);
+
 /** Return the type of data we're querying for */
 /*@ dependent @*/
 QofIdType qof_query_get_search_for (const QofQuery *q);
@@ -40,6 +40,12 @@ void qof_query_core_shutdown (void);
  * particular parameter get-function (obtained from the registry by
  * the Query internals), compare the object's parameter to the
  * predicate data.
+ *
+ * A parallel query (see qof_query_set_parallel()) calls the predicate
+ * from several threads at once, each with its own copy of pdata made
+ * by qof_query_core_predicate_copy().  A predicate may therefore keep
+ * state in its pdata, like the compiled regex of a string match, but
+ * must not touch any state shared between copies.
  */
 typedef gint (*QofQueryPredicateFunc) (gpointer object,
                                        QofParam *getter,
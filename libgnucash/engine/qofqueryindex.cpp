@@ -0,0 +1,545 @@
+/********************************************************************\
+ * qofqueryindex.cpp -- Secondary indexes for QofQuery.             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+}
+
+#include <algorithm>
+#include <map>
+
+#include "qofqueryindex.hpp"
+#include "qofid.hpp"
+#include "qofquery-p.h"
+#include "qofquerycore-p.h"
+
+static QofLogModule log_module = QOF_MOD_QUERY;
+
+typedef time64 (*query_date_getter) (gpointer, QofParam *);
+typedef gnc_numeric (*query_numeric_getter) (gpointer, QofParam *);
+typedef const GncGUID * (*query_guid_getter) (gpointer, QofParam *);
+
+/* The registered paths, in registration order. The param lists are owned
+ * here and stay alive until qof_query_index_shutdown(), since the book
+ * indexes point to them. */
+struct IndexDef
+{
+    std::string obj_type;
+    QofQueryParamList* param_list;
+};
+static std::vector<IndexDef> index_defs;
+/* Bumped on every registration so that books pick up new paths. */
+static guint index_defs_version = 0;
+
+static const char* book_indexes_key = "qof-query-indexes";
+
+struct BookIndexes
+{
+    ~BookIndexes ()
+    {
+        for (auto& type : by_type)
+            for (auto index : type.second)
+                delete index;
+    }
+    guint version = 0;
+    std::map<std::string, std::vector<QofQueryIndex*>> by_type;
+};
+
+static bool
+param_list_equal (const QofQueryParamList* l1, const QofQueryParamList* l2)
+{
+    for (; l1 && l2; l1 = l1->next, l2 = l2->next)
+        if (g_strcmp0 (static_cast<const char*>(l1->data),
+                       static_cast<const char*>(l2->data)))
+            return false;
+    return !l1 && !l2;
+}
+
+/* Keys are held in a sorted vector next to the object they came from; the
+ * ordinal breaks ties so that equal keys stay in collection order. */
+template <typename Key>
+struct IndexEntry
+{
+    Key key;
+    QofInstance* inst;
+    guint ordinal;
+};
+
+template <typename Key, typename Less>
+class SortedIndex : public QofQueryIndex
+{
+public:
+    using QofQueryIndex::QofQueryIndex;
+
+protected:
+    using Entry = IndexEntry<Key>;
+
+    void clear_keys () override
+    {
+        m_entries.clear ();
+    }
+
+    void sort_keys () override
+    {
+        Less less;
+        std::sort (m_entries.begin (), m_entries.end (),
+                   [&less](const Entry& a, const Entry& b)
+                   {
+                       if (less (a.key, b.key)) return true;
+                       if (less (b.key, a.key)) return false;
+                       return a.ordinal < b.ordinal;
+                   });
+    }
+
+    void append_hits (const Range& range,
+                      QofQueryIndexHits& hits) const override
+    {
+        for (auto pos = range.first; pos < range.second; ++pos)
+            hits.push_back ({m_entries[pos].inst, m_entries[pos].ordinal});
+    }
+
+    void add (const Key& key, QofInstance* inst, guint ordinal)
+    {
+        m_entries.push_back ({key, inst, ordinal});
+    }
+
+    /* The position of the first key not less than key. */
+    std::size_t lower (const Key& key) const
+    {
+        Less less;
+        return std::lower_bound (m_entries.begin (), m_entries.end (), key,
+                                 [&less](const Entry& e, const Key& k)
+                                 { return less (e.key, k); }) -
+            m_entries.begin ();
+    }
+
+    /* The position of the first key greater than key. */
+    std::size_t upper (const Key& key) const
+    {
+        Less less;
+        return std::upper_bound (m_entries.begin (), m_entries.end (), key,
+                                 [&less](const Key& k, const Entry& e)
+                                 { return less (k, e.key); }) -
+            m_entries.begin ();
+    }
+
+    /* The range satisfying how, given the positions of the first key not
+     * less than the low bound and of the first key above the high one. */
+    Range compare_range (QofQueryCompare how, std::size_t first_ge,
+                         std::size_t first_gt) const
+    {
+        switch (how)
+        {
+        case QOF_COMPARE_LT:
+            return {0, first_ge};
+        case QOF_COMPARE_LTE:
+            return {0, first_gt};
+        case QOF_COMPARE_EQUAL:
+            return {first_ge, first_gt};
+        case QOF_COMPARE_GT:
+            return {first_gt, m_entries.size ()};
+        case QOF_COMPARE_GTE:
+            return {first_ge, m_entries.size ()};
+        default:
+            return {0, m_entries.size ()};
+        }
+    }
+
+    std::vector<Entry> m_entries;
+};
+
+struct DateLess
+{
+    bool operator() (time64 a, time64 b) const noexcept { return a < b; }
+};
+
+/* Dates are kept exactly; a day match is widened to the whole day. */
+class DateIndex : public SortedIndex<time64, DateLess>
+{
+public:
+    using SortedIndex::SortedIndex;
+
+protected:
+    bool covers_predicate (const QofQueryPredData* pdata) const override
+    {
+        return !g_strcmp0 (pdata->type_name, QOF_TYPE_DATE) &&
+            pdata->how != QOF_COMPARE_NEQ;
+    }
+
+    void add_key (gpointer object, const QofParam* getter,
+                  QofInstance* inst, guint ordinal) override
+    {
+        auto param = const_cast<QofParam*>(getter);
+        add (((query_date_getter)getter->param_getfcn) (object, param),
+             inst, ordinal);
+    }
+
+    void ranges (const QofQueryPredData* pdata,
+                 std::vector<Range>& ranges) const override
+    {
+        auto pd = reinterpret_cast<const query_date_def*>(pdata);
+        auto low = pd->date, high = pd->date;
+        if (pd->options == QOF_DATE_MATCH_DAY)
+        {
+            low = gnc_time64_get_day_start (pd->date);
+            high = gnc_time64_get_day_end (pd->date);
+        }
+        ranges.push_back (compare_range (pdata->how, lower (low),
+                                         upper (high)));
+    }
+};
+
+struct NumericLess
+{
+    bool operator() (const gnc_numeric& a, const gnc_numeric& b) const noexcept
+    {
+        return gnc_numeric_compare (a, b) < 0;
+    }
+};
+
+/* The numeric predicates compare absolute values, so that's what is kept.
+ * Equality is only to four decimal places, so an equal match takes a
+ * slightly wider band around the amount. */
+class NumericIndex : public SortedIndex<gnc_numeric, NumericLess>
+{
+public:
+    using SortedIndex::SortedIndex;
+
+protected:
+    bool covers_predicate (const QofQueryPredData* pdata) const override
+    {
+        return !g_strcmp0 (pdata->type_name, QOF_TYPE_NUMERIC) &&
+            pdata->how != QOF_COMPARE_NEQ;
+    }
+
+    void add_key (gpointer object, const QofParam* getter,
+                  QofInstance* inst, guint ordinal) override
+    {
+        auto param = const_cast<QofParam*>(getter);
+        auto value = ((query_numeric_getter)getter->param_getfcn) (object,
+                                                                   param);
+        if (gnc_numeric_check (value))
+            unkeyed (inst, ordinal);
+        else
+            add (gnc_numeric_abs (value), inst, ordinal);
+    }
+
+    void ranges (const QofQueryPredData* pdata,
+                 std::vector<Range>& ranges) const override
+    {
+        auto pd = reinterpret_cast<const query_numeric_def*>(pdata);
+        if (pdata->how != QOF_COMPARE_EQUAL)
+        {
+            ranges.push_back (compare_range (pdata->how, lower (pd->amount),
+                                             upper (pd->amount)));
+            return;
+        }
+        auto amount = gnc_numeric_abs (pd->amount);
+        auto band = gnc_numeric_create (1, 1000);
+        auto low = gnc_numeric_sub (amount, band, GNC_DENOM_AUTO,
+                                    GNC_HOW_DENOM_LCD);
+        auto high = gnc_numeric_add (amount, band, GNC_DENOM_AUTO,
+                                     GNC_HOW_DENOM_LCD);
+        if (gnc_numeric_check (low) || gnc_numeric_check (high))
+            ranges.push_back ({0, m_entries.size ()});
+        else
+            ranges.push_back ({lower (low), upper (high)});
+    }
+};
+
+struct GuidLess
+{
+    bool operator() (const GncGUID& a, const GncGUID& b) const noexcept
+    {
+        return guid_compare (&a, &b) < 0;
+    }
+};
+
+/* Only QOF_GUID_MATCH_ANY is answered: each GUID in the predicate is a
+ * separate equal range. */
+class GuidIndex : public SortedIndex<GncGUID, GuidLess>
+{
+public:
+    using SortedIndex::SortedIndex;
+
+protected:
+    bool covers_predicate (const QofQueryPredData* pdata) const override
+    {
+        return !g_strcmp0 (pdata->type_name, QOF_TYPE_GUID) &&
+            reinterpret_cast<const query_guid_def*>(pdata)->options ==
+            QOF_GUID_MATCH_ANY;
+    }
+
+    void add_key (gpointer object, const QofParam* getter,
+                  QofInstance* inst, guint ordinal) override
+    {
+        auto param = const_cast<QofParam*>(getter);
+        auto guid = ((query_guid_getter)getter->param_getfcn) (object, param);
+        if (guid)
+            add (*guid, inst, ordinal);
+        else
+            unkeyed (inst, ordinal);
+    }
+
+    void ranges (const QofQueryPredData* pdata,
+                 std::vector<Range>& ranges) const override
+    {
+        auto pd = reinterpret_cast<const query_guid_def*>(pdata);
+        for (auto node = pd->guids; node; node = node->next)
+        {
+            auto& guid = *static_cast<const GncGUID*>(node->data);
+            ranges.push_back ({lower (guid), upper (guid)});
+        }
+    }
+};
+
+QofQueryIndex::QofQueryIndex (QofBook* book, QofIdTypeConst obj_type,
+                              const QofQueryParamList* param_list,
+                              std::vector<const QofParam*> params) :
+    m_book{book}, m_obj_type{obj_type}, m_param_list{param_list},
+    m_params(std::move (params))
+{
+    for (auto node = param_list; node; node = node->next)
+    {
+        if (!m_name.empty ())
+            m_name += '/';
+        m_name += static_cast<const char*>(node->data);
+    }
+    /* The keys depend on the indexed objects and on the objects the path
+     * passes through, but on nothing else in the book. */
+    m_collections.push_back (qof_book_get_collection (book, obj_type));
+    for (auto param = m_params.begin (); param + 1 < m_params.end (); ++param)
+        m_collections.push_back (qof_book_get_collection (book,
+                                                          (*param)->param_type));
+}
+
+QofQueryIndex::~QofQueryIndex () = default;
+
+bool
+QofQueryIndex::covers (const QofQueryTerm* term) const
+{
+    if (qof_query_term_is_inverted (term))
+        return false;
+    if (!param_list_equal (qof_query_term_get_param_path (term), m_param_list))
+        return false;
+    auto pdata = qof_query_term_get_pred_data (term);
+    return pdata && covers_predicate (pdata);
+}
+
+/* The counters only ever grow, so their sum is unchanged exactly when
+ * each of them is. */
+guint64
+QofQueryIndex::generation () const noexcept
+{
+    guint64 sum = 0;
+    for (auto col : m_collections)
+        sum += qof_collection_get_generation (col);
+    return sum;
+}
+
+bool
+QofQueryIndex::is_fresh () const noexcept
+{
+    return m_built && m_generation == generation ();
+}
+
+bool
+QofQueryIndex::acquire ()
+{
+    if (is_fresh ())
+        return true;
+
+    auto current = generation ();
+    if (!m_wanted || m_wanted_generation != current)
+    {
+        m_wanted = true;
+        m_wanted_generation = current;
+        return false;
+    }
+    rebuild ();
+    return true;
+}
+
+std::size_t
+QofQueryIndex::estimate (const QofQueryTerm* term) const
+{
+    std::vector<Range> found;
+    ranges (qof_query_term_get_pred_data (term), found);
+    auto rows = m_unkeyed.size ();
+    for (const auto& range : found)
+        if (range.second > range.first)
+            rows += range.second - range.first;
+    return rows;
+}
+
+void
+QofQueryIndex::collect (const QofQueryTerm* term,
+                        QofQueryIndexHits& hits) const
+{
+    std::vector<Range> found;
+    ranges (qof_query_term_get_pred_data (term), found);
+    for (const auto& range : found)
+        append_hits (range, hits);
+    hits.insert (hits.end (), m_unkeyed.begin (), m_unkeyed.end ());
+}
+
+void
+QofQueryIndex::unkeyed (QofInstance* inst, guint ordinal)
+{
+    m_unkeyed.push_back ({inst, ordinal});
+}
+
+void
+QofQueryIndex::rebuild ()
+{
+    ENTER ("index=%s/%s", m_obj_type.c_str (), m_name.c_str ());
+    /* Take the generation first: if a getter changes anything, which it
+     * shouldn't, the index is merely stale again. */
+    m_generation = generation ();
+    clear_keys ();
+    m_unkeyed.clear ();
+
+    auto col = qof_book_get_collection (m_book, m_obj_type.c_str ());
+    guint ordinal = 0;
+    for (auto inst : QofCollectionRange (col))
+    {
+        gpointer object = inst;
+        for (auto param = m_params.begin (); object && param + 1 != m_params.end ();
+             ++param)
+            object = (*param)->param_getfcn (object, *param);
+
+        if (object)
+            add_key (object, m_params.back (), inst, ordinal);
+        else
+            unkeyed (inst, ordinal);
+        ++ordinal;
+    }
+    sort_keys ();
+    m_population = ordinal;
+    m_built = true;
+    m_wanted = false;
+    LEAVE ("%u objects", ordinal);
+}
+
+/* Compile the path against the registered classes and create the index
+ * kind matching its final parameter, or nothing if it can't be indexed. */
+static QofQueryIndex*
+make_index (QofBook* book, const IndexDef& def)
+{
+    std::vector<const QofParam*> params;
+    QofIdTypeConst type = def.obj_type.c_str ();
+    for (auto node = def.param_list; node; node = node->next)
+    {
+        auto param = qof_class_get_parameter (type,
+                                              static_cast<const char*>(node->data));
+        if (!param)
+        {
+            PWARN ("Can't index %s: no parameter %s of %s",
+                   def.obj_type.c_str (), static_cast<char*>(node->data), type);
+            return nullptr;
+        }
+        params.push_back (param);
+        type = param->param_type;
+    }
+    if (params.empty ())
+        return nullptr;
+
+    auto obj_type = def.obj_type.c_str ();
+    if (!g_strcmp0 (type, QOF_TYPE_DATE))
+        return new DateIndex (book, obj_type, def.param_list, params);
+    if (!g_strcmp0 (type, QOF_TYPE_NUMERIC) ||
+        !g_strcmp0 (type, QOF_TYPE_DEBCRED))
+        return new NumericIndex (book, obj_type, def.param_list, params);
+    if (!g_strcmp0 (type, QOF_TYPE_GUID))
+        return new GuidIndex (book, obj_type, def.param_list, params);
+
+    PWARN ("Can't index %s: parameters of type %s aren't supported",
+           obj_type, type);
+    return nullptr;
+}
+
+static void
+book_indexes_free (QofBook* book, gpointer key, gpointer data)
+{
+    delete static_cast<BookIndexes*>(data);
+}
+
+const std::vector<QofQueryIndex*>&
+qof_query_book_indexes (QofBook* book, QofIdTypeConst obj_type)
+{
+    auto indexes = static_cast<BookIndexes*>(qof_book_get_data (book,
+                                                                book_indexes_key));
+    if (!indexes)
+    {
+        indexes = new BookIndexes;
+        qof_book_set_data_fin (book, book_indexes_key, indexes,
+                               book_indexes_free);
+    }
+    if (indexes->version != index_defs_version)
+    {
+        for (auto& type : indexes->by_type)
+            for (auto index : type.second)
+                delete index;
+        indexes->by_type.clear ();
+        indexes->version = index_defs_version;
+    }
+
+    auto type = indexes->by_type.find (obj_type);
+    if (type == indexes->by_type.end ())
+    {
+        std::vector<QofQueryIndex*> for_type;
+        for (const auto& def : index_defs)
+            if (def.obj_type == obj_type)
+                if (auto index = make_index (book, def))
+                    for_type.push_back (index);
+        type = indexes->by_type.emplace (obj_type, std::move (for_type)).first;
+    }
+    return type->second;
+}
+
+void
+qof_query_register_index (QofIdTypeConst obj_type,
+                          QofQueryParamList *param_list)
+{
+    g_return_if_fail (obj_type);
+    g_return_if_fail (param_list);
+
+    for (const auto& def : index_defs)
+        if (def.obj_type == obj_type &&
+            param_list_equal (def.param_list, param_list))
+        {
+            g_slist_free (param_list);
+            return;
+        }
+    index_defs.push_back ({obj_type, param_list});
+    ++index_defs_version;
+}
+
+void
+qof_query_index_shutdown ()
+{
+    for (auto& def : index_defs)
+        g_slist_free (def.param_list);
+    index_defs.clear ();
+    ++index_defs_version;
+}
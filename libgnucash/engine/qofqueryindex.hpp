@@ -0,0 +1,174 @@
+/********************************************************************\
+ * qofqueryindex.hpp -- Secondary indexes for QofQuery.             *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ *                                                                  *
+\********************************************************************/
+/** @file qofqueryindex.hpp
+ *
+ * The engine-private secondary indexes used by the QofQuery planner.
+ *
+ * An index is registered for an object type and a parameter path with
+ * qof_query_register_index(). Each book then lazily keeps, per registered
+ * path, the objects of the type sorted on the value the path leads to, so
+ * that the objects a term can match are found with a binary search
+ * instead of by running the term's predicate over the whole collection.
+ * Date, numeric and GUID valued paths can be indexed.
+ *
+ * The index only narrows the candidates: the query still runs every term
+ * on each of them, so an index may return more objects than the term
+ * matches but never fewer. Objects for which the path can't be followed,
+ * because an intermediate object is NULL, are always returned.
+ *
+ * Indexes don't follow individual changes. Instead they remember the
+ * generation counters of the collections the path goes through, the
+ * indexed type's and those of the intermediate objects, when they were
+ * built and are stale as soon as any object in these changes; changes to
+ * other types of objects leave them alone. Rebuilding costs more than a single
+ * scan, so a stale index is only rebuilt when a second query asks for it
+ * without the book having changed in between; a query that finds it
+ * stale the first time scans instead.
+ */
+
+#ifndef QOF_QUERY_INDEX_HPP
+#define QOF_QUERY_INDEX_HPP
+
+#include <glib.h>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "qof.h"
+
+/** An object found through an index, with its position in the collection
+ * so that candidates from several lookups can be merged back into
+ * collection order.
+ */
+struct QofQueryIndexHit
+{
+    QofInstance* inst;
+    guint ordinal;
+};
+
+using QofQueryIndexHits = std::vector<QofQueryIndexHit>;
+
+/** The index of one book over one registered parameter path. */
+class QofQueryIndex
+{
+public:
+    /** @param params The compiled parameters of param_list, one per
+     * element; the last one yields the key.
+     */
+    QofQueryIndex (QofBook* book, QofIdTypeConst obj_type,
+                   const QofQueryParamList* param_list,
+                   std::vector<const QofParam*> params);
+    QofQueryIndex (const QofQueryIndex&) = delete;
+    QofQueryIndex& operator= (const QofQueryIndex&) = delete;
+    virtual ~QofQueryIndex ();
+
+    /** @return the indexed path as a printable string, e.g.
+     * "trans/date-posted".
+     */
+    const std::string& name () const noexcept { return m_name; }
+
+    /** @return true if term is on the indexed path and its predicate is
+     * one the index can answer.
+     */
+    bool covers (const QofQueryTerm* term) const;
+
+    /** @return true if the index reflects the current state of the
+     * objects on its path. */
+    bool is_fresh () const noexcept;
+
+    /** Make the index usable for a query if that is worth it: a fresh
+     * index always is, a stale one is rebuilt if this is the second
+     * request since the book last changed.
+     * @return true if the index is now fresh.
+     */
+    bool acquire ();
+
+    /** @return the number of objects collect() would return for term.
+     * The index must be fresh and cover term. O(log n) per range.
+     */
+    std::size_t estimate (const QofQueryTerm* term) const;
+
+    /** Append the candidates for term to hits, in no particular order.
+     * The index must be fresh and cover term.
+     */
+    void collect (const QofQueryTerm* term, QofQueryIndexHits& hits) const;
+
+    /** @return the number of objects in the index. */
+    std::size_t population () const noexcept { return m_population; }
+
+protected:
+    /** A half-open range of positions in the sorted keys. */
+    using Range = std::pair<std::size_t, std::size_t>;
+
+    /** @return true if pdata is of the kind and mode the index handles. */
+    virtual bool covers_predicate (const QofQueryPredData* pdata) const = 0;
+    /** Drop all keys. */
+    virtual void clear_keys () = 0;
+    /** Extract the key of object, the result of following the path up to
+     * its last parameter, and add it with inst and ordinal.
+     */
+    virtual void add_key (gpointer object, const QofParam* getter,
+                          QofInstance* inst, guint ordinal) = 0;
+    /** Sort the keys once they have all been added. */
+    virtual void sort_keys () = 0;
+    /** Append to ranges the positions of the keys that can satisfy pdata. */
+    virtual void ranges (const QofQueryPredData* pdata,
+                         std::vector<Range>& ranges) const = 0;
+    /** Append the objects at the positions in range to hits. */
+    virtual void append_hits (const Range& range,
+                              QofQueryIndexHits& hits) const = 0;
+    /** Record an object that has no usable key, from add_key(). */
+    void unkeyed (QofInstance* inst, guint ordinal);
+
+private:
+    void rebuild ();
+    guint64 generation () const noexcept;
+
+    QofBook* m_book;
+    std::string m_obj_type;
+    const QofQueryParamList* m_param_list;
+    std::vector<const QofParam*> m_params;
+    std::string m_name;
+    /* The collections of the types on the path, whose generations are
+     * summed to tell whether the index is stale. */
+    std::vector<QofCollection*> m_collections;
+    /* Objects for which the path couldn't be followed. */
+    QofQueryIndexHits m_unkeyed;
+    std::size_t m_population = 0;
+    bool m_built = false;
+    guint64 m_generation = 0;
+    /* The generation at the last acquire() that found the index stale. */
+    guint64 m_wanted_generation = 0;
+    bool m_wanted = false;
+};
+
+/** @return the indexes of book over the registered paths of obj_type,
+ * creating them on first use. They are owned by the book.
+ */
+const std::vector<QofQueryIndex*>& qof_query_book_indexes (QofBook* book,
+                                                           QofIdTypeConst obj_type);
+
+/** Forget all registered paths; for qof_query_shutdown(). */
+void qof_query_index_shutdown ();
+
+#endif /* QOF_QUERY_INDEX_HPP */
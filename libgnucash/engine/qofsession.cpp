@@ -423,9 +423,12 @@ QofSessionImpl::is_saving () const noexcept
 /* Manipulators (save, load, etc.) -------------------------*/
 
 void
-QofSessionImpl::save (QofPercentageFunc percentage_func) noexcept
+QofSessionImpl::save (QofPercentageFunc percentage_func, bool incremental) noexcept
 {
-    if (!qof_book_session_not_saved (m_book)) //Clean book, nothing to do.
+    /* Clean book, nothing to do; unless a full save still has to fold the
+     * journal of an incremental one into the file. */
+    if (!qof_book_session_not_saved (m_book)
+        && (incremental || !qof_book_session_journaled (m_book)))
         return;
     m_saving = true;
     ENTER ("sess=%p book_id=%s", this, m_book_id.c_str ());
@@ -441,7 +444,10 @@ QofSessionImpl::save (QofPercentageFunc percentage_func) noexcept
     {
 
         backend->set_percentage(percentage_func);
-        backend->sync(m_book);
+        if (incremental)
+            backend->sync_incremental(m_book);
+        else
+            backend->sync(m_book);
         auto err = backend->get_error();
         if (err != ERR_BACKEND_NO_ERR)
         {
@@ -615,6 +621,14 @@ qof_session_save (QofSession *session,
     session->save (percentage_func);
 }
 
+void
+qof_session_save_incremental (QofSession *session,
+                              QofPercentageFunc percentage_func)
+{
+    if (!session) return;
+    session->save (percentage_func, true);
+}
+
 void
 qof_session_safe_save(QofSession *session, QofPercentageFunc percentage_func)
 {
@@ -236,6 +236,13 @@ QofBackend * qof_session_get_backend(const QofSession *session);
 void     qof_session_save (QofSession *session,
                            QofPercentageFunc percentage_func);
 
+/** Like qof_session_save(), but lets the backend store just the changes
+ *    since the last save where it can, as the XML backend does with a
+ *    journal next to the data file. Meant for auto-saves.
+ */
+void     qof_session_save_incremental (QofSession *session,
+                                       QofPercentageFunc percentage_func);
+
 /**
  * A special version of save used in the sql backend which moves the
  * existing tables aside, then saves everything to new tables, then
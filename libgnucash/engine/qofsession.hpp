@@ -47,7 +47,7 @@ struct QofSessionImpl
     void swap_books (QofSessionImpl &) noexcept;
     void ensure_all_data_loaded () noexcept;
     void load (QofPercentageFunc) noexcept;
-    void save (QofPercentageFunc) noexcept;
+    void save (QofPercentageFunc, bool incremental = false) noexcept;
     void safe_save (QofPercentageFunc) noexcept;
     bool save_in_progress () const noexcept;
     bool export_session (QofSessionImpl & real_session, QofPercentageFunc) noexcept;
@@ -23,6 +23,7 @@
 \********************************************************************/
 
 #include "../gnc-datetime.hpp"
+#include <random>
 #include <gtest/gtest.h>
 
 /* Backdoor to enable unittests to temporarily override the timezone: */
@@ -426,6 +427,77 @@ TEST(gnc_datetime_functions, test_date)
     EXPECT_EQ(ymd.month, 11);
     EXPECT_EQ(ymd.day - (12 + atime.offset() / 3600) / 24, 13);
 }
+static bool
+same_tm(const struct tm& a, const struct tm& b)
+{
+    return a.tm_sec == b.tm_sec && a.tm_min == b.tm_min &&
+        a.tm_hour == b.tm_hour && a.tm_mday == b.tm_mday &&
+        a.tm_mon == b.tm_mon && a.tm_year == b.tm_year &&
+        a.tm_wday == b.tm_wday && a.tm_yday == b.tm_yday &&
+        a.tm_isdst == b.tm_isdst;
+}
+
+/* The batch conversions take the UTC offset from a table of the zone's
+ * transitions rather than from boost, so check them against GncDateTime
+ * around the transitions of zones on both sides of the equator and at
+ * random times across the whole supported range.
+ */
+TEST(gnc_datetime_functions, test_batch_conversions)
+{
+#ifdef __MINGW32__
+    const char* zones[] = {"GMT Standard Time", "Eastern Standard Time",
+                           "AUS Eastern Standard Time", "India Standard Time"};
+#else
+    const char* zones[] = {"Europe/London", "America/New_York",
+                           "Australia/Sydney", "Asia/Kolkata"};
+#endif
+    std::vector<time64> times;
+    for (time64 t = 1451606400; t < 1483228800; t += 3600) // 2016
+    {
+        times.push_back(t);
+        times.push_back(t - 1);
+    }
+    std::mt19937_64 gen(1234);
+    std::uniform_int_distribution<time64> any_time(MINTIME, MAXTIME);
+    for (int i = 0; i < 2000; ++i)
+        times.push_back(any_time(gen));
+
+    for (auto zone : zones)
+    {
+        TimeZoneProvider tzp(zone);
+        _set_tzp(tzp);
+        std::vector<struct tm> tms(times.size());
+        std::vector<ymd> dates(times.size());
+        std::vector<std::string> local(times.size()), zoned(times.size());
+        GncDateTime::local_tm(times.data(), times.size(), tms.data());
+        GncDateTime::local_dates(times.data(), times.size(), dates.data());
+        GncDateTime::format(times.data(), times.size(), "%Y-%m-%d %H:%M:%S",
+                            local.data());
+        GncDateTime::format(times.data(), times.size(), "%d/%m/%Y %H:%M %z",
+                            zoned.data());
+        for (size_t i = 0; i < times.size(); ++i)
+        {
+            GncDateTime gncdt(times[i]);
+            auto date = gncdt.date().year_month_day();
+            if (!same_tm(static_cast<struct tm>(gncdt), tms[i]) ||
+                date.year != dates[i].year || date.month != dates[i].month ||
+                date.day != dates[i].day ||
+                gncdt.format("%Y-%m-%d %H:%M:%S") != local[i] ||
+                gncdt.format("%d/%m/%Y %H:%M %z") != zoned[i])
+            {
+                ADD_FAILURE() << zone << ": conversions of " << times[i]
+                              << " differ: " << zoned[i];
+                break;
+            }
+        }
+        _reset_tzp();
+    }
+
+    struct tm tm;
+    time64 bad_time = MAXTIME + 2 * 86400;
+    EXPECT_THROW(GncDateTime::local_tm(&bad_time, 1, &tm), std::invalid_argument);
+}
+
 /* This test works only in the America/LosAngeles time zone and
  * there's no way at present to make it more flexible.
 TEST(gnc_datetime_functions, test_timezone_offset)
@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 #include "../gnc-numeric.hpp"
 #include "../gnc-rational.hpp"
+#include <vector>
 
 TEST(gncnumeric_constructors, test_default_constructor)
 {
@@ -319,6 +320,71 @@ TEST(gncnumeric_operators, test_addition)
     EXPECT_EQ (1000000000, a.denom());
 }
 
+TEST(gncnumeric_operators, test_addition_same_denom)
+{
+    GncNumeric a(INT64_C(9223372036854775000), 100);
+    GncNumeric b(807, 100);
+    GncNumeric c = a + b;
+    EXPECT_EQ (INT64_MAX, c.num());
+    EXPECT_EQ (100, c.denom());
+    gnc_numeric d = gnc_numeric_add_fixed(static_cast<gnc_numeric>(a),
+                                          static_cast<gnc_numeric>(b));
+    EXPECT_EQ (INT64_MAX, d.num);
+    EXPECT_EQ (100, d.denom);
+    d = gnc_numeric_sub_fixed(gnc_numeric_create(INT64_MIN + 7, 100),
+                              gnc_numeric_create(7, 100));
+    EXPECT_EQ (INT64_MIN, d.num);
+    EXPECT_EQ (100, d.denom);
+    /* Overflowing 64 bits goes the long way round and is rounded. */
+    d = gnc_numeric_add_fixed(static_cast<gnc_numeric>(a),
+                              gnc_numeric_create(1000, 100));
+    EXPECT_NE (100, d.denom);
+}
+
+TEST(gncnumeric_operators, test_sum)
+{
+    std::vector<GncNumeric> values;
+    std::vector<gnc_numeric> cvalues;
+    for (int64_t i = 1; i <= 1000; ++i)
+    {
+        values.emplace_back(i * 1001, 100);
+        cvalues.push_back(gnc_numeric_create(i * 1001, 100));
+    }
+    auto sum = GncNumeric::sum(values.data(), values.size());
+    EXPECT_EQ (INT64_C(501000500), sum.num());
+    EXPECT_EQ (100, sum.denom());
+    auto csum = gnc_numeric_sum_array(cvalues.data(), cvalues.size(),
+                                      GNC_DENOM_AUTO, GNC_HOW_DENOM_FIXED |
+                                      GNC_HOW_RND_NEVER);
+    EXPECT_EQ (INT64_C(501000500), csum.num);
+    EXPECT_EQ (100, csum.denom);
+
+    /* Only the total has to fit in 64 bits. */
+    gnc_numeric big[] {gnc_numeric_create(INT64_MAX, 100),
+            gnc_numeric_create(1, 100), gnc_numeric_create(-2, 100)};
+    csum = gnc_numeric_sum_array(big, 3, GNC_DENOM_AUTO,
+                                 GNC_HOW_DENOM_FIXED | GNC_HOW_RND_NEVER);
+    EXPECT_EQ (INT64_MAX - 1, csum.num);
+    EXPECT_EQ (100, csum.denom);
+
+    /* Mixed denominators are added one by one. */
+    values.emplace_back(1, 3);
+    sum = GncNumeric::sum(values.data(), values.size());
+    EXPECT_EQ (INT64_C(1503001600), sum.num());
+    EXPECT_EQ (300, sum.denom());
+    cvalues.push_back(gnc_numeric_create(1, 1000));
+    csum = gnc_numeric_sum_array(cvalues.data(), cvalues.size(),
+                                 GNC_DENOM_AUTO, GNC_HOW_DENOM_LCD |
+                                 GNC_HOW_RND_NEVER);
+    EXPECT_EQ (INT64_C(5010005001), csum.num);
+    EXPECT_EQ (1000, csum.denom);
+
+    EXPECT_EQ (0, GncNumeric::sum(values.data(), 0).num());
+    EXPECT_TRUE (gnc_numeric_zero_p(gnc_numeric_sum_array(cvalues.data(), 0,
+                                                          GNC_DENOM_AUTO,
+                                                          GNC_HOW_DENOM_FIXED)));
+}
+
 TEST(gncnumeric_operators, test_subtraction)
 {
     GncNumeric a(123456789987654321, 1000000000);
@@ -0,0 +1,141 @@
+/********************************************************************
+ * gtest-guid-map.cpp -- Unit tests for GncGUIDMap.                 *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+ ********************************************************************/
+
+#include "../guid-map.hpp"
+
+#include <map>
+#include <random>
+#include <vector>
+#include <gtest/gtest.h>
+
+static std::vector<GncGUID>
+random_guids (std::size_t count)
+{
+    std::vector<GncGUID> guids (count);
+    for (auto& guid : guids)
+        guid_replace (&guid);
+    return guids;
+}
+
+/* GUIDs which differ only in their last byte, like hand-written test data. */
+static std::vector<GncGUID>
+sequential_guids (std::size_t count)
+{
+    std::vector<GncGUID> guids (count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        memset (guids[i].reserved, 0, GUID_DATA_SIZE);
+        guids[i].reserved[GUID_DATA_SIZE - 1] = i & 0xff;
+        guids[i].reserved[GUID_DATA_SIZE - 2] = (i >> 8) & 0xff;
+    }
+    return guids;
+}
+
+TEST (GncGUIDMap, empty)
+{
+    GncGUIDMap<int> map;
+    GncGUID guid;
+    guid_replace (&guid);
+    EXPECT_TRUE (map.empty ());
+    EXPECT_EQ (nullptr, map.find (guid));
+    EXPECT_FALSE (map.erase (guid));
+}
+
+TEST (GncGUIDMap, insert_find_erase)
+{
+    auto guids = random_guids (1000);
+    GncGUIDMap<std::size_t> map;
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        map.insert_or_assign (guids[i], i);
+    EXPECT_EQ (guids.size (), map.size ());
+    for (std::size_t i = 0; i < guids.size (); ++i)
+    {
+        auto found = map.find (guids[i]);
+        ASSERT_NE (nullptr, found);
+        EXPECT_EQ (i, *found);
+    }
+
+    map.insert_or_assign (guids[3], 42);
+    EXPECT_EQ (guids.size (), map.size ());
+    EXPECT_EQ (42u, *map.find (guids[3]));
+
+    for (std::size_t i = 0; i < guids.size (); i += 2)
+        EXPECT_TRUE (map.erase (guids[i]));
+    EXPECT_FALSE (map.erase (guids[0]));
+    EXPECT_EQ (guids.size () / 2, map.size ());
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        EXPECT_EQ (i % 2 != 0, map.find (guids[i]) != nullptr);
+
+    map.clear ();
+    EXPECT_TRUE (map.empty ());
+    EXPECT_EQ (nullptr, map.find (guids[1]));
+}
+
+TEST (GncGUIDMap, sequential_keys)
+{
+    auto guids = sequential_guids (5000);
+    GncGUIDMap<std::size_t> map;
+    map.reserve (guids.size ());
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        map.insert_or_assign (guids[i], i);
+    for (std::size_t i = 0; i < guids.size (); ++i)
+        EXPECT_EQ (i, *map.find (guids[i]));
+}
+
+/* Mix insertions and erasures and compare with std::map, so that the
+ * backward shifting on erase gets exercised around wrapped probes. */
+TEST (GncGUIDMap, random_operations)
+{
+    auto guids = random_guids (300);
+    auto cmp = [](const GncGUID& a, const GncGUID& b)
+    {
+        return memcmp (a.reserved, b.reserved, GUID_DATA_SIZE) < 0;
+    };
+    std::map<GncGUID, int, decltype(cmp)> reference (cmp);
+    GncGUIDMap<int> map;
+    std::mt19937 gen (1234);
+    std::uniform_int_distribution<std::size_t> pick (0, guids.size () - 1);
+
+    for (int i = 0; i < 20000; ++i)
+    {
+        auto& guid = guids[pick (gen)];
+        if (gen () % 3)
+        {
+            map.insert_or_assign (guid, i);
+            reference[guid] = i;
+        }
+        else
+            EXPECT_EQ (reference.erase (guid) != 0, map.erase (guid));
+    }
+    EXPECT_EQ (reference.size (), map.size ());
+    for (auto& guid : guids)
+    {
+        auto found = map.find (guid);
+        auto ref = reference.find (guid);
+        if (ref == reference.end ())
+            EXPECT_EQ (nullptr, found);
+        else
+        {
+            ASSERT_NE (nullptr, found);
+            EXPECT_EQ (ref->second, *found);
+        }
+    }
+}
@@ -72,6 +72,12 @@ test_strings strs[] =
         "xml:///test/path/file.gnucash",
         "xml:///test/path/file.gnucash", TRUE
     },
+    {
+        "gncbin:///test/path/file.gnucash", FALSE,
+        "gncbin", NULL, NULL, NULL, "/test/path/file.gnucash", 0,
+        "gncbin:///test/path/file.gnucash",
+        "gncbin:///test/path/file.gnucash", TRUE
+    },
     {
         "sqlite3:///test/path/file.gnucash", FALSE,
         "sqlite3", NULL, NULL, NULL, "/test/path/file.gnucash", 0,
@@ -98,6 +104,12 @@ test_strings strs[] =
         "xml://c:\\test\\path\\file.gnucash",
         "xml://c:\\test\\path\\file.gnucash", TRUE
     },
+    {
+        "gncbin://c:\\test\\path\\file.gnucash", FALSE,
+        "gncbin", NULL, NULL, NULL, "c:\\test\\path\\file.gnucash", 0,
+        "gncbin://c:\\test\\path\\file.gnucash",
+        "gncbin://c:\\test\\path\\file.gnucash", TRUE
+    },
     {
         "sqlite3://c:\\test\\path\\file.gnucash", FALSE,
         "sqlite3", NULL, NULL, NULL, "c:\\test\\path\\file.gnucash", 0,
@@ -226,3 +226,45 @@ TEST (KvpFrameTestForEachPrefix, for_each_prefix_2)
             EXPECT_EQ(value->get_type(), KvpValue::Type::INT64);
         }, count);
 }
+
+TEST_F (KvpFrameTest, PrecompiledPath)
+{
+    KvpPath path1 {{"top", "second", "twenty-first"}};
+    KvpPath path2 {{"top", "third", "thirty-first"}};
+    KvpPath path3 {{"top", "first"}};
+    auto v1 = new KvpValueImpl {15.0};
+    auto v2 = new KvpValueImpl { (int64_t)52};
+
+    EXPECT_EQ (3ul, path1.size ());
+    EXPECT_EQ (t_int_val, t_root.get_slot(path3));
+    EXPECT_EQ (nullptr, t_root.set(path1, v1));
+    EXPECT_EQ (v1, t_root.get_slot(Path {"top", "second", "twenty-first"}));
+    EXPECT_EQ (v1, t_root.set(path1, v2));
+    EXPECT_EQ (nullptr, t_root.set(path2, v1));
+    EXPECT_EQ (nullptr, t_root.set_path(path2, v1));
+    EXPECT_EQ (v1, t_root.get_slot(path2));
+    auto copy = path2;
+    EXPECT_EQ (v1, t_root.get_slot(copy));
+    EXPECT_EQ (v1, t_root.set_path(copy, nullptr));
+    EXPECT_EQ (nullptr, t_root.get_slot(path2));
+    delete v1;
+}
+
+TEST (KvpFrameTestOrder, keys_sorted)
+{
+    KvpFrame fr;
+    std::vector<std::string> keys {"delta", "alpha", "echo", "charlie", "bravo"};
+    for (auto const & key : keys)
+        fr.set({key}, new KvpValue {static_cast<int64_t>(key.size ())});
+    auto stored = fr.get_keys ();
+    EXPECT_EQ (keys.size (), stored.size ());
+    EXPECT_TRUE (std::is_sorted (stored.begin (), stored.end ()));
+    for (auto const & key : keys)
+        EXPECT_EQ (static_cast<int64_t>(key.size ()),
+                   fr.get_slot({key})->get<int64_t>());
+    delete fr.set({"charlie"}, nullptr);
+    EXPECT_EQ (nullptr, fr.get_slot({"charlie"}));
+    EXPECT_EQ (keys.size () - 1, fr.get_keys ().size ());
+    KvpFrame copy {fr};
+    EXPECT_EQ (0, compare (fr, copy));
+}
@@ -77,8 +77,105 @@ test_qof_string_cache( void )
     g_assert(str1_1 != str1_4);
 }
 
+static void
+test_qof_string_cache_atoms( void )
+{
+    QofStringAtom atom1, atom2, atom3;
+    gchar* str1 = qof_string_cache_insert_atom("atom1", &atom1);
+    gchar* str2 = qof_string_cache_insert_atom("atom2", &atom2);
+    gchar* str3 = qof_string_cache_insert_atom("atom1", &atom3);
+
+    g_assert(str1 == str3);
+    g_assert(atom1 != QOF_STRING_ATOM_NONE);
+    g_assert(atom1 != atom2);
+    g_assert(atom1 == atom3);
+    g_assert(qof_string_cache_atom("atom2") == atom2);
+    g_assert(qof_string_cache_atom("no such atom") == QOF_STRING_ATOM_NONE);
+    g_assert(qof_string_cache_atom_to_string(atom1) == str1);
+
+    g_assert(qof_string_cache_insert_atom(NULL, &atom3) == NULL);
+    g_assert(atom3 == QOF_STRING_ATOM_NONE);
+
+    qof_string_cache_remove(str1);
+    qof_string_cache_remove(str1);
+    qof_string_cache_remove(str2);
+    g_assert(qof_string_cache_atom("atom1") == QOF_STRING_ATOM_NONE);
+    g_assert(qof_string_cache_atom_to_string(atom1) == NULL);
+}
+
+static void
+test_qof_string_cache_stats( void )
+{
+    QofStringCacheStats before, after;
+    gchar* str;
+
+    qof_string_cache_get_stats(&before);
+    str = qof_string_cache_insert("stats");
+    qof_string_cache_insert("stats");
+    qof_string_cache_get_stats(&after);
+    g_assert_cmpuint(after.misses, ==, before.misses + 1);
+    g_assert_cmpuint(after.hits, ==, before.hits + 1);
+    g_assert_cmpuint(after.strings, ==, before.strings + 1);
+    g_assert_cmpuint(after.bytes, ==, before.bytes + strlen("stats") + 1);
+    g_assert_cmpuint(after.arena_bytes, >=, after.bytes);
+
+    qof_string_cache_remove(str);
+    qof_string_cache_remove(str);
+    qof_string_cache_get_stats(&after);
+    g_assert_cmpuint(after.strings, ==, before.strings);
+    g_assert_cmpuint(after.bytes, ==, before.bytes);
+}
+
+#define THREAD_STRINGS 2000
+
+static gpointer
+string_cache_thread (gpointer data)
+{
+    gchar buf[32];
+    gchar* cached[THREAD_STRINGS];
+    gboolean ok = TRUE;
+    int round, i;
+
+    for (round = 0; round < 10; round++)
+    {
+        for (i = 0; i < THREAD_STRINGS; i++)
+        {
+            g_snprintf (buf, sizeof (buf), "thread-%d", i);
+            cached[i] = qof_string_cache_insert (buf);
+            ok = ok && strcmp (cached[i], buf) == 0;
+        }
+        for (i = 0; i < THREAD_STRINGS; i++)
+            qof_string_cache_remove (cached[i]);
+    }
+    return GINT_TO_POINTER (ok);
+}
+
+static void
+test_qof_string_cache_threads( void )
+{
+    GThread *threads[4];
+    QofStringCacheStats before, after;
+    guint i;
+
+    qof_string_cache_get_stats(&before);
+    for (i = 0; i < G_N_ELEMENTS (threads); i++)
+        threads[i] = g_thread_new ("string-cache", string_cache_thread, NULL);
+    for (i = 0; i < G_N_ELEMENTS (threads); i++)
+        g_assert (g_thread_join (threads[i]));
+    qof_string_cache_get_stats(&after);
+    g_assert_cmpuint(after.strings, ==, before.strings);
+    /* The blocks the threads filled are all freed again. */
+    g_assert_cmpuint(after.arena_bytes, ==, before.arena_bytes);
+    g_assert_cmpuint(after.hits + after.misses, ==,
+                     before.hits + before.misses +
+                     G_N_ELEMENTS (threads) * 10 * THREAD_STRINGS);
+}
+
 void
 test_suite_qof_string_cache ( void )
 {
     GNC_TEST_ADD_FUNC( suitename, "string-cache", test_qof_string_cache);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache atoms", test_qof_string_cache_atoms);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache stats", test_qof_string_cache_stats);
+    GNC_TEST_ADD_FUNC( suitename, "string-cache threads", test_qof_string_cache_threads);
 }
@@ -0,0 +1,230 @@
+/********************************************************************
+ * test-qofevent.cpp: GLib g_test test suite for qofevent.          *
+ *                                                                  *
+ * This program is free software; you can redistribute it and/or    *
+ * modify it under the terms of the GNU General Public License as   *
+ * published by the Free Software Foundation; either version 2 of   *
+ * the License, or (at your option) any later version.              *
+ *                                                                  *
+ * This program is distributed in the hope that it will be useful,  *
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of   *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the    *
+ * GNU General Public License for more details.                     *
+ *                                                                  *
+ * You should have received a copy of the GNU General Public License*
+ * along with this program; if not, contact:                        *
+ *                                                                  *
+ * Free Software Foundation           Voice:  +1-617-542-5942       *
+ * 51 Franklin Street, Fifth Floor    Fax:    +1-617-542-2652       *
+ * Boston, MA  02110-1301,  USA       gnu@gnu.org                   *
+\********************************************************************/
+
+extern "C"
+{
+#include <config.h>
+#include <glib.h>
+#include <unittest-support.h>
+#include "../qof.h"
+}
+#include <vector>
+
+static const gchar *suitename = "/qof/qofevent";
+extern "C" void test_suite_qofevent ( void );
+
+struct Event
+{
+    QofInstance *ent;
+    QofEventId type;
+    gpointer data;
+    bool operator==( const Event& other ) const
+    {
+        return ent == other.ent && type == other.type && data == other.data;
+    }
+};
+
+typedef std::vector<Event> Events;
+
+typedef struct
+{
+    QofBook *book;
+    QofInstance *inst1;
+    QofInstance *inst2;
+    Events events;
+    gint handler;
+} Fixture;
+
+static void
+record_event( QofInstance *ent, QofEventId event_type, gpointer handler_data,
+              gpointer event_data )
+{
+    auto events = static_cast<Events*>( handler_data );
+    events->push_back( { ent, event_type, event_data } );
+}
+
+static void
+setup( Fixture *fixture, gconstpointer pData )
+{
+    fixture->book = qof_book_new();
+    fixture->inst1 = static_cast<QofInstance*>( g_object_new( QOF_TYPE_INSTANCE, NULL ) );
+    fixture->inst2 = static_cast<QofInstance*>( g_object_new( QOF_TYPE_INSTANCE, NULL ) );
+    qof_instance_init_data( fixture->inst1, "type1", fixture->book );
+    qof_instance_init_data( fixture->inst2, "type2", fixture->book );
+    new ( &fixture->events ) Events;
+    fixture->handler = qof_event_register_handler( record_event, &fixture->events );
+}
+
+static void
+teardown( Fixture *fixture, gconstpointer pData )
+{
+    qof_event_unregister_handler( fixture->handler );
+    fixture->events.~Events();
+    g_object_unref( fixture->inst1 );
+    g_object_unref( fixture->inst2 );
+    qof_book_destroy( fixture->book );
+}
+
+static void
+test_event_gen( Fixture *fixture, gconstpointer pData )
+{
+    int data;
+    Events expected {
+        { fixture->inst1, QOF_EVENT_MODIFY, NULL },
+        { fixture->inst1, QOF_EVENT_MODIFY, NULL },
+        { fixture->inst2, QOF_EVENT_ADD, &data },
+    };
+
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst2, QOF_EVENT_ADD, &data );
+    g_assert( fixture->events == expected );
+
+    g_test_message( "Test that suspended events are dropped" );
+    fixture->events.clear();
+    qof_event_suspend();
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_resume();
+    g_assert( fixture->events.empty() );
+}
+
+static void
+test_event_batch( Fixture *fixture, gconstpointer pData )
+{
+    int data;
+    Events batched;
+    gint batch_handler = qof_event_register_batch_handler( record_event, &batched );
+
+    qof_event_begin_batch();
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst2, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_ADD, NULL );
+
+    g_test_message( "Test that events with data are delivered at once" );
+    qof_event_gen( fixture->inst2, QOF_EVENT_REMOVE, &data );
+    Events expected { { fixture->inst2, QOF_EVENT_REMOVE, &data } };
+    g_assert( fixture->events == expected );
+    g_assert( batched == expected );
+    fixture->events.clear();
+    batched.clear();
+
+    g_test_message( "Test that nested batches are delivered by the outermost" );
+    qof_event_begin_batch();
+    qof_event_gen( fixture->inst2, QOF_EVENT_MODIFY, NULL );
+    qof_event_end_batch();
+    g_assert( fixture->events.empty() );
+
+    qof_event_end_batch();
+    expected = {
+        { fixture->inst1, QOF_EVENT_MODIFY, NULL },
+        { fixture->inst1, QOF_EVENT_ADD, NULL },
+        { fixture->inst2, QOF_EVENT_MODIFY, NULL },
+    };
+    g_assert( fixture->events == expected );
+    expected = {
+        { fixture->inst1, QOF_EVENT_MODIFY | QOF_EVENT_ADD, NULL },
+        { fixture->inst2, QOF_EVENT_MODIFY, NULL },
+    };
+    g_assert( batched == expected );
+
+    g_test_message( "Test that a destroy event delivers the queued events first" );
+    fixture->events.clear();
+    qof_event_begin_batch();
+    qof_event_gen( fixture->inst2, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_DESTROY, NULL );
+    expected = {
+        { fixture->inst1, QOF_EVENT_MODIFY, NULL },
+        { fixture->inst1, QOF_EVENT_DESTROY, NULL },
+    };
+    g_assert( fixture->events == expected );
+    qof_event_end_batch();
+    g_assert_cmpint( fixture->events.size(), == , 3 );
+    g_assert( fixture->events[2] == ( Event { fixture->inst2, QOF_EVENT_MODIFY, NULL } ) );
+
+    g_test_message( "Test that merged events are replayed in the order they were queued" );
+    fixture->events.clear();
+    batched.clear();
+    qof_event_begin_batch();
+    qof_event_gen( fixture->inst1, QOF_EVENT_REMOVE, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_ADD, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_REMOVE, NULL );
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_end_batch();
+    expected = {
+        { fixture->inst1, QOF_EVENT_REMOVE, NULL },
+        { fixture->inst1, QOF_EVENT_ADD, NULL },
+        { fixture->inst1, QOF_EVENT_MODIFY, NULL },
+    };
+    g_assert( fixture->events == expected );
+    expected = {
+        { fixture->inst1, QOF_EVENT_REMOVE | QOF_EVENT_ADD | QOF_EVENT_MODIFY, NULL },
+    };
+    g_assert( batched == expected );
+
+    qof_event_unregister_handler( batch_handler );
+}
+
+static void
+test_event_filter( Fixture *fixture, gconstpointer pData )
+{
+    QofIdType types[] = { "type2", NULL };
+
+    qof_event_set_handler_filter( fixture->handler, types, QOF_EVENT_NONE );
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst2, QOF_EVENT_MODIFY, NULL );
+    Events expected { { fixture->inst2, QOF_EVENT_MODIFY, NULL } };
+    g_assert( fixture->events == expected );
+
+    g_test_message( "Test filtering by event" );
+    fixture->events.clear();
+    qof_event_set_handler_filter( fixture->handler, NULL, QOF_EVENT_DESTROY );
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst2, QOF_EVENT_DESTROY, NULL );
+    expected = { { fixture->inst2, QOF_EVENT_DESTROY, NULL } };
+    g_assert( fixture->events == expected );
+
+    g_test_message( "Test that a batch only passes on the wanted events" );
+    fixture->events.clear();
+    qof_event_set_handler_filter( fixture->handler, types, QOF_EVENT_ADD );
+    qof_event_begin_batch();
+    qof_event_gen( fixture->inst1, QOF_EVENT_ADD, NULL );
+    qof_event_gen( fixture->inst2, QOF_EVENT_MODIFY, NULL );
+    qof_event_gen( fixture->inst2, QOF_EVENT_ADD, NULL );
+    qof_event_end_batch();
+    expected = { { fixture->inst2, QOF_EVENT_ADD, NULL } };
+    g_assert( fixture->events == expected );
+
+    g_test_message( "Test removing the filter" );
+    fixture->events.clear();
+    qof_event_set_handler_filter( fixture->handler, NULL, QOF_EVENT_NONE );
+    qof_event_gen( fixture->inst1, QOF_EVENT_MODIFY, NULL );
+    g_assert_cmpint( fixture->events.size(), == , 1 );
+}
+
+void
+test_suite_qofevent ( void )
+{
+    GNC_TEST_ADD( suitename, "event gen", Fixture, NULL, setup, test_event_gen, teardown );
+    GNC_TEST_ADD( suitename, "event batch", Fixture, NULL, setup, test_event_batch, teardown );
+    GNC_TEST_ADD( suitename, "event filter", Fixture, NULL, setup, test_event_filter, teardown );
+}
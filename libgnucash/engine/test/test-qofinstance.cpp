@@ -30,6 +30,8 @@ extern "C"
 }
 #include "../qof-backend.hpp"
 #include "../kvp-frame.hpp"
+#include "../qofid.hpp"
+#include <vector>
 static const gchar *suitename = "/qof/qofinstance";
 extern "C" void test_suite_qofinstance ( void );
 static gchar* error_message;
@@ -979,6 +981,118 @@ test_instance_get_referring_object_list( void )
     qof_book_destroy( book );
 }
 
+static void
+collect_instance( QofInstance *inst, gpointer data )
+{
+    static_cast<std::vector<QofInstance*>*>( data )->push_back( inst );
+}
+
+static void
+test_book_instance_memory( void )
+{
+    const guint num_insts = 10;
+    QofIdType type = "test type";
+    QofBook *book = qof_book_new();
+    std::vector<QofInstance*> insts;
+    gsize one;
+    guint i;
+
+    g_assert_cmpuint( qof_book_get_instance_memory( book, type ), == , 0 );
+    for ( i = 0; i < num_insts; i++ )
+    {
+        auto inst = static_cast<QofInstance*>( g_object_new( QOF_TYPE_INSTANCE, NULL ) );
+        qof_instance_init_data( inst, type, book );
+        insts.push_back( inst );
+    }
+    one = qof_book_get_instance_memory( book, type ) / num_insts;
+    g_assert_cmpuint( one, >= , sizeof( QofInstance ) );
+    g_assert_cmpuint( qof_book_get_instance_memory( book, type ), == , num_insts * one );
+    g_assert_cmpuint( qof_collection_get_instance_memory( qof_book_get_collection( book, type ) ),
+                      == , num_insts * one );
+
+    g_test_message( "Test that destroyed instances are no longer counted" );
+    for ( i = 0; i < num_insts / 2; i++ )
+        g_object_unref( insts[i] );
+    g_assert_cmpuint( qof_book_get_instance_memory( book, type ), == , ( num_insts / 2 ) * one );
+    for ( ; i < num_insts; i++ )
+        g_object_unref( insts[i] );
+    g_assert_cmpuint( qof_book_get_instance_memory( book, type ), == , 0 );
+
+    qof_book_destroy( book );
+}
+
+static void
+test_collection_iteration( void )
+{
+    const guint num_insts = 200;
+    QofIdType type = "test type";
+    QofCollection *col = qof_collection_new( type );
+    std::vector<QofInstance*> insts, seen;
+    QofCollectionIter iter;
+    QofInstance *inst;
+    guint i;
+
+    for ( i = 0; i < num_insts; i++ )
+    {
+        GncGUID guid;
+        guid_replace( &guid );
+        inst = static_cast<QofInstance*>( g_object_new( QOF_TYPE_INSTANCE,
+                                                        "guid", &guid, NULL ) );
+        inst->e_type = static_cast<QofIdType>( CACHE_INSERT( type ) );
+        qof_collection_insert_entity( col, inst );
+        insts.push_back( inst );
+    }
+    g_assert_cmpint( qof_collection_count( col ), == , num_insts );
+
+    g_test_message( "Test that foreach visits the entities in insertion order" );
+    qof_collection_foreach( col, collect_instance, &seen );
+    g_assert( seen == insts );
+
+    g_test_message( "Test that entities removed while iterating are skipped" );
+    seen.clear();
+    qof_collection_iter_init( &iter, col );
+    i = 0;
+    while ( ( inst = qof_collection_iter_next( &iter ) ) )
+    {
+        seen.push_back( inst );
+        /* Drop the odd-numbered entity following this one. */
+        if ( i + 1 < num_insts )
+            qof_collection_remove_entity( insts[i + 1] );
+        i += 2;
+    }
+    g_assert_cmpint( seen.size(), == , num_insts / 2 );
+    g_assert_cmpint( qof_collection_count( col ), == , num_insts / 2 );
+    for ( i = 0; i < num_insts; i++ )
+    {
+        const GncGUID *guid = qof_instance_get_guid( insts[i] );
+        g_assert( qof_collection_lookup_entity( col, guid ) ==
+                  ( i % 2 ? NULL : insts[i] ) );
+    }
+
+    g_test_message( "Test the C++ range after the removals were compacted" );
+    i = 0;
+    for ( auto ent : QofCollectionRange( col ) )
+    {
+        g_assert( ent == insts[i] );
+        g_assert( qof_collection_lookup_entity( col,
+                                                qof_instance_get_guid( ent ) ) == ent );
+        i += 2;
+    }
+    g_assert_cmpint( i, == , num_insts );
+
+    g_test_message( "Test that an abandoned iterator can be finished" );
+    qof_collection_iter_init( &iter, col );
+    g_assert( qof_collection_iter_next( &iter ) == insts[0] );
+    qof_collection_iter_finish( &iter );
+    qof_collection_iter_finish( &iter );
+    g_assert( qof_collection_iter_next( &iter ) == NULL );
+
+    for ( auto ent : insts )
+        g_object_unref( ent );
+    g_assert_cmpint( qof_collection_count( col ), == , 0 );
+    qof_collection_destroy( col );
+}
+
 extern "C" void
 test_suite_qofinstance ( void )
 {
@@ -997,4 +1111,6 @@ test_suite_qofinstance ( void )
     GNC_TEST_ADD_FUNC( suitename, "instance get referring object list from collection", test_instance_get_referring_object_list_from_collection );
     GNC_TEST_ADD_FUNC( suitename, "instance get typed referring object list", test_instance_get_typed_referring_object_list);
     GNC_TEST_ADD_FUNC( suitename, "instance get referring object list", test_instance_get_referring_object_list );
+    GNC_TEST_ADD_FUNC( suitename, "book instance memory", test_book_instance_memory );
+    GNC_TEST_ADD_FUNC( suitename, "collection iteration", test_collection_iteration );
 }
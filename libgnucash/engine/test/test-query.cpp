@@ -24,9 +24,11 @@ extern "C"
 {
 #include <config.h>
 #include <glib.h>
+#include <string.h>
 #include "qof.h"
 #include "cashobjects.h"
 #include "Transaction.h"
+#include "Query.h"
 #include "TransLog.h"
 #include "gnc-engine.h"
 #include "test-engine-stuff.h"
@@ -67,6 +69,278 @@ test_trans_query (Transaction *trans, gpointer data)
     return 0;
 }
 
+static int
+touch_transaction (Transaction *trans, gpointer data)
+{
+    xaccTransBeginEdit (trans);
+    xaccTransCommitEdit (trans);
+    return 1;
+}
+
+/* Run q twice after touching a transaction: the first run finds the split
+ * indexes stale and scans, the second rebuilds and uses them. Both have
+ * to find the same splits. Touching an account afterwards doesn't make
+ * the indexes on transactions stale. */
+static gboolean
+test_indexed_query (QofQuery *q, QofBook *book, gboolean expect_index)
+{
+    Account *root = gnc_book_get_root_account (book);
+    GList *scanned, *indexed, *n1, *n2;
+    gchar *plan;
+    gboolean ok = TRUE;
+
+    xaccAccountTreeForEachTransaction (root, touch_transaction, NULL);
+
+    scanned = g_list_copy (qof_query_run (q));
+    indexed = qof_query_run (q);
+    for (n1 = scanned, n2 = indexed; n1 && n2; n1 = n1->next, n2 = n2->next)
+        if (n1->data != n2->data)
+            break;
+    if (n1 || n2)
+    {
+        failure_args ("indexed query", __FILE__, __LINE__,
+                      "index found %d splits, scan found %d",
+                      g_list_length (indexed), g_list_length (scanned));
+        ok = FALSE;
+    }
+
+    xaccAccountBeginEdit (root);
+    xaccAccountCommitEdit (root);
+    plan = qof_query_explain (q);
+    if (expect_index && !strstr (plan, "Plan: index lookup"))
+    {
+        failure_args ("indexed query", __FILE__, __LINE__,
+                      "query didn't use an index:\n%s", plan);
+        ok = FALSE;
+    }
+    g_free (plan);
+    g_list_free (scanned);
+    return ok;
+}
+
+static void
+test_split_indexes (QofBook *book, Account *root)
+{
+    GList *accounts = gnc_account_get_descendants (root);
+    GList *node;
+    QofQuery *q;
+    Split *split = NULL;
+    time64 date;
+    gboolean ok = TRUE;
+
+    for (node = accounts; node; node = node->next)
+    {
+        Account *acc = static_cast<Account*>(node->data);
+        if (!split && xaccAccountGetSplitList (acc))
+            split = static_cast<Split*>(xaccAccountGetSplitList (acc)->data);
+
+        q = qof_query_create_for (GNC_ID_SPLIT);
+        qof_query_set_book (q, book);
+        xaccQueryAddSingleAccountMatch (q, acc, QOF_QUERY_AND);
+        ok = test_indexed_query (q, book, FALSE) && ok;
+        qof_query_destroy (q);
+    }
+    g_list_free (accounts);
+    if (!split)
+        return;
+
+    date = xaccTransRetDatePosted (xaccSplitGetParent (split));
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddDateMatchTT (q, TRUE, date, TRUE, date, QOF_QUERY_AND);
+    ok = test_indexed_query (q, book, TRUE) && ok;
+    qof_query_destroy (q);
+
+    q = qof_query_create_for (GNC_ID_SPLIT);
+    qof_query_set_book (q, book);
+    xaccQueryAddGUIDMatch (q, xaccTransGetGUID (xaccSplitGetParent (split)),
+                           GNC_ID_TRANS, QOF_QUERY_AND);
+    ok = test_indexed_query (q, book, TRUE) && ok;
+    qof_query_destroy (q);
+
+    if (ok)
+        success ("indexed split queries match scans");
+}
+
+static gboolean
+lists_equal (GList *l1, GList *l2)
+{
+    for (; l1 && l2; l1 = l1->next, l2 = l2->next)
+        if (l1->data != l2->data)
+            return FALSE;
+    return !l1 && !l2;
+}
+
+/* Read all the results of q through a cursor. */
+static GList *
+read_cursor (QofQuery *q, gint batch_size)
+{
+    QofQueryCursor *cursor = qof_query_run_cursor (q, batch_size);
+    GList *all = NULL, *batch;
+
+    while ((batch = qof_query_cursor_next (cursor)))
+    {
+        if ((gint)g_list_length (batch) > batch_size)
+            failure ("cursor batch too long");
+        all = g_list_concat (all, batch);
+    }
+    qof_query_cursor_destroy (cursor);
+    return all;
+}
+
+/* A limited run has to keep the same splits, in the same order, as
+ * cropping the unlimited one; cursors have to return the same as a run. */
+static void
+test_limits_and_cursors (QofBook *book)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    GList *all, *limited, *read, *tail;
+    gint count, limit;
+    gboolean ok = TRUE;
+
+    qof_query_set_book (q, book);
+    all = g_list_copy (qof_query_run (q));
+    count = g_list_length (all);
+
+    for (limit = 0; limit <= count + 1; limit += count / 4 + 1)
+    {
+        qof_query_set_max_results (q, limit);
+        limited = qof_query_run (q);
+        tail = limit < count ? g_list_nth (all, count - limit) : all;
+        ok = lists_equal (limited, tail) && ok;
+
+        read = read_cursor (q, 7);
+        ok = lists_equal (read, limited) && ok;
+        g_list_free (read);
+    }
+
+    qof_query_set_max_results (q, -1);
+    read = read_cursor (q, 5);
+    ok = lists_equal (read, all) && ok;
+    g_list_free (read);
+
+    /* Without a sort order the cursor streams, in collection order. */
+    qof_query_set_sort_order (q, NULL, NULL, NULL);
+    g_list_free (all);
+    all = g_list_copy (qof_query_run (q));
+    read = read_cursor (q, 3);
+    ok = lists_equal (read, all) && ok;
+    g_list_free (read);
+
+    g_list_free (all);
+    qof_query_destroy (q);
+    if (ok)
+        success ("limited queries and cursors match full runs");
+    else
+        failure ("limited queries or cursors differ from full runs");
+}
+
+static void
+test_parallel_query (QofBook *book)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    GList *serial;
+    gint threads[] = { 2, 4, 64, -1 };
+    gint count;
+    gboolean ok = TRUE;
+    guint i;
+
+    qof_query_set_book (q, book);
+    xaccQueryAddDescriptionMatch (q, "[aeiou].*[aeiou]", FALSE, TRUE,
+                                  QOF_COMPARE_CONTAINS, QOF_QUERY_AND);
+    xaccQueryAddValueMatch (q, gnc_numeric_zero (), QOF_NUMERIC_MATCH_CREDIT,
+                            QOF_COMPARE_GT, QOF_QUERY_OR);
+    serial = g_list_copy (qof_query_run (q));
+
+    for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+        qof_query_set_parallel (q, threads[i]);
+        ok = lists_equal (qof_query_run (q), serial) && ok;
+
+        qof_query_set_max_results (q, 3);
+        count = g_list_length (serial);
+        ok = lists_equal (qof_query_run (q),
+                          g_list_nth (serial, MAX (count - 3, 0))) && ok;
+        qof_query_set_max_results (q, -1);
+    }
+
+    g_list_free (serial);
+    qof_query_destroy (q);
+    if (ok)
+        success ("parallel queries match serial runs");
+    else
+        failure ("parallel queries differ from serial runs");
+}
+
+static int
+set_notes (Transaction *trans, gpointer data)
+{
+    gint *count = static_cast<gint*>(data);
+
+    xaccTransBeginEdit (trans);
+    xaccTransSetNotes (trans, (*count)++ % 3 ? "paid in cash" : "paid by cheque");
+    xaccTransCommitEdit (trans);
+    return 0;
+}
+
+/* Notes are kept in the transactions' kvp and cached on first use; the
+ * parallel run goes first so that the workers fill the caches. A term on
+ * a lazily cached balance must make the query run serially. */
+static void
+test_parallel_kvp_query (QofBook *book)
+{
+    QofQuery *q = qof_query_create_for (GNC_ID_SPLIT);
+    QofQueryPredData *pred;
+    GList *parallel;
+    gboolean ok = TRUE;
+    gchar *plan;
+    gint count = 0;
+
+    xaccAccountTreeForEachTransaction (gnc_book_get_root_account (book),
+                                       set_notes, &count);
+
+    qof_query_set_book (q, book);
+    pred = qof_query_string_predicate (QOF_COMPARE_CONTAINS, "cheque",
+                                       QOF_STRING_MATCH_NORMAL, FALSE);
+    qof_query_add_term (q, qof_query_build_param_list (SPLIT_TRANS,
+                                                       TRANS_NOTES, NULL),
+                        pred, QOF_QUERY_AND);
+    qof_query_set_parallel (q, 4);
+
+    plan = qof_query_explain (q);
+    if (strstr (plan, "Threads: 1\n"))
+    {
+        failure_args ("parallel kvp query", __FILE__, __LINE__,
+                      "query on notes doesn't run in parallel:\n%s", plan);
+        ok = FALSE;
+    }
+    g_free (plan);
+
+    parallel = g_list_copy (qof_query_run (q));
+    qof_query_set_parallel (q, 1);
+    ok = parallel && lists_equal (qof_query_run (q), parallel) && ok;
+    g_list_free (parallel);
+
+    xaccQueryAddNumericMatch (q, gnc_numeric_zero (), QOF_NUMERIC_MATCH_ANY,
+                              QOF_COMPARE_NEQ, QOF_QUERY_AND, SPLIT_BALANCE,
+                              NULL);
+    qof_query_set_parallel (q, 4);
+    plan = qof_query_explain (q);
+    if (!strstr (plan, "Threads: 1\n"))
+    {
+        failure_args ("parallel kvp query", __FILE__, __LINE__,
+                      "query on a balance runs in parallel:\n%s", plan);
+        ok = FALSE;
+    }
+    g_free (plan);
+
+    qof_query_destroy (q);
+    if (ok)
+        success ("parallel kvp queries match serial runs");
+    else
+        failure ("parallel kvp queries differ from serial runs");
+}
+
 static void
 run_test (void)
 {
@@ -81,6 +355,10 @@ run_test (void)
     add_random_transactions_to_book (book, 20);
 
     xaccAccountTreeForEachTransaction (root, test_trans_query, book);
+    test_split_indexes (book, root);
+    test_limits_and_cursors (book);
+    test_parallel_query (book);
+    test_parallel_kvp_query (book);
 
     qof_session_end (session);
 }
@@ -31,8 +31,10 @@ extern "C"
 #include "../Account.h"
 #include "../AccountP.h"
 #include "../Split.h"
+#include "../SplitP.h"
 #include "../Transaction.h"
 #include "../gnc-lot.h"
+#include "../gnc-pricedb.h"
 
 #if defined(__clang__) && (__clang_major__ == 5 || (__clang_major__ == 3 && __clang_minor__ < 5))
 #define USE_CLANG_FUNC_SIG 1
@@ -43,6 +45,7 @@ void test_suite_account (void);
 
 #include <qofinstance-p.h>
 #include <kvp-frame.hpp>
+#include "../gnc-split-index.hpp"
 
 typedef struct
 {
@@ -887,7 +890,7 @@ test_xaccFreeAccount (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert (!p_priv->splits->empty());
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1002,7 +1005,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     /* Check that we've got children, lots, and splits to remove */
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert (!p_priv->splits->empty());
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1018,7 +1021,7 @@ test_xaccAccountCommitEdit (Fixture *fixture, gconstpointer pData)
     test_signal_assert_hits (sig2, 0);
     g_assert (p_priv->children != NULL);
     g_assert (p_priv->lots != NULL);
-    g_assert (p_priv->splits != NULL);
+    g_assert (!p_priv->splits->empty());
     g_assert (p_priv->parent != NULL);
     g_assert (p_priv->commodity != NULL);
     g_assert_cmpint (check1->hits, ==, 0);
@@ -1102,19 +1105,19 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that the call fails with invalid account and split (throws) */
     g_assert (!gnc_account_insert_split (NULL, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->splits->size(), == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     g_assert (!gnc_account_insert_split (fixture->acct, NULL));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 0);
+    g_assert_cmpuint (priv->splits->size(), == , 0);
     g_assert (!priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 0);
     test_signal_assert_hits (sig2, 0);
     /* g_assert (!gnc_account_insert_split (fixture->acct, (Split*)priv)); */
-    /* g_assert_cmpuint (g_list_length (priv->splits), == , 0); */
+    /* g_assert_cmpuint (priv->splits->size(), == , 0); */
     /* g_assert (!priv->sort_dirty); */
     /* g_assert (!priv->balance_dirty); */
     /* test_signal_assert_hits (sig1, 0); */
@@ -1127,7 +1130,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
 
     /* Check that it works the first time */
     g_assert (gnc_account_insert_split (fixture->acct, split1));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 1);
+    g_assert_cmpuint (priv->splits->size(), == , 1);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 1);
@@ -1139,7 +1142,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_ADDED, split2);
     /* Now add a second split to the account and check that sort_dirty isn't set. We have to bump the editlevel to force this. */
     g_assert (gnc_account_insert_split (fixture->acct, split2));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->size(), == , 2);
     g_assert (!priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 2);
@@ -1150,7 +1153,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     qof_instance_increase_editlevel (fixture->acct);
     g_assert (gnc_account_insert_split (fixture->acct, split3));
     qof_instance_decrease_editlevel (fixture->acct);
-    g_assert_cmpuint (g_list_length (priv->splits), == , 3);
+    g_assert_cmpuint (priv->splits->size(), == , 3);
     g_assert (priv->sort_dirty);
     g_assert (priv->balance_dirty);
     test_signal_assert_hits (sig1, 3);
@@ -1161,7 +1164,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     sig3 = test_signal_new (&fixture->acct->inst, GNC_EVENT_ITEM_REMOVED,
                             split3);
     g_assert (gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->size(), == , 2);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1169,7 +1172,7 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     /* And do it again to make sure that it fails when the split has
      * already been removed */
     g_assert (!gnc_account_remove_split (fixture->acct, split3));
-    g_assert_cmpuint (g_list_length (priv->splits), == , 2);
+    g_assert_cmpuint (priv->splits->size(), == , 2);
     g_assert (priv->sort_dirty);
     g_assert (!priv->balance_dirty);
     test_signal_assert_hits (sig1, 4);
@@ -1179,6 +1182,45 @@ test_gnc_account_insert_remove_split (Fixture *fixture, gconstpointer pData)
     test_signal_free (sig3);
     test_signal_free (sig1);
 }
+/* xaccAccountGetSplitList
+SplitList *
+xaccAccountGetSplitList (const Account *acc)// C: 33 in 18 SCM: 13 in 7
+*/
+static void
+test_xaccAccountGetSplitList (Fixture *fixture, gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    Split *split = xaccMallocSplit (book);
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    SplitList *list = xaccAccountGetSplitList (fixture->acct);
+    SplitList *first = list, *node;
+    guint length = g_list_length (list), i = 0;
+
+    g_assert_cmpuint (length, ==, priv->splits->size ());
+    g_assert_cmpuint (length, >, 1);
+    for (node = list; node; node = node->next, ++i)
+    {
+        g_assert (node->data == (*priv->splits)[i]);
+        if (node->next)
+            g_assert_cmpint (xaccSplitOrder (static_cast<Split*>(node->data),
+                                             static_cast<Split*>(node->next->data)),
+                             <, 0);
+    }
+    /* Inserting and removing splits keeps the list in step without
+     * replacing the nodes a caller may be holding. */
+    g_assert (gnc_account_insert_split (fixture->acct, split));
+    list = xaccAccountGetSplitList (fixture->acct);
+    g_assert_cmpuint (g_list_length (list), ==, length + 1);
+    g_assert (g_list_find (list, split) != NULL);
+    g_assert_cmpint (g_list_position (list, first), >=, 0);
+    g_assert (priv->splits->contains (split));
+    g_assert (gnc_account_remove_split (fixture->acct, split));
+    list = xaccAccountGetSplitList (fixture->acct);
+    g_assert_cmpuint (g_list_length (list), ==, length);
+    g_assert (g_list_find (list, split) == NULL);
+    g_assert_cmpint (g_list_position (list, first), >=, 0);
+    g_assert (!priv->splits->contains (split));
+}
 /* xaccAccountSortSplits
 void
 xaccAccountSortSplits (Account *acc, gboolean force)// C: 4 in 2
@@ -1329,6 +1371,69 @@ test_xaccAccountRecomputeBalance (Fixture *fixture, gconstpointer pData)
     g_assert (!priv->balance_dirty);
 }
 
+static void
+test_xaccAccountRecomputeBalance_suffix (Fixture *fixture, gconstpointer pData)
+{
+    AccountPrivate *priv = fixture->func->get_private (fixture->acct);
+    auto& splits = *priv->splits;
+    gnc_numeric bogus = gnc_numeric_create (12345, 1);
+    gnc_numeric bal, clr_bal;
+    Split *first, *mid, *next;
+
+    xaccAccountSortSplits (fixture->acct, TRUE);
+    priv->balance_dirty = TRUE;
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert_cmpint (splits.size (), ==, 5);
+    first = splits[0];
+    mid = splits[2];
+    next = splits[3];
+    g_assert (!splits.has_stale_balances ());
+    bal = priv->balance;
+    clr_bal = priv->cleared_balance;
+
+    /* A change to the middle split leaves the splits before it alone. */
+    first->balance = bogus;
+    mid->amount = gnc_numeric_add_fixed (mid->amount, gnc_numeric_create (1, 1));
+    gnc_account_set_split_balance_dirty (fixture->acct, mid, FALSE);
+    g_assert (priv->balance_dirty);
+    g_assert_cmpint (splits.stale_from (), ==, 2);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (gnc_numeric_eq (first->balance, bogus));
+    g_assert (gnc_numeric_eq (next->balance,
+                              gnc_numeric_add_fixed (mid->balance,
+                                                     next->amount)));
+    g_assert (gnc_numeric_eq (priv->balance,
+                              gnc_numeric_add_fixed (bal,
+                                                     gnc_numeric_create (1, 1))));
+    g_assert (!priv->balance_dirty);
+
+    /* A change of reconcile state only redoes the cleared balances. */
+    bal = priv->balance;
+    mid->reconciled = (mid->reconciled == NREC) ? CREC : NREC;
+    clr_bal = priv->cleared_balance;
+    next->balance = bogus;
+    gnc_account_set_split_balance_dirty (fixture->acct, mid, TRUE);
+    g_assert_cmpint (splits.stale_from (), ==, 5);
+    g_assert_cmpint (splits.cleared_stale_from (), ==, 2);
+    xaccAccountRecomputeBalance (fixture->acct);
+    g_assert (gnc_numeric_eq (next->balance, bogus));
+    g_assert (gnc_numeric_eq (priv->balance, bal));
+    clr_bal = (mid->reconciled == NREC) ?
+        gnc_numeric_sub_fixed (clr_bal, mid->amount) :
+        gnc_numeric_add_fixed (clr_bal, mid->amount);
+    g_assert (gnc_numeric_eq (priv->cleared_balance, clr_bal));
+
+    /* Committing a split whose balance no longer follows from its amount
+     * marks it stale. */
+    next->balance = gnc_numeric_add_fixed (mid->balance, next->amount);
+    gnc_account_check_split_balance (fixture->acct, next);
+    g_assert (!splits.has_stale_balances ());
+    next->amount = gnc_numeric_add_fixed (next->amount, gnc_numeric_create (1, 1));
+    gnc_account_check_split_balance (fixture->acct, next);
+    g_assert_cmpint (splits.stale_from (), ==, 3);
+    g_assert (priv->balance_dirty);
+}
+
 /* xaccAccountOrder
 int
 xaccAccountOrder (const Account *aa, const Account *ab)// C: 11 in 3 */
@@ -1932,6 +2037,50 @@ test_xaccAccountGetBalanceAsOfDate (Fixture *fixture, gconstpointer pData)
     dval = gnc_numeric_to_double (val);
     g_assert_cmpfloat (dval, == , dbal);
 }
+/* xaccAccountGetBalancesAsOfDates
+void
+xaccAccountGetBalancesAsOfDates (Account *acc, const time64 *dates, gsize n,
+                                 gnc_numeric *balances)
+Also tests the cleared and reconciled variants.
+*/
+static void
+test_xaccAccountGetBalancesAsOfDates (Fixture *fixture, gconstpointer pData)
+{
+    const gint day = 24 * 3600;
+    const time64 now = gnc_time (NULL);
+    /* The fixture's transactions are posted from 9 days ago to a few
+     * days ahead; the last date is out of order on purpose. */
+    time64 dates[] = {now - 30 * day, now - 8 * day, now - 3 * day,
+                      now + 30 * day, now - 6 * day};
+    const gsize n = G_N_ELEMENTS (dates);
+    gnc_numeric balances[G_N_ELEMENTS (dates)];
+    gnc_numeric cleared[G_N_ELEMENTS (dates)];
+    gnc_numeric reconciled[G_N_ELEMENTS (dates)];
+
+    xaccAccountRecomputeBalance (fixture->acct);
+    xaccAccountGetBalancesAsOfDates (fixture->acct, dates, n, balances);
+    for (gsize i = 0; i < n; ++i)
+        g_assert (gnc_numeric_equal (balances[i],
+                                     xaccAccountGetBalanceAsOfDate (fixture->acct,
+                                                                    dates[i])));
+    g_assert (gnc_numeric_zero_p (balances[0]));
+    g_assert (gnc_numeric_equal (balances[3],
+                                 xaccAccountGetBalance (fixture->acct)));
+
+    xaccAccountGetClearedBalancesAsOfDates (fixture->acct, dates, n, cleared);
+    xaccAccountGetReconciledBalancesAsOfDates (fixture->acct, dates, n,
+                                               reconciled);
+    g_assert (gnc_numeric_zero_p (cleared[0]));
+    g_assert (gnc_numeric_zero_p (reconciled[0]));
+    g_assert (gnc_numeric_equal (cleared[3],
+                                 xaccAccountGetClearedBalance (fixture->acct)));
+    g_assert (gnc_numeric_equal (reconciled[3],
+                                 xaccAccountGetReconciledBalance (fixture->acct)));
+    /* Only the uncleared "waldo" transaction is posted before the second
+     * date. */
+    g_assert (!gnc_numeric_zero_p (balances[1]));
+    g_assert (gnc_numeric_zero_p (cleared[1]));
+}
 /* xaccAccountGetPresentBalance
 gnc_numeric
 xaccAccountGetPresentBalance (const Account *acc)// C: 4 in 2 */
@@ -1983,6 +2132,165 @@ test_xaccAccountGetPresentBalance (Fixture *fixture, gconstpointer pData)
  * xaccAccountGetBalanceAsOfDateInCurrency
  * xaccAccountGetBalanceChangeForPeriod
  */
+/* The recursive totals are cached on each account in the subtree; check
+ * that a change anywhere below drops the cached totals above it.
+ */
+static void
+test_xaccAccountGetBalanceInCurrency_cached (Fixture *fixture,
+                                             gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    gnc_commodity *usd = gnc_commodity_new (book, "US Dollar", "CURRENCY",
+                                            "USD", "0", 100);
+    Account *parent = xaccMallocAccount (book);
+    Account *child = xaccMallocAccount (book);
+    Account *grandchild = xaccMallocAccount (book);
+    AccountPrivate *p_priv = fixture->func->get_private (parent);
+    AccountPrivate *c_priv = fixture->func->get_private (child);
+    gnc_numeric bal;
+
+    gnc_account_append_child (fixture->acct, parent);
+    gnc_account_append_child (parent, child);
+    gnc_account_append_child (child, grandchild);
+    for (auto acc : {parent, child, grandchild})
+    {
+        xaccAccountSetCommodity (acc, usd);
+        gnc_account_set_start_balance (acc, gnc_numeric_create (100, 100));
+        xaccAccountRecomputeBalance (acc);
+    }
+
+    g_assert (p_priv->subtree_balances == NULL);
+    bal = xaccAccountGetBalanceInCurrency (parent, NULL, TRUE);
+    g_assert (gnc_numeric_equal (bal, gnc_numeric_create (300, 100)));
+    g_assert (p_priv->subtree_balances != NULL);
+    g_assert (c_priv->subtree_balances != NULL);
+    bal = xaccAccountGetBalanceInCurrency (child, NULL, TRUE);
+    g_assert (gnc_numeric_equal (bal, gnc_numeric_create (200, 100)));
+    bal = xaccAccountGetBalanceInCurrency (parent, NULL, FALSE);
+    g_assert (gnc_numeric_equal (bal, gnc_numeric_create (100, 100)));
+
+    gnc_account_set_start_balance (grandchild, gnc_numeric_create (500, 100));
+    xaccAccountRecomputeBalance (grandchild);
+    bal = xaccAccountGetBalanceInCurrency (parent, NULL, TRUE);
+    g_assert (gnc_numeric_equal (bal, gnc_numeric_create (700, 100)));
+
+    /* Moving a subtree away changes its old ancestors' totals. */
+    gnc_account_append_child (fixture->acct, child);
+    bal = xaccAccountGetBalanceInCurrency (parent, NULL, TRUE);
+    g_assert (gnc_numeric_equal (bal, gnc_numeric_create (100, 100)));
+}
+
+/* The total as the uncached code computes it: one account after the other
+ * in tree order, rounding after each addition. */
+static gnc_numeric
+flat_balance_in_currency (Account *acc, gnc_commodity *report)
+{
+    GList *descendants = gnc_account_get_descendants (acc);
+    gnc_numeric bal = xaccAccountConvertBalanceToCurrency (
+        acc, xaccAccountGetBalance (acc), xaccAccountGetCommodity (acc), report);
+
+    for (GList *node = descendants; node; node = g_list_next (node))
+    {
+        auto desc = static_cast<Account*>(node->data);
+        auto desc_bal = xaccAccountConvertBalanceToCurrency (
+            desc, xaccAccountGetBalance (desc), xaccAccountGetCommodity (desc),
+            report);
+        bal = gnc_numeric_add (bal, desc_bal, gnc_commodity_get_fraction (report),
+                               GNC_HOW_RND_ROUND_HALF_UP);
+    }
+    g_list_free (descendants);
+    return bal;
+}
+
+static GNCPrice *
+add_price (QofBook *book, gnc_commodity *com, gnc_commodity *cur,
+           gnc_numeric value)
+{
+    GNCPrice *price = gnc_price_create (book);
+
+    gnc_price_begin_edit (price);
+    gnc_price_set_commodity (price, com);
+    gnc_price_set_currency (price, cur);
+    gnc_price_set_time64 (price, gnc_time (NULL));
+    gnc_price_set_source (price, PRICE_SOURCE_USER_PRICE);
+    gnc_price_set_value (price, value);
+    gnc_price_commit_edit (price);
+    gnc_pricedb_add_price (gnc_pricedb_get_db (book), price);
+    gnc_price_unref (price);
+    return price;
+}
+
+/* Cached totals of children in other commodities have to match the old
+ * flat sum, follow the prices of their commodities and survive changes of
+ * unrelated prices.
+ */
+static void
+test_xaccAccountGetBalanceInCurrency_mixed (Fixture *fixture,
+                                            gconstpointer pData)
+{
+    QofBook *book = gnc_account_get_book (fixture->acct);
+    gnc_commodity *usd = gnc_commodity_new (book, "US Dollar", "CURRENCY",
+                                            "USD", "0", 100);
+    gnc_commodity *eur = gnc_commodity_new (book, "Euro", "CURRENCY",
+                                            "EUR", "0", 100);
+    gnc_commodity *gbp = gnc_commodity_new (book, "Pound", "CURRENCY",
+                                            "GBP", "0", 100);
+    gnc_commodity *jpy = gnc_commodity_new (book, "Yen", "CURRENCY",
+                                            "JPY", "0", 1);
+    gnc_commodity *stock = gnc_commodity_new (book, "Stock", "NASDAQ",
+                                              "STK", "0", 10000);
+    Account *parent = xaccMallocAccount (book);
+    Account *eur_acc = xaccMallocAccount (book);
+    Account *stock_acc = xaccMallocAccount (book);
+    Account *usd_acc = xaccMallocAccount (book);
+    GNCPrice *eur_price;
+    gnc_numeric bal;
+
+    gnc_account_append_child (fixture->acct, parent);
+    gnc_account_append_child (parent, eur_acc);
+    gnc_account_append_child (eur_acc, stock_acc);
+    gnc_account_append_child (parent, usd_acc);
+    xaccAccountSetCommodity (parent, usd);
+    xaccAccountSetCommodity (eur_acc, eur);
+    xaccAccountSetCommodity (stock_acc, stock);
+    xaccAccountSetCommodity (usd_acc, usd);
+    gnc_account_set_start_balance (parent, gnc_numeric_create (1000, 100));
+    gnc_account_set_start_balance (eur_acc, gnc_numeric_create (3333, 100));
+    gnc_account_set_start_balance (stock_acc, gnc_numeric_create (15, 10000));
+    gnc_account_set_start_balance (usd_acc, gnc_numeric_create (-777, 100));
+    for (auto acc : {parent, eur_acc, stock_acc, usd_acc})
+        xaccAccountRecomputeBalance (acc);
+
+    eur_price = add_price (book, eur, usd, gnc_numeric_create (1117, 1000));
+    add_price (book, stock, eur, gnc_numeric_create (12345, 100));
+    add_price (book, gbp, jpy, gnc_numeric_create (150, 1));
+
+    bal = xaccAccountGetBalanceInCurrency (parent, usd, TRUE);
+    g_assert (gnc_numeric_equal (bal, flat_balance_in_currency (parent, usd)));
+    bal = xaccAccountGetBalanceInCurrency (eur_acc, usd, TRUE);
+    g_assert (gnc_numeric_equal (bal, flat_balance_in_currency (eur_acc, usd)));
+
+    /* A price that none of the subtree's conversions can use. */
+    add_price (book, gbp, jpy, gnc_numeric_create (151, 1));
+    bal = xaccAccountGetBalanceInCurrency (parent, usd, TRUE);
+    g_assert (gnc_numeric_equal (bal, flat_balance_in_currency (parent, usd)));
+
+    gnc_price_begin_edit (eur_price);
+    gnc_price_set_value (eur_price, gnc_numeric_create (1251, 1000));
+    gnc_price_commit_edit (eur_price);
+    bal = xaccAccountGetBalanceInCurrency (parent, usd, TRUE);
+    g_assert (gnc_numeric_equal (bal, flat_balance_in_currency (parent, usd)));
+
+    /* Balances finer than a cent: adding the subtrees first would round
+     * differently, so the flat order decides. */
+    gnc_account_set_start_balance (usd_acc, gnc_numeric_create (5, 1000));
+    xaccAccountRecomputeBalance (usd_acc);
+    bal = xaccAccountGetBalanceInCurrency (parent, usd, TRUE);
+    g_assert (gnc_numeric_equal (bal, flat_balance_in_currency (parent, usd)));
+    bal = xaccAccountGetBalanceInCurrency (parent, NULL, TRUE);
+    g_assert (gnc_numeric_equal (bal, flat_balance_in_currency (parent, usd)));
+}
+
 /*
  * Yet more getters & setters:
  * xaccAccountGetSplitList
@@ -2558,8 +2866,10 @@ test_suite_account (void)
 // GNC_TEST_ADD (suitename, "xaccAcctChildrenEqual", Fixture, NULL, setup, test_xaccAcctChildrenEqual,  teardown );
 // GNC_TEST_ADD (suitename, "xaccAccountEqual", Fixture, NULL, setup, test_xaccAccountEqual,  teardown );
     GNC_TEST_ADD (suitename, "gnc account insert & remove split", Fixture, NULL, setup, test_gnc_account_insert_remove_split,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetSplitList", Fixture, &some_data, setup, test_xaccAccountGetSplitList,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccount Insert and Remove Lot", Fixture, &good_data, setup, test_xaccAccountInsertRemoveLot,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountRecomputeBalance suffix", Fixture, &some_data, setup, test_xaccAccountRecomputeBalance_suffix,  teardown );
     GNC_TEST_ADD_FUNC (suitename, "xaccAccountOrder", test_xaccAccountOrder );
     GNC_TEST_ADD (suitename, "qofAccountSetParent", Fixture, &some_data, setup, test_qofAccountSetParent,  teardown );
     GNC_TEST_ADD (suitename, "gnc account append/remove child", Fixture, NULL, setup, test_gnc_account_append_remove_child,  teardown );
@@ -2578,7 +2888,10 @@ test_suite_account (void)
     GNC_TEST_ADD (suitename, "gnc account get full name", Fixture, &good_data, setup, test_gnc_account_get_full_name,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetProjectedMinimumBalance", Fixture, &some_data, setup, test_xaccAccountGetProjectedMinimumBalance,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetBalanceAsOfDate", Fixture, &some_data, setup, test_xaccAccountGetBalanceAsOfDate,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalancesAsOfDates", Fixture, &some_data, setup, test_xaccAccountGetBalancesAsOfDates,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountGetPresentBalance", Fixture, &some_data, setup, test_xaccAccountGetPresentBalance,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalanceInCurrency cached", Fixture, NULL, setup, test_xaccAccountGetBalanceInCurrency_cached,  teardown );
+    GNC_TEST_ADD (suitename, "xaccAccountGetBalanceInCurrency mixed", Fixture, NULL, setup, test_xaccAccountGetBalanceInCurrency_mixed,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountFindOpenLots", Fixture, &complex_data, setup, test_xaccAccountFindOpenLots,  teardown );
     GNC_TEST_ADD (suitename, "xaccAccountForEachLot", Fixture, &complex_data, setup, test_xaccAccountForEachLot,  teardown );
 
@@ -46,6 +46,7 @@ void test_suite_transaction ( void );
 
 #include <qof-backend.hpp>
 #include <kvp-frame.hpp>
+#include <qofinstance-p.h>
 
 /* Copied from Transaction.c. Changing these values will break
  * existing databases, which is a good reason to fail a test.
@@ -1882,6 +1883,56 @@ test_xaccTransVoid (Fixture *fixture, gconstpointer pData)
     g_free (txn_notes);
 
 }
+/* The kvp values cached in a transaction must follow every change of its
+ * kvp frame, whichever way it's made.
+ */
+static void
+test_xaccTransKvpCache (Fixture *fixture, gconstpointer pData)
+{
+    auto txn = fixture->txn;
+    auto frame = txn->inst.kvp_data;
+    auto txn_notes = g_strdup (frame->get_slot({trans_notes_str})->get<const char*>());
+
+    g_assert_cmpstr (xaccTransGetNotes (txn), ==, txn_notes);
+    g_assert (!xaccTransGetIsClosingTxn (txn));
+    g_assert (!xaccTransGetVoidStatus (txn));
+    g_assert (xaccTransGetReadOnly (txn) == NULL);
+
+    xaccTransBeginEdit (txn);
+    xaccTransSetNotes (txn, "Changed notes");
+    xaccTransSetIsClosingTxn (txn, TRUE);
+    g_assert_cmpstr (xaccTransGetNotes (txn), ==, "Changed notes");
+    g_assert (xaccTransGetIsClosingTxn (txn));
+    xaccTransRollbackEdit (txn);
+    g_assert_cmpstr (xaccTransGetNotes (txn), ==, txn_notes);
+    g_assert (!xaccTransGetIsClosingTxn (txn));
+
+    xaccTransVoid (txn, "Voided for Unit Test");
+    g_assert (xaccTransGetVoidStatus (txn));
+    g_assert_cmpstr (xaccTransGetVoidReason (txn), ==, "Voided for Unit Test");
+    g_assert_cmpstr (xaccTransGetNotes (txn), ==, "Voided transaction");
+    g_assert_cmpstr (xaccTransGetReadOnly (txn), ==, "Transaction Voided");
+    xaccTransUnvoid (txn);
+    g_assert (!xaccTransGetVoidStatus (txn));
+    g_assert (xaccTransGetReadOnly (txn) == NULL);
+    g_assert_cmpstr (xaccTransGetNotes (txn), ==, txn_notes);
+
+    /* Only a change drops the cache; a change made straight to the frame
+     * has to be signalled. */
+    auto notes = xaccTransGetNotes (txn);
+    g_assert (qof_instance_get_slots (QOF_INSTANCE (txn)) == frame);
+    g_assert (txn->cache_valid & TRANS_CACHED_NOTES);
+    g_assert (xaccTransGetNotes (txn) == notes);
+    delete frame->set ({trans_notes_str},
+                       new KvpValue (g_strdup ("Direct notes")));
+    qof_instance_slots_changed (QOF_INSTANCE (txn));
+    g_assert_cmpstr (xaccTransGetNotes (txn), ==, "Direct notes");
+
+    qof_instance_slot_delete (QOF_INSTANCE (txn), trans_notes_str);
+    g_assert (xaccTransGetNotes (txn) == NULL);
+
+    g_free (txn_notes);
+}
 /* xaccTransReverse
 Transaction *
 xaccTransReverse (Transaction *orig)// C: 2 in 2  Local: 0:0:0
@@ -1985,9 +2036,89 @@ test_xaccTransScrubGainsDate_gains_dirty (GainsFixture *fixture,
  * cap-gains.c and Scrub3.c that are beyond the scope of this test
  * program.
  */
+/* gnc_transaction_book_end
+static void
+gnc_transaction_book_end(QofBook* book)*/
+static void
+book_end_event_handler (QofInstance *ent, QofEventId event_type,
+                        gpointer handler_data, gpointer event_data)
+{
+    auto events = static_cast<GList**>(handler_data);
+    *events = g_list_prepend (*events, ent);
+}
+
+/* A finalizer of the dying book touching an object of another book. */
+static void
+book_end_touch_other (QofBook *book, gpointer key, gpointer user_data)
+{
+    qof_event_gen (QOF_INSTANCE (user_data), QOF_EVENT_MODIFY, NULL);
+}
+
+static void
+test_gnc_transaction_book_end (void)
+{
+    QofBook *book = qof_book_new ();
+    QofBook *other_book = qof_book_new ();
+    auto other = xaccMallocAccount (other_book);
+    auto root = gnc_book_get_root_account (book);
+    auto acc1 = xaccMallocAccount (book);
+    auto acc2 = xaccMallocAccount (book);
+    auto curr = gnc_commodity_new (book, "Gnu Rand", "CURRENCY", "GNR", "", 240);
+    auto lot = gnc_lot_new (book);
+    auto txn = xaccMallocTransaction (book);
+    auto split1 = xaccMallocSplit (book);
+    auto split2 = xaccMallocSplit (book);
+    gpointer t_ref = txn, s_ref = split1, l_ref = lot, a_ref = acc1;
+    gpointer c_ref;
+    GList *events = NULL;
+    gint handler;
+
+    gnc_account_append_child (root, acc1);
+    gnc_account_append_child (root, acc2);
+    xaccAccountSetCommodity (acc1, curr);
+    xaccAccountSetCommodity (acc2, curr);
+    xaccTransBeginEdit (txn);
+    xaccTransSetCurrency (txn, curr);
+    xaccSplitSetParent (split1, txn);
+    xaccSplitSetParent (split2, txn);
+    xaccSplitSetAccount (split1, acc1);
+    xaccSplitSetAccount (split2, acc2);
+    xaccSplitSetValue (split1, gnc_numeric_create (100, 240));
+    xaccSplitSetValue (split2, gnc_numeric_create (-100, 240));
+    xaccTransCommitEdit (txn);
+    xaccAccountInsertLot (acc1, lot);
+    gnc_lot_add_split (lot, split1);
+    g_assert (split1->lot == lot);
+
+    g_object_add_weak_pointer (G_OBJECT (txn), &t_ref);
+    g_object_add_weak_pointer (G_OBJECT (split1), &s_ref);
+    g_object_add_weak_pointer (G_OBJECT (lot), &l_ref);
+    g_object_add_weak_pointer (G_OBJECT (acc1), &a_ref);
+    /* Left open, so the rollback copy with its split copies goes too. */
+    xaccTransBeginEdit (txn);
+    c_ref = txn->orig->splits->data;
+    g_object_add_weak_pointer (G_OBJECT (c_ref), &c_ref);
+    qof_book_set_data_fin (book, "other", other, book_end_touch_other);
+    handler = qof_event_register_handler (book_end_event_handler, &events);
+
+    qof_book_destroy (book);
+    qof_event_unregister_handler (handler);
+
+    g_assert (t_ref == NULL);
+    g_assert (s_ref == NULL);
+    g_assert (l_ref == NULL);
+    g_assert (a_ref == NULL);
+    g_assert (c_ref == NULL);
+    /* The book announces its destruction, its objects stay quiet and
+     * the other book's aren't affected. */
+    events = g_list_reverse (events);
+    g_assert_cmpint (g_list_length (events), ==, 2);
+    g_assert (events->data == book);
+    g_assert (events->next->data == other);
+    g_list_free (events);
+    qof_book_destroy (other_book);
+}
 /* xaccTransFindSplitByAccount C: 7 in 5  Local: 0:0:0
- * destroy_tx_on_book_close Local: 0:1:0
- * gnc_transaction_book_end Local: 0:1:0
  * trans_is_balanced_p Local: 0:1:0
  * Trivial pass-through.
  */
@@ -2003,6 +2134,7 @@ test_suite_transaction (void)
     GNC_TEST_ADD_FUNC (suitename, "gnc transaction init", test_gnc_transaction_init);
     GNC_TEST_ADD_FUNC (suitename, "gnc transaction dispose", test_gnc_transaction_dispose);
     GNC_TEST_ADD_FUNC (suitename, "gnc transaction finalize", test_gnc_transaction_finalize);
+    GNC_TEST_ADD_FUNC (suitename, "gnc transaction book end", test_gnc_transaction_book_end);
     GNC_TEST_ADD (suitename, "gnc transaction set/get property", Fixture, NULL, setup, test_gnc_transaction_set_get_property, teardown);
     GNC_TEST_ADD (suitename, "xaccMallocTransaction", Fixture, NULL, setup, test_xaccMallocTransaction, teardown);
     GNC_TEST_ADD (suitename, "xaccTransSortSplits", Fixture, NULL, setup, test_xaccTransSortSplits, teardown);
@@ -2039,6 +2171,7 @@ test_suite_transaction (void)
     GNC_TEST_ADD (suitename, "xaccTransOrder_num_action", Fixture, NULL, setup, test_xaccTransOrder_num_action, teardown);
     GNC_TEST_ADD (suitename, "xaccTransGetTxnType", Fixture, NULL, setup, test_xaccTransGetTxnType, teardown);
     GNC_TEST_ADD (suitename, "xaccTransVoid", Fixture, NULL, setup, test_xaccTransVoid, teardown);
+    GNC_TEST_ADD (suitename, "xaccTransKvpCache", Fixture, NULL, setup, test_xaccTransKvpCache, teardown);
     GNC_TEST_ADD (suitename, "xaccTransReverse", Fixture, NULL, setup, test_xaccTransReverse, teardown);
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate_no_dirty", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_no_dirty, teardown_with_gains);
     GNC_TEST_ADD (suitename, "xaccTransScrubGainsDate_base_dirty", GainsFixture, NULL, setup_with_gains, test_xaccTransScrubGainsDate_base_dirty, teardown_with_gains);
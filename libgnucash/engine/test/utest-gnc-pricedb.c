@@ -1129,6 +1129,52 @@ test_gnc_pricedb_lookup_nearest_in_time64 (PriceDBFixture *fixture, gconstpointe
     g_assert_cmpstr(GET_CUR_NAME(price), ==, "AUD");
     g_assert_cmpstr(GET_COM_NAME(price), ==, "USD");
 }
+/* gnc_pricedb_get_price_range
+gboolean
+gnc_pricedb_get_price_range (GNCPriceDB *db,// Local: 0:0:0
+*/
+static void
+test_gnc_pricedb_get_price_range (PriceDBFixture *fixture, gconstpointer pData)
+{
+    GNCPriceRange range;
+    time64 start = gnc_dmy2time64(1, 1, 2008);
+    time64 end = gnc_dmy2time64(31, 12, 2008);
+    guint i;
+
+    g_assert(gnc_pricedb_get_price_range(fixture->pricedb, fixture->com->gbp,
+                                         fixture->com->eur, start, end,
+                                         &range));
+    g_assert_cmpuint(range.count, ==, 8);
+    g_assert_cmpint(gnc_price_get_time64(range.prices[0]), ==,
+                    gnc_dmy2time64(12, 11, 2008));
+    g_assert_cmpint(gnc_price_get_time64(range.prices[7]), ==,
+                    gnc_dmy2time64(12, 5, 2008));
+    for (i = 1; i < range.count; ++i)
+        g_assert_cmpint(gnc_price_get_time64(range.prices[i - 1]), >,
+                        gnc_price_get_time64(range.prices[i]));
+
+    /* Both ends are inclusive. */
+    g_assert(gnc_pricedb_get_price_range(fixture->pricedb, fixture->com->gbp,
+                                         fixture->com->eur,
+                                         gnc_dmy2time64(13, 5, 2008),
+                                         gnc_dmy2time64(12, 6, 2008),
+                                         &range));
+    g_assert_cmpuint(range.count, ==, 5);
+
+    /* Only prices in the requested direction are returned. */
+    g_assert(!gnc_pricedb_get_price_range(fixture->pricedb, fixture->com->eur,
+                                          fixture->com->gbp, start, end,
+                                          &range));
+    g_assert_cmpuint(range.count, ==, 0);
+    g_assert(range.prices == NULL);
+
+    g_assert(!gnc_pricedb_get_price_range(fixture->pricedb, fixture->com->gbp,
+                                          fixture->com->eur,
+                                          gnc_dmy2time64(1, 1, 2015),
+                                          gnc_dmy2time64(31, 12, 2015),
+                                          &range));
+    g_assert_cmpuint(range.count, ==, 0);
+}
 // Not Used
 /* gnc_pricedb_lookup_latest_before_t64
 GNCPrice *
@@ -1248,6 +1294,53 @@ test_gnc_pricedb_convert_balance_nearest_price_t64 (PriceDBFixture *fixture, gco
     g_assert_cmpint(result.denom, ==, 100);
 
 }
+
+static void
+test_gnc_pricedb_convert_balance_cache (PriceDBFixture *fixture, gconstpointer pData)
+{
+    time64 t = gnc_dmy2time64(15, 8, 2011);
+    gnc_numeric from = gnc_numeric_create(10000, 100);
+    QofBook *book = qof_instance_get_book(fixture->pricedb);
+    GNCPrice *price;
+    gnc_numeric result;
+    int i;
+
+    /* USD to EUR goes through GBP; repeating it must give the same. */
+    for (i = 0; i < 3; ++i)
+    {
+        result = gnc_pricedb_convert_balance_nearest_price_t64(fixture->pricedb,
+                                                               from,
+                                                               fixture->com->usd,
+                                                               fixture->com->eur,
+                                                               t);
+        g_assert_cmpint(result.num, ==, 7009);
+        g_assert_cmpint(result.denom, ==, 100);
+    }
+
+    /* A new direct price replaces the cached cross rate... */
+    price = construct_price(book, fixture->com->usd, fixture->com->eur, t,
+                            PRICE_SOURCE_USER_PRICE,
+                            gnc_numeric_create(8, 10));
+    gnc_pricedb_add_price(fixture->pricedb, price);
+    result = gnc_pricedb_convert_balance_nearest_price_t64(fixture->pricedb,
+                                                           from,
+                                                           fixture->com->usd,
+                                                           fixture->com->eur,
+                                                           t);
+    g_assert_cmpint(result.num, ==, 8000);
+    g_assert_cmpint(result.denom, ==, 100);
+
+    /* ...and removing it brings the cross rate back. */
+    gnc_pricedb_remove_price(fixture->pricedb, price);
+    gnc_price_unref(price);
+    result = gnc_pricedb_convert_balance_nearest_price_t64(fixture->pricedb,
+                                                           from,
+                                                           fixture->com->usd,
+                                                           fixture->com->eur,
+                                                           t);
+    g_assert_cmpint(result.num, ==, 7009);
+    g_assert_cmpint(result.denom, ==, 100);
+}
 /* pricedb_foreach_pricelist
 static void
 pricedb_foreach_pricelist(gpointer key, gpointer val, gpointer user_data)// Local: 0:1:0
@@ -1498,12 +1591,14 @@ test_suite_gnc_pricedb (void)
     GNC_TEST_ADD (suitename, "gnc pricedb lookup day", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_day_t64, teardown);
 // GNC_TEST_ADD (suitename, "lookup nearest in time", Fixture, NULL, setup, test_lookup_nearest_in_time, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb lookup nearest in time", PriceDBFixture, NULL, setup, test_gnc_pricedb_lookup_nearest_in_time64, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb get price range", PriceDBFixture, NULL, setup, test_gnc_pricedb_get_price_range, teardown);
 // GNC_TEST_ADD (suitename, "direct balance conversion", Fixture, NULL, setup, test_direct_balance_conversion, teardown);
 // GNC_TEST_ADD (suitename, "extract common prices", Fixture, NULL, setup, test_extract_common_prices, teardown);
 // GNC_TEST_ADD (suitename, "convert balance", Fixture, NULL, setup, test_convert_balance, teardown);
 // GNC_TEST_ADD (suitename, "indirect balance conversion", Fixture, NULL, setup, test_indirect_balance_conversion, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance latest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_latest_price, teardown);
     GNC_TEST_ADD (suitename, "gnc pricedb convert balance nearest price", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_nearest_price_t64, teardown);
+    GNC_TEST_ADD (suitename, "gnc pricedb convert balance cache", PriceDBFixture, NULL, setup, test_gnc_pricedb_convert_balance_cache, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach pricelist", Fixture, NULL, setup, test_pricedb_foreach_pricelist, teardown);
 // GNC_TEST_ADD (suitename, "pricedb foreach currencies hash", Fixture, NULL, setup, test_pricedb_foreach_currencies_hash, teardown);
 // GNC_TEST_ADD (suitename, "unstable price traversal", Fixture, NULL, setup, test_unstable_price_traversal, teardown);